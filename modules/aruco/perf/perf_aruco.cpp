@@ -0,0 +1,52 @@
+// This file is part of OpenCV project.
+// It is subject to the license terms in the LICENSE file found in the top-level directory
+// of this distribution and at http://opencv.org/license.html.
+#include "perf_precomp.hpp"
+
+namespace opencv_test { namespace {
+
+CV_ENUM(CornerRefineMethod, CORNER_REFINE_NONE, CORNER_REFINE_APRILTAG)
+
+typedef tuple<Size, CornerRefineMethod> ArucoParams;
+typedef perf::TestBaseWithParam<ArucoParams> ArucoDetectorPerfTest;
+
+// grid of markers on a white background, slightly blurred
+static Mat generateMarkersImage(const Ptr<Dictionary> &dictionary, Size size)
+{
+    Mat image(size, CV_8UC1, Scalar::all(255));
+    const int markerSide = std::min(size.width, size.height) / 8;
+    const int gap = markerSide / 2;
+    int id = 0;
+    for (int y = gap; y + markerSide + gap <= size.height; y += markerSide + gap)
+    {
+        for (int x = gap; x + markerSide + gap <= size.width; x += markerSide + gap)
+        {
+            Mat marker;
+            drawMarker(dictionary, id++ % dictionary->bytesList.rows, markerSide, marker, 1);
+            marker.copyTo(image(Rect(x, y, markerSide, markerSide)));
+        }
+    }
+    GaussianBlur(image, image, Size(3, 3), 0);
+    return image;
+}
+
+PERF_TEST_P(ArucoDetectorPerfTest, detectMarkers,
+            testing::Combine(testing::Values(szVGA, sz1080p, sz2160p), CornerRefineMethod::all()))
+{
+    const Size size = get<0>(GetParam());
+    const int method = get<1>(GetParam());
+
+    Ptr<Dictionary> dictionary = getPredefinedDictionary(DICT_6X6_250);
+    Mat image = generateMarkersImage(dictionary, size);
+
+    Ptr<DetectorParameters> params = DetectorParameters::create();
+    params->cornerRefinementMethod = method;
+
+    vector< vector<Point2f> > corners;
+    vector<int> ids;
+    TEST_CYCLE() detectMarkers(image, dictionary, corners, ids, params);
+
+    SANITY_CHECK_NOTHING();
+}
+
+}} // namespace
@@ -600,12 +600,10 @@ static void do_unionfind_line(unionfind_t *uf, Mat &im, int w, int s, int y){
  *  return 1 if the quad looks okay, 0 if it should be discarded
  *  quad
  **/
-int fit_quad(const Ptr<DetectorParameters> &_params, const Mat im, zarray_t *cluster, struct sQuad *quad){
-    CV_Assert(cluster != NULL);
-
+int fit_quad(const Ptr<DetectorParameters> &_params, const Mat im, std::vector<struct pt> &cluster, struct sQuad *quad){
     int res = 0;
 
-    int sz = _zarray_size(cluster);
+    int sz = (int)cluster.size();
     if (sz < 4) // can't fit a quad to less than 4 points
         return 0;
 
@@ -619,8 +617,7 @@ int fit_quad(const Ptr<DetectorParameters> &_params, const Mat im, zarray_t *clu
     int32_t xmax = 0, xmin = INT32_MAX, ymax = 0, ymin = INT32_MAX;
 
     for (int pidx = 0; pidx < sz; pidx++) {
-        struct pt *p;
-        _zarray_get_volatile(cluster, pidx, &p);
+        struct pt *p = &cluster[pidx];
 
         //(a > b) ? a : b;
         //xmax = imax(xmax, p->x);
@@ -646,8 +643,7 @@ int fit_quad(const Ptr<DetectorParameters> &_params, const Mat im, zarray_t *clu
     double dot = 0;
 
     for (int pidx = 0; pidx < sz; pidx++) {
-        struct pt *p;
-        _zarray_get_volatile(cluster, pidx, &p);
+        struct pt *p = &cluster[pidx];
 
         double dx = p->x - cx;
         double dy = p->y - cy;
@@ -665,26 +661,22 @@ int fit_quad(const Ptr<DetectorParameters> &_params, const Mat im, zarray_t *clu
     // step for segmenting them into four lines.
     if (1) {
         //        zarray_sort(cluster, pt_compare_theta);
-        ptsort((struct pt*) cluster->data, sz);
+        ptsort(&cluster[0], sz);
 
         // remove duplicate points. (A byproduct of our segmentation system.)
         if (1) {
             int outpos = 1;
 
-            struct pt *last;
-            _zarray_get_volatile(cluster, 0, &last);
+            struct pt last = cluster[0];
 
             for (int i = 1; i < sz; i++) {
 
-                struct pt *p;
-                _zarray_get_volatile(cluster, i, &p);
+                struct pt p = cluster[i];
 
-                if (p->x != last->x || p->y != last->y) {
+                if (p.x != last.x || p.y != last.y) {
 
                     if (i != outpos)  {
-                        struct pt *out;
-                        _zarray_get_volatile(cluster, outpos, &out);
-                        memcpy(out, p, sizeof(struct pt));
+                        cluster[outpos] = p;
                     }
 
                     outpos++;
@@ -693,7 +685,7 @@ int fit_quad(const Ptr<DetectorParameters> &_params, const Mat im, zarray_t *clu
                 last = p;
             }
 
-            cluster->size = outpos;
+            cluster.resize(outpos);
             sz = outpos;
         }
 
@@ -714,8 +706,7 @@ int fit_quad(const Ptr<DetectorParameters> &_params, const Mat im, zarray_t *clu
 
         // put each point into a bucket.
         for (int i = 0; i < sz; i++) {
-            struct pt *p;
-            _zarray_get_volatile(cluster, i, &p);
+            struct pt *p = &cluster[i];
 
             CV_Assert(p->theta >= -CV_PI && p->theta <= CV_PI);
 
@@ -735,13 +726,13 @@ int fit_quad(const Ptr<DetectorParameters> &_params, const Mat im, zarray_t *clu
         for (int i = 0; i < nbuckets; i++) {
             for (int j = 0; j < ASSOC; j++) {
                 if (v[i][j].theta != 0) {
-                    _zarray_set(cluster, outsz, &v[i][j], NULL);
+                    cluster[outsz] = v[i][j];
                     outsz++;
                 }
             }
         }
 
-        _zarray_truncate(cluster, outsz);
+        cluster.resize(outsz);
         sz = outsz;
     }
 
@@ -757,8 +748,7 @@ int fit_quad(const Ptr<DetectorParameters> &_params, const Mat im, zarray_t *clu
     struct line_fit_pt *lfps = lfps_.data();
 
     for (int i = 0; i < sz; i++) {
-        struct pt *p;
-        _zarray_get_volatile(cluster, i, &p);
+        struct pt *p = &cluster[i];
 
         if (i > 0) {
             memcpy(&lfps[i], &lfps[i-1], sizeof(struct line_fit_pt));
@@ -832,7 +822,7 @@ int fit_quad(const Ptr<DetectorParameters> &_params, const Mat im, zarray_t *clu
 
     int indices[4];
     if (1) {
-        if (!quad_segment_maxima(_params, _zarray_size(cluster), lfps, indices))
+        if (!quad_segment_maxima(_params, sz, lfps, indices))
             goto finish;
     } else {
         if (!quad_segment_agg(sz, lfps, indices))
@@ -848,8 +838,7 @@ int fit_quad(const Ptr<DetectorParameters> &_params, const Mat im, zarray_t *clu
         // plausibility checks that save us tons of time in quad
         // decoding.
         for (int i = 0; i < 4; i++) {
-            struct pt *p;
-            _zarray_get_volatile(cluster, indices[i], &p);
+            struct pt *p = &cluster[indices[i]];
 
             quad->p[i][0] = (float)(.5*p->x); // undo fixed-point arith.
             quad->p[i][1] = (float)(.5*p->y);
@@ -1028,55 +1017,41 @@ int fit_quad(const Ptr<DetectorParameters> &_params, const Mat im, zarray_t *clu
     return res;
 }
 
-/**
- *
- * @param nCidx0
- * @param nCidx1
- * @param nClusters
- * @param nW
- * @param nH
- * @param nquads
- * @param td
- * @param im
- */
-static void do_quad(int nCidx0, int nCidx1, zarray_t &nClusters, int nW, int nH, zarray_t *nquads, const Ptr<DetectorParameters> &td, const Mat im){
-
-    CV_Assert(nquads != NULL);
-
-    //struct quad_task *task = (struct quad_task*) p;
-
-    //zarray_t *clusters = nClusters;
-    zarray_t *quads = nquads;
-    int w = nW, h = nH;
-
-    for (int cidx = nCidx0; cidx < nCidx1; cidx++) {
-
-        zarray_t *cluster;
-        _zarray_get(&nClusters, cidx, &cluster);
-
-        if (_zarray_size(cluster) < td->aprilTagMinClusterPixels)
-            continue;
-
-        // a cluster should contain only boundary points around the
-        // tag. it cannot be bigger than the whole screen. (Reject
-        // large connected blobs that will be prohibitively slow to
-        // fit quads to.) A typical point along an edge is added three
-        // times (because it has 3 neighbors). The maximum perimeter
-        // is 2w+2h.
-        if (_zarray_size(cluster) > 3*(2*w+2*h)) {
-            continue;
-        }
-
-        struct sQuad quad;
-        memset(&quad, 0, sizeof(struct sQuad));
-
-        if (fit_quad(td, im, cluster, &quad)) {
-            //pthread_mutex_lock(&td.mutex);
-            _zarray_add(quads, &quad);
-            //pthread_mutex_unlock(&td.mutex);
-        }
-    }
-}
+// a point of the boundary between two connected components, tagged with the
+// id of the pair of components
+struct cluster_pt{
+    uint64_t id;
+    struct pt p;
+};
+
+// hash map from pair of components ids to clusters, the clusters are kept in
+// order of first appearance
+struct cluster_table{
+    std::vector<int> heads;
+    std::vector<uint64_t> ids;
+    std::vector<int> next;
+    std::vector< std::vector<struct pt> > clusters;
+    int nclusters;
+};
+
+// Rows of the blocks in which the union-find and the clustering are split. The
+// blocks do not depend on the number of threads, so neither do the results.
+static const int APRILTAG_BLOCK_ROWS = 32;
+// Number of hash partitions of the clusters, must be a power of 2.
+static const int APRILTAG_CLUSTER_PARTITIONS = 64;
+
+// Scratch memory of apriltag_quad_thresh, allocated once per call and shared
+// by its steps.
+struct apriltag_buffers{
+    Mat thold;
+    std::vector<struct ufrec> uf_data;
+    std::vector<uint32_t> labels;
+    std::vector< std::vector<struct cluster_pt> > block_pts; // [block*APRILTAG_CLUSTER_PARTITIONS + partition]
+    std::vector<struct cluster_table> tables;
+    std::vector< std::vector<struct pt>* > clusters;
+    std::vector<struct sQuad> quads;
+    std::vector<uchar> quad_ok;
+};
 
 /**
  *
@@ -1122,176 +1097,185 @@ void threshold(const Mat mIm, const Ptr<DetectorParameters> &parameters, Mat& mT
     int tw = w / tilesz;
     int th = h / tilesz;
 
-    uint8_t *im_max = (uint8_t*)calloc(tw*th, sizeof(uint8_t));
-    uint8_t *im_min = (uint8_t*)calloc(tw*th, sizeof(uint8_t));
-
+    std::vector<uint8_t> im_max_buf(std::max(tw*th, 1)), im_min_buf(std::max(tw*th, 1));
+    uint8_t *im_max = &im_max_buf[0];
+    uint8_t *im_min = &im_min_buf[0];
 
     // first, collect min/max statistics for each tile
-    for (int ty = 0; ty < th; ty++) {
-        for (int tx = 0; tx < tw; tx++) {
-            uint8_t max = 0, min = 255;
+    parallel_for_(Range(0, th), [&](const Range& range){
+        for (int ty = range.start; ty < range.end; ty++) {
+            for (int tx = 0; tx < tw; tx++) {
+                uint8_t max = 0, min = 255;
 
-            for (int dy = 0; dy < tilesz; dy++) {
+                for (int dy = 0; dy < tilesz; dy++) {
 
-                for (int dx = 0; dx < tilesz; dx++) {
+                    for (int dx = 0; dx < tilesz; dx++) {
 
-                    uint8_t v = mIm.data[(ty*tilesz+dy)*s + tx*tilesz + dx];
-                    if (v < min)
-                        min = v;
-                    if (v > max)
-                        max = v;
+                        uint8_t v = mIm.data[(ty*tilesz+dy)*s + tx*tilesz + dx];
+                        if (v < min)
+                            min = v;
+                        if (v > max)
+                            max = v;
+                    }
                 }
+                im_max[ty*tw+tx] = max;
+                im_min[ty*tw+tx] = min;
             }
-            im_max[ty*tw+tx] = max;
-            im_min[ty*tw+tx] = min;
         }
-    }
+    });
 
     // second, apply 3x3 max/min convolution to "blur" these values
     // over larger areas. This reduces artifacts due to abrupt changes
     // in the threshold value.
-    uint8_t *im_max_tmp = (uint8_t*)calloc(tw*th, sizeof(uint8_t));
-    uint8_t *im_min_tmp = (uint8_t*)calloc(tw*th, sizeof(uint8_t));
+    std::vector<uint8_t> im_max_tmp_buf(std::max(tw*th, 1)), im_min_tmp_buf(std::max(tw*th, 1));
+    uint8_t *im_max_tmp = &im_max_tmp_buf[0];
+    uint8_t *im_min_tmp = &im_min_tmp_buf[0];
 
-    for (int ty = 0; ty < th; ty++) {
-        for (int tx = 0; tx < tw; tx++) {
-            uint8_t max = 0, min = 255;
+    parallel_for_(Range(0, th), [&](const Range& range){
+        for (int ty = range.start; ty < range.end; ty++) {
+            for (int tx = 0; tx < tw; tx++) {
+                uint8_t max = 0, min = 255;
 
-            for (int dy = -1; dy <= 1; dy++) {
-                if (ty+dy < 0 || ty+dy >= th)
-                    continue;
-                for (int dx = -1; dx <= 1; dx++) {
-                    if (tx+dx < 0 || tx+dx >= tw)
+                for (int dy = -1; dy <= 1; dy++) {
+                    if (ty+dy < 0 || ty+dy >= th)
                         continue;
-
-                    uint8_t m = im_max[(ty+dy)*tw+tx+dx];
-                    if (m > max)
-                        max = m;
-                    m = im_min[(ty+dy)*tw+tx+dx];
-                    if (m < min)
-                        min = m;
+                    for (int dx = -1; dx <= 1; dx++) {
+                        if (tx+dx < 0 || tx+dx >= tw)
+                            continue;
+
+                        uint8_t m = im_max[(ty+dy)*tw+tx+dx];
+                        if (m > max)
+                            max = m;
+                        m = im_min[(ty+dy)*tw+tx+dx];
+                        if (m < min)
+                            min = m;
+                    }
                 }
-            }
 
-            im_max_tmp[ty*tw + tx] = max;
-            im_min_tmp[ty*tw + tx] = min;
+                im_max_tmp[ty*tw + tx] = max;
+                im_min_tmp[ty*tw + tx] = min;
+            }
         }
-    }
-    free(im_max);
-    free(im_min);
+    });
     im_max = im_max_tmp;
     im_min = im_min_tmp;
 
-    for (int ty = 0; ty < th; ty++) {
-        for (int tx = 0; tx < tw; tx++) {
+    parallel_for_(Range(0, th), [&](const Range& range){
+        for (int ty = range.start; ty < range.end; ty++) {
+            for (int tx = 0; tx < tw; tx++) {
 
-            int min_ = im_min[ty*tw + tx];
-            int max_ = im_max[ty*tw + tx];
+                int min_ = im_min[ty*tw + tx];
+                int max_ = im_max[ty*tw + tx];
 
-            // low contrast region? (no edges)
-            if (max_ - min_ < parameters->aprilTagMinWhiteBlackDiff) {
-                for (int dy = 0; dy < tilesz; dy++) {
-                    int y = ty*tilesz + dy;
+                // low contrast region? (no edges)
+                if (max_ - min_ < parameters->aprilTagMinWhiteBlackDiff) {
+                    for (int dy = 0; dy < tilesz; dy++) {
+                        int y = ty*tilesz + dy;
 
-                    for (int dx = 0; dx < tilesz; dx++) {
-                        int x = tx*tilesz + dx;
+                        for (int dx = 0; dx < tilesz; dx++) {
+                            int x = tx*tilesz + dx;
 
-                        //threshim->buf[y*s+x] = 127;
-                        mThresh.data[y*s+x] = 127;
+                            //threshim->buf[y*s+x] = 127;
+                            mThresh.data[y*s+x] = 127;
+                        }
                     }
+                    continue;
                 }
-                continue;
-            }
 
-            // otherwise, actually threshold this tile.
+                // otherwise, actually threshold this tile.
 
-            // argument for biasing towards dark; specular highlights
-            // can be substantially brighter than white tag parts
-            uint8_t thresh = saturate_cast<uint8_t>((max_ + min_) / 2);
+                // argument for biasing towards dark; specular highlights
+                // can be substantially brighter than white tag parts
+                uint8_t thresh = saturate_cast<uint8_t>((max_ + min_) / 2);
 
-            for (int dy = 0; dy < tilesz; dy++) {
-                int y = ty*tilesz + dy;
+                for (int dy = 0; dy < tilesz; dy++) {
+                    int y = ty*tilesz + dy;
 
-                for (int dx = 0; dx < tilesz; dx++) {
-                    int x = tx*tilesz + dx;
+                    for (int dx = 0; dx < tilesz; dx++) {
+                        int x = tx*tilesz + dx;
 
-                    uint8_t v = mIm.data[y*s+x];
-                    mThresh.data[y*s+x] = (v > thresh) ? 255 : 0;
+                        uint8_t v = mIm.data[y*s+x];
+                        mThresh.data[y*s+x] = (v > thresh) ? 255 : 0;
+                    }
                 }
             }
         }
-    }
+    });
 
     // we skipped over the non-full-sized tiles above. Fix those now.
-    for (int y = 0; y < h; y++) {
+    parallel_for_(Range(0, h), [&](const Range& range){
+        for (int y = range.start; y < range.end; y++) {
 
-        // what is the first x coordinate we need to process in this row?
+            // what is the first x coordinate we need to process in this row?
 
-        int x0;
+            int x0;
 
-        if (y >= th*tilesz) {
-            x0 = 0; // we're at the bottom; do the whole row.
-        } else {
-            x0 = tw*tilesz; // we only need to do the right most part.
-        }
+            if (y >= th*tilesz) {
+                x0 = 0; // we're at the bottom; do the whole row.
+            } else {
+                x0 = tw*tilesz; // we only need to do the right most part.
+            }
 
-        // compute tile coordinates and clamp.
-        int ty = y / tilesz;
-        if (ty >= th)
-            ty = th - 1;
+            // compute tile coordinates and clamp.
+            int ty = y / tilesz;
+            if (ty >= th)
+                ty = th - 1;
 
-        for (int x = x0; x < w; x++) {
-            int tx = x / tilesz;
-            if (tx >= tw)
-                tx = tw - 1;
+            for (int x = x0; x < w; x++) {
+                int tx = x / tilesz;
+                if (tx >= tw)
+                    tx = tw - 1;
 
-            int max = im_max[ty*tw + tx];
-            int min = im_min[ty*tw + tx];
-            int thresh = min + (max - min) / 2;
+                int max = im_max[ty*tw + tx];
+                int min = im_min[ty*tw + tx];
+                int thresh = min + (max - min) / 2;
 
-            uint8_t v = mIm.data[y*s+x];
-            if (v > thresh){
-                mThresh.data[y*s+x] = 255;
-            }
-            else{
-                mThresh.data[y*s+x] = 0;
+                uint8_t v = mIm.data[y*s+x];
+                if (v > thresh){
+                    mThresh.data[y*s+x] = 255;
+                }
+                else{
+                    mThresh.data[y*s+x] = 0;
+                }
             }
         }
-    }
-    free(im_min);
-    free(im_max);
+    });
 
     // this is a dilate/erode deglitching scheme that does not improve
     // anything as far as I can tell.
-    if (parameters->aprilTagDeglitch) {
-        Mat tmp(h,w, mIm.type());
-        for (int y = 1; y + 1 < h; y++) {
-            for (int x = 1; x + 1 < w; x++) {
-                uint8_t max = 0;
-                for (int dy = -1; dy <= 1; dy++) {
-                    for (int dx = -1; dx <= 1; dx++) {
-                        uint8_t v = mThresh.data[(y+dy)*s + x + dx];
-                        if (v > max)
-                            max = v;
+    if (parameters->aprilTagDeglitch && h > 2) {
+        Mat tmp(h, w, mIm.type());
+        parallel_for_(Range(1, h - 1), [&](const Range& range){
+            for (int y = range.start; y < range.end; y++) {
+                for (int x = 1; x + 1 < w; x++) {
+                    uint8_t max = 0;
+                    for (int dy = -1; dy <= 1; dy++) {
+                        for (int dx = -1; dx <= 1; dx++) {
+                            uint8_t v = mThresh.data[(y+dy)*s + x + dx];
+                            if (v > max)
+                                max = v;
+                        }
                     }
+                    tmp.data[y*s+x] = max;
                 }
-                tmp.data[y*s+x] = max;
             }
-        }
-
-        for (int y = 1; y + 1 < h; y++) {
-            for (int x = 1; x + 1 < w; x++) {
-                uint8_t min = 255;
-                for (int dy = -1; dy <= 1; dy++) {
-                    for (int dx = -1; dx <= 1; dx++) {
-                        uint8_t v = tmp.data[(y+dy)*s + x + dx];
-                        if (v < min)
-                            min = v;
+        });
+
+        parallel_for_(Range(1, h - 1), [&](const Range& range){
+            for (int y = range.start; y < range.end; y++) {
+                for (int x = 1; x + 1 < w; x++) {
+                    uint8_t min = 255;
+                    for (int dy = -1; dy <= 1; dy++) {
+                        for (int dx = -1; dx <= 1; dx++) {
+                            uint8_t v = tmp.data[(y+dy)*s + x + dx];
+                            if (v < min)
+                                min = v;
+                        }
                     }
+                    mThresh.data[y*s+x] = min;
                 }
-                mThresh.data[y*s+x] = min;
             }
-        }
+        });
     }
 
 }
@@ -1319,8 +1303,10 @@ zarray_t *apriltag_quad_thresh(const Ptr<DetectorParameters> &parameters, const
     // step 1. threshold the image, creating the edge image.
 
     int w = mImg.cols, h = mImg.rows;
+    apriltag_buffers buffers;
 
-    Mat thold(h, w, mImg.type());
+    Mat &thold = buffers.thold;
+    thold.create(h, w, mImg.type());
     threshold(mImg, parameters, thold);
 
     int ts = thold.cols;
@@ -1332,94 +1318,168 @@ zarray_t *apriltag_quad_thresh(const Ptr<DetectorParameters> &parameters, const
     ////////////////////////////////////////////////////////
     // step 2. find connected components.
 
-    unionfind_t *uf = unionfind_create(w * h);
+    // The rows are split in blocks. The lines inside a block only connect
+    // pixels of that block, so the blocks are processed in parallel; then
+    // the lines on the seams between blocks merge them.
+    const int nblocks = (h + APRILTAG_BLOCK_ROWS - 1) / APRILTAG_BLOCK_ROWS;
+
+    buffers.uf_data.resize((size_t)w * h + 1);
+    unionfind_t ufs;
+    ufs.maxid = w * h;
+    ufs.data = &buffers.uf_data[0];
+    unionfind_t *uf = &ufs;
+
+    parallel_for_(Range(0, nblocks), [&](const Range& range){
+        for (int b = range.start; b < range.end; b++) {
+            int y0 = b * APRILTAG_BLOCK_ROWS;
+            int y1 = std::min(y0 + APRILTAG_BLOCK_ROWS, h);
+
+            for (uint32_t i = (uint32_t)y0 * w; i < (uint32_t)y1 * w; i++) {
+                uf->data[i].size = 1;
+                uf->data[i].parent = i;
+            }
+
+            for (int y = y0; y < y1 - 1; y++) {
+                do_unionfind_line(uf, thold, w, ts, y);
+            }
+        }
+    });
 
-    // TODO PARALLELIZE
-    for (int y = 0; y < h - 1; y++) {
-        do_unionfind_line(uf, thold, w, ts, y);
+    for (int b = 1; b < nblocks; b++) {
+        do_unionfind_line(uf, thold, w, ts, b * APRILTAG_BLOCK_ROWS - 1);
     }
 
-    // XXX sizing??
-    int nclustermap = 2*w*h - 1;
+    // flatten the trees, so that the clustering only reads the labels
+    buffers.labels.resize((size_t)w * h);
+    uint32_t *labels = &buffers.labels[0];
+    parallel_for_(Range(0, nblocks), [&](const Range& range){
+        for (uint32_t i = (uint32_t)range.start * APRILTAG_BLOCK_ROWS * w;
+             i < (uint32_t)std::min(range.end * APRILTAG_BLOCK_ROWS, h) * w; i++) {
+            uint32_t root = i;
+            while (uf->data[root].parent != root)
+                root = uf->data[root].parent;
+            labels[i] = root;
+        }
+    });
 
-    struct uint64_zarray_entry **clustermap = (struct uint64_zarray_entry**)calloc(nclustermap, sizeof(struct uint64_zarray_entry*));
+    // Collect the boundary points of every block, hashed by the ids of the
+    // two components they separate.
+    buffers.block_pts.resize(nblocks * APRILTAG_CLUSTER_PARTITIONS);
 
-    for (int y = 1; y < h-1; y++) {
-        for (int x = 1; x < w-1; x++) {
+    parallel_for_(Range(0, nblocks), [&](const Range& range){
+        for (int b = range.start; b < range.end; b++) {
+            std::vector<struct cluster_pt> *block_pts = &buffers.block_pts[b * APRILTAG_CLUSTER_PARTITIONS];
+            for (int k = 0; k < APRILTAG_CLUSTER_PARTITIONS; k++)
+                block_pts[k].clear();
 
-            uint8_t v0 = thold.data[y*ts + x];
-            if (v0 == 127)
-                continue;
+            int y0 = std::max(b * APRILTAG_BLOCK_ROWS, 1);
+            int y1 = std::min((b + 1) * APRILTAG_BLOCK_ROWS, h - 1);
+            for (int y = y0; y < y1; y++) {
+                for (int x = 1; x < w-1; x++) {
 
-            // XXX don't query this until we know we need it?
-            uint64_t rep0 = unionfind_get_representative(uf, y*w + x);
+                    uint8_t v0 = thold.data[y*ts + x];
+                    if (v0 == 127)
+                        continue;
 
-            // whenever we find two adjacent pixels such that one is
-            // white and the other black, we add the point half-way
-            // between them to a cluster associated with the unique
-            // ids of the white and black regions.
-            //
-            // We additionally compute the gradient direction (i.e., which
-            // direction was the white pixel?) Note: if (v1-v0) == 255, then
-            // (dx,dy) points towards the white pixel. if (v1-v0) == -255, then
-            // (dx,dy) points towards the black pixel. p.gx and p.gy will thus
-            // be -255, 0, or 255.
-            //
-            // Note that any given pixel might be added to multiple
-            // different clusters. But in the common case, a given
-            // pixel will be added multiple times to the same cluster,
-            // which increases the size of the cluster and thus the
-            // computational costs.
-            //
-            // A possible optimization would be to combine entries
-            // within the same cluster.
-
-#define DO_CONN(dx, dy)                                                 \
-        if (1) {                                                    \
-            uint8_t v1 = thold.data[y*ts + dy*ts + x + dx];         \
-            \
-            if (v0 + v1 == 255) {                                   \
-                uint64_t rep1 = unionfind_get_representative(uf, y*w + dy*w + x + dx); \
-                uint64_t clusterid;                                 \
-                if (rep0 < rep1)                                    \
-                clusterid = (rep1 << 32) + rep0;                \
-                else                                                \
-                clusterid = (rep0 << 32) + rep1;                \
-                \
-                /* XXX lousy hash function */                       \
-        uint32_t clustermap_bucket = u64hash_2(clusterid) % nclustermap; \
-        struct uint64_zarray_entry *entry = clustermap[clustermap_bucket]; \
-        while (entry && entry->id != clusterid)     {       \
-            entry = entry->next;                            \
-        }                                                   \
-        \
-        if (!entry) {                                       \
-            entry = (struct uint64_zarray_entry*)calloc(1, sizeof(struct uint64_zarray_entry)); \
-            entry->id = clusterid;                          \
-            entry->cluster = _zarray_create(sizeof(struct pt)); \
-            entry->next = clustermap[clustermap_bucket];    \
-            clustermap[clustermap_bucket] = entry;          \
-        }                                                   \
-        \
-        struct pt p;                                        \
-        p.x = saturate_cast<uint16_t>(2*x + dx);            \
-        p.y = saturate_cast<uint16_t>(2*y + dy);            \
-        p.gx = saturate_cast<uint16_t>(dx*((int) v1-v0));   \
-        p.gy = saturate_cast<uint16_t>(dy*((int) v1-v0));   \
-        _zarray_add(entry->cluster, &p);                    \
-        }                                                   \
-    }
+                    uint64_t rep0 = labels[y*w + x];
+
+                    // whenever we find two adjacent pixels such that one is
+                    // white and the other black, we add the point half-way
+                    // between them to a cluster associated with the unique
+                    // ids of the white and black regions.
+                    //
+                    // We additionally compute the gradient direction (i.e., which
+                    // direction was the white pixel?) Note: if (v1-v0) == 255, then
+                    // (dx,dy) points towards the white pixel. if (v1-v0) == -255, then
+                    // (dx,dy) points towards the black pixel. p.gx and p.gy will thus
+                    // be -255, 0, or 255.
+                    //
+                    // Note that any given pixel might be added to multiple
+                    // different clusters. But in the common case, a given
+                    // pixel will be added multiple times to the same cluster,
+                    // which increases the size of the cluster and thus the
+                    // computational costs.
+                    //
+                    // A possible optimization would be to combine entries
+                    // within the same cluster.
+
+#define DO_CONN(dx, dy)                                                         \
+                    if (1) {                                                    \
+                        uint8_t v1 = thold.data[y*ts + dy*ts + x + dx];         \
+                                                                                \
+                        if (v0 + v1 == 255) {                                   \
+                            uint64_t rep1 = labels[y*w + dy*w + x + dx];        \
+                            struct cluster_pt cp;                               \
+                            if (rep0 < rep1)                                    \
+                                cp.id = (rep1 << 32) + rep0;                    \
+                            else                                                \
+                                cp.id = (rep0 << 32) + rep1;                    \
+                            cp.p.x = saturate_cast<uint16_t>(2*x + dx);         \
+                            cp.p.y = saturate_cast<uint16_t>(2*y + dy);         \
+                            cp.p.theta = 0;                                     \
+                            cp.p.gx = saturate_cast<uint16_t>(dx*((int) v1-v0)); \
+                            cp.p.gy = saturate_cast<uint16_t>(dy*((int) v1-v0)); \
+                            uint32_t partition = u64hash_2(cp.id) & (APRILTAG_CLUSTER_PARTITIONS - 1); \
+                            block_pts[partition].push_back(cp);                 \
+                        }                                                       \
+                    }
 
-    // do 4 connectivity. NB: Arguments must be [-1, 1] or we'll overflow .gx, .gy
-    DO_CONN(1, 0);
-    DO_CONN(0, 1);
+                    // do 4 connectivity. NB: Arguments must be [-1, 1] or we'll overflow .gx, .gy
+                    DO_CONN(1, 0);
+                    DO_CONN(0, 1);
 
-    // do 8 connectivity
-    DO_CONN(-1, 1);
-    DO_CONN(1, 1);
-}
-}
+                    // do 8 connectivity
+                    DO_CONN(-1, 1);
+                    DO_CONN(1, 1);
 #undef DO_CONN
+                }
+            }
+        }
+    });
+
+    // Group the points of every partition into clusters. Blocks are visited
+    // in order, so the points of a cluster keep the row-major scan order.
+    buffers.tables.resize(APRILTAG_CLUSTER_PARTITIONS);
+
+    parallel_for_(Range(0, APRILTAG_CLUSTER_PARTITIONS), [&](const Range& range){
+        for (int k = range.start; k < range.end; k++) {
+            struct cluster_table &table = buffers.tables[k];
+
+            size_t npts = 0;
+            for (int b = 0; b < nblocks; b++)
+                npts += buffers.block_pts[b * APRILTAG_CLUSTER_PARTITIONS + k].size();
+
+            size_t nheads = 16;
+            while (nheads < 2 * npts)
+                nheads *= 2;
+            table.heads.assign(nheads, -1);
+            table.ids.clear();
+            table.next.clear();
+            table.nclusters = 0;
+
+            for (int b = 0; b < nblocks; b++) {
+                const std::vector<struct cluster_pt> &pts = buffers.block_pts[b * APRILTAG_CLUSTER_PARTITIONS + k];
+                for (size_t i = 0; i < pts.size(); i++) {
+                    // the low bits of the hash selected the partition
+                    size_t head = (u64hash_2(pts[i].id) / APRILTAG_CLUSTER_PARTITIONS) & (nheads - 1);
+                    int c = table.heads[head];
+                    while (c >= 0 && table.ids[c] != pts[i].id)
+                        c = table.next[c];
+
+                    if (c < 0) {
+                        c = table.nclusters++;
+                        table.ids.push_back(pts[i].id);
+                        table.next.push_back(table.heads[head]);
+                        table.heads[head] = c;
+                        if ((int)table.clusters.size() < table.nclusters)
+                            table.clusters.resize(table.nclusters);
+                        table.clusters[c].clear();
+                    }
+                    table.clusters[c].push_back(pts[i].p);
+                }
+            }
+        }
+    });
 
 #ifdef APRIL_DEBUG
 Mat out = Mat::zeros(h, w, CV_8UC3);
@@ -1428,7 +1488,7 @@ uint32_t *colors = (uint32_t*) calloc(w*h, sizeof(*colors));
 
 for (int y = 0; y < h; y++) {
     for (int x = 0; x < w; x++) {
-        uint32_t v = unionfind_get_representative(uf, y*w+x);
+        uint32_t v = labels[y*w+x];
 
         if (unionfind_get_set_size(uf, v) < parameters->aprilTagMinClusterPixels)
             continue;
@@ -1457,20 +1517,21 @@ out = Mat::zeros(h, w, CV_8UC3);
 
     ////////////////////////////////////////////////////////
     // step 3. process each connected component.
-    zarray_t *clusters = _zarray_create(sizeof(zarray_t*)); //, uint64_zarray_hash_size(clustermap));
-    CV_Assert(clusters != NULL);
+    std::vector< std::vector<struct pt>* > &clusters = buffers.clusters;
+    clusters.clear();
 
-    for (int i = 0; i < nclustermap; i++) {
-        for (struct uint64_zarray_entry *entry = clustermap[i]; entry; entry = entry->next) {
+    for (int k = 0; k < APRILTAG_CLUSTER_PARTITIONS; k++) {
+        struct cluster_table &table = buffers.tables[k];
+        for (int c = 0; c < table.nclusters; c++) {
             // XXX reject clusters here?
-            _zarray_add(clusters, &entry->cluster);
+            clusters.push_back(&table.clusters[c]);
         }
     }
+    int sz = (int)clusters.size();
 
 #ifdef APRIL_DEBUG
-for (int i = 0; i < _zarray_size(clusters); i++) {
-    zarray_t *cluster;
-    _zarray_get(clusters, i, &cluster);
+for (int i = 0; i < sz; i++) {
+    std::vector<struct pt> &cluster = *clusters[i];
 
     uint32_t r, g, b;
 
@@ -1479,9 +1540,8 @@ for (int i = 0; i < _zarray_size(clusters); i++) {
     g = bias + (random() % (200-bias));
     b = bias + (random() % (200-bias));
 
-    for (int j = 0; j < _zarray_size(cluster); j++) {
-        struct pt *p;
-        _zarray_get_volatile(cluster, j, &p);
+    for (size_t j = 0; j < cluster.size(); j++) {
+        struct pt *p = &cluster[j];
 
         int x = p->x / 2;
         int y = p->y / 2;
@@ -1495,41 +1555,47 @@ imwrite("2.4 debug_clusters.pnm", out);
 out = Mat::zeros(h, w, CV_8UC3);
 #endif
 
-    for (int i = 0; i < _zarray_size(clusters); i++) {
-        zarray_t *cluster;
-        _zarray_get(clusters, i, &cluster);
+    // the contours are taken before fit_quad sorts the clusters
+    size_t ncontours = contours.size();
+    contours.resize(ncontours + sz);
 
-        std::vector< Point > cnt;
-        for (int j = 0; j < _zarray_size(cluster); j++) {
-            struct pt *p;
-            _zarray_get_volatile(cluster, j, &p);
+    buffers.quads.resize(std::max(sz, 1));
+    buffers.quad_ok.resize(std::max(sz, 1));
 
-            Point pnt(p->x, p->y);
-            cnt.push_back(pnt);
-        }
-        contours.push_back(cnt);
-    }
+    parallel_for_(Range(0, sz), [&](const Range& range){
+        for (int i = range.start; i < range.end; i++) {
+            std::vector<struct pt> &cluster = *clusters[i];
 
-    for (int i = 0; i < nclustermap; i++) {
-        struct uint64_zarray_entry *entry = clustermap[i];
-        while (entry) {
-            struct uint64_zarray_entry *tmp = entry->next;
-            free(entry);
-            entry = tmp;
-        }
-    }
-    free(clustermap);
+            std::vector< Point > &cnt = contours[ncontours + i];
+            cnt.resize(cluster.size());
+            for (size_t j = 0; j < cluster.size(); j++)
+                cnt[j] = Point(cluster[j].x, cluster[j].y);
 
-    zarray_t *quads = _zarray_create(sizeof(struct sQuad));
+            buffers.quad_ok[i] = 0;
+
+            if ((int)cluster.size() < parameters->aprilTagMinClusterPixels)
+                continue;
+
+            // a cluster should contain only boundary points around the
+            // tag. it cannot be bigger than the whole screen. (Reject
+            // large connected blobs that will be prohibitively slow to
+            // fit quads to.) A typical point along an edge is added three
+            // times (because it has 3 neighbors). The maximum perimeter
+            // is 2w+2h.
+            if ((int)cluster.size() > 3*(2*w+2*h))
+                continue;
 
-    //int chunksize = 1 + sz / (APRILTAG_TASKS_PER_THREAD_TARGET * numberOfThreads);
-    int chunksize = h / (10 * getNumThreads());
-    int sz = _zarray_size(clusters);
+            struct sQuad &quad = buffers.quads[i];
+            memset(&quad, 0, sizeof(struct sQuad));
 
-    // TODO PARALLELIZE
-    for (int i = 0; i < sz; i += chunksize) {
-        int min = sz < (i+chunksize)? sz: (i+chunksize);
-        do_quad(i, min, *clusters, w, h, quads, parameters, mImg);
+            buffers.quad_ok[i] = (uchar)(fit_quad(parameters, mImg, cluster, &quad) != 0);
+        }
+    });
+
+    zarray_t *quads = _zarray_create(sizeof(struct sQuad));
+    for (int i = 0; i < sz; i++) {
+        if (buffers.quad_ok[i])
+            _zarray_add(quads, &buffers.quads[i]);
     }
 
 #ifdef APRIL_DEBUG
@@ -1556,14 +1622,6 @@ for (int i = 0; i < _zarray_size(quads); i++) {
 imwrite("2.5 debug_lines.pnm", out);
 #endif
 
-    unionfind_destroy(uf);
-
-    for (int i = 0; i < _zarray_size(clusters); i++) {
-        zarray_t *cluster;
-        _zarray_get(clusters, i, &cluster);
-        _zarray_destroy(cluster);
-    }
-    _zarray_destroy(clusters);
     return quads;
 }
 
@@ -19,6 +19,8 @@
 #ifndef _OPENCV_APRIL_QUAD_THRESH_HPP_
 #define _OPENCV_APRIL_QUAD_THRESH_HPP_
 
+#include <vector>
+
 #include "opencv2/aruco.hpp"
 #include "unionfind.hpp"
 #include "zmaxheap.hpp"
@@ -31,13 +33,6 @@ static inline uint32_t u64hash_2(uint64_t x) {
     return uint32_t((2654435761UL * x) >> 32);
 }
 
-struct uint64_zarray_entry{
-    uint64_t id;
-    zarray_t *cluster;
-
-    struct uint64_zarray_entry *next;
-};
-
 struct pt{
     // Note: these represent 2*actual value.
     uint16_t x, y;
@@ -102,7 +97,7 @@ int quad_segment_agg(int sz, struct line_fit_pt *lfps, int indices[4]);
  *  return 1 if the quad looks okay, 0 if it should be discarded
  *  quad
  **/
-int fit_quad(const Ptr<DetectorParameters> &_params, const Mat im, zarray_t *cluster, struct sQuad *quad);
+int fit_quad(const Ptr<DetectorParameters> &_params, const Mat im, std::vector<struct pt> &cluster, struct sQuad *quad);
 
 /**
  *
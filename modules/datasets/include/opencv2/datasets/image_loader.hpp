@@ -0,0 +1,96 @@
+// This file is part of OpenCV project.
+// It is subject to the license terms in the LICENSE file found in the top-level directory
+// of this distribution and at http://opencv.org/license.html.
+
+#ifndef OPENCV_DATASETS_IMAGE_LOADER_HPP
+#define OPENCV_DATASETS_IMAGE_LOADER_HPP
+
+#include <string>
+#include <vector>
+
+#include <opencv2/core.hpp>
+
+namespace cv
+{
+namespace datasets
+{
+
+//! @addtogroup datasets
+//! @{
+
+/** @brief Iterates over the images of a dataset, decoding them lazily in background threads.
+
+Datasets only store image paths (e.g. OR_imagenetObj::image, SLAM_kittiObj::images). The loader
+decodes them with imread on a pool of worker threads, keeping at most Params::prefetch decoded
+images ahead of the consumer, and returns them in a fixed order: the order of the file list, or a
+shuffled one fully determined by Params::seed and the epoch number.
+
+Decoded (and resized) images can be stored in Params::cacheDir. Cache files hold a small header
+followed by the raw pixel data, so later epochs or runs skip decoding and the files can be memory
+mapped. Entries depend on the modification time and size of the source file, edited images are
+decoded again. Usage example:
+~~~
+Ptr<OR_imagenet> dataset = OR_imagenet::create();
+dataset->load(path);
+vector<string> files;
+vector< Ptr<Object> > &val = dataset->getValidation();
+for (size_t i = 0; i < val.size(); ++i)
+    files.push_back(path + static_cast<OR_imagenetObj *>(val[i].get())->image);
+
+ImageLoader::Params params;
+params.size = Size(224, 224);
+Ptr<ImageLoader> loader = ImageLoader::create(files, params);
+Mat img;
+int index;
+while (loader->next(img, index))
+{
+    // img is the image of val[index]
+}
+~~~
+ */
+class CV_EXPORTS ImageLoader
+{
+public:
+    struct CV_EXPORTS Params
+    {
+        Params();
+
+        int numThreads;         //!< number of decoding threads, -1 for cv::getNumThreads()
+        int prefetch;           //!< maximum number of decoded images waiting to be read, -1 for 2*numThreads
+        int flags;              //!< imread flags
+        Size size;              //!< images are resized to this size, empty size keeps the original one
+        bool shuffle;           //!< shuffle samples, with a new permutation each epoch
+        uint64 seed;            //!< seed of the shuffling
+        std::string cacheDir;   //!< directory of the decoded images cache, empty to disable caching
+    };
+
+    virtual ~ImageLoader() {}
+
+    /** @brief Get the next image.
+    @param image decoded image, empty if the file could not be read.
+    @param index position of the image in the file list passed to create().
+
+    Returns false at the end of the epoch. Errors other than unreadable files (e.g. out of memory) in
+    the decoding threads are raised here, after the image has been consumed.
+     */
+    virtual bool next(Mat &image, int &index) = 0;
+
+    /** @brief Start a new epoch. Shuffled loaders draw a new permutation.
+     */
+    virtual void reset() = 0;
+
+    //! Number of images in an epoch.
+    virtual int getNumImages() const = 0;
+
+    //! Current epoch, starting from 0.
+    virtual int getEpoch() const = 0;
+
+    static Ptr<ImageLoader> create(const std::vector<std::string> &files, const Params &params = Params());
+};
+
+//! @}
+
+}
+}
+
+#endif
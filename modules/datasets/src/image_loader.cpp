@@ -0,0 +1,350 @@
+// This file is part of OpenCV project.
+// It is subject to the license terms in the LICENSE file found in the top-level directory
+// of this distribution and at http://opencv.org/license.html.
+
+#include "opencv2/datasets/image_loader.hpp"
+#include "opencv2/datasets/util.hpp"
+
+#include <opencv2/imgcodecs.hpp>
+#include <opencv2/imgproc.hpp>
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#include <sys/types.h>
+#include <sys/stat.h>
+
+namespace cv
+{
+namespace datasets
+{
+
+using namespace std;
+
+ImageLoader::Params::Params() :
+    numThreads(-1), prefetch(-1), flags(IMREAD_COLOR), size(), shuffle(false), seed(0)
+{
+}
+
+// cache file layout: header followed by the continuous pixel data, aligned to 32 bytes
+struct CacheHeader
+{
+    char magic[8];
+    uint64 key;
+    int rows, cols, type, reserved;
+};
+
+static const char cacheMagic[8] = { 'C', 'V', 'D', 'S', 'I', 'M', 'G', '1' };
+
+class ImageLoaderImp CV_FINAL : public ImageLoader
+{
+public:
+    ImageLoaderImp(const vector<string> &files, const Params &params);
+    virtual ~ImageLoaderImp() CV_OVERRIDE;
+
+    virtual bool next(Mat &image, int &index) CV_OVERRIDE;
+    virtual void reset() CV_OVERRIDE;
+    virtual int getNumImages() const CV_OVERRIDE { return (int)files.size(); }
+    virtual int getEpoch() const CV_OVERRIDE { return epoch; }
+
+private:
+    // decodes the image at position pos of the epoch, returns an empty image if it can't be read,
+    // other failures (e.g. out of memory) are reported in error instead of being thrown
+    Mat loadImage(int pos, string &error) const;
+    bool cacheKey(int fileIndex, uint64 &key) const;
+    string cachePath(uint64 key) const;
+    bool readCache(const string &path, uint64 key, Mat &image) const;
+    void writeCache(const string &path, uint64 key, const Mat &image, int pos) const;
+
+    void startEpoch();
+    void stopWorkers();
+
+    vector<string> files;
+    Params params;
+    // makes the temporary cache files of concurrent loaders distinct
+    string tmpSuffix;
+    vector<int> order;
+    int epoch;
+    int consumed;
+
+    // ring of prefetched images, position pos is stored in slot pos % prefetch
+    struct Slot
+    {
+        Slot() : pos(-1) {}
+        Mat image;
+        string error;
+        int pos;
+    };
+    vector<Slot> slots;
+    int claimed;
+
+    void worker();
+
+    vector<thread> workers;
+    mutex lock;
+    condition_variable spaceAvailable, imageReady;
+    bool stopping;
+};
+
+ImageLoaderImp::ImageLoaderImp(const vector<string> &files_, const Params &params_) :
+    files(files_), params(params_), epoch(0), consumed(0), claimed(0), stopping(false)
+{
+    CV_Assert(params.numThreads == -1 || params.numThreads > 0);
+    CV_Assert(params.prefetch == -1 || params.prefetch > 0);
+    CV_Assert(params.size.width >= 0 && params.size.height >= 0);
+
+    if (params.numThreads < 0)
+        params.numThreads = max(getNumThreads(), 1);
+    if (params.prefetch < 0)
+        params.prefetch = 2*params.numThreads;
+    tmpSuffix = cv::format(".%p.%llx", (const void *)this, (unsigned long long)getTickCount());
+    if (!params.cacheDir.empty())
+    {
+        createDirectory(params.cacheDir);
+        char last = params.cacheDir[params.cacheDir.size()-1];
+        if (last != '/' && last != '\\')
+            params.cacheDir += "/";
+    }
+
+    startEpoch();
+}
+
+ImageLoaderImp::~ImageLoaderImp()
+{
+    stopWorkers();
+}
+
+bool ImageLoaderImp::cacheKey(int fileIndex, uint64 &key) const
+{
+    // the file is not cached when it can't be stat'ed
+    const string &name = files[fileIndex];
+    struct stat info;
+    if (stat(name.c_str(), &info) != 0)
+        return false;
+
+    // FNV-1a of everything the cached image depends on, the modification time and the size
+    // of the file make edited images miss the cache
+    key = 14695981039346656037ULL;
+    for (size_t i = 0; i < name.size(); ++i)
+        key = (key ^ (uchar)name[i]) * 1099511628211ULL;
+    const uint64 extra[5] = { (uint64)(int64)info.st_mtime, (uint64)(int64)info.st_size,
+                              (uint64)(unsigned)params.flags, (uint64)(unsigned)params.size.width,
+                              (uint64)(unsigned)params.size.height };
+    for (int i = 0; i < 5; ++i)
+        key = (key ^ extra[i]) * 1099511628211ULL;
+    return true;
+}
+
+string ImageLoaderImp::cachePath(uint64 key) const
+{
+    return params.cacheDir + cv::format("%08x%08x.bin", (unsigned)(key >> 32), (unsigned)(key & 0xffffffffu));
+}
+
+bool ImageLoaderImp::readCache(const string &path, uint64 key, Mat &image) const
+{
+    ifstream infile(path.c_str(), ios::binary | ios::ate);
+    if (!infile.is_open())
+        return false;
+    const uint64 fileSize = (uint64)infile.tellg();
+    infile.seekg(0);
+
+    // truncated or corrupted entries are ignored, the image is decoded again
+    CacheHeader header;
+    if (fileSize < sizeof(header) || !infile.read((char *)&header, sizeof(header)) ||
+        memcmp(header.magic, cacheMagic, sizeof(cacheMagic)) != 0 || header.key != key ||
+        header.type < 0 || header.type != CV_MAT_TYPE(header.type) ||
+        header.rows <= 0 || header.cols <= 0 ||
+        (uint64)header.rows*(uint64)header.cols*CV_ELEM_SIZE(header.type) != fileSize - sizeof(header))
+    {
+        return false;
+    }
+
+    image.create(header.rows, header.cols, header.type);
+    if (!infile.read((char *)image.data, image.total()*image.elemSize()))
+    {
+        image.release();
+        return false;
+    }
+    return true;
+}
+
+void ImageLoaderImp::writeCache(const string &path, uint64 key, const Mat &image, int pos) const
+{
+    CV_Assert(image.isContinuous());
+
+    CacheHeader header;
+    memcpy(header.magic, cacheMagic, sizeof(cacheMagic));
+    header.key = key;
+    header.rows = image.rows;
+    header.cols = image.cols;
+    header.type = image.type();
+    header.reserved = 0;
+
+    // write to a private file first, so that readers never see partial images
+    string tmpPath = path + tmpSuffix + cv::format(".%d.tmp", pos);
+    bool ok;
+    {
+        ofstream outfile(tmpPath.c_str(), ios::binary);
+        outfile.write((const char *)&header, sizeof(header));
+        outfile.write((const char *)image.data, image.total()*image.elemSize());
+        ok = outfile.good();
+    }
+    if (!ok || rename(tmpPath.c_str(), path.c_str()) != 0)
+        remove(tmpPath.c_str());
+}
+
+Mat ImageLoaderImp::loadImage(int pos, string &error) const
+{
+    const int fileIndex = order[pos];
+    Mat image;
+    try
+    {
+        uint64 key = 0;
+        string path;
+        if (!params.cacheDir.empty() && cacheKey(fileIndex, key))
+        {
+            path = cachePath(key);
+            if (readCache(path, key, image))
+                return image;
+        }
+
+        image = imread(files[fileIndex], params.flags);
+        if (image.empty())
+            return image;
+
+        if (params.size.area() > 0 && image.size() != params.size)
+        {
+            Mat resized;
+            bool shrink = params.size.width < image.cols && params.size.height < image.rows;
+            resize(image, resized, params.size, 0, 0, shrink ? INTER_AREA : INTER_LINEAR);
+            image = resized;
+        }
+
+        if (!path.empty())
+            writeCache(path, key, image, pos);
+    }
+    catch (const cv::Exception &)
+    {
+        image.release();
+    }
+    catch (const std::exception &e)
+    {
+        image.release();
+        error = e.what();
+    }
+    catch (...)
+    {
+        image.release();
+        error = "unknown exception";
+    }
+    return image;
+}
+
+void ImageLoaderImp::startEpoch()
+{
+    const int n = (int)files.size();
+    order.resize(n);
+    for (int i = 0; i < n; ++i)
+        order[i] = i;
+
+    if (params.shuffle)
+    {
+        // Fisher-Yates with cv::RNG, identical permutations on every platform
+        RNG rng(params.seed + (uint64)epoch*0x9E3779B97F4A7C15ULL);
+        for (int i = n - 1; i > 0; --i)
+            std::swap(order[i], order[rng.uniform(0, i + 1)]);
+    }
+
+    consumed = 0;
+    claimed = 0;
+    slots.assign(params.prefetch, Slot());
+
+    stopping = false;
+    int numWorkers = min(params.numThreads, n);
+    for (int i = 0; i < numWorkers; ++i)
+        workers.push_back(thread(&ImageLoaderImp::worker, this));
+}
+
+void ImageLoaderImp::stopWorkers()
+{
+    {
+        lock_guard<mutex> guard(lock);
+        stopping = true;
+    }
+    spaceAvailable.notify_all();
+    for (size_t i = 0; i < workers.size(); ++i)
+        workers[i].join();
+    workers.clear();
+}
+
+void ImageLoaderImp::worker()
+{
+    const int n = (int)files.size();
+    for (;;)
+    {
+        int pos;
+        {
+            unique_lock<mutex> guard(lock);
+            spaceAvailable.wait(guard, [&] { return stopping || claimed >= n || claimed < consumed + params.prefetch; });
+            if (stopping || claimed >= n)
+                return;
+            pos = claimed++;
+        }
+
+        string error;
+        Mat image = loadImage(pos, error);
+
+        {
+            lock_guard<mutex> guard(lock);
+            Slot &slot = slots[pos % params.prefetch];
+            slot.image = image;
+            slot.error = error;
+            slot.pos = pos;
+        }
+        imageReady.notify_all();
+    }
+}
+
+bool ImageLoaderImp::next(Mat &image, int &index)
+{
+    if (consumed >= (int)files.size())
+        return false;
+
+    string error;
+    {
+        unique_lock<mutex> guard(lock);
+        Slot &slot = slots[consumed % params.prefetch];
+        imageReady.wait(guard, [&] { return slot.pos == consumed; });
+        image = slot.image;
+        slot.image.release();
+        swap(error, slot.error);
+        slot.pos = -1;
+        index = order[consumed++];
+    }
+    spaceAvailable.notify_all();
+
+    // errors of the workers are raised in the consumer thread
+    if (!error.empty())
+        CV_Error(Error::StsError, "Failed to load " + files[index] + ": " + error);
+    return true;
+}
+
+void ImageLoaderImp::reset()
+{
+    stopWorkers();
+    ++epoch;
+    startEpoch();
+}
+
+Ptr<ImageLoader> ImageLoader::create(const vector<string> &files, const Params &params)
+{
+    return Ptr<ImageLoaderImp>(new ImageLoaderImp(files, params));
+}
+
+}
+}
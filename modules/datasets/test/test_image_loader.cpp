@@ -0,0 +1,260 @@
+// This file is part of OpenCV project.
+// It is subject to the license terms in the LICENSE file found in the top-level directory
+// of this distribution and at http://opencv.org/license.html.
+#include "test_precomp.hpp"
+
+#include <fstream>
+
+namespace opencv_test { namespace {
+
+using namespace cv::datasets;
+
+static Mat loadSingle(const string &file, const string &cacheDir)
+{
+    ImageLoader::Params params;
+    params.numThreads = 1;
+    params.cacheDir = cacheDir;
+    Ptr<ImageLoader> loader = ImageLoader::create(vector<string>(1, file), params);
+
+    Mat image;
+    int index = -1;
+    EXPECT_TRUE(loader->next(image, index));
+    EXPECT_EQ(0, index);
+    EXPECT_FALSE(loader->next(image, index));
+    return image;
+}
+
+static Mat randomImage(Size size, uint64 seed)
+{
+    Mat image(size, CV_8UC3);
+    RNG rng(seed);
+    rng.fill(image, RNG::UNIFORM, 0, 256);
+    return image;
+}
+
+// overwrite the end of the pixel data of the single cache entry of cacheDir
+static void tamperCacheEntry(const string &cacheDir)
+{
+    vector<string> entries;
+    getDirList(cacheDir, entries);
+    ASSERT_EQ(1u, entries.size());
+
+    string path = cacheDir + "/" + entries[0];
+    std::fstream entry(path.c_str(), std::ios::in | std::ios::out | std::ios::binary);
+    entry.seekp(-16, std::ios::end);
+    entry.write(string(16, '\x7f').c_str(), 16);
+}
+
+TEST(Datasets_ImageLoader, cache_cold_and_warm)
+{
+    const string cacheDir = cv::tempfile("datasets_cache");
+    const string file = cv::tempfile(".png");
+    ASSERT_TRUE(cv::utils::fs::createDirectories(cacheDir));
+
+    Mat original = randomImage(Size(64, 48), 1);
+    ASSERT_TRUE(imwrite(file, original));
+
+    // cold: decoded and stored in the cache
+    Mat cold = loadSingle(file, cacheDir);
+    EXPECT_EQ(0, cvtest::norm(original, cold, NORM_INF));
+
+    // warm: served from the cache, edits of the cache entry show up in the image
+    Mat warm = loadSingle(file, cacheDir);
+    EXPECT_EQ(0, cvtest::norm(original, warm, NORM_INF));
+
+    tamperCacheEntry(cacheDir);
+    Mat tampered = loadSingle(file, cacheDir);
+    EXPECT_GT(cvtest::norm(original, tampered, NORM_INF), 0);
+
+    cv::utils::fs::remove_all(cacheDir);
+    remove(file.c_str());
+}
+
+TEST(Datasets_ImageLoader, cache_invalidated_by_changed_file)
+{
+    const string cacheDir = cv::tempfile("datasets_cache");
+    const string file = cv::tempfile(".png");
+    ASSERT_TRUE(cv::utils::fs::createDirectories(cacheDir));
+
+    Mat original = randomImage(Size(64, 48), 1);
+    ASSERT_TRUE(imwrite(file, original));
+    loadSingle(file, cacheDir);
+
+    // a different size gives a different file size, even within the mtime resolution
+    Mat edited = randomImage(Size(80, 60), 2);
+    ASSERT_TRUE(imwrite(file, edited));
+
+    Mat loaded = loadSingle(file, cacheDir);
+    ASSERT_EQ(edited.size(), loaded.size());
+    EXPECT_EQ(0, cvtest::norm(edited, loaded, NORM_INF));
+
+    cv::utils::fs::remove_all(cacheDir);
+    remove(file.c_str());
+}
+
+TEST(Datasets_ImageLoader, corrupted_cache_entry_is_decoded_again)
+{
+    const string cacheDir = cv::tempfile("datasets_cache");
+    const string file = cv::tempfile(".png");
+    ASSERT_TRUE(cv::utils::fs::createDirectories(cacheDir));
+
+    Mat original = randomImage(Size(64, 48), 1);
+    ASSERT_TRUE(imwrite(file, original));
+    loadSingle(file, cacheDir);
+
+    // truncate the entry
+    vector<string> entries;
+    getDirList(cacheDir, entries);
+    ASSERT_EQ(1u, entries.size());
+    {
+        std::ofstream entry((cacheDir + "/" + entries[0]).c_str(), std::ios::binary | std::ios::trunc);
+        entry.write("CVDSIMG1", 8);
+    }
+
+    Mat loaded = loadSingle(file, cacheDir);
+    EXPECT_EQ(0, cvtest::norm(original, loaded, NORM_INF));
+
+    cv::utils::fs::remove_all(cacheDir);
+    remove(file.c_str());
+}
+
+// writes n small images, the pixels of image i are all 10*i
+static vector<string> writeImages(const string &dir, int n)
+{
+    vector<string> files;
+    for (int i = 0; i < n; ++i)
+    {
+        string file = dir + cv::format("/%02d.png", i);
+        EXPECT_TRUE(imwrite(file, Mat(8, 8, CV_8UC3, Scalar::all(10*i))));
+        files.push_back(file);
+    }
+    return files;
+}
+
+// indices returned during one epoch, checking that every image matches its index
+static vector<int> readEpoch(ImageLoader &loader)
+{
+    vector<int> indices;
+    Mat image;
+    int index = -1;
+    while (loader.next(image, index))
+    {
+        EXPECT_FALSE(image.empty());
+        if (!image.empty())
+            EXPECT_EQ(10*index, image.at<Vec3b>(0, 0)[0]);
+        indices.push_back(index);
+    }
+    return indices;
+}
+
+static vector<int> readEpoch(const vector<string> &files, const ImageLoader::Params &params)
+{
+    Ptr<ImageLoader> loader = ImageLoader::create(files, params);
+    return readEpoch(*loader);
+}
+
+static bool isPermutation(vector<int> indices, int n)
+{
+    std::sort(indices.begin(), indices.end());
+    for (int i = 0; i < (int)indices.size(); ++i)
+        if (indices[i] != i)
+            return false;
+    return (int)indices.size() == n;
+}
+
+TEST(Datasets_ImageLoader, shuffle_is_deterministic)
+{
+    const string dir = cv::tempfile("datasets_images");
+    ASSERT_TRUE(cv::utils::fs::createDirectories(dir));
+    const int n = 20;
+    vector<string> files = writeImages(dir, n);
+
+    ImageLoader::Params params;
+    params.numThreads = 2;
+    params.shuffle = true;
+    params.seed = 42;
+    vector<int> first = readEpoch(files, params);
+    vector<int> second = readEpoch(files, params);
+    EXPECT_TRUE(isPermutation(first, n));
+    EXPECT_EQ(first, second);
+
+    params.seed = 43;
+    vector<int> other = readEpoch(files, params);
+    EXPECT_TRUE(isPermutation(other, n));
+    EXPECT_NE(first, other);
+
+    cv::utils::fs::remove_all(dir);
+}
+
+TEST(Datasets_ImageLoader, order_does_not_depend_on_thread_count)
+{
+    const string dir = cv::tempfile("datasets_images");
+    ASSERT_TRUE(cv::utils::fs::createDirectories(dir));
+    const int n = 20;
+    vector<string> files = writeImages(dir, n);
+
+    ImageLoader::Params serial;
+    serial.numThreads = 1;
+    serial.prefetch = 1;
+    ImageLoader::Params parallel;
+    parallel.numThreads = 4;
+    parallel.prefetch = 3;
+
+    vector<int> identity(n);
+    for (int i = 0; i < n; ++i)
+        identity[i] = i;
+    EXPECT_EQ(identity, readEpoch(files, serial));
+    EXPECT_EQ(identity, readEpoch(files, parallel));
+
+    serial.shuffle = parallel.shuffle = true;
+    serial.seed = parallel.seed = 7;
+    EXPECT_EQ(readEpoch(files, serial), readEpoch(files, parallel));
+
+    cv::utils::fs::remove_all(dir);
+}
+
+TEST(Datasets_ImageLoader, reset)
+{
+    const string dir = cv::tempfile("datasets_images");
+    ASSERT_TRUE(cv::utils::fs::createDirectories(dir));
+    const int n = 20;
+    vector<string> files = writeImages(dir, n);
+
+    ImageLoader::Params params;
+    params.numThreads = 3;
+    params.shuffle = true;
+    params.seed = 5;
+    Ptr<ImageLoader> loader = ImageLoader::create(files, params);
+    EXPECT_EQ(n, loader->getNumImages());
+    EXPECT_EQ(0, loader->getEpoch());
+    vector<int> epoch0 = readEpoch(*loader);
+
+    // every epoch draws a new permutation
+    loader->reset();
+    EXPECT_EQ(1, loader->getEpoch());
+    vector<int> epoch1 = readEpoch(*loader);
+    EXPECT_TRUE(isPermutation(epoch1, n));
+    EXPECT_NE(epoch0, epoch1);
+
+    // resetting in the middle of an epoch starts a full new one
+    Mat image;
+    int index;
+    for (int i = 0; i < 5; ++i)
+        ASSERT_TRUE(loader->next(image, index));
+    loader->reset();
+    EXPECT_EQ(2, loader->getEpoch());
+    vector<int> epoch2 = readEpoch(*loader);
+    EXPECT_TRUE(isPermutation(epoch2, n));
+
+    // the permutations only depend on the seed and the epoch
+    Ptr<ImageLoader> replay = ImageLoader::create(files, params);
+    EXPECT_EQ(epoch0, readEpoch(*replay));
+    replay->reset();
+    EXPECT_EQ(epoch1, readEpoch(*replay));
+    replay->reset();
+    EXPECT_EQ(epoch2, readEpoch(*replay));
+
+    cv::utils::fs::remove_all(dir);
+}
+
+}} // namespace
@@ -0,0 +1,74 @@
+// This file is part of OpenCV project.
+// It is subject to the license terms in the LICENSE file found in the top-level directory
+// of this distribution and at http://opencv.org/license.html.
+#include "perf_precomp.hpp"
+
+namespace opencv_test { namespace {
+
+typedef tuple<Size, int> FuzzyParams;
+typedef perf::TestBaseWithParam<FuzzyParams> F0;
+typedef perf::TestBaseWithParam<FuzzyParams> F1;
+typedef perf::TestBaseWithParam<FuzzyParams> Inpaint;
+
+// valid everywhere except a set of 3 pixels wide scratches
+static Mat scratchMask(const Size& size)
+{
+    RNG rng(1234);
+    Mat mask(size, CV_8UC1, Scalar::all(255));
+    for (int i = 0; i < 50; i++)
+    {
+        Point p1(rng.uniform(0, size.width), rng.uniform(0, size.height));
+        Point p2(rng.uniform(0, size.width), rng.uniform(0, size.height));
+        line(mask, p1, p2, Scalar::all(0), 3);
+    }
+    return mask;
+}
+
+PERF_TEST_P(F0, FT02D_process, testing::Combine(testing::Values(Size(1920, 1080), Size(4000, 3000)),
+                                                testing::Values(2, 10)))
+{
+    const Size size = get<0>(GetParam());
+    const int radius = get<1>(GetParam());
+
+    Mat image(size, CV_8UC3), kernel, output;
+    declare.in(image, WARMUP_RNG);
+    createKernel(LINEAR, radius, kernel, 3);
+    Mat mask = scratchMask(size);
+
+    TEST_CYCLE() FT02D_process(image, kernel, output, mask);
+
+    SANITY_CHECK_NOTHING();
+}
+
+PERF_TEST_P(F1, FT12D_process, testing::Combine(testing::Values(Size(640, 480), Size(1280, 720)),
+                                                testing::Values(2, 10)))
+{
+    const Size size = get<0>(GetParam());
+    const int radius = get<1>(GetParam());
+
+    Mat image(size, CV_8UC3), kernel, output;
+    declare.in(image, WARMUP_RNG);
+    createKernel(LINEAR, radius, kernel, 3);
+    Mat mask = scratchMask(size);
+
+    TEST_CYCLE() FT12D_process(image, kernel, output, mask);
+
+    SANITY_CHECK_NOTHING();
+}
+
+PERF_TEST_P(Inpaint, inpaint, testing::Combine(testing::Values(Size(1920, 1080), Size(4000, 3000)),
+                                               testing::Values((int)ONE_STEP, (int)MULTI_STEP, (int)ITERATIVE)))
+{
+    const Size size = get<0>(GetParam());
+    const int algorithm = get<1>(GetParam());
+
+    Mat image(size, CV_8UC3), output;
+    declare.in(image, WARMUP_RNG);
+    Mat mask = scratchMask(size);
+
+    TEST_CYCLE() inpaint(image, mask, output, 2, LINEAR, algorithm);
+
+    SANITY_CHECK_NOTHING();
+}
+
+}} // namespace
@@ -40,9 +40,261 @@
 //M*/
 
 #include "precomp.hpp"
+#include "opencv2/core/hal/intrin.hpp"
 
 using namespace cv;
 
+namespace
+{
+
+// Splits kernel into ky^T * kx. Kernels created by ft::createKernel are always
+// separable, other kernels (or kernels whose channels differ) make it return false.
+bool separateKernel(const Mat &kernel, std::vector<float> &kx, std::vector<float> &ky)
+{
+    if (kernel.depth() != CV_32F)
+    {
+        return false;
+    }
+
+    const int cn = kernel.channels();
+    int pivotX = 0, pivotY = 0;
+    float pivot = 0;
+
+    for (int y = 0; y < kernel.rows; y++)
+    {
+        const float *k = kernel.ptr<float>(y);
+
+        for (int x = 0; x < kernel.cols; x++)
+        {
+            if (std::abs(k[x * cn]) > std::abs(pivot))
+            {
+                pivot = k[x * cn];
+                pivotX = x;
+                pivotY = y;
+            }
+        }
+    }
+
+    if (pivot == 0)
+    {
+        return false;
+    }
+
+    kx.resize(kernel.cols);
+    ky.resize(kernel.rows);
+
+    for (int x = 0; x < kernel.cols; x++)
+    {
+        kx[x] = kernel.ptr<float>(pivotY)[x * cn];
+    }
+
+    for (int y = 0; y < kernel.rows; y++)
+    {
+        ky[y] = kernel.ptr<float>(y)[pivotX * cn] / pivot;
+    }
+
+    for (int y = 0; y < kernel.rows; y++)
+    {
+        const float *k = kernel.ptr<float>(y);
+
+        for (int x = 0; x < kernel.cols; x++)
+        {
+            for (int c = 0; c < cn; c++)
+            {
+                if (k[x * cn + c] != ky[y] * kx[x])
+                {
+                    return false;
+                }
+            }
+        }
+    }
+
+    return true;
+}
+
+// dst += weight * src
+void accumulateWeighted(float *dst, const float *src, float weight, int len)
+{
+    int i = 0;
+
+#if CV_SIMD128
+    v_float32x4 w = v_setall_f32(weight);
+
+    for (; i <= len - 4; i += 4)
+    {
+        v_store(dst + i, v_load(dst + i) + v_load(src + i) * w);
+    }
+#endif
+
+    for (; i < len; i++)
+    {
+        dst[i] += weight * src[i];
+    }
+}
+
+// Horizontal pass of the separable F0-transform over one image row: for every component
+// column i, the kx weighted sum of the valid pixels around i * radiusX and the sum of their weights.
+void rowComponents(const float *src, const uchar *mask, int cols, int cn, const std::vector<float> &kx,
+                   int An, float *numerators, float *denominators)
+{
+    const int radiusX = ((int)kx.size() - 1) / 2;
+
+    for (int i = 0; i < An; i++)
+    {
+        const int x0 = i * radiusX - radiusX;
+        const int tStart = std::max(0, -x0);
+        const int tEnd = std::min((int)kx.size(), cols - x0);
+        float *num = numerators + i * cn;
+        float den = 0;
+
+        for (int c = 0; c < cn; c++)
+        {
+            num[c] = 0;
+        }
+
+        for (int t = tStart; t < tEnd; t++)
+        {
+            const int x = x0 + t;
+
+            if (!mask[x] || kx[t] == 0)
+            {
+                continue;
+            }
+
+            den += kx[t];
+
+            for (int c = 0; c < cn; c++)
+            {
+                num[c] += kx[t] * src[x * cn + c];
+            }
+        }
+
+        denominators[i] = den;
+    }
+}
+
+// F0 components with the separable kernel ky^T * kx, computed row then column and in parallel
+// over the rows of components. denominators receives the sum of the kernel weights of the valid
+// pixels of each component, the component is 0 where this sum is 0.
+void separableComponents(const Mat &matrix, const Mat &mask, const std::vector<float> &kx, const std::vector<float> &ky,
+                         Mat &components, Mat &denominators)
+{
+    const int cn = matrix.channels();
+    const int radiusX = ((int)kx.size() - 1) / 2;
+    const int radiusY = ((int)ky.size() - 1) / 2;
+    const int An = matrix.cols / radiusX + 1;
+    const int Bn = matrix.rows / radiusY + 1;
+
+    Mat matrix32F;
+    matrix.convertTo(matrix32F, CV_32F);
+
+    components.create(Bn, An, CV_MAKETYPE(CV_32F, cn));
+    denominators.create(Bn, An, CV_32F);
+
+    parallel_for_(Range(0, Bn), [&](const Range &range)
+    {
+        AutoBuffer<float> buffer(2 * An * (cn + 1));
+        float *num = buffer.data();
+        float *den = num + An * cn;
+        float *rowNum = den + An;
+        float *rowDen = rowNum + An * cn;
+
+        for (int o = range.start; o < range.end; o++)
+        {
+            std::fill(num, num + An * (cn + 1), 0.f);
+
+            for (int t = 0; t < (int)ky.size(); t++)
+            {
+                const int y = o * radiusY - radiusY + t;
+
+                if (y < 0 || y >= matrix.rows || ky[t] == 0)
+                {
+                    continue;
+                }
+
+                rowComponents(matrix32F.ptr<float>(y), mask.ptr<uchar>(y), matrix.cols, cn, kx, An, rowNum, rowDen);
+                accumulateWeighted(num, rowNum, ky[t], An * cn);
+                accumulateWeighted(den, rowDen, ky[t], An);
+            }
+
+            float *comp = components.ptr<float>(o);
+            float *compDen = denominators.ptr<float>(o);
+
+            for (int i = 0; i < An; i++)
+            {
+                compDen[i] = den[i];
+
+                for (int c = 0; c < cn; c++)
+                {
+                    comp[i * cn + c] = den[i] != 0 ? num[i * cn + c] / den[i] : 0.f;
+                }
+            }
+        }
+    });
+}
+
+// Inverse F0-transform with the separable kernel ky^T * kx, computed column then row and
+// in parallel over the output rows.
+void separableInverse(const Mat &components, const std::vector<float> &kx, const std::vector<float> &ky, Mat &output)
+{
+    const int cn = components.channels();
+    const int radiusX = ((int)kx.size() - 1) / 2;
+    const int radiusY = ((int)ky.size() - 1) / 2;
+    const int An = components.cols;
+    const int Bn = components.rows;
+
+    parallel_for_(Range(0, output.rows), [&](const Range &range)
+    {
+        AutoBuffer<float> buffer(An * cn);
+        float *column = buffer.data();
+
+        for (int y = range.start; y < range.end; y++)
+        {
+            const int oStart = std::max(0, (y + radiusY - 1) / radiusY - 1);
+            const int oEnd = std::min(Bn - 1, (y + radiusY) / radiusY);
+
+            std::fill(column, column + An * cn, 0.f);
+
+            for (int o = oStart; o <= oEnd; o++)
+            {
+                const float w = ky[y - o * radiusY + radiusY];
+
+                if (w != 0)
+                {
+                    accumulateWeighted(column, components.ptr<float>(o), w, An * cn);
+                }
+            }
+
+            float *dst = output.ptr<float>(y);
+            std::fill(dst, dst + output.cols * cn, 0.f);
+
+            for (int i = 0; i < An; i++)
+            {
+                const int x0 = i * radiusX - radiusX;
+                const int tStart = std::max(0, -x0);
+                const int tEnd = std::min((int)kx.size(), output.cols - x0);
+
+                for (int t = tStart; t < tEnd; t++)
+                {
+                    if (kx[t] == 0)
+                    {
+                        continue;
+                    }
+
+                    float *d = dst + (x0 + t) * cn;
+
+                    for (int c = 0; c < cn; c++)
+                    {
+                        d[c] += kx[t] * column[i * cn + c];
+                    }
+                }
+            }
+        }
+    });
+}
+
+}
+
 void ft::FT02D_FL_process(InputArray matrix, const int radius, OutputArray output)
 {
     CV_Assert(matrix.channels() == 3);
@@ -55,9 +307,9 @@ void ft::FT02D_FL_process(InputArray matrix, const int radius, OutputArray outpu
     Mat channel[3];
     split(imagePadded, channel);
 
-    uchar *im_r = channel[2].data;
-    uchar *im_g = channel[1].data;
-    uchar *im_b = channel[0].data;
+    const uchar *im_r = channel[2].data;
+    const uchar *im_g = channel[1].data;
+    const uchar *im_b = channel[0].data;
 
     int width = imagePadded.cols;
     int height = imagePadded.rows;
@@ -68,11 +320,6 @@ void ft::FT02D_FL_process(InputArray matrix, const int radius, OutputArray outpu
     std::vector<uchar> c_g(n_width * n_height);
     std::vector<uchar> c_b(n_width * n_height);
 
-    int sum_r, sum_g, sum_b, num, c_wei;
-    int c_pos, pos, pos2, wy;
-    int cy = 0;
-    float num_f;
-
     std::vector<int> wei(radius + 1);
 
     for (int i = 0; i <= radius; i++)
@@ -80,95 +327,84 @@ void ft::FT02D_FL_process(InputArray matrix, const int radius, OutputArray outpu
         wei[i] = radius - i;
     }
 
-    for (int y = radius; y < height - radius; y += radius)
+    // component rows are centered at y = radius, 2 * radius, ... < height - radius
+    parallel_for_(Range(0, std::max(0, (height - radius - 1) / radius)), [&](const Range &range)
     {
-        c_pos = cy;
-
-        for (int x = radius; x < width - radius; x += radius)
+        for (int cy = range.start; cy < range.end; cy++)
         {
-            num = sum_r = sum_g = sum_b = 0;
+            int y = (cy + 1) * radius;
+            int c_pos = cy * n_width;
 
-            for (int y1 = y - radius; y1 <= y + radius; y1++)
+            for (int x = radius; x < width - radius; x += radius)
             {
-                pos = y1 * width;
-                wy = wei[abs(y1 - y)];
+                int num = 0, sum_r = 0, sum_g = 0, sum_b = 0;
 
-                for (int x1 = x - radius; x1 <= x + radius; x1++)
+                for (int y1 = y - radius; y1 <= y + radius; y1++)
                 {
-                    c_wei = wei[abs(x1 - x)] * wy;
-                    pos2 = pos + x1;
-                    sum_r += im_r[pos2] * c_wei;
-                    sum_g += im_g[pos2] * c_wei;
-                    sum_b += im_b[pos2] * c_wei;
-                    num += c_wei;
+                    int pos = y1 * width;
+                    int wy = wei[abs(y1 - y)];
+
+                    for (int x1 = x - radius; x1 <= x + radius; x1++)
+                    {
+                        int c_wei = wei[abs(x1 - x)] * wy;
+                        int pos2 = pos + x1;
+                        sum_r += im_r[pos2] * c_wei;
+                        sum_g += im_g[pos2] * c_wei;
+                        sum_b += im_b[pos2] * c_wei;
+                        num += c_wei;
+                    }
                 }
-            }
 
-            num_f = 1.0f / (float)num;
+                float num_f = 1.0f / (float)num;
 
-            c_r[c_pos] = (uchar)cvRound(sum_r * num_f);
-            c_g[c_pos] = (uchar)cvRound(sum_g * num_f);
-            c_b[c_pos] = (uchar)cvRound(sum_b * num_f);
+                c_r[c_pos] = (uchar)cvRound(sum_r * num_f);
+                c_g[c_pos] = (uchar)cvRound(sum_g * num_f);
+                c_b[c_pos] = (uchar)cvRound(sum_b * num_f);
 
-            c_pos++;
+                c_pos++;
+            }
         }
-
-        cy += n_width;
-    }
-
-    int p1, p2, p3, p4, yw, w1, w2, w3, w4, lx, ly, lx1, ly1, pos_iFT;
-    float num_iFT;
+    });
 
     int output_height = matrix.rows();
     int output_width = matrix.cols();
 
-    uchar *img_r = new uchar[output_height * output_width];
-    uchar *img_g = new uchar[output_height * output_width];
-    uchar *img_b = new uchar[output_height * output_width];
+    output.create(output_height, output_width, CV_8UC3);
 
-    for (int y = 0; y < output_height; y++)
-    {
-        ly1 = (y % radius);
-        ly = radius - ly1;
-        yw = y / radius * n_width;
-        pos_iFT = y * output_width;
+    Mat outputMat = output.getMat();
 
-        for (int x = 0; x < output_width; x++)
+    parallel_for_(Range(0, output_height), [&](const Range &range)
+    {
+        for (int y = range.start; y < range.end; y++)
         {
-            lx1 = (x % radius);
-            lx = radius - lx1;
+            int ly1 = (y % radius);
+            int ly = radius - ly1;
+            int yw = y / radius * n_width;
+            uchar *dst = outputMat.ptr<uchar>(y);
 
-            p1 = x / radius + yw;
-            p2 = p1 + 1;
-            p3 = p1 + n_width;
-            p4 = p3 + 1;
+            for (int x = 0; x < output_width; x++)
+            {
+                int lx1 = (x % radius);
+                int lx = radius - lx1;
 
-            w1 = lx * ly;
-            w2 = lx1 * ly;
-            w3 = lx * ly1;
-            w4 = lx1 * ly1;
+                int p1 = x / radius + yw;
+                int p2 = p1 + 1;
+                int p3 = p1 + n_width;
+                int p4 = p3 + 1;
 
-            num_iFT = 1.0f / (float)(w1 + w2 + w3 + w4);
+                int w1 = lx * ly;
+                int w2 = lx1 * ly;
+                int w3 = lx * ly1;
+                int w4 = lx1 * ly1;
 
-            img_r[pos_iFT] = (uchar)((c_r[p1] * w1 + c_r[p2] * w2 + c_r[p3] * w3 + c_r[p4] * w4) * num_iFT);
-            img_g[pos_iFT] = (uchar)((c_g[p1] * w1 + c_g[p2] * w2 + c_g[p3] * w3 + c_g[p4] * w4) * num_iFT);
-            img_b[pos_iFT] = (uchar)((c_b[p1] * w1 + c_b[p2] * w2 + c_b[p3] * w3 + c_b[p4] * w4) * num_iFT);
+                float num_iFT = 1.0f / (float)(w1 + w2 + w3 + w4);
 
-            pos_iFT++;
+                dst[3 * x] = (uchar)((c_b[p1] * w1 + c_b[p2] * w2 + c_b[p3] * w3 + c_b[p4] * w4) * num_iFT);
+                dst[3 * x + 1] = (uchar)((c_g[p1] * w1 + c_g[p2] * w2 + c_g[p3] * w3 + c_g[p4] * w4) * num_iFT);
+                dst[3 * x + 2] = (uchar)((c_r[p1] * w1 + c_r[p2] * w2 + c_r[p3] * w3 + c_r[p4] * w4) * num_iFT);
+            }
         }
-    }
-
-    Mat compR(output_height, output_width, CV_8UC1, img_r);
-    Mat compG(output_height, output_width, CV_8UC1, img_g);
-    Mat compB(output_height, output_width, CV_8UC1, img_b);
-
-    std::vector<Mat> oComp;
-
-    oComp.push_back(compB);
-    oComp.push_back(compG);
-    oComp.push_back(compR);
-
-    merge(oComp, output);
+    });
 }
 
 void ft::FT02D_FL_process_float(InputArray matrix, const int radius, OutputArray output)
@@ -183,9 +419,9 @@ void ft::FT02D_FL_process_float(InputArray matrix, const int radius, OutputArray
     Mat channel[3];
     split(imagePadded, channel);
 
-    uchar *im_r = channel[2].data;
-    uchar *im_g = channel[1].data;
-    uchar *im_b = channel[0].data;
+    const uchar *im_r = channel[2].data;
+    const uchar *im_g = channel[1].data;
+    const uchar *im_b = channel[0].data;
 
     int width = imagePadded.cols;
     int height = imagePadded.rows;
@@ -196,11 +432,6 @@ void ft::FT02D_FL_process_float(InputArray matrix, const int radius, OutputArray
     std::vector<float> c_g(n_width * n_height);
     std::vector<float> c_b(n_width * n_height);
 
-    int sum_r, sum_g, sum_b, num, c_wei;
-    int c_pos, pos, pos2, wy;
-    int cy = 0;
-    float num_f;
-
     std::vector<int> wei(radius + 1);
 
     for (int i = 0; i <= radius; i++)
@@ -208,95 +439,84 @@ void ft::FT02D_FL_process_float(InputArray matrix, const int radius, OutputArray
         wei[i] = radius - i;
     }
 
-    for (int y = radius; y < height - radius; y += radius)
+    // component rows are centered at y = radius, 2 * radius, ... < height - radius
+    parallel_for_(Range(0, std::max(0, (height - radius - 1) / radius)), [&](const Range &range)
     {
-        c_pos = cy;
-
-        for (int x = radius; x < width - radius; x += radius)
+        for (int cy = range.start; cy < range.end; cy++)
         {
-            num = sum_r = sum_g = sum_b = 0;
+            int y = (cy + 1) * radius;
+            int c_pos = cy * n_width;
 
-            for (int y1 = y - radius; y1 <= y + radius; y1++)
+            for (int x = radius; x < width - radius; x += radius)
             {
-                pos = y1 * width;
-                wy = wei[abs(y1 - y)];
+                int num = 0, sum_r = 0, sum_g = 0, sum_b = 0;
 
-                for (int x1 = x - radius; x1 <= x + radius; x1++)
+                for (int y1 = y - radius; y1 <= y + radius; y1++)
                 {
-                    c_wei = wei[abs(x1 - x)] * wy;
-                    pos2 = pos + x1;
-                    sum_r += im_r[pos2] * c_wei;
-                    sum_g += im_g[pos2] * c_wei;
-                    sum_b += im_b[pos2] * c_wei;
-                    num += c_wei;
+                    int pos = y1 * width;
+                    int wy = wei[abs(y1 - y)];
+
+                    for (int x1 = x - radius; x1 <= x + radius; x1++)
+                    {
+                        int c_wei = wei[abs(x1 - x)] * wy;
+                        int pos2 = pos + x1;
+                        sum_r += im_r[pos2] * c_wei;
+                        sum_g += im_g[pos2] * c_wei;
+                        sum_b += im_b[pos2] * c_wei;
+                        num += c_wei;
+                    }
                 }
-            }
 
-            num_f = 1.0f / (float)num;
+                float num_f = 1.0f / (float)num;
 
-            c_r[c_pos] = sum_r * num_f;
-            c_g[c_pos] = sum_g * num_f;
-            c_b[c_pos] = sum_b * num_f;
+                c_r[c_pos] = sum_r * num_f;
+                c_g[c_pos] = sum_g * num_f;
+                c_b[c_pos] = sum_b * num_f;
 
-            c_pos++;
+                c_pos++;
+            }
         }
-
-        cy += n_width;
-    }
-
-    int p1, p2, p3, p4, yw, w1, w2, w3, w4, lx, ly, lx1, ly1, pos_iFT;
-    float num_iFT;
+    });
 
     int output_height = matrix.rows();
     int output_width = matrix.cols();
 
-    float *img_r = new float[output_height * output_width];
-    float *img_g = new float[output_height * output_width];
-    float *img_b = new float[output_height * output_width];
+    output.create(output_height, output_width, CV_32FC3);
 
-    for (int y = 0; y < output_height; y++)
-    {
-        ly1 = (y % radius);
-        ly = radius - ly1;
-        yw = y / radius * n_width;
-        pos_iFT = y * output_width;
+    Mat outputMat = output.getMat();
 
-        for (int x = 0; x < output_width; x++)
+    parallel_for_(Range(0, output_height), [&](const Range &range)
+    {
+        for (int y = range.start; y < range.end; y++)
         {
-            lx1 = (x % radius);
-            lx = radius - lx1;
+            int ly1 = (y % radius);
+            int ly = radius - ly1;
+            int yw = y / radius * n_width;
+            float *dst = outputMat.ptr<float>(y);
 
-            p1 = x / radius + yw;
-            p2 = p1 + 1;
-            p3 = p1 + n_width;
-            p4 = p3 + 1;
+            for (int x = 0; x < output_width; x++)
+            {
+                int lx1 = (x % radius);
+                int lx = radius - lx1;
 
-            w1 = lx * ly;
-            w2 = lx1 * ly;
-            w3 = lx * ly1;
-            w4 = lx1 * ly1;
+                int p1 = x / radius + yw;
+                int p2 = p1 + 1;
+                int p3 = p1 + n_width;
+                int p4 = p3 + 1;
 
-            num_iFT = 1.0f / (float)(w1 + w2 + w3 + w4);
+                int w1 = lx * ly;
+                int w2 = lx1 * ly;
+                int w3 = lx * ly1;
+                int w4 = lx1 * ly1;
 
-            img_r[pos_iFT] = (c_r[p1] * w1 + c_r[p2] * w2 + c_r[p3] * w3 + c_r[p4] * w4) * num_iFT;
-            img_g[pos_iFT] = (c_g[p1] * w1 + c_g[p2] * w2 + c_g[p3] * w3 + c_g[p4] * w4) * num_iFT;
-            img_b[pos_iFT] = (c_b[p1] * w1 + c_b[p2] * w2 + c_b[p3] * w3 + c_b[p4] * w4) * num_iFT;
+                float num_iFT = 1.0f / (float)(w1 + w2 + w3 + w4);
 
-            pos_iFT++;
+                dst[3 * x] = (c_b[p1] * w1 + c_b[p2] * w2 + c_b[p3] * w3 + c_b[p4] * w4) * num_iFT;
+                dst[3 * x + 1] = (c_g[p1] * w1 + c_g[p2] * w2 + c_g[p3] * w3 + c_g[p4] * w4) * num_iFT;
+                dst[3 * x + 2] = (c_r[p1] * w1 + c_r[p2] * w2 + c_r[p3] * w3 + c_r[p4] * w4) * num_iFT;
+            }
         }
-    }
-
-    Mat compR(output_height, output_width, CV_32FC1, img_r);
-    Mat compG(output_height, output_width, CV_32FC1, img_g);
-    Mat compB(output_height, output_width, CV_32FC1, img_b);
-
-    std::vector<Mat> oComp;
-
-    oComp.push_back(compB);
-    oComp.push_back(compG);
-    oComp.push_back(compR);
-
-    merge(oComp, output);
+    });
 }
 
 void ft::FT02D_components(InputArray matrix, InputArray kernel, OutputArray components, InputArray mask)
@@ -321,16 +541,26 @@ void ft::FT02D_components(InputArray matrix, InputArray kernel, OutputArray comp
     int An = matrix.cols() / radiusX + 1;
     int Bn = matrix.rows() / radiusY + 1;
 
+    components.create(Bn, An, CV_MAKETYPE(CV_32F, matrix.channels()));
+
+    Mat componentsMat = components.getMat();
+
+    std::vector<float> kx, ky;
+
+    if (inputMask.type() == CV_8UC1 && separateKernel(kernel.getMat(), kx, ky))
+    {
+        Mat denominators;
+        separableComponents(matrix.getMat(), inputMask, kx, ky, componentsMat, denominators);
+
+        return;
+    }
+
     Mat matrixPadded;
     Mat maskPadded;
 
     copyMakeBorder(matrix, matrixPadded, radiusY, kernel.rows(), radiusX, kernel.cols(), BORDER_CONSTANT, Scalar(0));
     copyMakeBorder(inputMask, maskPadded, radiusY, kernel.rows(), radiusX, kernel.cols(), BORDER_CONSTANT, Scalar(0));
 
-    components.create(Bn, An, CV_MAKETYPE(CV_32F, matrix.channels()));
-
-    Mat componentsMat = components.getMat();
-
     for (int i = 0; i < An; i++)
     {
         for (int o = 0; o < Bn; o++)
@@ -369,6 +599,16 @@ void ft::FT02D_inverseFT(InputArray components, InputArray kernel, OutputArray o
 
     output.create(height, width, CV_32F);
 
+    std::vector<float> kx, ky;
+
+    if (componentsMat.type() == CV_32FC1 && separateKernel(kernel.getMat(), kx, ky))
+    {
+        Mat outputMat = output.getMat();
+        separableInverse(componentsMat, kx, ky, outputMat);
+
+        return;
+    }
+
     Mat outputZeroes(outputHeightPadded, outputWidthPadded, CV_32F, Scalar(0));
 
     for (int i = 0; i < componentsMat.cols; i++)
@@ -421,6 +661,19 @@ void ft::FT02D_process(InputArray matrix, InputArray kernel, OutputArray output,
 
     output.create(matrix.size(), CV_MAKETYPE(CV_32F, matrix.channels()));
 
+    std::vector<float> kx, ky;
+
+    if (inputMask.type() == CV_8UC1 && separateKernel(kernel.getMat(), kx, ky))
+    {
+        Mat components, denominators;
+        separableComponents(matrix.getMat(), inputMask, kx, ky, components, denominators);
+
+        Mat outputMat = output.getMat();
+        separableInverse(components, kx, ky, outputMat);
+
+        return;
+    }
+
     Mat outputZeroes(outputHeightPadded, outputWidthPadded, output.type(), Scalar(0));
 
     copyMakeBorder(matrix, matrixPadded, radiusY, kernel.rows(), radiusX, kernel.cols(), BORDER_CONSTANT, Scalar(0));
@@ -478,6 +731,53 @@ int ft::FT02D_iteration(InputArray matrix, InputArray kernel, OutputArray output
         maskOutput.setTo(1);
     }
 
+    Mat maskMat = mask.getMat();
+    std::vector<float> kx, ky;
+
+    if (maskMat.type() == CV_8UC1 && separateKernel(kernel.getMat(), kx, ky))
+    {
+        Mat components, denominators;
+        separableComponents(matrix.getMat(), maskMat, kx, ky, components, denominators);
+
+        if (firstStop && countNonZero(denominators) < (int)denominators.total())
+        {
+            return -1;
+        }
+
+        Mat outputMat = output.getMat();
+        separableInverse(components, kx, ky, outputMat);
+
+        Mat maskOutputMat;
+
+        if (maskOutput.needed())
+        {
+            maskOutputMat = maskOutput.getMat();
+        }
+
+        for (int o = 0; o < Bn; o++)
+        {
+            const float *den = denominators.ptr<float>(o);
+
+            for (int i = 0; i < An; i++)
+            {
+                if (den[i] != 0)
+                {
+                    continue;
+                }
+
+                undefinedComponents++;
+
+                if (!maskOutputMat.empty())
+                {
+                    Rect area(i * radiusX - radiusX + 1, o * radiusY - radiusY + 1, kernel.cols() - 2, kernel.rows() - 2);
+                    maskOutputMat(area & Rect(0, 0, matrix.cols(), matrix.rows())).setTo(0);
+                }
+            }
+        }
+
+        return undefinedComponents;
+    }
+
     Mat matrixOutputMat = Mat::zeros(outputHeightPadded, outputWidthPadded, CV_MAKETYPE(CV_32F, matrix.channels()));
     Mat maskOutputMat = Mat::ones(outputHeightPadded, outputWidthPadded, CV_8UC1);
 
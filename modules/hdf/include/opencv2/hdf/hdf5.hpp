@@ -48,6 +48,48 @@ using namespace std;
 //! @{
 
 
+/** @brief Sequential reader over blocks of rows of a dataset.
+
+Blocks span the whole dataset along every dimension but the first one, and are aligned to the
+dataset chunks along the first dimension, so that every chunk is fetched (and decompressed) once.
+Instances are created by HDF5::dsopenblocks().
+
+@note While prefetching is enabled the next block is read on a background thread between two calls
+of read(), so any other HDF5 call (on any file), including calls from the thread that iterates, runs
+concurrently with it. Prefetching is therefore only done when the HDF5 library is built thread safe.
+ */
+class CV_EXPORTS_W HDF5BlockReader
+{
+public:
+
+    virtual ~HDF5BlockReader() {}
+
+    /** @brief Read the next block of the dataset.
+    @param Array Mat container where the block is returned. If it already has the size and type of the
+           block, data is stored into it (it can be a view into a larger caller-provided matrix). Otherwise
+           it is reallocated or, when prefetching, shares the buffer the block was prefetched into.
+
+    Returns false once all the blocks have been read.
+     */
+    CV_WRAP virtual bool read( OutputArray Array ) = 0;
+
+    /** @brief Offset along the first dimension of the block returned by the last read().
+     */
+    CV_WRAP virtual int getBlockOffset() const = 0;
+
+    /** @brief Number of rows (size along the first dimension) of a full block.
+     */
+    CV_WRAP virtual int getBlockRows() const = 0;
+
+    /** @brief Number of blocks in the dataset.
+     */
+    CV_WRAP virtual int getBlockCount() const = 0;
+
+    /** @brief Restart the iteration from the first block.
+     */
+    CV_WRAP virtual void reset() = 0;
+};
+
 /** @brief Hierarchical Data Format version 5 interface.
 
 Notice that this module is compiled only when hdf5 is correctly installed.
@@ -575,6 +617,38 @@ public:
     CV_WRAP virtual void dsread( OutputArray Array, const String& dslabel,
                  const int* dims_offset, const int* dims_counts ) const = 0;
 
+    /** @brief Open a dataset for reading in blocks of rows.
+    @param dslabel specify the source hdf5 dataset label.
+    @param block_rows size of the blocks along the first dimension. It is rounded up to a multiple of the
+           chunk size of the dataset. H5_NONE uses one chunk for chunked datasets, and blocks of about 4MB
+           otherwise.
+    @param cache_size size in bytes of the raw chunk cache of the dataset. H5_NONE keeps the HDF5 default.
+    @param prefetch read the next block on a background thread while the current one is processed.
+           It is ignored unless the HDF5 library is built thread safe.
+
+    Returns a HDF5BlockReader iterating over the dataset. This is meant for datasets that do not fit in
+    memory, or to overlap I/O and processing. Reading every block gives the same data as dsread().
+
+    @note The reader keeps the dataset open, release it before closing the file.
+
+    - Example below computes the sum of a large dataset block by block:
+    @code{.cpp}
+      // open hdf5 file
+      cv::Ptr<cv::hdf::HDF5> h5io = cv::hdf::open( "mytest.h5" );
+      cv::Ptr<cv::hdf::HDF5BlockReader> reader = h5io->dsopenblocks( "features" );
+      cv::Mat block;
+      cv::Scalar total;
+      while ( reader->read( block ) )
+        total += cv::sum( block );
+      reader.release();
+      // release
+      h5io->close();
+    @endcode
+     */
+    CV_WRAP virtual Ptr<HDF5BlockReader> dsopenblocks( const String& dslabel,
+                 const int block_rows = HDF5::H5_NONE, const int cache_size = HDF5::H5_NONE,
+                 const bool prefetch = false ) const = 0;
+
     /** @brief Fetch keypoint dataset size
     @param kplabel specify the hdf5 dataset label to be measured.
     @param dims_flag will fetch dataset dimensions on H5_GETDIMS, and dataset maximum dimensions on H5_GETMAXDIMS.
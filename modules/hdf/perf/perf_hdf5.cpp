@@ -0,0 +1,69 @@
+// This file is part of OpenCV project.
+// It is subject to the license terms in the LICENSE file found in the top-level directory
+// of this distribution and at http://opencv.org/license.html.
+#include "perf_precomp.hpp"
+
+namespace opencv_test { namespace {
+
+// chunked dataset larger than the default chunk cache of HDF5
+static String createDataset(int compresslevel)
+{
+    const int rows = 4096, cols = 1024, chunk_rows = 256;
+    String filename = cv::tempfile(".h5");
+
+    Mat data(rows, cols, CV_32F);
+    randu(data, 0, 1);
+
+    vector<int> chunks;
+    chunks.push_back(chunk_rows); chunks.push_back(cols);
+
+    Ptr<HDF5> h5io = hdf::open(filename);
+    h5io->dscreate(rows, cols, CV_32F, "data", compresslevel, chunks);
+    h5io->dswrite(data, "data");
+    h5io->close();
+    return filename;
+}
+
+typedef TestBaseWithParam<int> HDF5Perf;
+
+PERF_TEST_P(HDF5Perf, dsread, testing::Values(HDF5::H5_NONE, 1))
+{
+    String filename = createDataset(GetParam());
+    Ptr<HDF5> h5io = hdf::open(filename);
+    Mat data;
+
+    TEST_CYCLE() h5io->dsread(data, "data");
+
+    h5io->close();
+    remove(filename.c_str());
+    SANITY_CHECK_NOTHING();
+}
+
+typedef tuple<int, bool> HDF5BlocksParams;
+typedef TestBaseWithParam<HDF5BlocksParams> HDF5BlocksPerf;
+
+PERF_TEST_P(HDF5BlocksPerf, dsopenblocks,
+            testing::Combine(testing::Values(HDF5::H5_NONE, 1), testing::Bool()))
+{
+    String filename = createDataset(get<0>(GetParam()));
+    const bool prefetch = get<1>(GetParam());
+    Ptr<HDF5> h5io = hdf::open(filename);
+    Ptr<HDF5BlockReader> reader = h5io->dsopenblocks("data", 1024, 16 << 20, prefetch);
+    Mat block;
+    Scalar total;
+
+    // iterate over the whole dataset, summing blocks stands for the processing
+    TEST_CYCLE()
+    {
+        reader->reset();
+        while (reader->read(block))
+            total += sum(block);
+    }
+
+    reader.release();
+    h5io->close();
+    remove(filename.c_str());
+    SANITY_CHECK_NOTHING();
+}
+
+}} // namespace
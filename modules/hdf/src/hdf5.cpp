@@ -36,6 +36,8 @@
 
 #include <hdf5.h>
 
+#include <thread>
+
 using namespace std;
 
 namespace cv
@@ -166,6 +168,10 @@ public:
     virtual void dsread( OutputArray Array, const String& dslabel,
              const int* dims_offset, const int* dims_counts ) const CV_OVERRIDE;
 
+    // read dataset block by block
+    virtual Ptr<HDF5BlockReader> dsopenblocks( const String& dslabel, const int block_rows = H5_NONE,
+             const int cache_size = H5_NONE, const bool prefetch = false ) const CV_OVERRIDE;
+
     /*
      *  std::vector<cv::KeyPoint>
      */
@@ -262,6 +268,25 @@ inline int HDF5Impl::GetCVtype( hid_t h5Type ) const
     return cvType;
 }
 
+// Memory data space describing the layout of a matrix. Rows of non-continuous 2D matrices (views into
+// a larger buffer) are addressed through their step, so that data is transferred in place.
+static hid_t createMemSpace( const Mat& matrix, int n_dims, const hsize_t* counts )
+{
+    vector<hsize_t> dims( n_dims ), offset( n_dims, 0 );
+    for ( int d = 0; d < n_dims; d++ )
+      dims[d] = counts[d];
+
+    if ( matrix.isContinuous() )
+      return H5Screate_simple( n_dims, &dims[0], NULL );
+
+    CV_Assert( n_dims == 2 && matrix.dims == 2 && matrix.step[0] % matrix.elemSize() == 0 );
+    dims[0] = matrix.rows;
+    dims[1] = matrix.step[0] / matrix.elemSize();
+    hid_t mspace = H5Screate_simple( n_dims, &dims[0], NULL );
+    H5Sselect_hyperslab( mspace, H5S_SELECT_SET, &offset[0], NULL, counts, NULL );
+    return mspace;
+}
+
 HDF5Impl::HDF5Impl( const String& _hdf5_filename )
                   : m_hdf5_filename( _hdf5_filename )
 {
@@ -867,15 +892,12 @@ void HDF5Impl::dsread( OutputArray Array, const String& dslabel,
       mxdims[d] = (int) dsdims[d];
     }
 
-    // allocate persistent Mat
+    // allocate persistent Mat (kept as is if it already has the right size and type)
     Array.create( n_dims, mxdims, CV_MAKETYPE(dType, channs) );
-
-    // get blank data space
-    hid_t dspace = H5Screate_simple( n_dims, dsdims, NULL );
+    Mat matrix = Array.getMat();
 
     // get matrix write window
-    H5Sselect_hyperslab( dspace, H5S_SELECT_SET,
-                         foffset, NULL, dsdims, NULL );
+    hid_t dspace = createMemSpace( matrix, n_dims, dsdims );
 
     // set custom offsets
     if ( dims_offset != NULL )
@@ -889,7 +911,6 @@ void HDF5Impl::dsread( OutputArray Array, const String& dslabel,
                          foffset, NULL, dsdims, NULL );
 
     // read from DS
-    Mat matrix = Array.getMat();
     H5Dread( dsdata, dstype, dspace, fspace, H5P_DEFAULT, matrix.data );
 
     delete [] dsdims;
@@ -930,8 +951,8 @@ void HDF5Impl::dswrite( InputArray Array, const String& dslabel,
 
     Mat matrix = Array.getMat();
 
-    // memory array should be compact
-    CV_Assert( matrix.isContinuous() );
+    // memory array should be compact, or a 2D view into a compact array
+    CV_Assert( matrix.isContinuous() || matrix.dims == 2 );
 
     int n_dims = matrix.dims;
     int channs = matrix.channels();
@@ -965,7 +986,7 @@ void HDF5Impl::dswrite( InputArray Array, const String& dslabel,
     hid_t dsdata = H5Dopen( m_h5_file_id, dslabel.c_str(), H5P_DEFAULT );
 
     // create input data space
-    hid_t dspace = H5Screate_simple( n_dims, dsdims, NULL );
+    hid_t dspace = createMemSpace( matrix, n_dims, dsdims );
 
     // set custom offsets
     if ( dims_offset != NULL )
@@ -1428,6 +1449,279 @@ void HDF5Impl::kpread( vector<KeyPoint>& keypoints, const String& kplabel,
     H5Dclose( dsdata );
 }
 
+/*
+ *  block reader
+ */
+
+class HDF5BlockReaderImpl CV_FINAL : public HDF5BlockReader
+{
+public:
+
+    //! takes ownership of the dataset and its type
+    HDF5BlockReaderImpl( hid_t dsdata, hid_t dstype, int type,
+                         int block_rows, bool prefetch );
+
+    virtual ~HDF5BlockReaderImpl() CV_OVERRIDE;
+
+    virtual bool read( OutputArray Array ) CV_OVERRIDE;
+
+    virtual int getBlockOffset() const CV_OVERRIDE { return m_offset; }
+    virtual int getBlockRows() const CV_OVERRIDE { return m_block_rows; }
+    virtual int getBlockCount() const CV_OVERRIDE { return m_n_blocks; }
+
+    virtual void reset() CV_OVERRIDE;
+
+private:
+
+    //! read block into matrix, returns false on failure, never throws
+    bool readBlock( int block, Mat& matrix ) const;
+
+    //! wait for the pending prefetch, if any
+    bool waitPrefetch();
+
+    //! start prefetching the given block
+    void startPrefetch( int block );
+
+    hid_t m_dsdata;
+    hid_t m_dstype;
+    int m_type;
+    vector<hsize_t> m_dims;
+    int m_block_rows;
+    int m_n_blocks;
+    int m_next_block;
+    int m_offset;
+    bool m_prefetch;
+
+    //! block read in the background and its status
+    Mat m_next;
+    int m_next_index;
+    bool m_next_ok;
+    std::thread m_worker;
+};
+
+HDF5BlockReaderImpl::HDF5BlockReaderImpl( hid_t dsdata, hid_t dstype, int type,
+                         int block_rows, bool prefetch )
+                  : m_dsdata( dsdata ), m_dstype( dstype ), m_type( type ),
+                    m_next_block( 0 ), m_offset( -1 ), m_prefetch( prefetch ),
+                    m_next_index( -1 ), m_next_ok( false )
+{
+    // fetch dims
+    hid_t fspace = H5Dget_space( m_dsdata );
+    int n_dims = H5Sget_simple_extent_ndims( fspace );
+    m_dims.resize( n_dims );
+    H5Sget_simple_extent_dims( fspace, &m_dims[0], NULL );
+    H5Sclose( fspace );
+
+    // fetch chunking along the first dimension
+    hsize_t chunk_rows = 0;
+    hid_t cparms = H5Dget_create_plist( m_dsdata );
+    if ( H5D_CHUNKED == H5Pget_layout( cparms ) )
+    {
+      vector<hsize_t> chunks( n_dims );
+      if ( H5Pget_chunk( cparms, n_dims, &chunks[0] ) > 0 )
+        chunk_rows = chunks[0];
+    }
+    H5Pclose( cparms );
+
+    // bytes of a single row along the first dimension
+    size_t row_bytes = CV_ELEM_SIZE( m_type );
+    for ( int d = 1; d < n_dims; d++ )
+      row_bytes *= (size_t) m_dims[d];
+
+    if ( block_rows == HDF5::H5_NONE )
+    {
+      if ( chunk_rows > 0 )
+        m_block_rows = (int) chunk_rows;
+      else
+        m_block_rows = (int) std::max( (size_t)1, ( (size_t)1 << 22 ) / std::max( row_bytes, (size_t)1 ) );
+    }
+    else if ( chunk_rows > 0 )
+      m_block_rows = (int) ( ( ( block_rows + chunk_rows - 1 ) / chunk_rows ) * chunk_rows );
+    else
+      m_block_rows = block_rows;
+
+    m_n_blocks = (int) ( ( m_dims[0] + m_block_rows - 1 ) / m_block_rows );
+
+    if ( m_prefetch && m_n_blocks > 0 )
+      startPrefetch( 0 );
+}
+
+HDF5BlockReaderImpl::~HDF5BlockReaderImpl()
+{
+    waitPrefetch();
+    H5Tclose( m_dstype );
+    H5Dclose( m_dsdata );
+}
+
+bool HDF5BlockReaderImpl::readBlock( int block, Mat& matrix ) const
+{
+    const int n_dims = (int) m_dims.size();
+    vector<hsize_t> foffset( n_dims, 0 ), counts( m_dims );
+    foffset[0] = (hsize_t) block * m_block_rows;
+    counts[0] = std::min( (hsize_t) m_block_rows, m_dims[0] - foffset[0] );
+
+    try
+    {
+      vector<int> sizes( n_dims );
+      for ( int d = 0; d < n_dims; d++ )
+        sizes[d] = (int) counts[d];
+      matrix.create( n_dims, &sizes[0], m_type );
+
+      hid_t dspace = createMemSpace( matrix, n_dims, &counts[0] );
+      hid_t fspace = H5Dget_space( m_dsdata );
+      H5Sselect_hyperslab( fspace, H5S_SELECT_SET, &foffset[0], NULL, &counts[0], NULL );
+
+      herr_t status = H5Dread( m_dsdata, m_dstype, dspace, fspace, H5P_DEFAULT, matrix.data );
+
+      H5Sclose( dspace );
+      H5Sclose( fspace );
+      return status >= 0;
+    }
+    catch (...)
+    {
+      return false;
+    }
+}
+
+bool HDF5BlockReaderImpl::waitPrefetch()
+{
+    if ( m_worker.joinable() )
+    {
+      m_worker.join();
+      return true;
+    }
+    return false;
+}
+
+void HDF5BlockReaderImpl::startPrefetch( int block )
+{
+    m_next_index = block;
+    // do not overwrite a buffer that has been handed out to the caller
+    if ( m_next.u && m_next.u->refcount > 1 )
+      m_next.release();
+    m_worker = std::thread( [this, block]() { m_next_ok = readBlock( block, m_next ); } );
+}
+
+bool HDF5BlockReaderImpl::read( OutputArray Array )
+{
+    // only Mat support
+    CV_Assert( Array.isMat() );
+
+    if ( m_next_block >= m_n_blocks )
+      return false;
+
+    const int block = m_next_block++;
+    m_offset = block * m_block_rows;
+
+    if ( !m_prefetch )
+    {
+      Mat matrix;
+      vector<int> sizes( m_dims.size() );
+      for ( size_t d = 0; d < m_dims.size(); d++ )
+        sizes[d] = (int) m_dims[d];
+      sizes[0] = std::min( m_block_rows, sizes[0] - m_offset );
+
+      // keep caller-provided storage when it matches the block
+      Array.create( (int) sizes.size(), &sizes[0], m_type );
+      matrix = Array.getMat();
+      if ( !readBlock( block, matrix ) )
+        CV_Error_(Error::StsError, ("Failed to read block %d.", block));
+      return true;
+    }
+
+    waitPrefetch();
+    if ( m_next_index != block )
+      m_next_ok = readBlock( block, m_next );
+    if ( !m_next_ok )
+      CV_Error_(Error::StsError, ("Failed to read block %d.", block));
+
+    Mat& dst = Array.getMatRef();
+    if ( !dst.empty() && dst.size == m_next.size && dst.type() == m_next.type() )
+    {
+      // recycle a buffer owned only by the caller, fill views in place
+      if ( dst.isContinuous() && dst.u && dst.u->refcount == 1 )
+        std::swap( dst, m_next );
+      else
+        m_next.copyTo( dst );
+    }
+    else
+    {
+      dst = m_next;
+      m_next.release();
+    }
+
+    if ( m_next_block < m_n_blocks )
+      startPrefetch( m_next_block );
+    else
+      m_next_index = -1;
+
+    return true;
+}
+
+void HDF5BlockReaderImpl::reset()
+{
+    waitPrefetch();
+    m_next_index = -1;
+    m_next_block = 0;
+    m_offset = -1;
+
+    if ( m_prefetch && m_n_blocks > 0 )
+      startPrefetch( 0 );
+}
+
+Ptr<HDF5BlockReader> HDF5Impl::dsopenblocks( const String& dslabel, const int block_rows,
+             const int cache_size, const bool prefetch ) const
+{
+    CV_Assert( block_rows == H5_NONE || block_rows > 0 );
+    CV_Assert( cache_size == H5_NONE || cache_size >= 0 );
+
+    // check dataset exists
+    if ( hlexists( dslabel ) == false )
+      CV_Error_(Error::StsInternal, ("Dataset '%s' does not exist.", dslabel.c_str()));
+
+    // dataset access with tuned chunk cache, fully read chunks are evicted first
+    hid_t dsapl = H5Pcreate( H5P_DATASET_ACCESS );
+    if ( cache_size != H5_NONE )
+      H5Pset_chunk_cache( dsapl, H5D_CHUNK_CACHE_NSLOTS_DEFAULT, (size_t)cache_size, 1.0 );
+
+    // open the HDF5 dataset
+    hid_t dsdata = H5Dopen( m_h5_file_id, dslabel.c_str(), dsapl );
+    H5Pclose( dsapl );
+    if ( dsdata < 0 )
+      CV_Error_(Error::StsInternal, ("Cannot open dataset '%s'.", dslabel.c_str()));
+
+    // get data type
+    hid_t dstype = H5Dget_type( dsdata );
+
+    hid_t h5type;
+    int channs = 1;
+    if ( H5Tget_class( dstype ) == H5T_ARRAY )
+    {
+      // fetch channs
+      hsize_t ardims[1];
+      H5Tget_array_dims( dstype, ardims );
+      channs = (int) ardims[0];
+      // fetch depth
+      hid_t tsuper = H5Tget_super( dstype );
+      h5type = H5Tget_native_type( tsuper, H5T_DIR_ASCEND );
+      H5Tclose( tsuper );
+    } else
+      h5type = H5Tget_native_type( dstype, H5T_DIR_ASCEND );
+
+    int dType = GetCVtype( h5type );
+    H5Tclose( h5type );
+
+    // the background reads would race with any other HDF5 call, including the caller's ones
+    bool threadsafe = false;
+#if H5_VERSION_GE(1, 8, 16)
+    hbool_t is_ts = 0;
+    threadsafe = H5is_library_threadsafe( &is_ts ) >= 0 && is_ts;
+#endif
+
+    return makePtr<HDF5BlockReaderImpl>( dsdata, dstype, CV_MAKETYPE(dType, channs), block_rows,
+                                         prefetch && threadsafe );
+}
+
 CV_EXPORTS Ptr<HDF5> open( const String& HDF5Filename )
 {
     return makePtr<HDF5Impl>( HDF5Filename );
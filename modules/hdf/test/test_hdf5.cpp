@@ -371,4 +371,71 @@ TEST_F(HDF5_Test, test_attribute_InutArray_OutputArray_2d)
     m_hdf_io->close();
 }
 
+TEST_F(HDF5_Test, read_dataset_blocks)
+{
+    reset();
+
+    String dataset_name = "/blocks";
+
+    Mat data(37, 5, CV_32FC2);
+    randu(data, -100, 100);
+
+    vector<int> chunks;
+    chunks.push_back(4); chunks.push_back(5);
+
+    m_hdf_io = hdf::open(m_filename);
+    m_hdf_io->dscreate(data.rows, data.cols, data.type(), dataset_name, hdf::HDF5::H5_NONE, chunks);
+    m_hdf_io->dswrite(data, dataset_name);
+
+    for (int prefetch = 0; prefetch < 2; prefetch++)
+    {
+        // block size is rounded up to the chunk size
+        Ptr<hdf::HDF5BlockReader> reader = m_hdf_io->dsopenblocks(dataset_name, 6, 1 << 16, prefetch != 0);
+        EXPECT_EQ(reader->getBlockRows(), 8);
+        EXPECT_EQ(reader->getBlockCount(), 5);
+
+        for (int pass = 0; pass < 2; pass++)
+        {
+            Mat assembled(data.size(), data.type()), block;
+            int blocks = 0;
+            while (reader->read(block))
+            {
+                int offset = reader->getBlockOffset();
+                EXPECT_EQ(offset, blocks * reader->getBlockRows());
+                ASSERT_LE(offset + block.rows, data.rows);
+                EXPECT_EQ(block.type(), data.type());
+                block.copyTo(assembled.rowRange(offset, offset + block.rows));
+                blocks++;
+            }
+            EXPECT_EQ(blocks, reader->getBlockCount());
+            EXPECT_LE(cvtest::norm(assembled, data, NORM_INF), 1e-10);
+            reader->reset();
+        }
+
+        // blocks are stored into caller-provided views
+        reader->reset();
+        Mat assembled(data.size(), data.type(), Scalar::all(0));
+        Mat view = assembled.rowRange(0, reader->getBlockRows());
+        EXPECT_TRUE(reader->read(view));
+        EXPECT_EQ(view.data, assembled.data);
+        EXPECT_LE(cvtest::norm(assembled.rowRange(0, view.rows), data.rowRange(0, view.rows), NORM_INF), 1e-10);
+    }
+
+    // dsread into a view of a larger matrix
+    Mat larger(data.rows + 2, data.cols + 3, data.type(), Scalar::all(0));
+    Mat roi = larger(Rect(1, 2, data.cols, data.rows));
+    m_hdf_io->dsread(roi, dataset_name);
+    EXPECT_EQ(roi.data, larger.ptr(2, 1));
+    EXPECT_LE(cvtest::norm(roi, data, NORM_INF), 1e-10);
+    EXPECT_EQ(countNonZero(larger.row(0).reshape(1)), 0);
+
+    // dswrite from a view of a larger matrix
+    m_hdf_io->dswrite(roi, "/from_roi");
+    Mat written;
+    m_hdf_io->dsread(written, "/from_roi");
+    EXPECT_LE(cvtest::norm(written, data, NORM_INF), 1e-10);
+
+    m_hdf_io->close();
+}
+
 }} // namespace
@@ -0,0 +1,40 @@
+// This file is part of OpenCV project.
+// It is subject to the license terms in the LICENSE file found in the top-level directory
+// of this distribution and at http://opencv.org/license.html.
+#include "perf_precomp.hpp"
+
+namespace opencv_test { namespace {
+
+typedef perf::TestBaseWithParam<Size> histogram;
+
+PERF_TEST_P(histogram, unwrapPhaseMap, testing::Values(Size(640, 480), Size(1920, 1080), Size(2592, 1944)))
+{
+    const Size size = GetParam();
+
+    // wrapped tilted paraboloid with a shadowed disk in the middle
+    Mat wrappedPhaseMap(size, CV_32FC1);
+    Mat shadowMask(size, CV_8UC1, Scalar::all(255));
+    const float cx = size.width / 2.f, cy = size.height / 2.f, r2 = cx * cx + cy * cy;
+    for (int i = 0; i < size.height; i++)
+    {
+        for (int j = 0; j < size.width; j++)
+        {
+            float v = 60.f * ((j - cx) * (j - cx) + (i - cy) * (i - cy)) / r2 + 40.f * j / size.width;
+            wrappedPhaseMap.at<float>(i, j) = std::atan2(std::sin(v), std::cos(v));
+            if ((j - cx) * (j - cx) + (i - cy) * (i - cy) < size.height * size.height / 64.f)
+                shadowMask.at<uchar>(i, j) = 0;
+        }
+    }
+
+    HistogramPhaseUnwrapping::Params params;
+    params.width = size.width;
+    params.height = size.height;
+    Ptr<HistogramPhaseUnwrapping> phaseUnwrapping = HistogramPhaseUnwrapping::create(params);
+
+    Mat unwrappedPhaseMap;
+    TEST_CYCLE() phaseUnwrapping->unwrapPhaseMap(wrappedPhaseMap, unwrappedPhaseMap, shadowMask);
+
+    SANITY_CHECK_NOTHING();
+}
+
+}} // namespace
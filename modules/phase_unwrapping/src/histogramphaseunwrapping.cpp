@@ -60,116 +60,48 @@ public:
     void getInverseReliabilityMap( OutputArray reliabilityMap ) CV_OVERRIDE;
 
 private:
-    // Class describing a pixel
-    class Pixel
-    {
-    private:
-        // Value from the wrapped phase map
-        float phaseValue;
-        // Id of a pixel. Computed from its position in the Mat
-        int idx;
-        // Pixel is valid if it's not in a shadow region
-        bool valid;
-        // "Quality" parameter. See reference paper
-        float inverseReliability;
-        // Number of 2pi  that needs to be added to the pixel to unwrap the phase map
-        int increment;
-        // Number of pixels that are in the same group as the current pixel
-        int nbrOfPixelsInGroup;
-        // Group id. At first, group id is the same value as idx
-        int groupId;
-        // Pixel is alone in its group
-        bool singlePixelGroup;
-    public:
-        Pixel();
-        Pixel( float pV, int id, bool v, float iR, int inc );
-        float getPhaseValue();
-        int getIndex();
-        bool getValidity();
-        float getInverseReliability();
-        int getIncrement();
-        int getNbrOfPixelsInGroup();
-        int getGroupId();
-        bool getSinglePixelGroup();
-        void setIncrement( int inc );
-        // When a pixel which is not in a single group is added to a new group, we need to keep the previous increment and add "inc" to it.
-        void changeIncrement( int inc );
-        void setNbrOfPixelsInGroup( int nbr );
-        void setGroupId( int gId );
-        void setSinglePixelGroup( bool s );
-    };
-    // Class describing an Edge as presented in the reference paper
-    class Edge
-    {
-    private:
-        // Id of the first pixel that forms the edge
-        int pixOneId;
-        // Id of the second pixel that forms the edge
-        int pixTwoId;
-        // Number of 2pi that needs to be added to the second pixel to remove discontinuities
-        int increment;
-    public:
-        Edge();
-        Edge( int p1, int p2, int inc );
-        int getPixOneId();
-        int getPixTwoId();
-        int getIncrement();
-    };
-    // Class describing a bin from the histogram
-    class HistogramBin
-    {
-    private:
-        float start;
-        float end;
-        std::vector<Edge> edges;
-    public:
-        HistogramBin();
-        HistogramBin( float s, float e );
-        void addEdge( Edge e );
-        std::vector<Edge> getEdges();
-    };
-    // Class describing the histogram. Bins before "thresh" are smaller than the one after "thresh" value
-    class Histogram
-    {
-    private:
-        std::vector<HistogramBin> bins;
-        float thresh;
-        float smallWidth;
-        float largeWidth;
-        int nbrOfSmallBins;
-        int nbrOfLargeBins;
-        int nbrOfBins;
-    public:
-        Histogram();
-        void createBins( float t, int nbrOfBinsBeforeThresh, int nbrOfBinsAfterThresh );
-        void addBin( HistogramBin b );
-        void addEdgeInBin( Edge e, int binIndex);
-        float getThresh();
-        float getSmallWidth();
-        float getLargeWidth();
-        int getNbrOfBins();
-        std::vector<Edge> getEdgesFromBin( int binIndex );
-    };
     // Params for phase unwrapping
     Params params;
-    // Pixels from the wrapped phase map
-    std::vector<Pixel> pixels;
-    // Histogram used to unwrap
-    Histogram histogram;
+    /* Pixels from the wrapped phase map. Each pixel attribute is stored in its own vector,
+     * indexed by the pixel position idx = i*cols + j
+     */
+    // Value from the wrapped phase map
+    std::vector<float> phaseValues;
+    // "Quality" parameter. See reference paper
+    std::vector<float> inverseReliabilities;
+    // Pixel is valid if it's not in a shadow region
+    std::vector<uchar> validity;
+    /* Edges sorted by histogram bin, in creation order inside a bin. An edge links pixel idx to
+     * its right neighbour (stored as 2*idx) or to the pixel under it (stored as 2*idx + 1)
+     */
+    std::vector<int> edges;
+    // Width of the histogram bins before and after params.histThresh
+    float smallWidth;
+    float largeWidth;
+    /* Groups of pixels are stored as a union-find forest. The increment of a pixel, i.e. the number
+     * of 2pi that needs to be added to it to unwrap the phase map, is the sum of the increments
+     * stored along its path to the root of its group.
+     */
+    std::vector<int> parents;
+    std::vector<int> increments;
+    // Number of pixels in the group, only up to date for the group roots
+    std::vector<int> nbrOfPixelsInGroup;
     // Compute pixel reliability.
     void computePixelsReliability( InputArray wrappedPhaseMap, InputArray shadowMask = noArray() );
     // Compute edges reliability and sort them in the histogram
     void computeEdgesReliabilityAndCreateHistogram();
-    // Methods that is used in the previous one
-    void createAndSortEdge( int idx1, int idx2 );
+    // Histogram bin of the edge linking pixels idx1 and idx2
+    int findBin( int idx1, int idx2 ) const;
     // Unwrap the phase map thanks to the histogram
     void unwrapHistogram();
+    // Returns the root of the group of pixel idx and the increment of the pixel, compressing its path
+    int findGroup( int idx, int &increment );
     // add right number of 2*pi to the pixels
     void addIncrement( OutputArray unwrappedPhaseMap );
     // Gamma function from the paper
-    float wrap( float a, float b );
+    float wrap( float a, float b ) const;
     // Similar to the previous one but returns the number of 2pi that needs to be added
-    int findInc( float a, float b );
+    int findInc( float a, float b ) const;
 };
 // Default parameters
 HistogramPhaseUnwrapping::Params::Params(){
@@ -182,204 +114,11 @@ HistogramPhaseUnwrapping::Params::Params(){
 HistogramPhaseUnwrapping_Impl::HistogramPhaseUnwrapping_Impl(
                             const HistogramPhaseUnwrapping::Params &parameters ) : params(parameters)
 {
-
-}
-
-HistogramPhaseUnwrapping_Impl::Pixel::Pixel()
-{
-
-}
-// Constructor
-HistogramPhaseUnwrapping_Impl::Pixel::Pixel( float pV, int id, bool v, float iR, int inc )
-{
-    phaseValue = pV;
-    idx = id;
-    valid = v;
-    inverseReliability = iR;
-    increment = inc;
-    nbrOfPixelsInGroup = 1;
-    groupId = id;
-    singlePixelGroup = true;
-}
-
-float HistogramPhaseUnwrapping_Impl::Pixel::getPhaseValue()
-{
-    return phaseValue;
-}
-
-int HistogramPhaseUnwrapping_Impl::Pixel::getIndex()
-{
-    return idx;
-}
-
-bool HistogramPhaseUnwrapping_Impl::Pixel::getValidity()
-{
-    return valid;
-}
-
-float HistogramPhaseUnwrapping_Impl::Pixel::getInverseReliability()
-{
-    return inverseReliability;
-}
-
-int HistogramPhaseUnwrapping_Impl::Pixel::getIncrement()
-{
-    return increment;
-}
-
-int HistogramPhaseUnwrapping_Impl::Pixel::getNbrOfPixelsInGroup()
-{
-    return nbrOfPixelsInGroup;
-}
-
-int HistogramPhaseUnwrapping_Impl::Pixel::getGroupId()
-{
-    return groupId;
-}
-
-bool HistogramPhaseUnwrapping_Impl::Pixel::getSinglePixelGroup()
-{
-    return singlePixelGroup;
-}
-
-void HistogramPhaseUnwrapping_Impl::Pixel::setIncrement( int inc )
-{
-    increment = inc;
-}
-/* When a pixel of a non-single group is added to an other non-single group, we need to add a new
-increment to the one that was there previously and that was already removing some wraps.
-*/
-void HistogramPhaseUnwrapping_Impl::Pixel::changeIncrement( int inc )
-{
-    increment += inc;
-}
-
-void HistogramPhaseUnwrapping_Impl::Pixel::setNbrOfPixelsInGroup( int nbr )
-{
-    nbrOfPixelsInGroup = nbr;
-}
-void HistogramPhaseUnwrapping_Impl::Pixel::setGroupId( int gId )
-{
-    groupId = gId;
-}
-
-void HistogramPhaseUnwrapping_Impl::Pixel::setSinglePixelGroup( bool s )
-{
-    singlePixelGroup = s;
-}
-
-HistogramPhaseUnwrapping_Impl::Edge::Edge()
-{
-
-}
-// Constructor
-HistogramPhaseUnwrapping_Impl::Edge::Edge( int p1, int p2, int inc )
-{
-    pixOneId = p1;
-    pixTwoId = p2;
-    increment = inc;
-}
-
-int HistogramPhaseUnwrapping_Impl::Edge::getPixOneId()
-{
-    return pixOneId;
-}
-
-int HistogramPhaseUnwrapping_Impl::Edge::getPixTwoId()
-{
-    return pixTwoId;
-}
-
-int HistogramPhaseUnwrapping_Impl::Edge::getIncrement()
-{
-    return increment;
-}
-
-HistogramPhaseUnwrapping_Impl::HistogramBin::HistogramBin()
-{
-
-}
-
-HistogramPhaseUnwrapping_Impl::HistogramBin::HistogramBin( float s, float e )
-{
-    start = s;
-    end = e;
-}
-
-void HistogramPhaseUnwrapping_Impl::HistogramBin::addEdge( Edge e )
-{
-    edges.push_back(e);
-}
-std::vector<HistogramPhaseUnwrapping_Impl::Edge> HistogramPhaseUnwrapping_Impl::HistogramBin::getEdges()
-{
-    return edges;
-}
-HistogramPhaseUnwrapping_Impl::Histogram::Histogram()
-{
-
-}
-/*
- * create histogram bins. Bins size is not uniform, as in the reference paper
- *
- */
-void HistogramPhaseUnwrapping_Impl::Histogram::createBins( float t, int nbrOfBinsBeforeThresh,
-                                                           int nbrOfBinsAfterThresh )
-{
-    thresh = t;
-
-    nbrOfSmallBins = nbrOfBinsBeforeThresh;
-    nbrOfLargeBins = nbrOfBinsAfterThresh;
-    nbrOfBins = nbrOfBinsBeforeThresh + nbrOfBinsAfterThresh;
-
-    smallWidth = thresh / nbrOfSmallBins;
-    largeWidth = static_cast<float>(32 * CV_PI * CV_PI - thresh) / static_cast<float>(nbrOfLargeBins);
-
-    for( int i = 0; i < nbrOfSmallBins; ++i )
-    {
-        addBin(HistogramBin(i * smallWidth, ( i + 1 ) * smallWidth));
-    }
-    for( int i = 0; i < nbrOfLargeBins; ++i )
-    {
-        addBin(HistogramBin(thresh + i * largeWidth, thresh + ( i + 1 ) * largeWidth));
-    }
-}
-// Add a bin b to the histogram
-void HistogramPhaseUnwrapping_Impl::Histogram::addBin( HistogramBin b )
-{
-    bins.push_back(b);
-}
-// Add edge E in bin binIndex
-void HistogramPhaseUnwrapping_Impl::Histogram::addEdgeInBin( Edge e, int binIndex )
-{
-    bins[binIndex].addEdge(e);
-}
-float HistogramPhaseUnwrapping_Impl::Histogram::getThresh()
-{
-    return thresh;
-}
-
-float HistogramPhaseUnwrapping_Impl::Histogram::getSmallWidth()
-{
-    return smallWidth;
+    smallWidth = params.histThresh / params.nbrOfSmallBins;
+    largeWidth = static_cast<float>(32 * CV_PI * CV_PI - params.histThresh) /
+                 static_cast<float>(params.nbrOfLargeBins);
 }
 
-float HistogramPhaseUnwrapping_Impl::Histogram::getLargeWidth()
-{
-    return largeWidth;
-}
-
-int HistogramPhaseUnwrapping_Impl::Histogram::getNbrOfBins()
-{
-    return nbrOfBins;
-}
-
-std::vector<HistogramPhaseUnwrapping_Impl::Edge> HistogramPhaseUnwrapping_Impl::
-                                                 Histogram::getEdgesFromBin( int binIndex )
-{
-    std::vector<HistogramPhaseUnwrapping_Impl::Edge> temp;
-    temp = bins[binIndex].getEdges();
-    return temp;
-}
 /* Method in which reliabilities are computed and edges are sorted in the histogram.
 Increments are computed for each pixels.
  */
@@ -420,291 +159,227 @@ void HistogramPhaseUnwrapping_Impl::computePixelsReliability( InputArray wrapped
     Mat &wPhaseMap = *(Mat*) wrappedPhaseMap.getObj();
     Mat &mask = *(Mat*) shadowMask.getObj();
 
-    int idx; //idx is used to store pixel position (idx = i*cols + j)
-    bool valid;//tells if a pixel is in the valid mask region
+    phaseValues.resize(rows * cols);
+    inverseReliabilities.resize(rows * cols);
+    validity.resize(rows * cols);
 
-    // H, V, D1, D2 are from the paper
-    float H, V, D1, D2, D;
-    /* used to store neighbours coordinates
-     * ul = upper left, um = upper middle, ur = upper right
-     * ml = middle left, mr = middle right
-     * ll = lower left, lm = lower middle, lr = lower right
-     */
-    Point ul, um, ur, ml, mr, ll, lm, lr;
+    const float maxInverseReliability = static_cast<float>(16 * CV_PI * CV_PI);
 
-    for( int i = 0; i < rows; ++i )
+    parallel_for_(Range(0, rows), [&](const Range& range)
     {
-        for( int j = 0; j < cols; ++j )
+        for( int i = range.start; i < range.end; ++i )
         {
-            if( mask.at<uchar>( i, j ) != 0 ) //if pixel is in a valid region
+            const float* phase = wPhaseMap.ptr<float>(i);
+            const uchar* maskRow = mask.ptr<uchar>(i);
+            for( int j = 0; j < cols; ++j )
             {
-                if( i == 0 || i == rows - 1 || j == 0 || j == cols - 1 )
-                {
-                    idx = i * cols + j;
-                    valid = true;
-                    Pixel p(wPhaseMap.at<float>(i, j), idx, valid,
-                            static_cast<float>(16 * CV_PI * CV_PI), 0);
-                    pixels.push_back(p);
-                }
-                else
+                int idx = i * cols + j; //idx is used to store pixel position
+                phaseValues[idx] = phase[j];
+                validity[idx] = maskRow[j] != 0;
+                // pixel is not in a valid region or on the border. It's inverse reliability is set to the maximum
+                inverseReliabilities[idx] = maxInverseReliability;
+
+                if( maskRow[j] == 0 || i == 0 || i == rows - 1 || j == 0 || j == cols - 1 )
+                    continue;
+
+                /* if one of the neighbouring pixel is not fully valid,
+                 * pixel (i,j) is considered as being on the border.
+                 */
+                const uchar* up = maskRow - mask.step[0];
+                const uchar* down = maskRow + mask.step[0];
+                if( up[j-1] != 255 || up[j] != 255 || up[j+1] != 255 ||
+                    maskRow[j-1] != 255 || maskRow[j] != 255 || maskRow[j+1] != 255 ||
+                    down[j-1] != 255 || down[j] != 255 || down[j+1] != 255 )
+                    continue;
+
+                /* neighbours:
+                 * ul = upper left, um = upper middle, ur = upper right
+                 * ml = middle left, mr = middle right
+                 * ll = lower left, lm = lower middle, lr = lower right
+                 */
+                const float* upPhase = wPhaseMap.ptr<float>(i - 1);
+                const float* downPhase = wPhaseMap.ptr<float>(i + 1);
+                float ul = upPhase[j-1], um = upPhase[j], ur = upPhase[j+1];
+                float ml = phase[j-1], mm = phase[j], mr = phase[j+1];
+                float ll = downPhase[j-1], lm = downPhase[j], lr = downPhase[j+1];
+
+                // H, V, D1, D2 are from the paper
+                float H = wrap(ml, mm) - wrap(mm, mr);
+                float V = wrap(um, mm) - wrap(mm, lm);
+                float D1 = wrap(ul, mm) - wrap(mm, lr);
+                float D2 = wrap(ur, mm) - wrap(mm, ll);
+                inverseReliabilities[idx] = H * H + V * V + D1 * D1 + D2 * D2;
+            }
+        }
+    });
+}
+/* Edges are created from the pixels: each valid pixel is linked to its right neighbour (first edge)
+ * and to the one that is under it (second edge), when they are valid.
+ * Edges are sorted in the histogram bins with a counting sort: the edges of each band of rows are
+ * first counted per bin, which gives the position of the first edge of every (band, bin) pair, then
+ * stored at these positions. Inside a bin, edges stay in the order in which they are created.
+ */
+void HistogramPhaseUnwrapping_Impl::computeEdgesReliabilityAndCreateHistogram()
+{
+    const int rows = params.height;
+    const int cols = params.width;
+    const int nbrOfBins = params.nbrOfSmallBins + params.nbrOfLargeBins;
+    const int bandHeight = 32;
+    const int nbrOfBands = ( rows + bandHeight - 1 ) / bandHeight;
+
+    // number of edges of band b in bin k, then position of the first one, in binPositions[b*nbrOfBins + k]
+    std::vector<int> binPositions(nbrOfBands * nbrOfBins, 0);
+
+    // count (store = false) or store (store = true) the edges of the bands in range
+    auto processBands = [&]( const Range& range, bool store )
+    {
+        for( int b = range.start; b < range.end; ++b )
+        {
+            int* positions = &binPositions[b * nbrOfBins];
+            int rowEnd = std::min(rows, ( b + 1 ) * bandHeight);
+            for( int i = b * bandHeight; i < rowEnd; ++i )
+            {
+                for( int j = 0; j < cols; ++j )
                 {
-                    ul = Point(j-1, i-1);
-                    um = Point(j, i-1);
-                    ur = Point(j+1, i-1);
-                    ml = Point(j-1, i);
-                    mr = Point(j+1, i);
-                    ll = Point(j-1, i+1);
-                    lm = Point(j, i+1);
-                    lr = Point(j+1, i+1);
-
-                    Mat neighbourhood = mask( Rect( j-1, i-1, 3, 3 ) );
-                    Scalar meanValue = mean(neighbourhood);
-
-                    /* if mean value is different from 255, it means that one of the neighbouring
-                     * pixel is not valid -> pixel (i,j) is considered as being on the border.
-                     */
-                    if( meanValue[0] != 255 )
+                    int idx = i * cols + j;
+                    if( !validity[idx] )
+                        continue;
+                    if( j != cols - 1 && validity[idx + 1] ) // Pixel to the right
                     {
-                        idx = i * cols + j;
-                        valid = true;
-                        Pixel p(wPhaseMap.at<float>(i, j), idx, valid,
-                                static_cast<float>(16 * CV_PI * CV_PI), 0);
-                        pixels.push_back(p);
+                        int binIndex = findBin(idx, idx + 1);
+                        if( store )
+                            edges[positions[binIndex]] = 2 * idx;
+                        positions[binIndex]++;
                     }
-                    else
+                    if( i != rows - 1 && validity[idx + cols] ) // Pixel under pixel idx
                     {
-                        H = wrap(wPhaseMap.at<float>(ml.y, ml.x), wPhaseMap.at<float>(i, j))
-                            - wrap(wPhaseMap.at<float>(i, j), wPhaseMap.at<float>(mr.y, mr.x));
-                        V = wrap(wPhaseMap.at<float>(um.y, um.x), wPhaseMap.at<float>(i, j))
-                            - wrap(wPhaseMap.at<float>(i, j), wPhaseMap.at<float>(lm.y, lm.x));
-                        D1 = wrap(wPhaseMap.at<float>(ul.y, ul.x), wPhaseMap.at<float>(i, j))
-                            - wrap(wPhaseMap.at<float>(i, j), wPhaseMap.at<float>(lr.y, lr.x));
-                        D2 = wrap(wPhaseMap.at<float>(ur.y, ur.x), wPhaseMap.at<float>(i, j))
-                            - wrap(wPhaseMap.at<float>(i, j), wPhaseMap.at<float>(ll.y, ll.x));
-                        D = H * H + V * V + D1 * D1 + D2 * D2;
-
-                        idx = i * cols + j;
-                        valid = true;
-                        Pixel p(wPhaseMap.at<float>(i, j), idx, valid, D, 0);
-                        pixels.push_back(p);
+                        int binIndex = findBin(idx, idx + cols);
+                        if( store )
+                            edges[positions[binIndex]] = 2 * idx + 1;
+                        positions[binIndex]++;
                     }
                 }
             }
-            else // pixel is not in a valid region. It's inverse reliability is set to the maximum
-            {
-                idx = i * cols + j;
-                valid = false;
-                Pixel p(wPhaseMap.at<float>(i, j), idx, valid,
-                        static_cast<float>(16 * CV_PI * CV_PI), 0);
-                pixels.push_back(p);
-            }
+        }
+    };
+
+    parallel_for_(Range(0, nbrOfBands), [&]( const Range& range ) { processBands(range, false); });
+
+    int nbrOfEdges = 0;
+    for( int k = 0; k < nbrOfBins; ++k )
+    {
+        for( int b = 0; b < nbrOfBands; ++b )
+        {
+            int count = binPositions[b * nbrOfBins + k];
+            binPositions[b * nbrOfBins + k] = nbrOfEdges;
+            nbrOfEdges += count;
         }
     }
+    edges.resize(nbrOfEdges);
+
+    parallel_for_(Range(0, nbrOfBands), [&]( const Range& range ) { processBands(range, true); });
 }
-/* Edges are created from the vector of pixels. We loop on the vector and create the edges
- * that link the current pixel to his right neighbour (first edge) and the one that is under it (second edge)
+/* Histogram bins are not uniform, as in the reference paper: bins before "histThresh" are smaller
+ * than the ones after it.
  */
-void HistogramPhaseUnwrapping_Impl::computeEdgesReliabilityAndCreateHistogram()
+int HistogramPhaseUnwrapping_Impl::findBin( int idx1, int idx2 ) const
 {
-    int row;
-    int col;
-    histogram.createBins(params.histThresh, params.nbrOfSmallBins, params.nbrOfLargeBins);
-    int nbrOfPixels = static_cast<int>(pixels.size());
-    /* Edges are built by considering a pixel and it's right-neighbour and lower-neighbour.
-     We discard non-valid pixels here.
-     */
-    for( int i = 0; i < nbrOfPixels; ++i )
+    float edgeReliability = inverseReliabilities[idx1] + inverseReliabilities[idx2];
+    int binIndex;
+    if( edgeReliability < params.histThresh )
     {
-        if( pixels[i].getValidity() )
-        {
-            row = pixels[i].getIndex() / params.width;
-            col = pixels[i].getIndex() % params.width;
-
-            if( row != params.height - 1 && col != params.width -1 )
-            {
-                int idxRight, idxDown;
-                idxRight = row * params.width + col + 1; // Pixel to the right
-                idxDown = ( row + 1 ) * params.width + col; // Pixel under pixel i.
-                createAndSortEdge(i, idxRight);
-                createAndSortEdge(i, idxDown);
-            }
-            else if( row != params.height - 1 && col == params.width - 1 )
-            {
-                int idxDown = ( row + 1 ) * params.width + col;
-                createAndSortEdge(i, idxDown);
-            }
-            else if( row == params.height - 1 && col != params.width - 1 )
-            {
-                int idxRight = row * params.width + col + 1;
-                createAndSortEdge(i, idxRight);
-            }
-        }
+        binIndex = static_cast<int> (ceil(edgeReliability / smallWidth) - 1);
+    }
+    else
+    {
+        binIndex = params.nbrOfSmallBins +
+                   static_cast<int> (ceil((edgeReliability - params.histThresh) / largeWidth) - 1);
     }
+    return std::min(std::max(binIndex, 0), params.nbrOfSmallBins + params.nbrOfLargeBins - 1);
 }
-/*used along the previous method to sort edges in the histogram*/
-void HistogramPhaseUnwrapping_Impl::createAndSortEdge( int idx1, int idx2 )
+
+/* Edges are processed from the most reliable bin to the least reliable one. The two groups linked
+ * by an edge are merged: the smallest group is added to the largest one, and for groups of the same
+ * size, the group of the least reliable pixel is added to the other one. The pixels of the added
+ * group get the same number of 2pi, which only needs to be added to the root of the group.
+ */
+void HistogramPhaseUnwrapping_Impl::unwrapHistogram()
 {
-    if( pixels[idx2].getValidity() )
+    int nbrOfPixels = static_cast<int>(validity.size());
+    int nbrOfEdges = static_cast<int>(edges.size());
+
+    parents.resize(nbrOfPixels);
+    for( int i = 0; i < nbrOfPixels; ++i )
+        parents[i] = i;
+    increments.assign(nbrOfPixels, 0);
+    nbrOfPixelsInGroup.assign(nbrOfPixels, 1);
+
+    for( int j = 0; j < nbrOfEdges; ++j )
     {
-        float edgeReliability = pixels[idx1].getInverseReliability() +
-                                pixels[idx2].getInverseReliability();
-        int inc = findInc(pixels[idx2].getPhaseValue(), pixels[idx1].getPhaseValue());
-        Edge e(idx1, idx2, inc);
+        int pOneId = edges[j] >> 1;
+        int pTwoId = pOneId + ( ( edges[j] & 1 ) ? params.width : 1 );
+        // Number of 2pi that needs to be added to the second pixel to remove discontinuities
+        int edgeInc = findInc(phaseValues[pTwoId], phaseValues[pOneId]);
+
+        int incOne, incTwo;
+        int groupOne = findGroup(pOneId, incOne);
+        int groupTwo = findGroup(pTwoId, incTwo);
+        if( groupOne == groupTwo )
+            continue;
+
+        int nbrOfPixelsInGroupOne = nbrOfPixelsInGroup[groupOne];
+        int nbrOfPixelsInGroupTwo = nbrOfPixelsInGroup[groupTwo];
+        float invRel1 = inverseReliabilities[pOneId];
+        float invRel2 = inverseReliabilities[pTwoId];
+
+        bool oneToTwo;
+        // Both pixels are in a single group: the pixel with the worst quality is added to the other one
+        if( nbrOfPixelsInGroupOne == 1 && nbrOfPixelsInGroupTwo == 1 )
+            oneToTwo = invRel1 > invRel2;
+        else
+            oneToTwo = nbrOfPixelsInGroupOne < nbrOfPixelsInGroupTwo ||
+                       ( nbrOfPixelsInGroupOne == nbrOfPixelsInGroupTwo && invRel1 >= invRel2 );
 
-        if( edgeReliability < histogram.getThresh() )
+        int from, to, inc;
+        if( oneToTwo ) //group p1 added to group p2
         {
-            int binIndex = static_cast<int> (ceil(edgeReliability / histogram.getSmallWidth()) - 1);
-            if( binIndex == -1 )
-            {
-                binIndex = 0;
-            }
-            histogram.addEdgeInBin(e, binIndex);
+            from = groupOne;
+            to = groupTwo;
+            inc = incTwo + edgeInc - incOne;
         }
-        else
+        else //group p2 added to group p1
         {
-            int binIndex = params.nbrOfSmallBins +
-                           static_cast<int> (ceil((edgeReliability - histogram.getThresh()) /
-                                 histogram.getLargeWidth()) - 1);
-            histogram.addEdgeInBin(e, binIndex);
+            from = groupTwo;
+            to = groupOne;
+            inc = incOne - edgeInc - incTwo;
         }
+        parents[from] = to;
+        increments[from] += inc - increments[to];
+        nbrOfPixelsInGroup[to] += nbrOfPixelsInGroup[from];
     }
 }
-
-void HistogramPhaseUnwrapping_Impl::unwrapHistogram()
+int HistogramPhaseUnwrapping_Impl::findGroup( int idx, int &increment )
 {
-    int nbrOfPixels = static_cast<int>(pixels.size());
-    int nbrOfBins = histogram.getNbrOfBins();
-    /* This vector is used to keep track of the number of pixels in each group and avoid useless group.
-       For example, if lastPixelAddedToGroup[10] is equal to 5, it means that pixel "5" was the last one
-       to be added to group 10. So, pixel "5" is the only one that has the correct value for parameter
-       "numberOfPixelsInGroup" in order to avoid a loop on all the pixels to update this number*/
-    std::vector<int> lastPixelAddedToGroup(nbrOfPixels, 0);
-    for( int i = 0; i < nbrOfBins; ++i )
+    int root = idx;
+    int inc = 0;
+    while( parents[root] != root )
     {
-        std::vector<Edge> currentEdges = histogram.getEdgesFromBin(i);
-        int nbrOfEdgesInBin = static_cast<int>(currentEdges.size());
-
-        for( int j = 0; j < nbrOfEdgesInBin; ++j )
-        {
-
-            int pOneId = currentEdges[j].getPixOneId();
-            int pTwoId = currentEdges[j].getPixTwoId();
-            // Both pixels are in a single group.
-            if( pixels[pOneId].getSinglePixelGroup() && pixels[pTwoId].getSinglePixelGroup() )
-            {
-                float invRel1 = pixels[pOneId].getInverseReliability();
-                float invRel2 = pixels[pTwoId].getInverseReliability();
-                // Quality of pixel 2 is better than that of pixel 1 -> pixel 1 is added to group 2
-                if( invRel1 > invRel2 )
-                {
-                    int newGroupId = pixels[pTwoId].getGroupId();
-                    int newInc = pixels[pTwoId].getIncrement() + currentEdges[j].getIncrement();
-                    pixels[pOneId].setGroupId(newGroupId);
-                    pixels[pOneId].setIncrement(newInc);
-                    lastPixelAddedToGroup[newGroupId] = pOneId; // Pixel 1 is the last one to be added to group 2
-                }
-                else
-                {
-                    int newGroupId = pixels[pOneId].getGroupId();
-                    int newInc = pixels[pOneId].getIncrement() - currentEdges[j].getIncrement();
-                    pixels[pTwoId].setGroupId(newGroupId);
-                    pixels[pTwoId].setIncrement(newInc);
-                    lastPixelAddedToGroup[newGroupId] = pTwoId;
-                }
-                pixels[pOneId].setNbrOfPixelsInGroup(2);
-                pixels[pTwoId].setNbrOfPixelsInGroup(2);
-                pixels[pOneId].setSinglePixelGroup(false);
-                pixels[pTwoId].setSinglePixelGroup(false);
-            }
-            //p1 is in a single group, p2 is not -> p1 added to p2
-            else if( pixels[pOneId].getSinglePixelGroup() && !pixels[pTwoId].getSinglePixelGroup() )
-            {
-                int newGroupId = pixels[pTwoId].getGroupId();
-                int lastPix = lastPixelAddedToGroup[newGroupId];
-                int newNbrOfPixelsInGroup = pixels[lastPix].getNbrOfPixelsInGroup() + 1;
-                int newInc = pixels[pTwoId].getIncrement() + currentEdges[j].getIncrement();
-
-                pixels[pOneId].setGroupId(newGroupId);
-                pixels[pOneId].setNbrOfPixelsInGroup(newNbrOfPixelsInGroup);
-                pixels[pTwoId].setNbrOfPixelsInGroup(newNbrOfPixelsInGroup);
-                pixels[pOneId].setIncrement(newInc);
-                pixels[pOneId].setSinglePixelGroup(false);
-
-                lastPixelAddedToGroup[newGroupId] = pOneId;
-            }
-            //p2 is in a single group, p1 is not -> p2 added to p1
-            else if( !pixels[pOneId].getSinglePixelGroup() && pixels[pTwoId].getSinglePixelGroup() )
-            {
-                int newGroupId = pixels[pOneId].getGroupId();
-                int lastPix = lastPixelAddedToGroup[newGroupId];
-                int newNbrOfPixelsInGroup = pixels[lastPix].getNbrOfPixelsInGroup() + 1;
-                int newInc = pixels[pOneId].getIncrement() - currentEdges[j].getIncrement();
-
-                pixels[pTwoId].setGroupId(newGroupId);
-                pixels[pTwoId].setNbrOfPixelsInGroup(newNbrOfPixelsInGroup);
-                pixels[pOneId].setNbrOfPixelsInGroup(newNbrOfPixelsInGroup);
-                pixels[pTwoId].setIncrement(newInc);
-                pixels[pTwoId].setSinglePixelGroup(false);
-
-                lastPixelAddedToGroup[newGroupId] = pTwoId;
-            }
-            //p1 and p2 are in two different groups
-            else if( pixels[pOneId].getGroupId() != pixels[pTwoId].getGroupId() )
-            {
-                int pOneGroupId = pixels[pOneId].getGroupId();
-                int pTwoGroupId = pixels[pTwoId].getGroupId();
-
-                float invRel1 = pixels[pOneId].getInverseReliability();
-                float invRel2 = pixels[pTwoId].getInverseReliability();
-
-                int lastAddedToGroupOne = lastPixelAddedToGroup[pOneGroupId];
-                int lastAddedToGroupTwo = lastPixelAddedToGroup[pTwoGroupId];
-
-                int nbrOfPixelsInGroupOne = pixels[lastAddedToGroupOne].getNbrOfPixelsInGroup();
-                int nbrOfPixelsInGroupTwo = pixels[lastAddedToGroupTwo].getNbrOfPixelsInGroup();
-
-                int totalNbrOfPixels = nbrOfPixelsInGroupOne + nbrOfPixelsInGroupTwo;
-
-                if( nbrOfPixelsInGroupOne < nbrOfPixelsInGroupTwo ||
-                   (nbrOfPixelsInGroupOne == nbrOfPixelsInGroupTwo && invRel1 >= invRel2) ) //group p1 added to group p2
-                {
-                    pixels[pTwoId].setNbrOfPixelsInGroup(totalNbrOfPixels);
-                    pixels[pOneId].setNbrOfPixelsInGroup(totalNbrOfPixels);
-                    int inc = pixels[pTwoId].getIncrement() + currentEdges[j].getIncrement() -
-                                 pixels[pOneId].getIncrement();
-                    lastPixelAddedToGroup[pTwoGroupId] = pOneId;
+        inc += increments[root];
+        root = parents[root];
+    }
+    increment = inc + increments[root];
 
-                    for( int k = 0; k < nbrOfPixels; ++k )
-                    {
-                        if( pixels[k].getGroupId() == pOneGroupId )
-                        {
-                            pixels[k].setGroupId(pTwoGroupId);
-                            pixels[k].changeIncrement(inc);
-                        }
-                    }
-                }
-                else if( nbrOfPixelsInGroupOne > nbrOfPixelsInGroupTwo ||
-                        (nbrOfPixelsInGroupOne == nbrOfPixelsInGroupTwo && invRel2 > invRel1) ) //group p2 added to group p1
-                {
-                    int oldGroupId = pTwoGroupId;
-                    pixels[pOneId].setNbrOfPixelsInGroup(totalNbrOfPixels);
-                    pixels[pTwoId].setNbrOfPixelsInGroup(totalNbrOfPixels);
-                    int inc = pixels[pOneId].getIncrement() - currentEdges[j].getIncrement() -
-                              pixels[pTwoId].getIncrement();
-                    lastPixelAddedToGroup[pOneGroupId] = pTwoId;
-
-                    for( int k = 0; k < nbrOfPixels; ++k )
-                    {
-                        if( pixels[k].getGroupId() == oldGroupId )
-                        {
-                            pixels[k].setGroupId(pOneGroupId);
-                            pixels[k].changeIncrement(inc);
-                        }
-                    }
-                }
-            }
-        }
+    // link the pixels of the path directly to the root, keeping their increment
+    while( parents[idx] != root && idx != root )
+    {
+        int next = parents[idx];
+        int relInc = increments[idx];
+        parents[idx] = root;
+        increments[idx] = inc;
+        inc -= relInc;
+        idx = next;
     }
+    return root;
 }
 void HistogramPhaseUnwrapping_Impl::addIncrement( OutputArray unwrappedPhaseMap )
 {
@@ -713,20 +388,30 @@ void HistogramPhaseUnwrapping_Impl::addIncrement( OutputArray unwrappedPhaseMap
     int cols = params.width;
     if( uPhaseMap.empty() )
         uPhaseMap.create(rows, cols, CV_32FC1);
-    int nbrOfPixels = static_cast<int>(pixels.size());
-    for( int i = 0; i < nbrOfPixels; ++i )
-    {
-        int row = pixels[i].getIndex() / params.width;
-        int col = pixels[i].getIndex() % params.width;
 
-        if( pixels[i].getValidity() )
+    parallel_for_(Range(0, rows), [&]( const Range& range )
+    {
+        for( int i = range.start; i < range.end; ++i )
         {
-            uPhaseMap.at<float>(row, col) = pixels[i].getPhaseValue() +
-                                            static_cast<float>(2 * CV_PI * pixels[i].getIncrement());
+            float* uPhase = uPhaseMap.ptr<float>(i);
+            for( int j = 0; j < cols; ++j )
+            {
+                int idx = i * cols + j;
+                if( !validity[idx] )
+                    continue;
+
+                int inc = increments[idx];
+                for( int p = idx; parents[p] != p; )
+                {
+                    p = parents[p];
+                    inc += increments[p];
+                }
+                uPhase[j] = phaseValues[idx] + static_cast<float>(2 * CV_PI * inc);
+            }
         }
-    }
+    });
 }
-float HistogramPhaseUnwrapping_Impl::wrap( float a, float b )
+float HistogramPhaseUnwrapping_Impl::wrap( float a, float b ) const
 {
     float result;
     float difference = a - b;
@@ -740,7 +425,7 @@ float HistogramPhaseUnwrapping_Impl::wrap( float a, float b )
     return result;
 }
 
-int HistogramPhaseUnwrapping_Impl::findInc( float a, float b )
+int HistogramPhaseUnwrapping_Impl::findInc( float a, float b ) const
 {
     float difference;
     int wrapValue;
@@ -765,10 +450,11 @@ void HistogramPhaseUnwrapping_Impl::getInverseReliabilityMap( OutputArray invers
         reliabilityMap_.create(rows, cols, CV_32FC1);
     for( int i = 0; i < rows; ++i )
     {
+        float* reliability = reliabilityMap_.ptr<float>(i);
         for( int j = 0; j < cols; ++j )
         {
             int idx = i * cols + j;
-            reliabilityMap_.at<float>(i, j) = pixels[idx].getInverseReliability();
+            reliability[j] = inverseReliabilities[idx];
         }
     }
 }
@@ -260,4 +260,28 @@ PERF_TEST_P(Size_MatType, Registration_Projective,
     SANITY_CHECK_NOTHING();
 }
 
+// One iteration of the projective mapper, the innermost step of MapperPyramid
+PERF_TEST_P(Size_MatType, Registration_ProjectiveIteration,
+            Combine(Values(szVGA, sz720p),
+                    Values(MatType(CV_32FC1), MatType(CV_64FC1), MatType(CV_64FC3))))
+{
+    const Size size = get<0>(GetParam());
+    const int type = get<1>(GetParam());
+
+    Mat frame(size, type), warped;
+    declare.in(frame, WARMUP_RNG);
+
+    Matx<double, 3, 3> projTr(1., 0., 0., 0., 1., 0., 0.0001, 0.0001, 1);
+    MapProjec mapTest(projTr);
+    mapTest.warp(frame, warped);
+
+    MapperGradProj mapper;
+    Ptr<Map> init = mapper.getMap();
+    Ptr<Map> result;
+
+    TEST_CYCLE() result = mapper.calculate(frame, warped, init);
+
+    SANITY_CHECK_NOTHING();
+}
+
 }} // namespace
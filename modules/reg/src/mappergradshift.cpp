@@ -38,10 +38,24 @@
 #include "precomp.hpp"
 #include "opencv2/reg/mappergradshift.hpp"
 #include "opencv2/reg/mapshift.hpp"
+#include "normal_equations.hpp"
 
 namespace cv {
 namespace reg {
 
+namespace {
+
+struct ShiftJacobian
+{
+    void operator()(double, double, double Ix, double Iy, double* J) const
+    {
+        J[0] = Ix;
+        J[1] = Iy;
+    }
+};
+
+}  // namespace
+
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 MapperGradShift::MapperGradShift()
@@ -60,7 +74,6 @@ cv::Ptr<Map> MapperGradShift::calculate(
     InputArray _img1, InputArray image2, cv::Ptr<Map> init) const
 {
     Mat img1 = _img1.getMat();
-    Mat gradx, grady, imgDiff;
     Mat img2;
 
     CV_DbgAssert(img1.size() == image2.size());
@@ -72,23 +85,10 @@ cv::Ptr<Map> MapperGradShift::calculate(
         img2 = image2.getMat();
     }
 
-    // Get gradient in all channels
-    gradient(img1, img2, gradx, grady, imgDiff);
-
     // Calculate parameters using least squares
     Matx<double, 2, 2> A;
     Vec<double, 2> b;
-    // For each value in A, all the matrix elements are added and then the channels are also added,
-    // so we have two calls to "sum". The result can be found in the first element of the final
-    // Scalar object.
-
-    A(0, 0) = sum(sum(gradx.mul(gradx)))[0];
-    A(0, 1) = sum(sum(gradx.mul(grady)))[0];
-    A(1, 1) = sum(sum(grady.mul(grady)))[0];
-    A(1, 0) = A(0, 1);
-
-    b(0) = -sum(sum(imgDiff.mul(gradx)))[0];
-    b(1) = -sum(sum(imgDiff.mul(grady)))[0];
+    calculateNormalEquations(img1, img2, ShiftJacobian(), A, b);
 
     // Calculate shift. We use Cholesky decomposition, as A is symmetric.
     Vec<double, 2> shift = A.inv(DECOMP_CHOLESKY)*b;
@@ -0,0 +1,107 @@
+// This file is part of OpenCV project.
+// It is subject to the license terms in the LICENSE file found in the top-level directory
+// of this distribution and at http://opencv.org/license.html.
+
+#ifndef OPENCV_REG_NORMAL_EQUATIONS_HPP
+#define OPENCV_REG_NORMAL_EQUATIONS_HPP
+
+#include <algorithm>
+#include <vector>
+
+#include "opencv2/core.hpp"
+#include "opencv2/core/utility.hpp"
+
+namespace cv {
+namespace reg {
+
+template<typename _Tp, int N, typename Jacobian>
+static void accumulateNormalEquations(const Mat& img1, const Mat& img2, const Jacobian& jacobian,
+                                      int rowStart, int rowEnd,
+                                      Matx<double, N, N>& A, Vec<double, N>& b)
+{
+    const int cn = img1.channels();
+    const int cols = img1.cols;
+    const int lastRow = img1.rows - 1;
+    double J[N];
+
+    for(int r_i = rowStart; r_i < rowEnd; ++r_i) {
+        const _Tp* p1 = img1.ptr<_Tp>(r_i);
+        const _Tp* p2 = img2.ptr<_Tp>(r_i);
+        const _Tp* p2Up = img2.ptr<_Tp>(std::max(r_i - 1, 0));
+        const _Tp* p2Down = img2.ptr<_Tp>(std::min(r_i + 1, lastRow));
+        for(int c_i = 0; c_i < cols; ++c_i) {
+            const int left = std::max(c_i - 1, 0)*cn;
+            const int right = std::min(c_i + 1, cols - 1)*cn;
+            for(int ch = 0; ch < cn; ++ch) {
+                // Same central differences and difference image as Mapper::gradient
+                const int i = c_i*cn + ch;
+                const _Tp Ix = (p2[right + ch] - p2[left + ch])*(_Tp)0.5;
+                const _Tp Iy = (p2Down[i] - p2Up[i])*(_Tp)0.5;
+                const double It = (double)(p2[i] - p1[i]);
+
+                jacobian((double)c_i, (double)r_i, (double)Ix, (double)Iy, J);
+                for(int k = 0; k < N; ++k) {
+                    for(int l = 0; l <= k; ++l)
+                        A(k, l) += J[k]*J[l];
+                    b(k) -= It*J[k];
+                }
+            }
+        }
+    }
+}
+
+/*
+ * Builds the least squares system A*k = b of a gradient based mapper in a single pass over the
+ * images, without the per-pixel temporaries. jacobian(x, y, Ix, Iy, J) fills the N derivatives
+ * of the linearized image difference with respect to the map parameters at pixel (x, y), so that
+ * A = sum(J*J^t) and b = -sum(It*J), summed over all pixels and channels.
+ */
+template<int N, typename Jacobian>
+void calculateNormalEquations(const Mat& img1, const Mat& img2, const Jacobian& jacobian,
+                              Matx<double, N, N>& A, Vec<double, N>& b)
+{
+    CV_Assert(img1.size() == img2.size() && img1.type() == img2.type());
+
+    Mat im1 = img1, im2 = img2;
+    if(img1.depth() != CV_32F && img1.depth() != CV_64F) {
+        img1.convertTo(im1, CV_64F);
+        img2.convertTo(im2, CV_64F);
+    }
+
+    // Partial sums of fixed row blocks are added in order, so the result does not depend on
+    // the number of threads
+    const int blockRows = 16;
+    const int numBlocks = (im1.rows + blockRows - 1)/blockRows;
+    std::vector< Matx<double, N, N> > blockA(numBlocks);
+    std::vector< Vec<double, N> > blockB(numBlocks);
+
+    parallel_for_(Range(0, numBlocks), [&](const Range& range) {
+        for(int bl_i = range.start; bl_i < range.end; ++bl_i) {
+            const int rowStart = bl_i*blockRows;
+            const int rowEnd = std::min(rowStart + blockRows, im1.rows);
+            if(im1.depth() == CV_32F)
+                accumulateNormalEquations<float, N>(im1, im2, jacobian, rowStart, rowEnd,
+                                                    blockA[bl_i], blockB[bl_i]);
+            else
+                accumulateNormalEquations<double, N>(im1, im2, jacobian, rowStart, rowEnd,
+                                                     blockA[bl_i], blockB[bl_i]);
+        }
+    });
+
+    A = Matx<double, N, N>();
+    b = Vec<double, N>();
+    for(int bl_i = 0; bl_i < numBlocks; ++bl_i) {
+        A += blockA[bl_i];
+        b += blockB[bl_i];
+    }
+
+    // Upper half values (A is symmetric)
+    for(int k = 0; k < N; ++k) {
+        for(int l = k + 1; l < N; ++l)
+            A(k, l) = A(l, k);
+    }
+}
+
+}}  // namespace cv::reg
+
+#endif
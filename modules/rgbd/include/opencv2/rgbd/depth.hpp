@@ -328,9 +328,13 @@ namespace rgbd
   class CV_EXPORTS_W RgbdPlane: public Algorithm
   {
   public:
+    /** RGBD_PLANE_METHOD_DEFAULT grows the planes one after the other from the most planar tiles.
+     * RGBD_PLANE_METHOD_BLOCK_MERGE merges the neighboring planar tiles of a same plane all at once and assigns
+     * the points in parallel, which is faster on multi-core machines and gives very similar planes
+     */
     enum RGBD_PLANE_METHOD
     {
-      RGBD_PLANE_METHOD_DEFAULT
+      RGBD_PLANE_METHOD_DEFAULT, RGBD_PLANE_METHOD_BLOCK_MERGE
     };
 
       RgbdPlane(int method = RgbdPlane::RGBD_PLANE_METHOD_DEFAULT)
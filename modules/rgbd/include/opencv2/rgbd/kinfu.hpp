@@ -193,6 +193,43 @@ public:
     @return true if succeded to align new frame with current scene, false if opposite
     */
     CV_WRAP virtual bool update(InputArray depth) = 0;
+
+    /** @brief Result of a frame processed by updateAsync() */
+    struct UpdateResult
+    {
+        //! true if the frame was aligned with the scene
+        bool success;
+        //! camera pose after the frame, the previous pose if the frame was not aligned
+        Affine3f pose;
+    };
+
+    /** @brief Frame submitted by updateAsync() */
+    class UpdateFuture
+    {
+    public:
+        virtual ~UpdateFuture() {}
+
+        /** @brief Waits for the frame to be processed
+        @return result of the frame, rethrows errors that happened during its processing
+        */
+        virtual UpdateResult get() const = 0;
+    };
+
+    /** @brief Process next depth frame asynchronously
+
+      Does the same as update(), but returns immediately. Frames are processed in submission order:
+      the bilateral filter and the points and normals pyramids of a frame are computed on a worker thread
+      while the previous frame is still being aligned, integrated and raycasted on another one.
+      At most two frames are in flight, a new call blocks until the older one is done.
+      The OpenCL implementation processes the frame on the calling thread before returning.
+
+      Other methods wait for the submitted frames to be processed. Depth is copied, so the caller can
+      reuse its buffer right away.
+
+    @param depth one-channel image which size and depth scale is described in algorithm's parameters
+    @return future result of the frame
+    */
+    virtual Ptr<UpdateFuture> updateAsync(InputArray depth) = 0;
 };
 
 //! @}
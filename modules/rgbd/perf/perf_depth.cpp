@@ -0,0 +1,95 @@
+// This file is part of OpenCV project.
+// It is subject to the license terms in the LICENSE file found in the top-level directory
+// of this distribution and at http://opencv.org/license.html
+#include "perf_precomp.hpp"
+
+namespace opencv_test { namespace {
+
+static Matx33f cameraMatrix(const Size& sz)
+{
+    const float f = 525.f * sz.width / 640.f;
+    return Matx33f(f, 0, (sz.width - 1) * 0.5f,
+                   0, f, (sz.height - 1) * 0.5f,
+                   0, 0, 1);
+}
+
+// bumpy surface in millimeters, with a few holes
+static Mat_<unsigned short> generateDepth(const Size& sz)
+{
+    Mat_<unsigned short> depth(sz);
+    for (int y = 0; y < sz.height; y++)
+        for (int x = 0; x < sz.width; x++)
+            depth(y, x) = (unsigned short)(1500 + 500.f * x / sz.width +
+                                           100.f * std::sin(x * 0.05f) * std::cos(y * 0.04f));
+    RNG rng(0);
+    for (int i = 0; i < 64; i++)
+        circle(depth, Point(rng.uniform(0, sz.width), rng.uniform(0, sz.height)), 5, Scalar(0), FILLED);
+    return depth;
+}
+
+CV_ENUM(NormalsMethod, RgbdNormals::RGBD_NORMALS_METHOD_FALS, RgbdNormals::RGBD_NORMALS_METHOD_LINEMOD,
+                       RgbdNormals::RGBD_NORMALS_METHOD_SRI)
+typedef tuple<Size, NormalsMethod> NormalsParams;
+typedef TestBaseWithParam<NormalsParams> NormalsPerf;
+
+PERF_TEST_P(NormalsPerf, compute,
+            testing::Combine(testing::Values(szVGA, sz720p), NormalsMethod::all()))
+{
+    const Size sz = get<0>(GetParam());
+    const int method = get<1>(GetParam());
+    const Matx33f K = cameraMatrix(sz);
+
+    Mat depth, points3d, normals;
+    generateDepth(sz).convertTo(depth, CV_32F, 0.001);
+    depthTo3d(depth, Mat(K), points3d);
+
+    Ptr<RgbdNormals> normalsComputer = RgbdNormals::create(sz.height, sz.width, CV_32F, Mat(K), 5, method);
+    normalsComputer->initialize();
+
+    TEST_CYCLE() (*normalsComputer)(points3d, normals);
+
+    SANITY_CHECK_NOTHING();
+}
+
+typedef TestBaseWithParam<Size> DepthCleanerPerf;
+
+PERF_TEST_P(DepthCleanerPerf, compute, testing::Values(szVGA, sz720p))
+{
+    const Size sz = GetParam();
+    Mat depth = generateDepth(sz), cleaned;
+
+    Ptr<DepthCleaner> cleaner = DepthCleaner::create(CV_16U);
+
+    TEST_CYCLE() (*cleaner)(depth, cleaned);
+
+    SANITY_CHECK_NOTHING();
+}
+
+typedef tuple<Size, bool> RegisterDepthParams;
+typedef TestBaseWithParam<RegisterDepthParams> RegisterDepthPerf;
+
+PERF_TEST_P(RegisterDepthPerf, registerDepth,
+            testing::Combine(testing::Values(szVGA, sz720p), testing::Bool()))
+{
+    const Size sz = get<0>(GetParam());
+    const bool distortion = get<1>(GetParam());
+    const Matx33f K = cameraMatrix(sz);
+    Mat depth = generateDepth(sz), registered;
+
+    // external camera slightly shifted and rotated with respect to the depth one
+    Matx44f Rt = Matx44f::eye();
+    Matx33f R;
+    Rodrigues(Vec3f(0.01f, -0.02f, 0.005f), R);
+    for (int j = 0; j < 3; j++)
+        for (int i = 0; i < 3; i++)
+            Rt(j, i) = R(j, i);
+    Rt(0, 3) = 0.025f;
+
+    Mat distCoeffs = distortion ? (Mat_<float>(1, 5) << 0.1f, -0.05f, 0.001f, 0.001f, 0.f) : Mat();
+
+    TEST_CYCLE() registerDepth(K, K, distCoeffs, Rt, depth, sz, registered, true);
+
+    SANITY_CHECK_NOTHING();
+}
+
+}} // namespace
@@ -0,0 +1,90 @@
+// This file is part of OpenCV project.
+// It is subject to the license terms in the LICENSE file found in the top-level directory
+// of this distribution and at http://opencv.org/license.html
+
+// This code is also subject to the license terms in the LICENSE_KinectFusion.md file found in this module's directory
+
+#include "perf_precomp.hpp"
+#include "../test/test_kinfu_scene.hpp"
+
+namespace opencv_test { namespace {
+
+// the frames of the cube and spheres scene of the tests
+static std::vector<Mat> sceneFrames(const kinfu::Params& params, size_t nFrames)
+{
+    Ptr<Scene> scene = Scene::create(1, params.frameSize, params.intr, params.depthFactor);
+    std::vector<Affine3f> poses = scene->getPoses();
+    CV_Assert(nFrames <= poses.size());
+
+    std::vector<Mat> frames;
+    for(size_t i = 0; i < nFrames; i++)
+        frames.push_back(scene->depth(poses[i]));
+    return frames;
+}
+
+typedef TestBaseWithParam<bool> KinFuPerf;
+
+#ifdef OPENCV_ENABLE_NONFREE
+// Throughput: a whole sequence, with the frames submitted as fast as possible
+PERF_TEST_P(KinFuPerf, sequence, testing::Bool())
+#else
+PERF_TEST_P(KinFuPerf, DISABLED_sequence, testing::Bool())
+#endif
+{
+    const bool async = GetParam();
+
+    Ptr<kinfu::Params> params = kinfu::Params::coarseParams();
+    std::vector<Mat> frames = sceneFrames(*params, 8);
+    Ptr<kinfu::KinFu> kf = kinfu::KinFu::create(params);
+
+    TEST_CYCLE()
+    {
+        kf->reset();
+        Ptr<kinfu::KinFu::UpdateFuture> result;
+        for(size_t i = 0; i < frames.size(); i++)
+        {
+            if(async)
+                result = kf->updateAsync(frames[i]);
+            else
+                ASSERT_TRUE(kf->update(frames[i]));
+        }
+        if(async)
+            ASSERT_TRUE(result->get().success);
+    }
+
+    SANITY_CHECK_NOTHING();
+}
+
+#ifdef OPENCV_ENABLE_NONFREE
+// Latency: time from the submission of a frame to its pose, the previous frame being already processed
+PERF_TEST_P(KinFuPerf, frame, testing::Bool())
+#else
+PERF_TEST_P(KinFuPerf, DISABLED_frame, testing::Bool())
+#endif
+{
+    const bool async = GetParam();
+
+    Ptr<kinfu::Params> params = kinfu::Params::coarseParams();
+    std::vector<Mat> frames = sceneFrames(*params, 2);
+    Ptr<kinfu::KinFu> kf = kinfu::KinFu::create(params);
+
+    while(next())
+    {
+        kf->reset();
+        ASSERT_TRUE(kf->update(frames[0]));
+
+        startTimer();
+        bool success;
+        if(async)
+            success = kf->updateAsync(frames[1])->get().success;
+        else
+            success = kf->update(frames[1]);
+        stopTimer();
+
+        ASSERT_TRUE(success);
+    }
+
+    SANITY_CHECK_NOTHING();
+}
+
+}} // namespace
@@ -0,0 +1,62 @@
+// This file is part of OpenCV project.
+// It is subject to the license terms in the LICENSE file found in the top-level directory
+// of this distribution and at http://opencv.org/license.html
+#include "perf_precomp.hpp"
+
+namespace opencv_test { namespace {
+
+// Textured, bumpy surface seen from a camera moving sideways by a couple of pixels between the frames
+static void generateFrames(const Size& sz, Mat& K, Mat& image0, Mat& depth0, Mat& image1, Mat& depth1)
+{
+    const int shift = 3;
+    Size bigSize(sz.width + shift, sz.height + shift);
+
+    Mat image(bigSize, CV_8UC1);
+    RNG rng(0);
+    rng.fill(image, RNG::UNIFORM, 0, 255);
+    GaussianBlur(image, image, Size(7, 7), 2.0);
+
+    Mat depth(bigSize, CV_32FC1);
+    for(int y = 0; y < bigSize.height; y++)
+    {
+        float* depthRow = depth.ptr<float>(y);
+        for(int x = 0; x < bigSize.width; x++)
+            depthRow[x] = 1.5f + 0.5f * x / bigSize.width +
+                          0.1f * std::sin(x * 0.05f) * std::cos(y * 0.04f);
+    }
+
+    image(Rect(0, 0, sz.width, sz.height)).copyTo(image0);
+    depth(Rect(0, 0, sz.width, sz.height)).copyTo(depth0);
+    image(Rect(shift, shift / 2, sz.width, sz.height)).copyTo(image1);
+    depth(Rect(shift, shift / 2, sz.width, sz.height)).copyTo(depth1);
+
+    const float f = 525.f * sz.width / 640.f;
+    K = (Mat_<float>(3, 3) << f, 0, (sz.width - 1) * 0.5f,
+                              0, f, (sz.height - 1) * 0.5f,
+                              0, 0, 1);
+}
+
+typedef tuple<Size, std::string> OdometryParams;
+typedef TestBaseWithParam<OdometryParams> OdometryPerf;
+
+PERF_TEST_P(OdometryPerf, compute,
+            testing::Combine(testing::Values(szVGA, sz720p),
+                             testing::Values("RgbdOdometry", "ICPOdometry", "RgbdICPOdometry")))
+{
+    const Size sz = get<0>(GetParam());
+    const std::string type = get<1>(GetParam());
+
+    Mat K, image0, depth0, image1, depth1;
+    generateFrames(sz, K, image0, depth0, image1, depth1);
+
+    Ptr<Odometry> odometry = Odometry::create(type);
+    odometry->setCameraMatrix(K);
+
+    // pyramids are rebuilt by each call, as for a new pair of frames
+    Mat mask(sz, CV_8UC1, Scalar(255)), Rt;
+    TEST_CYCLE() odometry->compute(image0, depth0, mask, image1, depth1, mask, Rt);
+
+    SANITY_CHECK_NOTHING();
+}
+
+}} // namespace
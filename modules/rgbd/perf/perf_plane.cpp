@@ -0,0 +1,61 @@
+// This file is part of OpenCV project.
+// It is subject to the license terms in the LICENSE file found in the top-level directory
+// of this distribution and at http://opencv.org/license.html
+#include "perf_precomp.hpp"
+
+namespace opencv_test { namespace {
+
+// a room corner with a box standing in it: every pixel lies on one of several planes
+static void generatePoints(const Size& sz, Mat& points3d, Mat& normals)
+{
+    const float f = 525.f * sz.width / 640.f;
+    const Matx33f K(f, 0, (sz.width - 1) * 0.5f,
+                    0, f, (sz.height - 1) * 0.5f,
+                    0, 0, 1);
+    const Vec4f planes[] = { Vec4f(0.f, -0.8f, -0.6f, 2.f), Vec4f(0.5f, 0.f, -0.866f, 2.5f),
+                             Vec4f(-0.5f, 0.f, -0.866f, 2.5f), Vec4f(0.1f, 0.2f, -0.97f, 1.2f) };
+
+    Mat_<float> depth(sz);
+    for (int y = 0; y < sz.height; y++)
+        for (int x = 0; x < sz.width; x++)
+        {
+            const Vec3f ray((x - K(0, 2)) / f, (y - K(1, 2)) / f, 1.f);
+            // the box is in front of everything else in the middle of the image
+            bool box = std::abs(x - sz.width / 2) < sz.width / 6 && std::abs(y - sz.height / 2) < sz.height / 5;
+            float z = 0;
+            for (int i = 0; i < (box ? 4 : 3); i++)
+            {
+                float t = -planes[i][3] / (planes[i][0] * ray[0] + planes[i][1] * ray[1] + planes[i][2] * ray[2]);
+                if (t > 0 && (z == 0 || t < z))
+                    z = t;
+            }
+            depth(y, x) = z;
+        }
+
+    depthTo3d(depth, Mat(K), points3d);
+    Ptr<RgbdNormals> normalsComputer = RgbdNormals::create(sz.height, sz.width, CV_32F, Mat(K), 5,
+                                                           RgbdNormals::RGBD_NORMALS_METHOD_FALS);
+    (*normalsComputer)(points3d, normals);
+}
+
+CV_ENUM(PlaneMethod, RgbdPlane::RGBD_PLANE_METHOD_DEFAULT, RgbdPlane::RGBD_PLANE_METHOD_BLOCK_MERGE)
+typedef tuple<Size, PlaneMethod> PlaneParams;
+typedef TestBaseWithParam<PlaneParams> PlanePerf;
+
+PERF_TEST_P(PlanePerf, compute,
+            testing::Combine(testing::Values(szVGA, sz720p), PlaneMethod::all()))
+{
+    const Size sz = get<0>(GetParam());
+    const int method = get<1>(GetParam());
+
+    Mat points3d, normals, mask, coefficients;
+    generatePoints(sz, points3d, normals);
+
+    RgbdPlane planeComputer(method);
+
+    TEST_CYCLE() planeComputer(points3d, normals, mask, coefficients);
+
+    SANITY_CHECK_NOTHING();
+}
+
+}} // namespace
@@ -116,49 +116,74 @@ namespace rgbd
       // Precompute some data
       const ContainerDepth sigma_L = (float)(0.8 + 0.035 * theta_mean / (CV_PI / 2 - theta_mean));
       Mat_<ContainerDepth> sigma_z(rows, cols);
-      for (int y = 0; y < rows; ++y)
-        for (int x = 0; x < cols; ++x)
-          sigma_z(y, x) = (float)(0.0012 + 0.0019 * (depth_in(y, x) * scale - 0.4) * (depth_in(y, x) * scale - 0.4));
+      parallel_for_(Range(0, rows), [&](const Range& range)
+      {
+        for (int y = range.start; y < range.end; ++y)
+          for (int x = 0; x < cols; ++x)
+            sigma_z(y, x) = (float)(0.0012 + 0.0019 * (depth_in(y, x) * scale - 0.4) * (depth_in(y, x) * scale - 0.4));
+      });
 
       ContainerDepth difference_threshold = 10;
       Mat_<ContainerDepth> Dw_sum = Mat_<ContainerDepth>::zeros(rows, cols), w_sum =
           Mat_<ContainerDepth>::zeros(rows, cols);
-      for (int y = 0; y < rows - 1; ++y)
+
+      // Every pixel (y, x) of [0, rows - 1) x [1, cols - 1) is smoothed with itself and with its neighbors
+      // (0, 1), (1, -1), (1, 0) and (1, 1), and contributes symmetrically to them. The sums are gathered per
+      // pixel in the order they used to be scattered in a row-major traversal, so rows can be processed in
+      // parallel with the very same result.
+      const int offsets[8][2] = { { -1, -1 }, { -1, 0 }, { -1, 1 }, { 0, -1 }, { 0, 1 }, { 1, -1 }, { 1, 0 }, { 1, 1 } };
+      ContainerDepth delta_u[8];
+      for (int k = 0; k < 8; ++k)
+      {
+        const int j = offsets[k][0], i = offsets[k][1];
+        delta_u[k] = sqrt(ContainerDepth(j) * ContainerDepth(j) + ContainerDepth(i) * ContainerDepth(i));
+      }
+
+      parallel_for_(Range(0, rows), [&](const Range& range)
       {
-        // Every pixel has had the contribution of previous pixels (in a row-major way)
-        for (int x = 1; x < cols - 1; ++x)
+        for (int y = range.start; y < range.end; ++y)
         {
-          for (int j = 0; j <= 1; ++j)
-            for (int i = -1; i <= 1; ++i)
+          for (int x = 0; x < cols; ++x)
+          {
+            // contributions from the previous pixels, then from the pixel itself and the next ones
+            for (int k = 0; k < 9; ++k)
             {
-              if ((j == 0) && (i == -1))
+              int yn = y, xn = x, center_y = y, center_x = x;
+              ContainerDepth du = 0;
+              if (k < 4)
+              {
+                // (y, x) is a neighbor of an earlier pixel
+                center_y = yn = y + offsets[k][0];
+                center_x = xn = x + offsets[k][1];
+                du = delta_u[k];
+              }
+              else if (k > 4)
+              {
+                yn = y + offsets[k - 1][0];
+                xn = x + offsets[k - 1][1];
+                du = delta_u[k - 1];
+              }
+
+              if ((center_y < 0) || (center_y >= rows - 1) || (center_x < 1) || (center_x >= cols - 1))
                 continue;
-              ContainerDepth delta_u = sqrt(
-                  ContainerDepth(j) * ContainerDepth(j) + ContainerDepth(i) * ContainerDepth(i));
+
               ContainerDepth delta_z;
-              if (depth_in(y, x) > depth_in(y + j, x + i))
-                delta_z = (float)(depth_in(y, x) - depth_in(y + j, x + i));
+              if (depth_in(y, x) > depth_in(yn, xn))
+                delta_z = (float)(depth_in(y, x) - depth_in(yn, xn));
               else
-                delta_z = (float)(depth_in(y + j, x + i) - depth_in(y, x));
+                delta_z = (float)(depth_in(yn, xn) - depth_in(y, x));
               if (delta_z < difference_threshold)
               {
                 delta_z *= scale;
                 ContainerDepth w = exp(
-                    -delta_u * delta_u / 2 / sigma_L / sigma_L - delta_z * delta_z / 2 / sigma_z(y, x) / sigma_z(y, x));
+                    -du * du / 2 / sigma_L / sigma_L - delta_z * delta_z / 2 / sigma_z(y, x) / sigma_z(y, x));
                 w_sum(y, x) += w;
-                Dw_sum(y, x) += depth_in(y + j, x + i) * w;
-                if ((j != 0) || (i != 0))
-                {
-                  w = exp(
-                      -delta_u * delta_u / 2 / sigma_L / sigma_L - delta_z * delta_z / 2 / sigma_z(y + j, x + i)
-                                                                   / sigma_z(y + j, x + i));
-                  w_sum(y + j, x + i) += w;
-                  Dw_sum(y + j, x + i) += depth_in(y, x) * w;
-                }
+                Dw_sum(y, x) += depth_in(yn, xn) * w;
               }
             }
+          }
         }
-      }
+      });
       Mat(Dw_sum / w_sum).copyTo(depth_out);
     }
   };
@@ -143,134 +143,214 @@ namespace rgbd
             initialProjection = initialProjection * rbtRgb2Depth * K.inv();
         }
 
-        // Apply the initial projection to the input depth
-        Mat_<Point3f> transformedCloud;
-        {
-            Mat_<Point3f> point_tmp(outputImagePlaneSize);
+        // The input is split into bands of rows, each one splatted into its own z-buffer in parallel.
+        // A band only covers the output rows its points project to, so the z-buffers are sized to those rows.
+        // The z-buffers are then merged keeping the closest depth, which does not depend on the order of the splats.
+        const int rows = unregisteredDepth.rows;
+        const int bandsCount = std::max(1, std::min(getNumThreads(), rows / 16));
+        std::vector< Mat_<DepthDepth> > bandDepth(bandsCount);
+        std::vector<int> bandFirstRow(bandsCount, 0);
+        const float metersToInputUnitsScale = 1/inputDepthToMetersScale;
+        const Rect registeredDepthBounds(Point(), outputImagePlaneSize);
 
-            for(int j = 0; j < point_tmp.rows; ++j)
+        parallel_for_(Range(0, bandsCount), [&](const Range& range)
+        {
+            std::vector<Point2f> transformedAndProjectedPoints(outputImagePlaneSize.width);
+            for (int band = range.start; band < range.end; ++band)
             {
-                const DepthDepth *unregisteredDepthPtr = unregisteredDepth[j];
+                const int bandStart = band * rows / bandsCount, bandEnd = (band + 1) * rows / bandsCount;
 
-                Point3f *point = point_tmp[j];
-                for(int i = 0; i < point_tmp.cols; ++i, ++unregisteredDepthPtr, ++point)
+                // Apply the initial projection to the input depth
+                Mat_<Point3f> transformedCloud;
                 {
-                    float rescaled_depth = float(*unregisteredDepthPtr) * inputDepthToMetersScale;
+                    Mat_<Point3f> point_tmp(bandEnd - bandStart, outputImagePlaneSize.width);
 
-                    // If the DepthDepth is of type unsigned short, zero is a sentinel value to indicate
-                    // no depth. CV_32F and CV_64F should already have NaN for no depth values.
-                    if (rescaled_depth == 0)
+                    for(int j = bandStart; j < bandEnd; ++j)
                     {
-                        rescaled_depth = std::numeric_limits<float>::quiet_NaN();
+                        const DepthDepth *unregisteredDepthPtr = unregisteredDepth[j];
+
+                        Point3f *point = point_tmp[j - bandStart];
+                        for(int i = 0; i < point_tmp.cols; ++i, ++unregisteredDepthPtr, ++point)
+                        {
+                            float rescaled_depth = float(*unregisteredDepthPtr) * inputDepthToMetersScale;
+
+                            // If the DepthDepth is of type unsigned short, zero is a sentinel value to indicate
+                            // no depth. CV_32F and CV_64F should already have NaN for no depth values.
+                            if (rescaled_depth == 0)
+                            {
+                                rescaled_depth = std::numeric_limits<float>::quiet_NaN();
+                            }
+
+                            point->x = i * rescaled_depth;
+                            point->y = j * rescaled_depth;
+                            point->z = rescaled_depth;
+                        }
                     }
 
-                    point->x = i * rescaled_depth;
-                    point->y = j * rescaled_depth;
-                    point->z = rescaled_depth;
+                    perspectiveTransform(point_tmp, transformedCloud, initialProjection);
                 }
-            }
 
-            perspectiveTransform(point_tmp, transformedCloud, initialProjection);
-        }
+                // Project the points into the external camera, keeping track of the output rows they land on
+                Mat_<Point2f> projectedPoints(transformedCloud.size());
+                int firstRow = outputImagePlaneSize.height, lastRow = -1;
+                for( int y = 0; y < transformedCloud.rows; y++ )
+                {
+                    if (hasDistortion)
+                    {
 
-        std::vector<Point2f> transformedAndProjectedPoints(transformedCloud.cols);
-        const float metersToInputUnitsScale = 1/inputDepthToMetersScale;
-        const Rect registeredDepthBounds(Point(), outputImagePlaneSize);
+                        // Project an entire row of points with distortion.
+                        // Doing this for the entire image at once would require more memory.
+                        projectPoints(transformedCloud.row(y),
+                                      Vec3f(0,0,0),
+                                      Vec3f(0,0,0),
+                                      registeredCameraMatrix,
+                                      registeredDistCoeffs,
+                                      transformedAndProjectedPoints);
+                        std::copy(transformedAndProjectedPoints.begin(), transformedAndProjectedPoints.end(), projectedPoints[y]);
 
-        for( int y = 0; y < transformedCloud.rows; y++ )
-        {
-            if (hasDistortion)
-            {
+                    }
+                    else
+                    {
 
-                // Project an entire row of points with distortion.
-                // Doing this for the entire image at once would require more memory.
-                projectPoints(transformedCloud.row(y),
-                              Vec3f(0,0,0),
-                              Vec3f(0,0,0),
-                              registeredCameraMatrix,
-                              registeredDistCoeffs,
-                              transformedAndProjectedPoints);
+                        // With no distortion, we just have to dehomogenize the point since all major transforms
+                        // already happened with initialProjection.
+                        Point2f *point2d = projectedPoints[y];
+                        const Point2f *point2d_end = point2d + projectedPoints.cols;
+                        const Point3f *point3d = transformedCloud[y];
+                        for( ; point2d < point2d_end; ++point2d, ++point3d )
+                        {
+                            point2d->x = point3d->x / point3d->z;
+                            point2d->y = point3d->y / point3d->z;
+                        }
 
-            }
-            else
-            {
+                    }
+
+                    const Point2f *point2d = projectedPoints[y], *point2d_end = point2d + projectedPoints.cols;
+                    for( ; point2d < point2d_end; ++point2d )
+                    {
+                        if (cvIsNaN(point2d->x))
+                            continue;
 
-                // With no distortion, we just have to dehomogenize the point since all major transforms
-                // already happened with initialProjection.
-                Point2f *point2d = &transformedAndProjectedPoints[0];
-                const Point2f *point2d_end = point2d + transformedAndProjectedPoints.size();
-                const Point3f *point3d = transformedCloud[y];
-                for( ; point2d < point2d_end; ++point2d, ++point3d )
+                        const Point2i projectedPixelLocation = *point2d;
+                        if (!registeredDepthBounds.contains(projectedPixelLocation))
+                            continue;
+
+                        // Dilation also writes the row above the projected location
+                        firstRow = std::min(firstRow, std::max(0, projectedPixelLocation.y - (depthDilation ? 1 : 0)));
+                        lastRow = std::max(lastRow, projectedPixelLocation.y);
+                    }
+                }
+
+                // The first band splats straight into the output, the others into buffers covering their rows only
+                Mat_<DepthDepth> zBuffer;
+                if (band == 0)
+                {
+                    zBuffer = registeredDepth;
+                    firstRow = 0;
+                }
+                else if (lastRow >= firstRow)
+                {
+                    zBuffer = Mat_<DepthDepth>(lastRow - firstRow + 1, outputImagePlaneSize.width, noDepthSentinelValue<DepthDepth>());
+                }
+                else
                 {
-                    point2d->x = point3d->x / point3d->z;
-                    point2d->y = point3d->y / point3d->z;
+                    // Nothing of this band lands in the output image
+                    continue;
                 }
 
-            }
+                for( int y = 0; y < transformedCloud.rows; y++ )
+                {
+                    const Point2f *outputProjectedPoint = projectedPoints[y];
+                    const Point3f *p = transformedCloud[y], *p_end = p + transformedCloud.cols;
 
-            const Point2f *outputProjectedPoint = &transformedAndProjectedPoints[0];
-            const Point3f *p = transformedCloud[y], *p_end = p + transformedCloud.cols;
+                    for( ; p < p_end; ++outputProjectedPoint, ++p )
+                    {
+                        // Skip this one if there isn't a valid depth
+                        const Point2f projectedPixelFloatLocation = *outputProjectedPoint;
+                        if (cvIsNaN(projectedPixelFloatLocation.x))
+                            continue;
 
+                        //Get integer pixel location
+                        const Point2i projectedPixelLocation = projectedPixelFloatLocation;
 
-            for( ; p < p_end; ++outputProjectedPoint, ++p )
-            {
+                        // Ensure that the projected point is actually contained in our output image
+                        if (!registeredDepthBounds.contains(projectedPixelLocation))
+                            continue;
 
+                        // Go back to our original scale, since that's what our output will be
+                        // The templated function is to ensure that integer values are rounded to the nearest integer
+                        const DepthDepth cloudDepth = floatToInputDepth<DepthDepth>(p->z*metersToInputUnitsScale);
 
+                        DepthDepth& outputDepth = zBuffer(projectedPixelLocation.y - firstRow, projectedPixelLocation.x);
 
-                // Skip this one if there isn't a valid depth
-                const Point2f projectedPixelFloatLocation = *outputProjectedPoint;
-                if (cvIsNaN(projectedPixelFloatLocation.x))
-                    continue;
+                        // Occlusion check
+                        if ( isEqualToNoDepthSentinelValue<DepthDepth>(outputDepth) || (outputDepth > cloudDepth) )
+                            outputDepth = cloudDepth;
 
-                //Get integer pixel location
-                const Point2i projectedPixelLocation = projectedPixelFloatLocation;
+                        // If desired, dilate this point to avoid holes in the final image
+                        if (depthDilation)
+                        {
 
-                // Ensure that the projected point is actually contained in our output image
-                if (!registeredDepthBounds.contains(projectedPixelLocation))
-                    continue;
+                            // Choosing to dilate in a 2x2 region, where the original projected location is in the bottom right of this
+                            // region. This is what's done on PrimeSense devices, but a more accurate scheme could be used.
+                            const Point2i dilatedProjectedLocations[3] = {Point2i(projectedPixelLocation.x - 1, projectedPixelLocation.y    ),
+                                                                          Point2i(projectedPixelLocation.x    , projectedPixelLocation.y - 1),
+                                                                          Point2i(projectedPixelLocation.x - 1, projectedPixelLocation.y - 1)};
 
-                // Go back to our original scale, since that's what our output will be
-                // The templated function is to ensure that integer values are rounded to the nearest integer
-                const DepthDepth cloudDepth = floatToInputDepth<DepthDepth>(p->z*metersToInputUnitsScale);
+                            for (int i = 0; i < 3; i++) {
 
-                DepthDepth& outputDepth = registeredDepth.at<DepthDepth>(projectedPixelLocation.y, projectedPixelLocation.x);
+                                const Point2i& dilatedCoordinates = dilatedProjectedLocations[i];
 
+                                if (!registeredDepthBounds.contains(dilatedCoordinates))
+                                    continue;
 
-                // Occlusion check
-                if ( isEqualToNoDepthSentinelValue<DepthDepth>(outputDepth) || (outputDepth > cloudDepth) )
-                    outputDepth = cloudDepth;
+                                DepthDepth& outputDilatedDepth = zBuffer(dilatedCoordinates.y - firstRow, dilatedCoordinates.x);
 
+                                // Occlusion check
+                                if ( isEqualToNoDepthSentinelValue(outputDilatedDepth) || (outputDilatedDepth > cloudDepth) )
+                                    outputDilatedDepth = cloudDepth;
 
-                // If desired, dilate this point to avoid holes in the final image
-                if (depthDilation)
-                {
+                            }
 
-                    // Choosing to dilate in a 2x2 region, where the original projected location is in the bottom right of this
-                    // region. This is what's done on PrimeSense devices, but a more accurate scheme could be used.
-                    const Point2i dilatedProjectedLocations[3] = {Point2i(projectedPixelLocation.x - 1, projectedPixelLocation.y    ),
-                                                                  Point2i(projectedPixelLocation.x    , projectedPixelLocation.y - 1),
-                                                                  Point2i(projectedPixelLocation.x - 1, projectedPixelLocation.y - 1)};
+                        } // depthDilation
 
-                    for (int i = 0; i < 3; i++) {
+                    } // iterate cols
+                } // iterate rows
 
-                        const Point2i& dilatedCoordinates = dilatedProjectedLocations[i];
+                bandDepth[band] = zBuffer;
+                bandFirstRow[band] = firstRow;
+            } // iterate bands
+        });
 
-                        if (!registeredDepthBounds.contains(dilatedCoordinates))
+        // Merge the z-buffers of the other bands into the output, each one over its own rows
+        if (bandsCount > 1)
+        {
+            parallel_for_(Range(0, outputImagePlaneSize.height), [&](const Range& range)
+            {
+                for (int y = range.start; y < range.end; ++y)
+                {
+                    DepthDepth *outputRow = bandDepth[0][y];
+                    for (int band = 1; band < bandsCount; ++band)
+                    {
+                        const int bandRow = y - bandFirstRow[band];
+                        if (bandRow < 0 || bandRow >= bandDepth[band].rows)
                             continue;
 
-                        DepthDepth& outputDilatedDepth = registeredDepth.at<DepthDepth>(dilatedCoordinates.y, dilatedCoordinates.x);
-
-                        // Occlusion check
-                        if ( isEqualToNoDepthSentinelValue(outputDilatedDepth) || (outputDilatedDepth > cloudDepth) )
-                            outputDilatedDepth = cloudDepth;
-
+                        const DepthDepth *bandValues = bandDepth[band][bandRow];
+                        for (int x = 0; x < outputImagePlaneSize.width; ++x)
+                        {
+                            const DepthDepth bandValue = bandValues[x];
+                            if (isEqualToNoDepthSentinelValue(bandValue))
+                                continue;
+
+                            // Occlusion check
+                            if ( isEqualToNoDepthSentinelValue(outputRow[x]) || (outputRow[x] > bandValue) )
+                                outputRow[x] = bandValue;
+                        }
                     }
-
-                } // depthDilation
-
-            } // iterate cols
-        } // iterate rows
-
+                }
+            });
+        }
     }
 
 
@@ -9,6 +9,8 @@
 #include "tsdf.hpp"
 #include "kinfu_frame.hpp"
 
+#include <future>
+
 namespace cv {
 namespace kinfu {
 
@@ -83,6 +85,19 @@ Ptr<Params> Params::coarseParams()
 }
 
 // T should be Mat or UMat
+// KinFu::UpdateFuture holding a std::shared_future
+class SharedUpdateFuture : public KinFu::UpdateFuture
+{
+public:
+    SharedUpdateFuture(const std::shared_future<KinFu::UpdateResult>& _result) : result(_result) { }
+
+    KinFu::UpdateResult get() const CV_OVERRIDE { return result.get(); }
+
+private:
+    std::shared_future<KinFu::UpdateResult> result;
+};
+
+
 template< typename T >
 class KinFuImpl : public KinFu
 {
@@ -104,9 +119,16 @@ public:
 
     bool update(InputArray depth) CV_OVERRIDE;
 
+    Ptr<UpdateFuture> updateAsync(InputArray depth) CV_OVERRIDE;
+
     bool updateT(const T& depth);
 
 private:
+    void prepareFrame(const T& depth, T& convertedDepth, std::vector<T>& newPoints, std::vector<T>& newNormals) const;
+    bool processFrame(const T& depth, const std::vector<T>& newPoints, const std::vector<T>& newNormals);
+    // waits for the frames submitted by updateAsync()
+    void waitAsync() const;
+
     Params params;
 
     cv::Ptr<ICP> icp;
@@ -116,6 +138,9 @@ private:
     Affine3f pose;
     std::vector<T> pyrPoints;
     std::vector<T> pyrNormals;
+
+    // the last two frames submitted by updateAsync()
+    std::shared_future<UpdateResult> lastUpdate, prevUpdate;
 };
 
 
@@ -134,6 +159,8 @@ KinFuImpl<T>::KinFuImpl(const Params &_params) :
 template< typename T >
 void KinFuImpl<T>::reset()
 {
+    waitAsync();
+
     frameCounter = 0;
     pose = Affine3f::Identity();
     volume->reset();
@@ -141,7 +168,16 @@ void KinFuImpl<T>::reset()
 
 template< typename T >
 KinFuImpl<T>::~KinFuImpl()
-{ }
+{
+    waitAsync();
+}
+
+template< typename T >
+void KinFuImpl<T>::waitAsync() const
+{
+    if(lastUpdate.valid())
+        lastUpdate.wait();
+}
 
 template< typename T >
 const Params& KinFuImpl<T>::getParams() const
@@ -152,6 +188,8 @@ const Params& KinFuImpl<T>::getParams() const
 template< typename T >
 const Affine3f KinFuImpl<T>::getPose() const
 {
+    waitAsync();
+
     return pose;
 }
 
@@ -160,6 +198,7 @@ template<>
 bool KinFuImpl<Mat>::update(InputArray _depth)
 {
     CV_Assert(!_depth.empty() && _depth.size() == params.frameSize);
+    waitAsync();
 
     Mat depth;
     if(_depth.isUMat())
@@ -178,6 +217,7 @@ template<>
 bool KinFuImpl<UMat>::update(InputArray _depth)
 {
     CV_Assert(!_depth.empty() && _depth.size() == params.frameSize);
+    waitAsync();
 
     UMat depth;
     if(!_depth.isUMat())
@@ -192,24 +232,109 @@ bool KinFuImpl<UMat>::update(InputArray _depth)
 }
 
 
+// UMat operations use the OpenCL queue of the calling thread, so the frame is processed right away
+template<>
+Ptr<KinFu::UpdateFuture> KinFuImpl<UMat>::updateAsync(InputArray _depth)
+{
+    CV_TRACE_FUNCTION();
+
+    std::promise<UpdateResult> promise;
+    try
+    {
+        UpdateResult result;
+        result.success = update(_depth);
+        result.pose = pose;
+        promise.set_value(result);
+    }
+    catch(...)
+    {
+        promise.set_exception(std::current_exception());
+    }
+    return makePtr<SharedUpdateFuture>(promise.get_future().share());
+}
+
 template< typename T >
-bool KinFuImpl<T>::updateT(const T& _depth)
+Ptr<KinFu::UpdateFuture> KinFuImpl<T>::updateAsync(InputArray _depth)
 {
     CV_TRACE_FUNCTION();
 
+    CV_Assert(!_depth.empty() && _depth.size() == params.frameSize);
+
+    // keep at most two frames in flight
+    if(prevUpdate.valid())
+        prevUpdate.wait();
+
     T depth;
+    _depth.copyTo(depth);
+
+    struct Frame
+    {
+        T depth;
+        std::vector<T> points, normals;
+    };
+
+    // doesn't depend on the model, runs while the previous frame is processed
+    std::shared_future< Ptr<Frame> > frame = std::async(std::launch::async, [this, depth]()
+    {
+        Ptr<Frame> f = makePtr<Frame>();
+        prepareFrame(depth, f->depth, f->points, f->normals);
+        return f;
+    });
+
+    // aligns the frames in submission order
+    std::shared_future<UpdateResult> previous = lastUpdate;
+    prevUpdate = lastUpdate;
+    lastUpdate = std::async(std::launch::async, [this, frame, previous]()
+    {
+        if(previous.valid())
+            previous.wait();
+
+        const Ptr<Frame>& f = frame.get();
+        UpdateResult result;
+        result.success = processFrame(f->depth, f->points, f->normals);
+        result.pose = pose;
+        return result;
+    });
+
+    return makePtr<SharedUpdateFuture>(lastUpdate);
+}
+
+
+template< typename T >
+void KinFuImpl<T>::prepareFrame(const T& _depth, T& depth,
+                                std::vector<T>& newPoints, std::vector<T>& newNormals) const
+{
     if(_depth.type() != DEPTH_TYPE)
         _depth.convertTo(depth, DEPTH_TYPE);
     else
         depth = _depth;
 
-    std::vector<T> newPoints, newNormals;
     makeFrameFromDepth(depth, newPoints, newNormals, params.intr,
                        params.pyramidLevels,
                        params.depthFactor,
                        params.bilateral_sigma_depth,
                        params.bilateral_sigma_spatial,
                        params.bilateral_kernel_size);
+}
+
+
+template< typename T >
+bool KinFuImpl<T>::updateT(const T& _depth)
+{
+    CV_TRACE_FUNCTION();
+
+    T depth;
+    std::vector<T> newPoints, newNormals;
+    prepareFrame(_depth, depth, newPoints, newNormals);
+
+    return processFrame(depth, newPoints, newNormals);
+}
+
+
+template< typename T >
+bool KinFuImpl<T>::processFrame(const T& depth, const std::vector<T>& newPoints, const std::vector<T>& newNormals)
+{
+    CV_TRACE_FUNCTION();
 
     if(frameCounter == 0)
     {
@@ -254,6 +379,7 @@ template< typename T >
 void KinFuImpl<T>::render(OutputArray image, const Matx44f& _cameraPose) const
 {
     CV_TRACE_FUNCTION();
+    waitAsync();
 
     Affine3f cameraPose(_cameraPose);
 
@@ -275,6 +401,7 @@ void KinFuImpl<T>::render(OutputArray image, const Matx44f& _cameraPose) const
 template< typename T >
 void KinFuImpl<T>::getCloud(OutputArray p, OutputArray n) const
 {
+    waitAsync();
     volume->fetchPointsNormals(p, n);
 }
 
@@ -282,6 +409,7 @@ void KinFuImpl<T>::getCloud(OutputArray p, OutputArray n) const
 template< typename T >
 void KinFuImpl<T>::getPoints(OutputArray points) const
 {
+    waitAsync();
     volume->fetchPointsNormals(points, noArray());
 }
 
@@ -289,6 +417,7 @@ void KinFuImpl<T>::getPoints(OutputArray points) const
 template< typename T >
 void KinFuImpl<T>::getNormals(InputArray points, OutputArray normals) const
 {
+    waitAsync();
     volume->fetchNormals(points, normals);
 }
 
@@ -434,6 +434,81 @@ void computeProjectiveMatrix(const Mat& ksi, Mat& Rt)
 #endif
 }
 
+// Projects every selected pixel of depth1 to depth0, storing the linear index of the matched pixel of depth0
+// (or -1) and the depth of the projected point.
+struct ProjectCorrespsInvoker : ParallelLoopBody
+{
+    ProjectCorrespsInvoker(const Mat& _depth0, const Mat& _validMask0,
+                           const Mat& _depth1, const Mat& _selectMask1, float _maxDepthDiff,
+                           const float* _KRK_inv0_u1, const float* _KRK_inv1_v1_plus_KRK_inv2,
+                           const float* _KRK_inv3_u1, const float* _KRK_inv4_v1_plus_KRK_inv5,
+                           const float* _KRK_inv6_u1, const float* _KRK_inv7_v1_plus_KRK_inv8,
+                           const double* _Kt_ptr, Mat& _target, Mat& _targetDepth) :
+        ParallelLoopBody(),
+        depth0(_depth0), validMask0(_validMask0), depth1(_depth1), selectMask1(_selectMask1),
+        maxDepthDiff(_maxDepthDiff),
+        KRK_inv0_u1(_KRK_inv0_u1), KRK_inv1_v1_plus_KRK_inv2(_KRK_inv1_v1_plus_KRK_inv2),
+        KRK_inv3_u1(_KRK_inv3_u1), KRK_inv4_v1_plus_KRK_inv5(_KRK_inv4_v1_plus_KRK_inv5),
+        KRK_inv6_u1(_KRK_inv6_u1), KRK_inv7_v1_plus_KRK_inv8(_KRK_inv7_v1_plus_KRK_inv8),
+        Kt_ptr(_Kt_ptr), target(_target), targetDepth(_targetDepth)
+    { }
+
+    virtual void operator ()(const Range& range) const CV_OVERRIDE
+    {
+        const Rect r(0, 0, depth1.cols, depth1.rows);
+        for(int v1 = range.start; v1 < range.end; v1++)
+        {
+            const float *depth1_row = depth1.ptr<float>(v1);
+            const uchar *mask1_row = selectMask1.ptr<uchar>(v1);
+            int *target_row = target.ptr<int>(v1);
+            float *targetDepth_row = targetDepth.ptr<float>(v1);
+            for(int u1 = 0; u1 < depth1.cols; u1++)
+            {
+                target_row[u1] = -1;
+
+                float d1 = depth1_row[u1];
+                if(!mask1_row[u1])
+                    continue;
+
+                CV_DbgAssert(!cvIsNaN(d1));
+                float transformed_d1 = static_cast<float>(d1 * (KRK_inv6_u1[u1] + KRK_inv7_v1_plus_KRK_inv8[v1]) +
+                                                          Kt_ptr[2]);
+                if(transformed_d1 <= 0)
+                    continue;
+
+                float transformed_d1_inv = 1.f / transformed_d1;
+                int u0 = cvRound(transformed_d1_inv * (d1 * (KRK_inv0_u1[u1] + KRK_inv1_v1_plus_KRK_inv2[v1]) +
+                                                       Kt_ptr[0]));
+                int v0 = cvRound(transformed_d1_inv * (d1 * (KRK_inv3_u1[u1] + KRK_inv4_v1_plus_KRK_inv5[v1]) +
+                                                       Kt_ptr[1]));
+
+                if(r.contains(Point(u0,v0)))
+                {
+                    float d0 = depth0.at<float>(v0,u0);
+                    if(validMask0.at<uchar>(v0, u0) && std::abs(transformed_d1 - d0) <= maxDepthDiff)
+                    {
+                        CV_DbgAssert(!cvIsNaN(d0));
+                        target_row[u1] = v0 * depth1.cols + u0;
+                        targetDepth_row[u1] = transformed_d1;
+                    }
+                }
+            }
+        }
+    }
+
+    const Mat& depth0;
+    const Mat& validMask0;
+    const Mat& depth1;
+    const Mat& selectMask1;
+    float maxDepthDiff;
+    const float *KRK_inv0_u1, *KRK_inv1_v1_plus_KRK_inv2;
+    const float *KRK_inv3_u1, *KRK_inv4_v1_plus_KRK_inv5;
+    const float *KRK_inv6_u1, *KRK_inv7_v1_plus_KRK_inv8;
+    const double* Kt_ptr;
+    Mat& target;
+    Mat& targetDepth;
+};
+
 static
 void computeCorresps(const Mat& K, const Mat& K_inv, const Mat& Rt,
                      const Mat& depth0, const Mat& validMask0,
@@ -446,7 +521,6 @@ void computeCorresps(const Mat& K, const Mat& K_inv, const Mat& Rt,
 
     Mat corresps(depth1.size(), CV_16SC2, Scalar::all(-1));
 
-    Rect r(0, 0, depth1.cols, depth1.rows);
     Mat Kt = Rt(Rect(3,0,1,3)).clone();
     Kt = K * Kt;
     const double * Kt_ptr = Kt.ptr<const double>();
@@ -478,52 +552,41 @@ void computeCorresps(const Mat& K, const Mat& K_inv, const Mat& Rt,
         }
     }
 
+    // projection is done in parallel, then the correspondences are resolved in the raster order of depth1,
+    // so that when several pixels project to the same one the result does not depend on the scheduling
+    Mat target(depth1.size(), CV_32SC1), targetDepth(depth1.size(), CV_32FC1);
+    ProjectCorrespsInvoker invoker(depth0, validMask0, depth1, selectMask1, maxDepthDiff,
+                                   KRK_inv0_u1, KRK_inv1_v1_plus_KRK_inv2,
+                                   KRK_inv3_u1, KRK_inv4_v1_plus_KRK_inv5,
+                                   KRK_inv6_u1, KRK_inv7_v1_plus_KRK_inv8,
+                                   Kt_ptr, target, targetDepth);
+    parallel_for_(Range(0, depth1.rows), invoker);
+
+    Mat correspDepth(depth1.size(), CV_32FC1);
+    Vec2s* corresps_data = corresps.ptr<Vec2s>();
+    float* correspDepth_data = correspDepth.ptr<float>();
     int correspCount = 0;
     for(int v1 = 0; v1 < depth1.rows; v1++)
     {
-        const float *depth1_row = depth1.ptr<float>(v1);
-        const uchar *mask1_row = selectMask1.ptr<uchar>(v1);
+        const int *target_row = target.ptr<int>(v1);
+        const float *targetDepth_row = targetDepth.ptr<float>(v1);
         for(int u1 = 0; u1 < depth1.cols; u1++)
         {
-            float d1 = depth1_row[u1];
-            if(mask1_row[u1])
-            {
-                CV_DbgAssert(!cvIsNaN(d1));
-                float transformed_d1 = static_cast<float>(d1 * (KRK_inv6_u1[u1] + KRK_inv7_v1_plus_KRK_inv8[v1]) +
-                                                          Kt_ptr[2]);
-                if(transformed_d1 > 0)
-                {
-                    float transformed_d1_inv = 1.f / transformed_d1;
-                    int u0 = cvRound(transformed_d1_inv * (d1 * (KRK_inv0_u1[u1] + KRK_inv1_v1_plus_KRK_inv2[v1]) +
-                                                           Kt_ptr[0]));
-                    int v0 = cvRound(transformed_d1_inv * (d1 * (KRK_inv3_u1[u1] + KRK_inv4_v1_plus_KRK_inv5[v1]) +
-                                                           Kt_ptr[1]));
+            int idx = target_row[u1];
+            if(idx < 0)
+                continue;
 
-                    if(r.contains(Point(u0,v0)))
-                    {
-                        float d0 = depth0.at<float>(v0,u0);
-                        if(validMask0.at<uchar>(v0, u0) && std::abs(transformed_d1 - d0) <= maxDepthDiff)
-                        {
-                            CV_DbgAssert(!cvIsNaN(d0));
-                            Vec2s& c = corresps.at<Vec2s>(v0,u0);
-                            if(c[0] != -1)
-                            {
-                                int exist_u1 = c[0], exist_v1 = c[1];
-
-                                float exist_d1 = (float)(depth1.at<float>(exist_v1,exist_u1) *
-                                    (KRK_inv6_u1[exist_u1] + KRK_inv7_v1_plus_KRK_inv8[exist_v1]) + Kt_ptr[2]);
-
-                                if(transformed_d1 > exist_d1)
-                                    continue;
-                            }
-                            else
-                                correspCount++;
-
-                            c = Vec2s((short)u1, (short)v1);
-                        }
-                    }
-                }
+            Vec2s& c = corresps_data[idx];
+            if(c[0] != -1)
+            {
+                if(targetDepth_row[u1] > correspDepth_data[idx])
+                    continue;
             }
+            else
+                correspCount++;
+
+            c = Vec2s((short)u1, (short)v1);
+            correspDepth_data[idx] = targetDepth_row[u1];
         }
     }
 
@@ -614,93 +677,306 @@ void calcICPEquationCoeffsTranslation(double* C, const Point3f& /*p0*/, const Ve
 typedef
 void (*CalcICPEquationCoeffsPtr)(double*, const Point3f&, const Vec3f&);
 
+// Correspondences are split into fixed blocks reduced in parallel; partial sums are added in block order,
+// so the result does not depend on the number of threads.
+static const int lsmBlockSize = 1 << 12;
+
+// Adds a^t*a and a^t*b to the partial sums, a is padded with zeros to 6 elements, AtA has a step of 6.
+static inline
+void accumulateLsm(double* AtA, double* AtB, const double* A, double b, int transformDim)
+{
+#if CV_SIMD128_64F
+    v_float64x2 a01 = v_load(A), a23 = v_load(A + 2), a45 = v_load(A + 4);
+    for(int y = 0; y < transformDim; y++)
+    {
+        v_float64x2 ay = v_setall_f64(A[y]);
+        double* AtA_ptr = AtA + y * 6;
+        v_store(AtA_ptr, v_muladd(ay, a01, v_load(AtA_ptr)));
+        v_store(AtA_ptr + 2, v_muladd(ay, a23, v_load(AtA_ptr + 2)));
+        if(transformDim > 4)
+            v_store(AtA_ptr + 4, v_muladd(ay, a45, v_load(AtA_ptr + 4)));
+    }
+    v_float64x2 vb = v_setall_f64(b);
+    v_store(AtB, v_muladd(a01, vb, v_load(AtB)));
+    v_store(AtB + 2, v_muladd(a23, vb, v_load(AtB + 2)));
+    if(transformDim > 4)
+        v_store(AtB + 4, v_muladd(a45, vb, v_load(AtB + 4)));
+#else
+    for(int y = 0; y < transformDim; y++)
+    {
+        double* AtA_ptr = AtA + y * 6;
+        for(int x = 0; x < transformDim; x++)
+            AtA_ptr[x] += A[y] * A[x];
+
+        AtB[y] += A[y] * b;
+    }
+#endif
+}
+
 static
-void calcRgbdLsmMatrices(const Mat& image0, const Mat& cloud0, const Mat& Rt,
-               const Mat& image1, const Mat& dI_dx1, const Mat& dI_dy1,
-               const Mat& corresps, double fx, double fy, double sobelScaleIn,
-               Mat& AtA, Mat& AtB, CalcRgbdEquationCoeffsPtr func, int transformDim)
+void reduceLsmBlocks(const std::vector<double>& partialAtA, const std::vector<double>& partialAtB,
+                     int transformDim, Mat& AtA, Mat& AtB)
 {
     AtA = Mat(transformDim, transformDim, CV_64FC1, Scalar(0));
     AtB = Mat(transformDim, 1, CV_64FC1, Scalar(0));
     double* AtB_ptr = AtB.ptr<double>();
 
+    const int blocksCount = (int)partialAtB.size() / 6;
+    for(int block = 0; block < blocksCount; block++)
+    {
+        const double* blockAtA = &partialAtA[block * 36];
+        const double* blockAtB = &partialAtB[block * 6];
+        for(int y = 0; y < transformDim; y++)
+        {
+            double* AtA_ptr = AtA.ptr<double>(y);
+            for(int x = 0; x < transformDim; x++)
+                AtA_ptr[x] += blockAtA[y * 6 + x];
+
+            AtB_ptr[y] += blockAtB[y];
+        }
+    }
+}
+
+struct RgbdDiffsInvoker : ParallelLoopBody
+{
+    RgbdDiffsInvoker(const Mat& _image0, const Mat& _image1, const Mat& _corresps,
+                     float* _diffs, double* _partialSigma) :
+        ParallelLoopBody(),
+        image0(_image0), image1(_image1), corresps(_corresps), diffs(_diffs), partialSigma(_partialSigma)
+    { }
+
+    virtual void operator ()(const Range& range) const CV_OVERRIDE
+    {
+        const Vec4i* corresps_ptr = corresps.ptr<Vec4i>();
+        for(int block = range.start; block < range.end; block++)
+        {
+            const int end = std::min((block + 1) * lsmBlockSize, corresps.rows);
+            double sigma = 0;
+            for(int correspIndex = block * lsmBlockSize; correspIndex < end; correspIndex++)
+            {
+                const Vec4i& c = corresps_ptr[correspIndex];
+                int u0 = c[0], v0 = c[1];
+                int u1 = c[2], v1 = c[3];
+
+                diffs[correspIndex] = static_cast<float>(static_cast<int>(image0.at<uchar>(v0,u0)) -
+                                                         static_cast<int>(image1.at<uchar>(v1,u1)));
+                sigma += diffs[correspIndex] * diffs[correspIndex];
+            }
+            partialSigma[block] = sigma;
+        }
+    }
+
+    const Mat& image0;
+    const Mat& image1;
+    const Mat& corresps;
+    float* diffs;
+    double* partialSigma;
+};
+
+template<CalcRgbdEquationCoeffsPtr func>
+struct RgbdLsmInvoker : ParallelLoopBody
+{
+    RgbdLsmInvoker(const Mat& _cloud0, const Mat& _Rt, const Mat& _dI_dx1, const Mat& _dI_dy1,
+                   const Mat& _corresps, const float* _diffs, double _sigma,
+                   double _fx, double _fy, double _sobelScale, int _transformDim,
+                   double* _partialAtA, double* _partialAtB) :
+        ParallelLoopBody(),
+        cloud0(_cloud0), Rt(_Rt), dI_dx1(_dI_dx1), dI_dy1(_dI_dy1), corresps(_corresps),
+        diffs(_diffs), sigma(_sigma), fx(_fx), fy(_fy), sobelScale(_sobelScale), transformDim(_transformDim),
+        partialAtA(_partialAtA), partialAtB(_partialAtB)
+    { }
+
+    virtual void operator ()(const Range& range) const CV_OVERRIDE
+    {
+        const double * Rt_ptr = Rt.ptr<const double>();
+        const Vec4i* corresps_ptr = corresps.ptr<Vec4i>();
+        double A_ptr[6] = { 0, 0, 0, 0, 0, 0 };
+
+        for(int block = range.start; block < range.end; block++)
+        {
+            double* AtA = partialAtA + block * 36;
+            double* AtB = partialAtB + block * 6;
+            const int end = std::min((block + 1) * lsmBlockSize, corresps.rows);
+            for(int correspIndex = block * lsmBlockSize; correspIndex < end; correspIndex++)
+            {
+                const Vec4i& c = corresps_ptr[correspIndex];
+                int u0 = c[0], v0 = c[1];
+                int u1 = c[2], v1 = c[3];
+
+                double w = sigma + std::abs(diffs[correspIndex]);
+                w = w > DBL_EPSILON ? 1./w : 1.;
+
+                double w_sobelScale = w * sobelScale;
+
+                const Point3f& p0 = cloud0.at<Point3f>(v0,u0);
+                Point3f tp0;
+                tp0.x = (float)(p0.x * Rt_ptr[0] + p0.y * Rt_ptr[1] + p0.z * Rt_ptr[2] + Rt_ptr[3]);
+                tp0.y = (float)(p0.x * Rt_ptr[4] + p0.y * Rt_ptr[5] + p0.z * Rt_ptr[6] + Rt_ptr[7]);
+                tp0.z = (float)(p0.x * Rt_ptr[8] + p0.y * Rt_ptr[9] + p0.z * Rt_ptr[10] + Rt_ptr[11]);
+
+                func(A_ptr,
+                     w_sobelScale * dI_dx1.at<short int>(v1,u1),
+                     w_sobelScale * dI_dy1.at<short int>(v1,u1),
+                     tp0, fx, fy);
+
+                accumulateLsm(AtA, AtB, A_ptr, w * diffs[correspIndex], transformDim);
+            }
+        }
+    }
+
+    const Mat& cloud0;
+    const Mat& Rt;
+    const Mat& dI_dx1;
+    const Mat& dI_dy1;
+    const Mat& corresps;
+    const float* diffs;
+    double sigma, fx, fy, sobelScale;
+    int transformDim;
+    double* partialAtA;
+    double* partialAtB;
+};
+
+template<CalcRgbdEquationCoeffsPtr func>
+static
+void calcRgbdLsmMatrices(const Mat& image0, const Mat& cloud0, const Mat& Rt,
+               const Mat& image1, const Mat& dI_dx1, const Mat& dI_dy1,
+               const Mat& corresps, double fx, double fy, double sobelScaleIn,
+               Mat& AtA, Mat& AtB, int transformDim)
+{
     const int correspsCount = corresps.rows;
+    const int blocksCount = (correspsCount + lsmBlockSize - 1) / lsmBlockSize;
 
     CV_Assert(Rt.type() == CV_64FC1);
-    const double * Rt_ptr = Rt.ptr<const double>();
 
     AutoBuffer<float> diffs(correspsCount);
     float* diffs_ptr = diffs.data();
 
-    const Vec4i* corresps_ptr = corresps.ptr<Vec4i>();
+    std::vector<double> partialSigma(blocksCount);
+    parallel_for_(Range(0, blocksCount), RgbdDiffsInvoker(image0, image1, corresps, diffs_ptr, &partialSigma[0]));
 
     double sigma = 0;
-    for(int correspIndex = 0; correspIndex < corresps.rows; correspIndex++)
-    {
-         const Vec4i& c = corresps_ptr[correspIndex];
-         int u0 = c[0], v0 = c[1];
-         int u1 = c[2], v1 = c[3];
-
-         diffs_ptr[correspIndex] = static_cast<float>(static_cast<int>(image0.at<uchar>(v0,u0)) -
-                                                      static_cast<int>(image1.at<uchar>(v1,u1)));
-         sigma += diffs_ptr[correspIndex] * diffs_ptr[correspIndex];
-    }
+    for(int block = 0; block < blocksCount; block++)
+        sigma += partialSigma[block];
     sigma = std::sqrt(sigma/correspsCount);
 
-    std::vector<double> A_buf(transformDim);
-    double* A_ptr = &A_buf[0];
+    std::vector<double> partialAtA(blocksCount * 36, 0.), partialAtB(blocksCount * 6, 0.);
+    parallel_for_(Range(0, blocksCount),
+                  RgbdLsmInvoker<func>(cloud0, Rt, dI_dx1, dI_dy1, corresps, diffs_ptr, sigma,
+                                       fx, fy, sobelScaleIn, transformDim, &partialAtA[0], &partialAtB[0]));
 
-    for(int correspIndex = 0; correspIndex < corresps.rows; correspIndex++)
-    {
-         const Vec4i& c = corresps_ptr[correspIndex];
-         int u0 = c[0], v0 = c[1];
-         int u1 = c[2], v1 = c[3];
+    reduceLsmBlocks(partialAtA, partialAtB, transformDim, AtA, AtB);
+}
 
-         double w = sigma + std::abs(diffs_ptr[correspIndex]);
-         w = w > DBL_EPSILON ? 1./w : 1.;
+typedef
+void (*CalcRgbdLsmMatricesPtr)(const Mat&, const Mat&, const Mat&, const Mat&, const Mat&, const Mat&,
+                               const Mat&, double, double, double, Mat&, Mat&, int);
 
-         double w_sobelScale = w * sobelScaleIn;
+struct ICPDiffsInvoker : ParallelLoopBody
+{
+    ICPDiffsInvoker(const Mat& _cloud0, const Mat& _Rt, const Mat& _cloud1, const Mat& _normals1,
+                    const Mat& _corresps, float* _diffs, Point3f* _tps0, double* _partialSigma) :
+        ParallelLoopBody(),
+        cloud0(_cloud0), Rt(_Rt), cloud1(_cloud1), normals1(_normals1), corresps(_corresps),
+        diffs(_diffs), tps0(_tps0), partialSigma(_partialSigma)
+    { }
+
+    virtual void operator ()(const Range& range) const CV_OVERRIDE
+    {
+        const double * Rt_ptr = Rt.ptr<const double>();
+        const Vec4i* corresps_ptr = corresps.ptr<Vec4i>();
+        for(int block = range.start; block < range.end; block++)
+        {
+            const int end = std::min((block + 1) * lsmBlockSize, corresps.rows);
+            double sigma = 0;
+            for(int correspIndex = block * lsmBlockSize; correspIndex < end; correspIndex++)
+            {
+                const Vec4i& c = corresps_ptr[correspIndex];
+                int u0 = c[0], v0 = c[1];
+                int u1 = c[2], v1 = c[3];
+
+                const Point3f& p0 = cloud0.at<Point3f>(v0,u0);
+                Point3f tp0;
+                tp0.x = (float)(p0.x * Rt_ptr[0] + p0.y * Rt_ptr[1] + p0.z * Rt_ptr[2] + Rt_ptr[3]);
+                tp0.y = (float)(p0.x * Rt_ptr[4] + p0.y * Rt_ptr[5] + p0.z * Rt_ptr[6] + Rt_ptr[7]);
+                tp0.z = (float)(p0.x * Rt_ptr[8] + p0.y * Rt_ptr[9] + p0.z * Rt_ptr[10] + Rt_ptr[11]);
+
+                Vec3f n1 = normals1.at<Vec3f>(v1, u1);
+                Point3f v = cloud1.at<Point3f>(v1,u1) - tp0;
+
+                tps0[correspIndex] = tp0;
+                diffs[correspIndex] = n1[0] * v.x + n1[1] * v.y + n1[2] * v.z;
+                sigma += diffs[correspIndex] * diffs[correspIndex];
+            }
+            partialSigma[block] = sigma;
+        }
+    }
 
-         const Point3f& p0 = cloud0.at<Point3f>(v0,u0);
-         Point3f tp0;
-         tp0.x = (float)(p0.x * Rt_ptr[0] + p0.y * Rt_ptr[1] + p0.z * Rt_ptr[2] + Rt_ptr[3]);
-         tp0.y = (float)(p0.x * Rt_ptr[4] + p0.y * Rt_ptr[5] + p0.z * Rt_ptr[6] + Rt_ptr[7]);
-         tp0.z = (float)(p0.x * Rt_ptr[8] + p0.y * Rt_ptr[9] + p0.z * Rt_ptr[10] + Rt_ptr[11]);
+    const Mat& cloud0;
+    const Mat& Rt;
+    const Mat& cloud1;
+    const Mat& normals1;
+    const Mat& corresps;
+    float* diffs;
+    Point3f* tps0;
+    double* partialSigma;
+};
 
-         func(A_ptr,
-              w_sobelScale * dI_dx1.at<short int>(v1,u1),
-              w_sobelScale * dI_dy1.at<short int>(v1,u1),
-              tp0, fx, fy);
+template<CalcICPEquationCoeffsPtr func>
+struct ICPLsmInvoker : ParallelLoopBody
+{
+    ICPLsmInvoker(const Mat& _normals1, const Mat& _corresps, const float* _diffs, const Point3f* _tps0,
+                  double _sigma, int _transformDim, double* _partialAtA, double* _partialAtB) :
+        ParallelLoopBody(),
+        normals1(_normals1), corresps(_corresps), diffs(_diffs), tps0(_tps0), sigma(_sigma),
+        transformDim(_transformDim), partialAtA(_partialAtA), partialAtB(_partialAtB)
+    { }
+
+    virtual void operator ()(const Range& range) const CV_OVERRIDE
+    {
+        const Vec4i* corresps_ptr = corresps.ptr<Vec4i>();
+        double A_ptr[6] = { 0, 0, 0, 0, 0, 0 };
 
-        for(int y = 0; y < transformDim; y++)
+        for(int block = range.start; block < range.end; block++)
         {
-            double* AtA_ptr = AtA.ptr<double>(y);
-            for(int x = y; x < transformDim; x++)
-                AtA_ptr[x] += A_ptr[y] * A_ptr[x];
+            double* AtA = partialAtA + block * 36;
+            double* AtB = partialAtB + block * 6;
+            const int end = std::min((block + 1) * lsmBlockSize, corresps.rows);
+            for(int correspIndex = block * lsmBlockSize; correspIndex < end; correspIndex++)
+            {
+                const Vec4i& c = corresps_ptr[correspIndex];
+                int u1 = c[2], v1 = c[3];
+
+                double w = sigma + std::abs(diffs[correspIndex]);
+                w = w > DBL_EPSILON ? 1./w : 1.;
 
-            AtB_ptr[y] += A_ptr[y] * w * diffs_ptr[correspIndex];
+                func(A_ptr, tps0[correspIndex], normals1.at<Vec3f>(v1, u1) * w);
+
+                accumulateLsm(AtA, AtB, A_ptr, w * diffs[correspIndex], transformDim);
+            }
         }
     }
 
-    for(int y = 0; y < transformDim; y++)
-        for(int x = y+1; x < transformDim; x++)
-            AtA.at<double>(x,y) = AtA.at<double>(y,x);
-}
+    const Mat& normals1;
+    const Mat& corresps;
+    const float* diffs;
+    const Point3f* tps0;
+    double sigma;
+    int transformDim;
+    double* partialAtA;
+    double* partialAtB;
+};
 
+template<CalcICPEquationCoeffsPtr func>
 static
 void calcICPLsmMatrices(const Mat& cloud0, const Mat& Rt,
                         const Mat& cloud1, const Mat& normals1,
                         const Mat& corresps,
-                        Mat& AtA, Mat& AtB, CalcICPEquationCoeffsPtr func, int transformDim)
+                        Mat& AtA, Mat& AtB, int transformDim)
 {
-    AtA = Mat(transformDim, transformDim, CV_64FC1, Scalar(0));
-    AtB = Mat(transformDim, 1, CV_64FC1, Scalar(0));
-    double* AtB_ptr = AtB.ptr<double>();
-
     const int correspsCount = corresps.rows;
+    const int blocksCount = (correspsCount + lsmBlockSize - 1) / lsmBlockSize;
 
     CV_Assert(Rt.type() == CV_64FC1);
-    const double * Rt_ptr = Rt.ptr<const double>();
 
     AutoBuffer<float> diffs(correspsCount);
     float * diffs_ptr = diffs.data();
@@ -708,58 +984,26 @@ void calcICPLsmMatrices(const Mat& cloud0, const Mat& Rt,
     AutoBuffer<Point3f> transformedPoints0(correspsCount);
     Point3f * tps0_ptr = transformedPoints0.data();
 
-    const Vec4i* corresps_ptr = corresps.ptr<Vec4i>();
+    std::vector<double> partialSigma(blocksCount);
+    parallel_for_(Range(0, blocksCount),
+                  ICPDiffsInvoker(cloud0, Rt, cloud1, normals1, corresps, diffs_ptr, tps0_ptr, &partialSigma[0]));
 
     double sigma = 0;
-    for(int correspIndex = 0; correspIndex < corresps.rows; correspIndex++)
-    {
-        const Vec4i& c = corresps_ptr[correspIndex];
-        int u0 = c[0], v0 = c[1];
-        int u1 = c[2], v1 = c[3];
-
-        const Point3f& p0 = cloud0.at<Point3f>(v0,u0);
-        Point3f tp0;
-        tp0.x = (float)(p0.x * Rt_ptr[0] + p0.y * Rt_ptr[1] + p0.z * Rt_ptr[2] + Rt_ptr[3]);
-        tp0.y = (float)(p0.x * Rt_ptr[4] + p0.y * Rt_ptr[5] + p0.z * Rt_ptr[6] + Rt_ptr[7]);
-        tp0.z = (float)(p0.x * Rt_ptr[8] + p0.y * Rt_ptr[9] + p0.z * Rt_ptr[10] + Rt_ptr[11]);
-
-        Vec3f n1 = normals1.at<Vec3f>(v1, u1);
-        Point3f v = cloud1.at<Point3f>(v1,u1) - tp0;
-
-        tps0_ptr[correspIndex] = tp0;
-        diffs_ptr[correspIndex] = n1[0] * v.x + n1[1] * v.y + n1[2] * v.z;
-        sigma += diffs_ptr[correspIndex] * diffs_ptr[correspIndex];
-    }
-
+    for(int block = 0; block < blocksCount; block++)
+        sigma += partialSigma[block];
     sigma = std::sqrt(sigma/correspsCount);
 
-    std::vector<double> A_buf(transformDim);
-    double* A_ptr = &A_buf[0];
-    for(int correspIndex = 0; correspIndex < corresps.rows; correspIndex++)
-    {
-        const Vec4i& c = corresps_ptr[correspIndex];
-        int u1 = c[2], v1 = c[3];
+    std::vector<double> partialAtA(blocksCount * 36, 0.), partialAtB(blocksCount * 6, 0.);
+    parallel_for_(Range(0, blocksCount),
+                  ICPLsmInvoker<func>(normals1, corresps, diffs_ptr, tps0_ptr, sigma, transformDim,
+                                      &partialAtA[0], &partialAtB[0]));
 
-        double w = sigma + std::abs(diffs_ptr[correspIndex]);
-        w = w > DBL_EPSILON ? 1./w : 1.;
-
-        func(A_ptr, tps0_ptr[correspIndex], normals1.at<Vec3f>(v1, u1) * w);
-
-        for(int y = 0; y < transformDim; y++)
-        {
-            double* AtA_ptr = AtA.ptr<double>(y);
-            for(int x = y; x < transformDim; x++)
-                AtA_ptr[x] += A_ptr[y] * A_ptr[x];
-
-            AtB_ptr[y] += A_ptr[y] * w * diffs_ptr[correspIndex];
-        }
-    }
-
-    for(int y = 0; y < transformDim; y++)
-        for(int x = y+1; x < transformDim; x++)
-            AtA.at<double>(x,y) = AtA.at<double>(y,x);
+    reduceLsmBlocks(partialAtA, partialAtB, transformDim, AtA, AtB);
 }
 
+typedef
+void (*CalcICPLsmMatricesPtr)(const Mat&, const Mat&, const Mat&, const Mat&, const Mat&, Mat&, Mat&, int);
+
 static
 bool solveSystem(const Mat& AtA, const Mat& AtB, double detThreshold, Mat& x)
 {
@@ -796,24 +1040,24 @@ bool RGBDICPOdometryImpl(OutputArray _Rt, const Mat& initRt,
                          int method, int transfromType)
 {
     int transformDim = -1;
-    CalcRgbdEquationCoeffsPtr rgbdEquationFuncPtr = 0;
-    CalcICPEquationCoeffsPtr icpEquationFuncPtr = 0;
+    CalcRgbdLsmMatricesPtr rgbdLsmMatricesFuncPtr = 0;
+    CalcICPLsmMatricesPtr icpLsmMatricesFuncPtr = 0;
     switch(transfromType)
     {
     case Odometry::RIGID_BODY_MOTION:
         transformDim = 6;
-        rgbdEquationFuncPtr = calcRgbdEquationCoeffs;
-        icpEquationFuncPtr = calcICPEquationCoeffs;
+        rgbdLsmMatricesFuncPtr = calcRgbdLsmMatrices<calcRgbdEquationCoeffs>;
+        icpLsmMatricesFuncPtr = calcICPLsmMatrices<calcICPEquationCoeffs>;
         break;
     case Odometry::ROTATION:
         transformDim = 3;
-        rgbdEquationFuncPtr = calcRgbdEquationCoeffsRotation;
-        icpEquationFuncPtr = calcICPEquationCoeffsRotation;
+        rgbdLsmMatricesFuncPtr = calcRgbdLsmMatrices<calcRgbdEquationCoeffsRotation>;
+        icpLsmMatricesFuncPtr = calcICPLsmMatrices<calcICPEquationCoeffsRotation>;
         break;
     case Odometry::TRANSLATION:
         transformDim = 3;
-        rgbdEquationFuncPtr = calcRgbdEquationCoeffsTranslation;
-        icpEquationFuncPtr = calcICPEquationCoeffsTranslation;
+        rgbdLsmMatricesFuncPtr = calcRgbdLsmMatrices<calcRgbdEquationCoeffsTranslation>;
+        icpLsmMatricesFuncPtr = calcICPLsmMatrices<calcICPEquationCoeffsTranslation>;
         break;
     default:
         CV_Error(Error::StsBadArg, "Incorrect transformation type");
@@ -864,19 +1108,19 @@ bool RGBDICPOdometryImpl(OutputArray _Rt, const Mat& initRt,
             Mat AtA(transformDim, transformDim, CV_64FC1, Scalar(0)), AtB(transformDim, 1, CV_64FC1, Scalar(0));
             if(corresps_rgbd.rows >= minCorrespsCount)
             {
-                calcRgbdLsmMatrices(srcFrame->pyramidImage[level], srcFrame->pyramidCloud[level], resultRt,
-                                    dstFrame->pyramidImage[level], dstFrame->pyramid_dI_dx[level], dstFrame->pyramid_dI_dy[level],
-                                    corresps_rgbd, fx, fy, sobelScale,
-                                    AtA_rgbd, AtB_rgbd, rgbdEquationFuncPtr, transformDim);
+                rgbdLsmMatricesFuncPtr(srcFrame->pyramidImage[level], srcFrame->pyramidCloud[level], resultRt,
+                                       dstFrame->pyramidImage[level], dstFrame->pyramid_dI_dx[level], dstFrame->pyramid_dI_dy[level],
+                                       corresps_rgbd, fx, fy, sobelScale,
+                                       AtA_rgbd, AtB_rgbd, transformDim);
 
                 AtA += AtA_rgbd;
                 AtB += AtB_rgbd;
             }
             if(corresps_icp.rows >= minCorrespsCount)
             {
-                calcICPLsmMatrices(srcFrame->pyramidCloud[level], resultRt,
-                                   dstFrame->pyramidCloud[level], dstFrame->pyramidNormals[level],
-                                   corresps_icp, AtA_icp, AtB_icp, icpEquationFuncPtr, transformDim);
+                icpLsmMatricesFuncPtr(srcFrame->pyramidCloud[level], resultRt,
+                                      dstFrame->pyramidCloud[level], dstFrame->pyramidNormals[level],
+                                      corresps_icp, AtA_icp, AtB_icp, transformDim);
                 AtA += AtA_icp;
                 AtB += AtB_icp;
             }
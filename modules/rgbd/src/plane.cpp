@@ -98,6 +98,16 @@ public:
     ++K_;
   }
 
+  /** Update the statistics with the ones of a whole set of points
+   */
+  void
+  UpdateStatistics(const Vec3f & m_sum, const Matx33f & Q, int K)
+  {
+    m_sum_ += m_sum;
+    Q_ += Q;
+    K_ += K;
+  }
+
   inline size_t
   empty() const
   {
@@ -216,58 +226,66 @@ public:
     n_.create(mini_rows, mini_cols);
     Q_.create(points3d.rows, points3d.cols);
     mse_.create(mini_rows, mini_cols);
-    for (int y = 0; y < mini_rows; ++y)
-      for (int x = 0; x < mini_cols; ++x)
-      {
-        // Update the tiles
-        Matx33f Q = Matx33f::zeros();
-        Vec3f m = Vec3f(0, 0, 0);
-        int K = 0;
-        for (int j = y * block_size; j < std::min((y + 1) * block_size, points3d.rows); ++j)
+    tile_Q_.create(mini_rows, mini_cols);
+    tile_K_.create(mini_rows, mini_cols);
+    // Every tile only touches its own pixels and statistics, so they are processed in parallel
+    parallel_for_(Range(0, mini_rows), [&](const Range& range)
+    {
+      for (int y = range.start; y < range.end; ++y)
+        for (int x = 0; x < mini_cols; ++x)
         {
-          const Vec3f * vec = points3d.ptr < Vec3f > (j, x * block_size), *vec_end;
-          float * pointpointt = reinterpret_cast<float*>(Q_.ptr < Vec<float, 9> > (j, x * block_size));
-          if (x == mini_cols - 1)
-            vec_end = points3d.ptr < Vec3f > (j, points3d.cols - 1) + 1;
-          else
-            vec_end = vec + block_size;
-          for (; vec != vec_end; ++vec, pointpointt += 9)
+          // Update the tiles
+          Matx33f Q = Matx33f::zeros();
+          Vec3f m = Vec3f(0, 0, 0);
+          int K = 0;
+          for (int j = y * block_size; j < std::min((y + 1) * block_size, points3d.rows); ++j)
           {
-            if (cvIsNaN(vec->val[0]))
-              continue;
-            // Fill point*point.t()
-            *pointpointt = vec->val[0] * vec->val[0];
-            *(pointpointt + 1) = vec->val[0] * vec->val[1];
-            *(pointpointt + 2) = vec->val[0] * vec->val[2];
-            *(pointpointt + 3) = *(pointpointt + 1);
-            *(pointpointt + 4) = vec->val[1] * vec->val[1];
-            *(pointpointt + 5) = vec->val[1] * vec->val[2];
-            *(pointpointt + 6) = *(pointpointt + 2);
-            *(pointpointt + 7) = *(pointpointt + 5);
-            *(pointpointt + 8) = vec->val[2] * vec->val[2];
-
-            Q += *reinterpret_cast<Matx33f*>(pointpointt);
-            m += (*vec);
-            ++K;
+            const Vec3f * vec = points3d.ptr < Vec3f > (j, x * block_size), *vec_end;
+            float * pointpointt = reinterpret_cast<float*>(Q_.ptr < Vec<float, 9> > (j, x * block_size));
+            if (x == mini_cols - 1)
+              vec_end = points3d.ptr < Vec3f > (j, points3d.cols - 1) + 1;
+            else
+              vec_end = vec + block_size;
+            for (; vec != vec_end; ++vec, pointpointt += 9)
+            {
+              if (cvIsNaN(vec->val[0]))
+                continue;
+              // Fill point*point.t()
+              *pointpointt = vec->val[0] * vec->val[0];
+              *(pointpointt + 1) = vec->val[0] * vec->val[1];
+              *(pointpointt + 2) = vec->val[0] * vec->val[2];
+              *(pointpointt + 3) = *(pointpointt + 1);
+              *(pointpointt + 4) = vec->val[1] * vec->val[1];
+              *(pointpointt + 5) = vec->val[1] * vec->val[2];
+              *(pointpointt + 6) = *(pointpointt + 2);
+              *(pointpointt + 7) = *(pointpointt + 5);
+              *(pointpointt + 8) = vec->val[2] * vec->val[2];
+
+              Q += *reinterpret_cast<Matx33f*>(pointpointt);
+              m += (*vec);
+              ++K;
+            }
+          }
+          tile_Q_(y, x) = Vec<float, 9>(Q.val);
+          tile_K_(y, x) = K;
+          if (K == 0)
+          {
+            mse_(y, x) = std::numeric_limits<float>::max();
+            continue;
           }
-        }
-        if (K == 0)
-        {
-          mse_(y, x) = std::numeric_limits<float>::max();
-          continue;
-        }
 
-        m /= K;
-        m_(y, x) = m;
+          m /= K;
+          m_(y, x) = m;
 
-        // Compute C
-        Matx33f C = Q - K * m * m.t();
+          // Compute C
+          Matx33f C = Q - K * m * m.t();
 
-        // Compute n
-        SVD svd(C);
-        n_(y, x) = Vec3f(svd.vt.at<float>(2, 0), svd.vt.at<float>(2, 1), svd.vt.at<float>(2, 2));
-        mse_(y, x) = svd.w.at<float>(2) / K;
-      }
+          // Compute n
+          SVD svd(C);
+          n_(y, x) = Vec3f(svd.vt.at<float>(2, 0), svd.vt.at<float>(2, 1), svd.vt.at<float>(2, 2));
+          mse_(y, x) = svd.w.at<float>(2) / K;
+        }
+    });
   }
 
   /** The size of the block */
@@ -276,6 +294,9 @@ public:
   Mat_<Vec3f> n_;
   Mat_<Vec<float, 9> > Q_;
   Mat_<float> mse_;
+  /** The sum of pi * pi^\top and the number of valid points over each tile */
+  Mat_<Vec<float, 9> > tile_Q_;
+  Mat_<int> tile_K_;
 };
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -501,6 +522,241 @@ private:
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
+/** Create a plane with the sensor error model, if any
+ */
+static Ptr<PlaneBase>
+createPlane(const Vec3f & m, const Vec3f & n, int index, float sensor_error_a, float sensor_error_b,
+            float sensor_error_c)
+{
+  if ((sensor_error_a == 0) && (sensor_error_b == 0) && (sensor_error_c == 0))
+    return Ptr<PlaneBase>(new Plane(m, n, index));
+  return Ptr<PlaneBase>(new PlaneABC(m, n, index, sensor_error_a, sensor_error_b, sensor_error_c));
+}
+
+/** Union-find over the tiles. The root of a set is always its smallest tile so that the result does not
+ * depend on the order of the merges
+ */
+class TileSets
+{
+public:
+  explicit TileSets(int n)
+      :
+        parent_(n)
+  {
+    for (int i = 0; i < n; ++i)
+      parent_[i] = i;
+  }
+
+  int
+  find(int i)
+  {
+    while (parent_[i] != i)
+    {
+      parent_[i] = parent_[parent_[i]];
+      i = parent_[i];
+    }
+    return i;
+  }
+
+  void
+  merge(int i, int j)
+  {
+    i = find(i);
+    j = find(j);
+    if (i < j)
+      parent_[j] = i;
+    else if (j < i)
+      parent_[i] = j;
+  }
+private:
+  std::vector<int> parent_;
+};
+
+/** Statistics of the inliers of each plane found in a band of tiles
+ */
+struct PlaneStatistics
+{
+  PlaneStatistics()
+      :
+        m_sum_(Vec3f(0, 0, 0)),
+        Q_(Matx33f::zeros()),
+        K_(0)
+  {
+  }
+
+  Vec3f m_sum_;
+  Matx33f Q_;
+  int K_;
+};
+
+/** Find the planes by merging the planar tiles instead of growing them one after the other: neighboring planar
+ * tiles that lie on each other's plane are merged with a union-find, every merged set gives a plane and all the
+ * points are then assigned in parallel to the first plane of their tile or of the neighboring ones they fit.
+ * Planes are ordered like in the sequential version, by the MSE of their best tile.
+ */
+static void
+findPlanesBlockMerge(const Mat_<Vec3f> & points3d, const Mat_<Vec3f> & normals, const PlaneGrid & plane_grid,
+                     float threshold, int min_size, float sensor_error_a, float sensor_error_b,
+                     float sensor_error_c, Mat_<unsigned char> & mask, std::vector<Vec4f> & plane_coefficients)
+{
+  const int block_size = plane_grid.block_size_;
+  const int mini_rows = plane_grid.mse_.rows, mini_cols = plane_grid.mse_.cols;
+  const int n_tiles = mini_rows * mini_cols;
+  const float mse_min = threshold * threshold;
+
+  // The planes of the planar tiles
+  std::vector<Ptr<PlaneBase> > tile_planes(n_tiles);
+  for (int y = 0; y < mini_rows; ++y)
+    for (int x = 0; x < mini_cols; ++x)
+      if (plane_grid.mse_(y, x) <= mse_min)
+        tile_planes[y * mini_cols + x] = createPlane(plane_grid.m_(y, x), plane_grid.n_(y, x), 0,
+                                                     sensor_error_a, sensor_error_b, sensor_error_c);
+
+  // Merge the neighboring tiles that belong to the same plane
+  TileSets tile_sets(n_tiles);
+  for (int y = 0; y < mini_rows; ++y)
+    for (int x = 0; x < mini_cols; ++x)
+    {
+      int i = y * mini_cols + x;
+      if (!tile_planes[i])
+        continue;
+      if ((x < mini_cols - 1) && tile_planes[i + 1]
+          && (tile_planes[i]->distance(plane_grid.m_(y, x + 1)) < threshold)
+          && (tile_planes[i + 1]->distance(plane_grid.m_(y, x)) < threshold))
+        tile_sets.merge(i, i + 1);
+      if ((y < mini_rows - 1) && tile_planes[i + mini_cols]
+          && (tile_planes[i]->distance(plane_grid.m_(y + 1, x)) < threshold)
+          && (tile_planes[i + mini_cols]->distance(plane_grid.m_(y, x)) < threshold))
+        tile_sets.merge(i, i + mini_cols);
+    }
+
+  // Order the sets by the MSE of their best tile, like the sequential version picks its seeds
+  std::vector<TileQueue::PlaneTile> seeds;
+  std::vector<float> best_mse(n_tiles, std::numeric_limits<float>::max());
+  for (int i = 0; i < n_tiles; ++i)
+    if (tile_planes[i])
+    {
+      int root = tile_sets.find(i);
+      best_mse[root] = std::min(best_mse[root], plane_grid.mse_(i / mini_cols, i % mini_cols));
+    }
+  for (int i = 0; i < n_tiles; ++i)
+    if (tile_planes[i] && (tile_sets.find(i) == i))
+      seeds.push_back(TileQueue::PlaneTile(i % mini_cols, i / mini_cols, best_mse[i]));
+  std::stable_sort(seeds.begin(), seeds.end());
+  // The mask can only hold 255 planes
+  if (seeds.size() > 255)
+    seeds.resize(255);
+
+  // Fit a plane on every set, and give each tile its plane index
+  std::vector<int> root_index(n_tiles, -1);
+  for (size_t k = 0; k < seeds.size(); ++k)
+    root_index[seeds[k].y_ * mini_cols + seeds[k].x_] = (int)k;
+  std::vector<PlaneStatistics> set_statistics(seeds.size());
+  Mat_<int> tile_index(mini_rows, mini_cols, -1);
+  for (int i = 0; i < n_tiles; ++i)
+  {
+    if (!tile_planes[i])
+      continue;
+    int k = root_index[tile_sets.find(i)];
+    if (k < 0)
+      continue;
+    int y = i / mini_cols, x = i % mini_cols;
+    int K = plane_grid.tile_K_(y, x);
+    set_statistics[k].m_sum_ += plane_grid.m_(y, x) * (float)K;
+    set_statistics[k].Q_ += Matx33f(plane_grid.tile_Q_(y, x).val);
+    set_statistics[k].K_ += K;
+    tile_index(y, x) = k;
+  }
+  std::vector<Ptr<PlaneBase> > planes(seeds.size());
+  for (size_t k = 0; k < seeds.size(); ++k)
+  {
+    int x = seeds[k].x_, y = seeds[k].y_;
+    planes[k] = createPlane(plane_grid.m_(y, x), plane_grid.n_(y, x), (int)k, sensor_error_a, sensor_error_b,
+                            sensor_error_c);
+    planes[k]->UpdateStatistics(set_statistics[k].m_sum_, set_statistics[k].Q_, set_statistics[k].K_);
+    planes[k]->UpdateParameters();
+  }
+
+  // Assign the points to the planes, one band of tiles at a time. The statistics of the inliers are kept per band
+  // and summed in band order so that the final coefficients do not depend on the number of threads
+  std::vector<std::vector<PlaneStatistics> > band_statistics(mini_rows,
+                                                             std::vector<PlaneStatistics>(planes.size()));
+  parallel_for_(Range(0, mini_rows), [&](const Range& range)
+  {
+    std::vector<int> candidates;
+    for (int y = range.start; y < range.end; ++y)
+    {
+      std::vector<PlaneStatistics> & statistics = band_statistics[y];
+      for (int x = 0; x < mini_cols; ++x)
+      {
+        // The planes of the tile and of its neighbors, the first ones having the priority
+        candidates.clear();
+        const int dx[5] = { 0, -1, 1, 0, 0 }, dy[5] = { 0, 0, 0, -1, 1 };
+        for (int k = 0; k < 5; ++k)
+        {
+          int xx = x + dx[k], yy = y + dy[k];
+          if ((xx >= 0) && (xx < mini_cols) && (yy >= 0) && (yy < mini_rows) && (tile_index(yy, xx) >= 0))
+            candidates.push_back(tile_index(yy, xx));
+        }
+        if (candidates.empty())
+          continue;
+        std::sort(candidates.begin(), candidates.end());
+        candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+
+        int x_end = std::min((x + 1) * block_size, points3d.cols);
+        for (int yy = y * block_size; yy < std::min((y + 1) * block_size, points3d.rows); ++yy)
+        {
+          uchar* data = mask.ptr(yy);
+          const Vec3f* point = points3d.ptr < Vec3f > (yy);
+          const Vec3f* normal = normals.empty() ? 0 : normals.ptr < Vec3f > (yy);
+          const Matx33f* Q_local = reinterpret_cast<const Matx33f *>(plane_grid.Q_.ptr < Vec<float, 9> > (yy));
+          for (int xx = x * block_size; xx < x_end; ++xx)
+          {
+            if (cvIsNaN(point[xx][0]))
+              continue;
+            for (size_t k = 0; k < candidates.size(); ++k)
+            {
+              const PlaneBase & plane = *planes[candidates[k]];
+              // If the point is close enough to the plane and, if known, its normal is similar
+              if ((plane.distance(point[xx]) < threshold)
+                  && (!normal || (std::abs(plane.n().dot(normal[xx])) > 0.3)))
+              {
+                PlaneStatistics & plane_statistics = statistics[candidates[k]];
+                plane_statistics.m_sum_ += point[xx];
+                plane_statistics.Q_ += Q_local[xx];
+                ++plane_statistics.K_;
+                data[xx] = (uchar)candidates[k];
+                break;
+              }
+            }
+          }
+        }
+      }
+    }
+  });
+
+  // Refine the planes with their inliers, drop the small ones and renumber the others
+  Mat_<uchar> lut(1, 256, (uchar)255);
+  for (size_t k = 0; k < planes.size(); ++k)
+  {
+    int x = seeds[k].x_, y = seeds[k].y_;
+    Ptr<PlaneBase> plane = createPlane(plane_grid.m_(y, x), planes[k]->n(), (int)k, sensor_error_a, sensor_error_b,
+                                       sensor_error_c);
+    for (y = 0; y < mini_rows; ++y)
+      plane->UpdateStatistics(band_statistics[y][k].m_sum_, band_statistics[y][k].Q_, band_statistics[y][k].K_);
+    if (plane->empty() || (plane->K() < min_size))
+      continue;
+    plane->UpdateParameters();
+
+    lut(0, (int)k) = (uchar)plane_coefficients.size();
+    Vec4f coeffs(plane->n()[0], plane->n()[1], plane->n()[2], plane->d());
+    if (coeffs(2) > 0)
+      coeffs = -coeffs;
+    plane_coefficients.push_back(coeffs);
+  }
+  LUT(mask, lut, mask);
+}
+
   void
   RgbdPlane::operator()(InputArray points3d_in, OutputArray mask_out, OutputArray plane_coefficients)
   {
@@ -530,75 +786,79 @@ private:
     Mat_<unsigned char> mask_out_uc = (Mat_<unsigned char>&) mask_out_mat;
     mask_out_uc.setTo(255);
     PlaneGrid plane_grid(points3d, block_size_);
-    TileQueue plane_queue(plane_grid);
-    size_t index_plane = 0;
-
     std::vector<Vec4f> plane_coefficients;
-    float mse_min = (float)(threshold_ * threshold_);
 
-    while (!plane_queue.empty())
+    if (method_ == RGBD_PLANE_METHOD_BLOCK_MERGE)
     {
-      // Get the first tile if it's good enough
-      const TileQueue::PlaneTile front_tile = plane_queue.front();
-      if (front_tile.mse_ > mse_min)
-        break;
+      findPlanesBlockMerge(points3d, normals, plane_grid, (float)threshold_, min_size_, (float)sensor_error_a_,
+                           (float)sensor_error_b_, (float)sensor_error_c_, mask_out_uc, plane_coefficients);
+    }
+    else
+    {
+      TileQueue plane_queue(plane_grid);
+      size_t index_plane = 0;
+      float mse_min = (float)(threshold_ * threshold_);
+
+      while (!plane_queue.empty())
+      {
+        // Get the first tile if it's good enough
+        const TileQueue::PlaneTile front_tile = plane_queue.front();
+        if (front_tile.mse_ > mse_min)
+          break;
 
-      InlierFinder inlier_finder((float)threshold_, points3d, normals, (unsigned char)index_plane, block_size_);
+        InlierFinder inlier_finder((float)threshold_, points3d, normals, (unsigned char)index_plane, block_size_);
 
-      // Construct the plane for the first tile
-      int x = front_tile.x_, y = front_tile.y_;
-      const Vec3f & n = plane_grid.n_(y, x);
-      Ptr<PlaneBase> plane;
-      if ((sensor_error_a_ == 0) && (sensor_error_b_ == 0) && (sensor_error_c_ == 0))
-        plane = Ptr<PlaneBase>(new Plane(plane_grid.m_(y, x), n, (int)index_plane));
-      else
-        plane = Ptr<PlaneBase>(new PlaneABC(plane_grid.m_(y, x), n, (int)index_plane,
-			(float)sensor_error_a_, (float)sensor_error_b_, (float)sensor_error_c_));
+        // Construct the plane for the first tile
+        int x = front_tile.x_, y = front_tile.y_;
+        const Vec3f & n = plane_grid.n_(y, x);
+        Ptr<PlaneBase> plane = createPlane(plane_grid.m_(y, x), n, (int)index_plane, (float)sensor_error_a_,
+                                           (float)sensor_error_b_, (float)sensor_error_c_);
 
-      Mat_<unsigned char> plane_mask = Mat_<unsigned char>::zeros(points3d.rows / block_size_,
-                                                                          points3d.cols / block_size_);
-      std::set<TileQueue::PlaneTile> neighboring_tiles;
-      neighboring_tiles.insert(front_tile);
-      plane_queue.remove(front_tile.y_, front_tile.x_);
+        Mat_<unsigned char> plane_mask = Mat_<unsigned char>::zeros(points3d.rows / block_size_,
+                                                                            points3d.cols / block_size_);
+        std::set<TileQueue::PlaneTile> neighboring_tiles;
+        neighboring_tiles.insert(front_tile);
+        plane_queue.remove(front_tile.y_, front_tile.x_);
 
-      // Process all the neighboring tiles
-      while (!neighboring_tiles.empty())
-        inlier_finder.Find(plane_grid, plane, plane_queue, neighboring_tiles, mask_out_uc, plane_mask);
+        // Process all the neighboring tiles
+        while (!neighboring_tiles.empty())
+          inlier_finder.Find(plane_grid, plane, plane_queue, neighboring_tiles, mask_out_uc, plane_mask);
 
-      // Don't record the plane if it's empty
-      if (plane->empty())
-        continue;
-      // Don't record the plane if it's smaller than asked
-      if (plane->K() < min_size_) {
-        // Reset the plane index in the mask
-        for (y = 0; y < plane_mask.rows; ++y)
-          for (x = 0; x < plane_mask.cols; ++x) {
-            if (!plane_mask(y, x))
-              continue;
-            // Go over the tile
-            for (int yy = y * block_size_;
-                yy < std::min((y + 1) * block_size_, mask_out_uc.rows); ++yy) {
-              uchar* data = mask_out_uc.ptr(yy, x * block_size_);
-              uchar* data_end = data
-                  + std::min(block_size_,
-                      mask_out_uc.cols - x * block_size_);
-              for (; data != data_end; ++data) {
-                if (*data == index_plane)
-                  *data = 255;
+        // Don't record the plane if it's empty
+        if (plane->empty())
+          continue;
+        // Don't record the plane if it's smaller than asked
+        if (plane->K() < min_size_) {
+          // Reset the plane index in the mask
+          for (y = 0; y < plane_mask.rows; ++y)
+            for (x = 0; x < plane_mask.cols; ++x) {
+              if (!plane_mask(y, x))
+                continue;
+              // Go over the tile
+              for (int yy = y * block_size_;
+                  yy < std::min((y + 1) * block_size_, mask_out_uc.rows); ++yy) {
+                uchar* data = mask_out_uc.ptr(yy, x * block_size_);
+                uchar* data_end = data
+                    + std::min(block_size_,
+                        mask_out_uc.cols - x * block_size_);
+                for (; data != data_end; ++data) {
+                  if (*data == index_plane)
+                    *data = 255;
+                }
               }
             }
-          }
-        continue;
-      }
+          continue;
+        }
 
-      ++index_plane;
-      if (index_plane >= 255)
-        break;
-      Vec4f coeffs(plane->n()[0], plane->n()[1], plane->n()[2], plane->d());
-      if (coeffs(2) > 0)
-        coeffs = -coeffs;
-      plane_coefficients.push_back(coeffs);
-    };
+        ++index_plane;
+        if (index_plane >= 255)
+          break;
+        Vec4f coeffs(plane->n()[0], plane->n()[1], plane->n()[2], plane->d());
+        if (coeffs(2) > 0)
+          coeffs = -coeffs;
+        plane_coefficients.push_back(coeffs);
+      };
+    }
 
     // Fill the plane coefficients
     if (plane_coefficients.empty())
@@ -330,7 +330,9 @@ protected:
 class CV_RgbdPlaneTest: public cvtest::BaseTest
 {
 public:
-  CV_RgbdPlaneTest()
+  CV_RgbdPlaneTest(int method = RgbdPlane::RGBD_PLANE_METHOD_DEFAULT)
+      :
+        method_(method)
   {
   }
   ~CV_RgbdPlaneTest()
@@ -342,7 +344,7 @@ protected:
   {
     try
     {
-      RgbdPlane plane_computer;
+      RgbdPlane plane_computer(method_);
 
       std::vector<Plane> planes;
       Mat points3d, ground_normals;
@@ -425,6 +427,8 @@ protected:
       std::cout << "plane " << tm2.getTimeMilli() << " ms " << std::endl;
     }
   }
+
+  int method_;
 };
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -441,4 +445,10 @@ TEST(Rgbd_Plane, compute)
   test.safe_run();
 }
 
+TEST(Rgbd_Plane, compute_block_merge)
+{
+  CV_RgbdPlaneTest test(RgbdPlane::RGBD_PLANE_METHOD_BLOCK_MERGE);
+  test.safe_run();
+}
+
 }} // namespace
@@ -0,0 +1,39 @@
+// This file is part of OpenCV project.
+// It is subject to the license terms in the LICENSE file found in the top-level directory
+// of this distribution and at http://opencv.org/license.html.
+#include "perf_precomp.hpp"
+
+namespace opencv_test { namespace {
+
+typedef TestBaseWithParam<Size> MotionSaliencyBinWangApr2014Perf;
+
+PERF_TEST_P(MotionSaliencyBinWangApr2014Perf, computeSaliency, testing::Values(szVGA, sz720p, sz1080p))
+{
+    const Size sz = GetParam();
+
+    // slowly drifting background with a moving bright square on top of it
+    const int nFrames = 8;
+    RNG rng(0);
+    Mat background(sz, CV_8UC1);
+    rng.fill(background, RNG::UNIFORM, 0, 200);
+    std::vector<Mat> frames(nFrames);
+    for (int i = 0; i < nFrames; i++)
+    {
+        frames[i] = background + Scalar(i);
+        rectangle(frames[i], Rect(sz.width / 8 + i * 16, sz.height / 4, sz.width / 8, sz.height / 4), Scalar(255), FILLED);
+    }
+
+    Ptr<MotionSaliencyBinWangApr2014> saliency = MotionSaliencyBinWangApr2014::create();
+    saliency->setImagesize(sz.width, sz.height);
+    saliency->init();
+    Mat map;
+    for (int i = 0; i < nFrames; i++)
+        saliency->computeSaliency(frames[i], map);
+
+    int frame = 0;
+    TEST_CYCLE() saliency->computeSaliency(frames[frame++ % nFrames], map);
+
+    SANITY_CHECK_NOTHING();
+}
+
+}} // namespace
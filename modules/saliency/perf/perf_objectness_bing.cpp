@@ -0,0 +1,59 @@
+// This file is part of OpenCV project.
+// It is subject to the license terms in the LICENSE file found in the top-level directory
+// of this distribution and at http://opencv.org/license.html.
+#include "perf_precomp.hpp"
+
+namespace opencv_test { namespace {
+
+// Writes a random MAXBGR model (stage I filter, active size indexes and stage II weights)
+// in the layout expected by ObjectnessBING::setTrainingPath()
+static std::string createRandomBINGModel()
+{
+    const std::string tmp = cv::tempfile();
+    const std::string dir = tmp.substr(0, tmp.find_last_of("/\\"));
+    const std::string name = "ObjNessB2W8MAXBGR";
+    const std::string prefix = dir + "/" + name;
+
+    RNG rng(0);
+    Mat filter(8, 8, CV_32F);
+    rng.fill(filter, RNG::UNIFORM, -1.f, 1.f);
+
+    // all 6x6 quantized sizes from 16 to 512 pixels
+    std::vector<int> idx;
+    for (int i = 0; i < 36; i++)
+        idx.push_back(i);
+
+    Mat reWeights((int)idx.size(), 2, CV_32F);
+    rng.fill(reWeights, RNG::UNIFORM, 0.5f, 1.5f);
+
+    FileStorage fs1(prefix + ".wS1.yml.gz", FileStorage::WRITE);
+    fs1 << name << filter;
+    FileStorage fsI(prefix + ".idx.yml.gz", FileStorage::WRITE);
+    fsI << name << Mat(idx);
+    FileStorage fs2(prefix + ".wS2.yml.gz", FileStorage::WRITE);
+    fs2 << name << reWeights;
+    return dir;
+}
+
+typedef TestBaseWithParam<Size> ObjectnessBINGPerf;
+
+PERF_TEST_P(ObjectnessBINGPerf, computeSaliency, testing::Values(szVGA, sz720p, sz1080p))
+{
+    const Size sz = GetParam();
+    const std::string modelDir = createRandomBINGModel();
+
+    Mat img(sz, CV_8UC3);
+    declare.in(img, WARMUP_RNG);
+
+    Ptr<ObjectnessBING> bing = ObjectnessBING::create();
+    bing->setTrainingPath(modelDir);
+    bing->setBBResDir(modelDir);
+
+    Mat boxes;
+    TEST_CYCLE() bing->computeSaliency(img, boxes);
+
+    ASSERT_FALSE(boxes.empty());
+    SANITY_CHECK_NOTHING();
+}
+
+}} // namespace
@@ -129,40 +129,58 @@ void ObjectnessBING::predictBBoxSI( Mat &img3u, ValStructVec<float, Vec4i> &valB
   valBoxes.reserve( 10000 );
   sz.clear();
   sz.reserve( 10000 );
-  for ( int ir = numSz - 1; ir >= 0; ir-- )
-  {
-    int r = _svmSzIdxs[ir];
-    int height = cvRound( pow( _base, r / _numT + _minT ) ), width = cvRound( pow( _base, r % _numT + _minT ) );
-    if( height > imgH * _base || width > imgW * _base )
-      continue;
 
-    height = min( height, imgH ), width = min( width, imgW );
-    Mat im3u, matchCost1f, mag1u;
-    resize( img3u, im3u, Size( cvRound( _W * imgW * 1.0 / width ), cvRound( _W * imgH * 1.0 / height ) ), 0, 0, INTER_LINEAR_EXACT );
-    gradientMag( im3u, mag1u );
-
-    matchCost1f = _tigF.matchTemplate( mag1u );
+  // Scales are independent of each other: score them concurrently, each one into its own slot,
+  // and concatenate the slots afterwards so that the output order does not depend on scheduling
+  std::vector<ValStructVec<float, Vec4i> > scaleBoxes( numSz );
 
+  parallel_for_( Range( 0, numSz ), [&]( const Range& range )
+  {
+    // Working buffers are shared by all the scales processed by this worker
+    Mat im3u, mag1u, matchCost1f;
     ValStructVec<float, Point> matchCost;
-    nonMaxSup( matchCost1f, matchCost, _NSS, NUM_WIN_PSZ, fast );
+    for ( int ir = range.start; ir < range.end; ir++ )
+    {
+      int r = _svmSzIdxs[ir];
+      int height = cvRound( pow( _base, r / _numT + _minT ) ), width = cvRound( pow( _base, r % _numT + _minT ) );
+      if( height > imgH * _base || width > imgW * _base )
+        continue;
+
+      height = min( height, imgH ), width = min( width, imgW );
+      resize( img3u, im3u, Size( cvRound( _W * imgW * 1.0 / width ), cvRound( _W * imgH * 1.0 / height ) ), 0, 0, INTER_LINEAR_EXACT );
+      gradientMag( im3u, mag1u );
+
+      _tigF.matchTemplate( mag1u, matchCost1f );
+      nonMaxSup( matchCost1f, matchCost, _NSS, NUM_WIN_PSZ, fast );
+
+      // Find true locations and match values
+      double ratioX = width / _W, ratioY = height / _W;
+      int iMax = min( matchCost.size(), NUM_WIN_PSZ );
+      ValStructVec<float, Vec4i> &boxes = scaleBoxes[ir];
+      boxes.reserve( iMax );
+      for ( int i = 0; i < iMax; i++ )
+      {
+        float mVal = matchCost( i );
+        Point pnt = matchCost[i];
+        Vec4i box( cvRound( pnt.x * ratioX ), cvRound( pnt.y * ratioY ) );
+        box[2] = cvRound( min( box[0] + width, imgW ) );
+        box[3] = cvRound( min( box[1] + height, imgH ) );
+        box[0]++;
+        box[1]++;
+        boxes.pushBack( mVal, box );
+      }
+    }
+  });
 
-    // Find true locations and match values
-    double ratioX = width / _W, ratioY = height / _W;
-    int iMax = min( matchCost.size(), NUM_WIN_PSZ );
-    for ( int i = 0; i < iMax; i++ )
+  for ( int ir = numSz - 1; ir >= 0; ir-- )
+  {
+    const ValStructVec<float, Vec4i> &boxes = scaleBoxes[ir];
+    for ( int i = 0; i < boxes.size(); i++ )
     {
-      float mVal = matchCost( i );
-      Point pnt = matchCost[i];
-      Vec4i box( cvRound( pnt.x * ratioX ), cvRound( pnt.y * ratioY ) );
-      box[2] = cvRound( min( box[0] + width, imgW ) );
-      box[3] = cvRound( min( box[1] + height, imgH ) );
-      box[0]++;
-      box[1]++;
-      valBoxes.pushBack( mVal, box );
+      valBoxes.pushBack( boxes( i ), boxes[i] );
       sz.push_back( ir );
     }
   }
-
 }
 
 void ObjectnessBING::predictBBoxSII( ValStructVec<float, Vec4i> &valBoxes, const std::vector<int> &sz )
@@ -115,98 +115,84 @@ MotionSaliencyBinWangApr2014::~MotionSaliencyBinWangApr2014()
 }
 
 // classification (and adaptation) functions
-bool MotionSaliencyBinWangApr2014::fullResolutionDetection( const Mat& image2, Mat& highResBFMask )
+bool MotionSaliencyBinWangApr2014::fullResolutionDetection( const Mat& image, Mat& highResBFMask )
 {
-  Mat image = image2.clone();
-
-  uchar currentPixelValue;
-  float currentEpslonValue;
-  bool backgFlag = false;
+  CV_Assert( image.type() == CV_8UC1 && image.size() == epslonPixelsValue.size() );
 
   // Initially, all pixels are considered as foreground and then we evaluate with the background model
   highResBFMask.create( image.rows, image.cols, CV_8U );
   highResBFMask.setTo( 1 );
 
-  uchar* pImage;
-  float* pEpslon;
-  uchar* pMask;
+  const int nTemplates = (int) backgroundModel.size();
 
-  // Scan all pixels of image
-  for ( int i = 0; i < image.rows; i++ )
+  // Every pixel only reads and updates its own templates, so rows are classified independently
+  parallel_for_( Range( 0, image.rows ), [&]( const Range& range )
   {
-
-    pImage = image.ptr<uchar>( i );
-    pEpslon = epslonPixelsValue.ptr<float>( i );
-    pMask = highResBFMask.ptr<uchar>( i );
-    for ( int j = 0; j < image.cols; j++ )
+    AutoBuffer<Vec2f*> templateRows( nTemplates );
+    for ( int i = range.start; i < range.end; i++ )
     {
-      /*    Pixels with activity greater than Bth are eliminated from the detection result. In this way,
-       continuously blinking noise-pixels will be eliminated from the detection results,
-       preventing the generation of false positives.*/
-      if( activityPixelsValue.at<uchar>( i, j ) < Bth )
+      const uchar* pImage = image.ptr<uchar>( i );
+      const float* pEpslon = epslonPixelsValue.ptr<float>( i );
+      const uchar* pActivity = activityPixelsValue.ptr<uchar>( i );
+      uchar* pMask = highResBFMask.ptr<uchar>( i );
+      for ( int z = 0; z < nTemplates; z++ )
+        templateRows[z] = backgroundModel[z]->ptr<Vec2f>( i );
+
+      for ( int j = 0; j < image.cols; j++ )
       {
-        backgFlag = false;
-        currentPixelValue = pImage[j];
-        currentEpslonValue = pEpslon[j];
+        /*    Pixels with activity greater than Bth are eliminated from the detection result. In this way,
+         continuously blinking noise-pixels will be eliminated from the detection results,
+         preventing the generation of false positives.*/
+        if( pActivity[j] >= Bth )
+        {
+          pMask[j] = 0;
+          continue;
+        }
 
         int counter = 0;
-        for ( size_t z = 0; z < backgroundModel.size(); z++ )
-        {
+        for ( int z = 0; z < nTemplates && counter == 0; z++ )
+          counter += (int) templateRows[z][j][1];
 
-          counter += (int) backgroundModel[z]->ptr<Vec2f>( i )[j][1];
-          if( counter != 0 )
-            break;
+        if( counter == 0 )
+        {
+          pMask[j] = 1;  //if the model of the current pixel is not yet initialized, we mark the pixels as foreground
+          continue;
         }
 
-        if( counter != 0 )  //if at least the first template is activated / initialized
+        const uchar currentPixelValue = pImage[j];
+        const float currentEpslonValue = pEpslon[j];
+        bool backgFlag = false;
+
+        // scan background model vector
+        for ( int z = 0; z < nTemplates; z++ )
         {
+          float& currentB = templateRows[z][j][0];
+          float& currentC = templateRows[z][j][1];
 
-          // scan background model vector
-          for ( size_t z = 0; z < backgroundModel.size(); z++ )
+          if( currentC > 0 )  //The current template is active
           {
-            float* currentB;
-            float* currentC;
-            currentB = & ( backgroundModel[z]->ptr<Vec2f>( i )[j][0] );
-            currentC = & ( backgroundModel[z]->ptr<Vec2f>( i )[j][1] );
-
-            //continue;
-            if( ( *currentC ) > 0 )  //The current template is active
+            // If there is a match with a current background template
+            if( !backgFlag && abs( currentPixelValue - currentB ) < currentEpslonValue )
             {
-              // If there is a match with a current background template
-              if( abs( currentPixelValue - ( *currentB ) ) < currentEpslonValue && !backgFlag )
-              {
-                // The correspondence pixel in the  BF mask is set as background ( 0 value)
-                pMask[j] = 0;
-                if( ( *currentC < L0 && z == 0 ) || ( *currentC < L1 && z == 1 ) || ( z > 1 ) )
-                {
-                  *currentC += 1;  // increment the efficacy of this template
-                }
-
-                *currentB = ( ( 1 - alpha ) * ( *currentB ) ) + ( alpha * currentPixelValue );  // Update the template value
-                backgFlag = true;
-              }
-              else
+              // The correspondence pixel in the  BF mask is set as background ( 0 value)
+              pMask[j] = 0;
+              if( ( currentC < L0 && z == 0 ) || ( currentC < L1 && z == 1 ) || ( z > 1 ) )
               {
-                *currentC -= 1;  // decrement the efficacy of this template
+                currentC += 1;  // increment the efficacy of this template
               }
 
+              currentB = ( ( 1 - alpha ) * currentB ) + ( alpha * currentPixelValue );  // Update the template value
+              backgFlag = true;
             }
-
-          }  // end "for" cicle of template vector
-
-        }
-        else
-        {
-          pMask[j] = 1;  //if the model of the current pixel is not yet initialized, we mark the pixels as foreground
-        }
-      }
-      else
-      {
-        pMask[j] = 0;
+            else
+            {
+              currentC -= 1;  // decrement the efficacy of this template
+            }
+          }
+        }  // end "for" cicle of template vector
       }
-
     }
-  }  // end "for" cicle of all image's pixels
+  });
 
   return true;
 }
@@ -408,13 +394,6 @@ bool MotionSaliencyBinWangApr2014::templateReplacement( const Mat& finalBFMask,
     neighborhoodCheck = true;
   }
 
-  int roiSize = 3;  // FIXED ROI SIZE, not change until you first appropriately adjust the following controls in the EVALUATION section!
-  int countNonZeroElements = 0;
-  std::vector<Mat> mv;
-  Mat replicateCurrentBAMat( roiSize, roiSize, CV_8U );
-  Mat backgroundModelROI( roiSize, roiSize, CV_32F );
-  Mat diffResult( roiSize, roiSize, CV_8U );
-
 // Scan all pixels of finalBFMask and all pixels of others models (the dimension are the same)
   const uchar* finalBFMaskP;
   Vec2b* pbgP;
@@ -455,76 +434,31 @@ bool MotionSaliencyBinWangApr2014::templateReplacement( const Mat& finalBFMask,
         {
           if( neighborhoodCheck )
           {
-            // replicate currentBA value
-            replicateCurrentBAMat.setTo( pbgP[j][0] );
+            const uchar currentBA = pbgP[j][0];
+            const int epslonInt = cvFloor( epslonP[j] );
+            const int y0 = std::max( i - 1, 0 ), y1 = std::min( i + 1, finalBFMask.rows - 1 );
+            const int x0 = std::max( j - 1, 0 ), x1 = std::min( j + 1, finalBFMask.cols - 1 );
 
             for ( size_t z = 0; z < backgroundModel.size(); z++ )
             {
-              // Neighborhood of current pixel in the current background model template.
-              // The ROI is centered in the pixel coordinates
-
-              if( i > 0 && j > 0 && i < ( backgroundModel[z]->rows - 1 ) && j < ( backgroundModel[z]->cols - 1 ) )
-              {
-                split( *backgroundModel[z], mv );
-                backgroundModelROI = mv[0]( Rect( j - (int) floor((float) roiSize / 2 ), i - (int) floor((float) roiSize / 2 ), roiSize, roiSize ) );
-              }
-              else if( i == 0 && j == 0 )  // upper leftt
-              {
-                split( *backgroundModel[z], mv );
-                backgroundModelROI = mv[0]( Rect( j, i, (int) ceil((float) roiSize / 2 ), (int) ceil((float) roiSize / 2 ) ) );
-              }
-              else if( j == 0 && i > 0 && i < ( backgroundModel[z]->rows - 1 ) )  // middle left
-              {
-                split( *backgroundModel[z], mv );
-                backgroundModelROI = mv[0]( Rect( j, i - (int) floor((float) roiSize / 2 ), (int) ceil((float) roiSize / 2 ), roiSize ) );
-              }
-              else if( i == ( backgroundModel[z]->rows - 1 ) && j == 0 )  //down left
-              {
-                split( *backgroundModel[z], mv );
-                backgroundModelROI = mv[0]( Rect( j, i - (int) floor((float) roiSize / 2 ), (int) ceil((float) roiSize / 2 ), (int) ceil((float) roiSize / 2 ) ) );
-              }
-              else if( i == 0 && j > 0 && j < ( backgroundModel[z]->cols - 1 ) )  // upper - middle
-              {
-                split( *backgroundModel[z], mv );
-                backgroundModelROI = mv[0]( Rect( ( j - (int) floor((float) roiSize / 2 ) ), i, roiSize, (int) ceil((float) roiSize / 2 ) ) );
-              }
-              else if( i == ( backgroundModel[z]->rows - 1 ) && j > 0 && j < ( backgroundModel[z]->cols - 1 ) )  //down middle
-              {
-                split( *backgroundModel[z], mv );
-                backgroundModelROI = mv[0](
-                    Rect( j - (int) floor((float) roiSize / 2 ), i - (int) floor((float) roiSize / 2 ), roiSize, (int) ceil((float) roiSize / 2 ) ) );
-              }
-              else if( i == 0 && j == ( backgroundModel[z]->cols - 1 ) )  // upper right
-              {
-                split( *backgroundModel[z], mv );
-                backgroundModelROI = mv[0]( Rect( j - (int) floor((float) roiSize / 2 ), i, (int) ceil((float) roiSize / 2 ), (int) ceil((float) roiSize / 2 ) ) );
-              }
-              else if( j == ( backgroundModel[z]->cols - 1 ) && i > 0 && i < ( backgroundModel[z]->rows - 1 ) )  // middle - right
-              {
-                split( *backgroundModel[z], mv );
-                backgroundModelROI = mv[0](
-                    Rect( j - (int) floor((float) roiSize / 2 ), i - (int) floor((float) roiSize / 2 ), (int) ceil((float) roiSize / 2 ), roiSize ) );
-              }
-              else if( i == ( backgroundModel[z]->rows - 1 ) && j == ( backgroundModel[z]->cols - 1 ) )  // down right
+              /* Check if the value of current pixel BA in potentialBackground model is already contained in at least one of its
+               * neighbors' background model. The 3x3 neighborhood is centered in the pixel coordinates and clipped at the borders
+               */
+              bool found = false;
+              for ( int y = y0; y <= y1 && !found; y++ )
               {
-                split( *backgroundModel[z], mv );
-                backgroundModelROI = mv[0](
-                    Rect( j - (int) floor((float) roiSize / 2 ), i - (int) floor((float) roiSize / 2 ), (int) ceil((float) roiSize / 2 ), (int) ceil((float) roiSize / 2 ) ) );
+                const Vec2f* pB = backgroundModel[z]->ptr<Vec2f>( y );
+                for ( int x = x0; x <= x1; x++ )
+                {
+                  if( abs( (int) saturate_cast<uchar>( pB[x][0] ) - (int) currentBA ) <= epslonInt )
+                  {
+                    found = true;
+                    break;
+                  }
+                }
               }
 
-              /* Check if the value of current pixel BA in potentialBackground model is already contained in at least one of its neighbors'
-               * background model
-               */
-              resize( replicateCurrentBAMat, replicateCurrentBAMat, Size( backgroundModelROI.cols, backgroundModelROI.rows ), 0, 0, INTER_LINEAR_EXACT );
-              resize( diffResult, diffResult, Size( backgroundModelROI.cols, backgroundModelROI.rows ), 0, 0, INTER_LINEAR_EXACT );
-
-              backgroundModelROI.convertTo( backgroundModelROI, CV_8U );
-
-              absdiff( replicateCurrentBAMat, backgroundModelROI, diffResult );
-              threshold( diffResult, diffResult, epslonP[j], 255, THRESH_BINARY_INV );
-              countNonZeroElements = countNonZero( diffResult );
-
-              if( countNonZeroElements > 0 )
+              if( found )
               {
                 /////////////////// REPLACEMENT of backgroundModel template ///////////////////
                 //replace TA with current TK
@@ -601,22 +535,25 @@ bool MotionSaliencyBinWangApr2014::activityControl( const Mat& current_noisePixe
 
 bool MotionSaliencyBinWangApr2014::decisionThresholdAdaptation()
 {
-
-  for ( int i = 0; i < activityPixelsValue.rows; i++ )
+  parallel_for_( Range( 0, activityPixelsValue.rows ), [&]( const Range& range )
   {
-    for ( int j = 0; j < activityPixelsValue.cols; j++ )
+    for ( int i = range.start; i < range.end; i++ )
     {
-      if( activityPixelsValue.at<uchar>( i, j ) > Binc && ( epslonPixelsValue.at<float>( i, j ) + deltaINC ) < epslonMAX )
+      const uchar* pActivity = activityPixelsValue.ptr<uchar>( i );
+      float* pEpslon = epslonPixelsValue.ptr<float>( i );
+      for ( int j = 0; j < activityPixelsValue.cols; j++ )
       {
-
-        epslonPixelsValue.at<float>( i, j ) += deltaINC;
-      }
-      else if( activityPixelsValue.at<uchar>( i, j ) < Bdec && ( epslonPixelsValue.at<float>( i, j ) - deltaDEC ) > epslonMIN )
-      {
-        epslonPixelsValue.at<float>( i, j ) -= deltaDEC;
+        if( pActivity[j] > Binc && ( pEpslon[j] + deltaINC ) < epslonMAX )
+        {
+          pEpslon[j] += deltaINC;
+        }
+        else if( pActivity[j] < Bdec && ( pEpslon[j] - deltaDEC ) > epslonMIN )
+        {
+          pEpslon[j] -= deltaDEC;
+        }
       }
     }
-  }
+  });
 
   return true;
 }
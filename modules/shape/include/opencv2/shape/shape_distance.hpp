@@ -180,6 +180,33 @@ public:
      */
     CV_WRAP virtual void setTransformAlgorithm(Ptr<ShapeTransformer> transformer) = 0;
     CV_WRAP virtual Ptr<ShapeTransformer> getTransformAlgorithm() const = 0;
+
+    /** @brief Set the tolerance of the assignment between the sample points of the two shapes.
+
+    With 0 (the default), the points are matched with the exact Jonker-Volgenant method. With a positive
+    tolerance, they are matched with an auction algorithm, stopped once the mean matching cost is
+    guaranteed to be within tolerance of the optimal one, which is much faster for large contours.
+
+    @param tolerance Tolerance of the mean matching cost.
+     */
+    CV_WRAP virtual void setAssignmentTolerance(float tolerance) = 0;
+    CV_WRAP virtual float getAssignmentTolerance() const = 0;
+
+    /** @brief Compute the shape distances between every pair of shapes of two sets.
+
+    The pairs are processed in parallel, and the parts of the shape context descriptors that only depend
+    on one contour are computed once for all its pairs. The image appearance cost is not supported, its
+    weight must be 0. Transformers other than ThinPlateSplineShapeTransformer and AffineTransformer are
+    shared by all the pairs, which are then processed sequentially.
+
+    @param contours1 Contours of the first shapes.
+    @param contours2 Contours of the second shapes.
+    @param distances Output CV_32F matrix of contours1.size() rows and contours2.size() columns, where
+    distances(i, j) is the shape distance between contours1[i] and contours2[j], as computed by
+    computeDistance.
+     */
+    CV_WRAP virtual void computeDistances(InputArrayOfArrays contours1, InputArrayOfArrays contours2,
+                                          OutputArray distances) = 0;
 };
 
 /* Complete constructor */
@@ -0,0 +1,79 @@
+// This file is part of OpenCV project.
+// It is subject to the license terms in the LICENSE file found in the top-level directory
+// of this distribution and at http://opencv.org/license.html.
+#include "perf_precomp.hpp"
+
+namespace opencv_test { namespace {
+
+// random star-shaped contour of numberPoints points
+static vector<Point2f> generateContour(RNG& rng, int numberPoints)
+{
+    const int numberLobes = rng.uniform(3, 8);
+    const float phase = rng.uniform(0.f, (float)CV_PI), depth = rng.uniform(0.1f, 0.4f);
+    vector<Point2f> contour;
+    for (int i = 0; i < numberPoints; i++)
+    {
+        float angle = (float)(2 * CV_PI * i / numberPoints);
+        float radius = 100.f * (1.f + depth * std::sin(numberLobes * angle + phase)) + rng.uniform(-2.f, 2.f);
+        contour.push_back(Point2f(200.f + radius * std::cos(angle), 200.f + radius * std::sin(angle)));
+    }
+    return contour;
+}
+
+typedef tuple<int, float> SCDParams;
+typedef perf::TestBaseWithParam<SCDParams> shape_context;
+
+PERF_TEST_P(shape_context, computeDistance, testing::Combine(testing::Values(100, 300), testing::Values(0.f, 0.001f)))
+{
+    const int numberPoints = get<0>(GetParam());
+    const float tolerance = get<1>(GetParam());
+
+    RNG rng(1234);
+    vector<Point2f> contour1 = generateContour(rng, numberPoints);
+    vector<Point2f> contour2 = generateContour(rng, numberPoints);
+
+    Ptr<ShapeContextDistanceExtractor> extractor = createShapeContextDistanceExtractor();
+    extractor->setAssignmentTolerance(tolerance);
+
+    TEST_CYCLE() extractor->computeDistance(contour1, contour2);
+
+    SANITY_CHECK_NOTHING();
+}
+
+typedef perf::TestBaseWithParam<int> shape_context_batch;
+
+PERF_TEST_P(shape_context_batch, computeDistances, testing::Values(10, 30))
+{
+    const int numberContours = GetParam();
+
+    RNG rng(1234);
+    vector<vector<Point2f> > contours;
+    for (int i = 0; i < numberContours; i++)
+        contours.push_back(generateContour(rng, 100));
+
+    Ptr<ShapeContextDistanceExtractor> extractor = createShapeContextDistanceExtractor();
+
+    Mat distances;
+    TEST_CYCLE() extractor->computeDistances(contours, contours, distances);
+
+    SANITY_CHECK_NOTHING();
+}
+
+typedef perf::TestBaseWithParam<int> hausdorff;
+
+PERF_TEST_P(hausdorff, computeDistance, testing::Values(100, 300))
+{
+    const int numberPoints = GetParam();
+
+    RNG rng(1234);
+    vector<Point2f> contour1 = generateContour(rng, numberPoints);
+    vector<Point2f> contour2 = generateContour(rng, numberPoints);
+
+    Ptr<HausdorffDistanceExtractor> extractor = createHausdorffDistanceExtractor();
+
+    TEST_CYCLE() extractor->computeDistance(contour1, contour2);
+
+    SANITY_CHECK_NOTHING();
+}
+
+}} // namespace
@@ -48,10 +48,24 @@
 #include "precomp.hpp"
 #include "opencv2/core.hpp"
 #include "scd_def.hpp"
+#include <algorithm>
 #include <limits>
 
 namespace cv
 {
+// Sample points of a contour, with the parts of its shape context descriptors that do not depend on the other shape
+struct SCDContour
+{
+    // 1xN CV_32FC2 points
+    Mat points;
+    // distances and angles between the points
+    Mat disMatrix;
+    Mat angleMatrix;
+    // descriptors of the first matching iteration, only computed for the first shape of a pair
+    Mat descriptors;
+    float meanDistance;
+};
+
 class ShapeContextDistanceExtractorImpl : public ShapeContextDistanceExtractor
 {
 public:
@@ -73,6 +87,7 @@ public:
         sigma=10.0f;
         name_ = "ShapeDistanceExtractor.SCD";
         costFlag = 0;
+        assignmentTolerance = 0;
     }
 
     /* Destructor */
@@ -83,6 +98,8 @@ public:
     //! the main operator
     virtual float computeDistance(InputArray contour1, InputArray contour2) CV_OVERRIDE;
 
+    virtual void computeDistances(InputArrayOfArrays contours1, InputArrayOfArrays contours2, OutputArray distances) CV_OVERRIDE;
+
     //! Setters/Getters
     virtual void setAngularBins(int _nAngularBins) CV_OVERRIDE { CV_Assert(_nAngularBins>0); nAngularBins=_nAngularBins; }
     virtual int getAngularBins() const CV_OVERRIDE { return nAngularBins; }
@@ -135,6 +152,9 @@ public:
     virtual void setTransformAlgorithm(Ptr<ShapeTransformer> _transformer) CV_OVERRIDE {transformer=_transformer;}
     virtual Ptr<ShapeTransformer> getTransformAlgorithm() const CV_OVERRIDE {return transformer;}
 
+    virtual void setAssignmentTolerance(float _assignmentTolerance) CV_OVERRIDE {CV_Assert(_assignmentTolerance>=0); assignmentTolerance=_assignmentTolerance;}
+    virtual float getAssignmentTolerance() const CV_OVERRIDE {return assignmentTolerance;}
+
     //! write/read
     virtual void write(FileStorage& fs) const CV_OVERRIDE
     {
@@ -150,7 +170,8 @@ public:
            << "iaWei" << imageAppearanceWeight
            << "costF" << costFlag
            << "rotIn" << rotationInvariant
-           << "sigma" << sigma;
+           << "sigma" << sigma
+           << "asTol" << assignmentTolerance;
     }
 
     virtual void read(const FileNode& fn) CV_OVERRIDE
@@ -164,6 +185,7 @@ public:
         imageAppearanceWeight = (float)fn["iaWei"];
         costFlag = (int)fn["costF"];
         sigma = (float)fn["sigma"];
+        assignmentTolerance = (float)fn["asTol"];
     }
 
 protected:
@@ -182,99 +204,153 @@ protected:
     float imageAppearanceWeight;
     float shapeContextWeight;
     float sigma;
+    float assignmentTolerance;
     String name_;
+
+    // converts the contour to 1xN CV_32FC2 points
+    void convertContour(InputArray contour, SCDContour& scdContour) const;
+    // computes the distance, angle and, for the first shape of a pair, descriptors matrices
+    void prepareContour(SCDContour& scdContour, bool first) const;
+    // iterative matching of the contours, returns the shape context cost and accumulates the bending energy
+    float matchContours(const SCDContour& contour1, const SCDContour& contour2, const Ptr<ShapeTransformer>& transform,
+                        float& bEnergy, Mat* warpedImage) const;
 };
 
-float ShapeContextDistanceExtractorImpl::computeDistance(InputArray contour1, InputArray contour2)
+// a new transformer of the same kind, empty if its kind is unknown
+static Ptr<ShapeTransformer> cloneTransformer(const Ptr<ShapeTransformer>& transformer)
 {
-    CV_INSTRUMENT_REGION();
-
-    // Checking //
-    Mat sset1=contour1.getMat(), sset2=contour2.getMat(), set1, set2;
-    if (set1.type() != CV_32F)
-        sset1.convertTo(set1, CV_32F);
-    else
-        sset1.copyTo(set1);
+    Ptr<ThinPlateSplineShapeTransformer> tps = transformer.dynamicCast<ThinPlateSplineShapeTransformer>();
+    if (!tps.empty())
+        return createThinPlateSplineShapeTransformer(tps->getRegularizationParameter());
+    Ptr<AffineTransformer> affine = transformer.dynamicCast<AffineTransformer>();
+    if (!affine.empty())
+        return createAffineTransformer(affine->getFullAffine());
+    return Ptr<ShapeTransformer>();
+}
 
-    if (set2.type() != CV_32F)
-        sset2.convertTo(set2, CV_32F);
-    else
-        sset2.copyTo(set2);
+void ShapeContextDistanceExtractorImpl::convertContour(InputArray contour, SCDContour& scdContour) const
+{
+    Mat sset=contour.getMat(), set;
+    sset.convertTo(set, CV_32F);
 
-    CV_Assert((set1.channels()==2) && (set1.cols>0));
-    CV_Assert((set2.channels()==2) && (set2.cols>0));
+    CV_Assert((set.channels()==2) && (set.cols>0));
 
     // Force vectors column-based
-    if (set1.dims > 1)
-        set1 = set1.reshape(2, 1);
-    if (set2.dims > 1)
-        set2 = set2.reshape(2, 1);
+    if (set.dims > 1)
+        set = set.reshape(2, 1);
+    scdContour.points = set;
+}
 
-    if (imageAppearanceWeight!=0)
+void ShapeContextDistanceExtractorImpl::prepareContour(SCDContour& scdContour, bool first) const
+{
+    SCD sce(nAngularBins, nRadialBins, innerRadius, outerRadius, rotationInvariant);
+    sce.buildDistanceMatrix(scdContour.points, scdContour.disMatrix);
+    sce.buildAngleMatrix(scdContour.points, scdContour.angleMatrix);
+    if (first)
     {
-        CV_Assert((!image1.empty()) && (!image2.empty()));
+        sce.computeDescriptors(scdContour.disMatrix, scdContour.angleMatrix, scdContour.descriptors);
+        scdContour.meanDistance = sce.getMeanDistance();
     }
+}
 
+float ShapeContextDistanceExtractorImpl::matchContours(const SCDContour& contour1, const SCDContour& contour2,
+                                                       const Ptr<ShapeTransformer>& transform, float& bEnergy,
+                                                       Mat* warpedImage) const
+{
     // Initializing Extractor, Descriptor structures and Matcher //
     SCD set1SCE(nAngularBins, nRadialBins, innerRadius, outerRadius, rotationInvariant);
-    Mat set1SCD;
+    Mat set1 = contour1.points.clone(), set1SCD;
     SCD set2SCE(nAngularBins, nRadialBins, innerRadius, outerRadius, rotationInvariant);
     Mat set2SCD;
     SCDMatcher matcher;
     std::vector<DMatch> matches;
-
-    // Distance components (The output is a linear combination of these 3) //
-    float sDistance=0, bEnergy=0, iAppearance=0;
-    float beta;
+    float beta, meanDistance=0;
 
     // Initializing some variables //
     std::vector<int> inliers1, inliers2;
 
-    Ptr<ThinPlateSplineShapeTransformer> transDown = transformer.dynamicCast<ThinPlateSplineShapeTransformer>();
+    Ptr<ThinPlateSplineShapeTransformer> transDown = transform.dynamicCast<ThinPlateSplineShapeTransformer>();
 
-    Mat warpedImage;
-    int ii, jj, pt;
-
-    for (ii=0; ii<iterations; ii++)
+    for (int ii=0; ii<iterations; ii++)
     {
-        // Extract SCD descriptor in the set1 //
-        set1SCE.extractSCD(set1, set1SCD, inliers1);
+        // Extract SCD descriptor in the set1, the ones of the first iteration are precomputed //
+        if (ii==0)
+        {
+            set1SCD = contour1.descriptors;
+            meanDistance = contour1.meanDistance;
+        }
+        else
+        {
+            set1SCE.extractSCD(set1, set1SCD, inliers1);
+            meanDistance = set1SCE.getMeanDistance();
+        }
 
-        // Extract SCD descriptor of the set2 (TARGET) //
-        set2SCE.extractSCD(set2, set2SCD, inliers2, set1SCE.getMeanDistance());
+        // Extract SCD descriptor of the set2 (TARGET), which does not move //
+        set2SCE.computeDescriptors(contour2.disMatrix, contour2.angleMatrix, set2SCD, inliers2, meanDistance);
 
         // regularization parameter with annealing rate annRate //
-        beta=set1SCE.getMeanDistance();
+        beta=meanDistance;
         beta *= beta;
 
         // match //
-        matcher.matchDescriptors(set1SCD, set2SCD, matches, comparer, inliers1, inliers2);
+        matcher.matchDescriptors(set1SCD, set2SCD, matches, comparer, inliers1, inliers2, assignmentTolerance);
 
         // apply TPS transform //
         if ( !transDown.empty() )
             transDown->setRegularizationParameter(beta);
-        transformer->estimateTransformation(set1, set2, matches);
-        bEnergy += transformer->applyTransformation(set1, set1);
+        transform->estimateTransformation(set1, contour2.points, matches);
+        bEnergy += transform->applyTransformation(set1, set1);
 
         // Image appearance //
-        if (imageAppearanceWeight!=0)
+        if (warpedImage)
         {
             // Have to accumulate the transformation along all the iterations
             if (ii==0)
             {
                 if ( !transDown.empty() )
                 {
-                    image2.copyTo(warpedImage);
+                    image2.copyTo(*warpedImage);
                 }
                 else
                 {
-                    image1.copyTo(warpedImage);
+                    image1.copyTo(*warpedImage);
                 }
             }
-            transformer->warpImage(warpedImage, warpedImage);
+            transform->warpImage(*warpedImage, *warpedImage);
         }
     }
 
+    return matcher.getMatchingCost();
+}
+
+float ShapeContextDistanceExtractorImpl::computeDistance(InputArray contour1, InputArray contour2)
+{
+    CV_INSTRUMENT_REGION();
+
+    // Checking //
+    Mat sset1=contour1.getMat();
+    SCDContour set1, set2;
+    convertContour(contour1, set1);
+    convertContour(contour2, set2);
+
+    if (imageAppearanceWeight!=0)
+    {
+        CV_Assert((!image1.empty()) && (!image2.empty()));
+    }
+
+    prepareContour(set1, true);
+    prepareContour(set2, false);
+
+    // Distance components (The output is a linear combination of these 3) //
+    float sDistance=0, bEnergy=0, iAppearance=0;
+
+    Ptr<ThinPlateSplineShapeTransformer> transDown = transformer.dynamicCast<ThinPlateSplineShapeTransformer>();
+
+    Mat warpedImage;
+    int ii, jj, pt;
+
+    sDistance = matchContours(set1, set2, transformer, bEnergy, imageAppearanceWeight!=0 ? &warpedImage : 0);
+
     Mat gaussWindow, diffIm;
     if (imageAppearanceWeight!=0)
     {
@@ -317,11 +393,58 @@ float ShapeContextDistanceExtractorImpl::computeDistance(InputArray contour1, In
         }
         iAppearance = float(cv::sum(appIm)[0]/sset1.cols);
     }
-    sDistance = matcher.getMatchingCost();
 
     return (sDistance*shapeContextWeight+bEnergy*bendingEnergyWeight+iAppearance*imageAppearanceWeight);
 }
 
+void ShapeContextDistanceExtractorImpl::computeDistances(InputArrayOfArrays contours1, InputArrayOfArrays contours2,
+                                                         OutputArray _distances)
+{
+    CV_INSTRUMENT_REGION();
+
+    CV_Assert(imageAppearanceWeight==0);
+
+    const int n1 = (int)contours1.total(), n2 = (int)contours2.total();
+    std::vector<SCDContour> set1(n1), set2(n2);
+    for (int i=0; i<n1; i++)
+        convertContour(contours1.getMat(i), set1[i]);
+    for (int i=0; i<n2; i++)
+        convertContour(contours2.getMat(i), set2[i]);
+
+    // the descriptors matrices of each contour are computed once, and shared by all its pairs
+    parallel_for_(Range(0, n1+n2), [&](const Range& range)
+    {
+        for (int i=range.start; i<range.end; i++)
+        {
+            if (i<n1)
+                prepareContour(set1[i], true);
+            else
+                prepareContour(set2[i-n1], false);
+        }
+    });
+
+    _distances.create(n1, n2, CV_32F);
+    Mat distances = _distances.getMat();
+
+    // the transformation is estimated in the transformer, so each thread needs its own one
+    const bool parallel = !cloneTransformer(transformer).empty();
+    auto computePairs = [&](const Range& range)
+    {
+        Ptr<ShapeTransformer> pairTransformer = parallel ? cloneTransformer(transformer) : transformer;
+        for (int k=range.start; k<range.end; k++)
+        {
+            int i = k/n2, j = k%n2;
+            float bEnergy=0;
+            float sDistance = matchContours(set1[i], set2[j], pairTransformer, bEnergy, 0);
+            distances.at<float>(i, j) = sDistance*shapeContextWeight+bEnergy*bendingEnergyWeight;
+        }
+    };
+    if (parallel)
+        parallel_for_(Range(0, n1*n2), computePairs);
+    else
+        computePairs(Range(0, n1*n2));
+}
+
 Ptr <ShapeContextDistanceExtractor> createShapeContextDistanceExtractor(int nAngularBins, int nRadialBins, float innerRadius, float outerRadius, int iterations,
                                                                         const Ptr<HistogramCostExtractor> &comparer, const Ptr<ShapeTransformer> &transformer)
 {
@@ -332,22 +455,32 @@ Ptr <ShapeContextDistanceExtractor> createShapeContextDistanceExtractor(int nAng
 //! SCD
 void SCD::extractSCD(cv::Mat &contour, cv::Mat &descriptors, const std::vector<int> &queryInliers, const float _meanDistance)
 {
-    cv::Mat contourMat = contour;
-    cv::Mat disMatrix = cv::Mat::zeros(contourMat.cols, contourMat.cols, CV_32F);
-    cv::Mat angleMatrix = cv::Mat::zeros(contourMat.cols, contourMat.cols, CV_32F);
+    cv::Mat disMatrix, angleMatrix;
+    buildDistanceMatrix(contour, disMatrix);
+    buildAngleMatrix(contour, angleMatrix);
+    computeDescriptors(disMatrix, angleMatrix, descriptors, queryInliers, _meanDistance);
+}
+
+void SCD::computeDescriptors(const cv::Mat &_disMatrix, const cv::Mat &angleMatrix, cv::Mat &descriptors,
+                             const std::vector<int> &queryInliers, const float _meanDistance)
+{
+    const int nPoints = _disMatrix.rows;
+    cv::Mat disMatrix;
 
     std::vector<double> logspaces, angspaces;
     logarithmicSpaces(logspaces);
     angularSpaces(angspaces);
-    buildNormalizedDistanceMatrix(contourMat, disMatrix, queryInliers, _meanDistance);
-    buildAngleMatrix(contourMat, angleMatrix);
+    normalizeDistanceMatrix(_disMatrix, disMatrix, queryInliers, _meanDistance);
 
     // Now, build the descriptor matrix (each row is a point) //
-    descriptors = cv::Mat::zeros(contourMat.cols, descriptorSize(), CV_32F);
+    descriptors = cv::Mat::zeros(nPoints, descriptorSize(), CV_32F);
 
-    for (int ptidx=0; ptidx<contourMat.cols; ptidx++)
+    for (int ptidx=0; ptidx<nPoints; ptidx++)
     {
-        for (int cmp=0; cmp<contourMat.cols; cmp++)
+        const float* dis = disMatrix.ptr<float>(ptidx);
+        const float* angle = angleMatrix.ptr<float>(ptidx);
+        float* descriptor = descriptors.ptr<float>(ptidx);
+        for (int cmp=0; cmp<nPoints; cmp++)
         {
             if (ptidx==cmp) continue;
             if ((int)queryInliers.size()>0)
@@ -358,7 +491,7 @@ void SCD::extractSCD(cv::Mat &contour, cv::Mat &descriptors, const std::vector<i
             int angidx=-1, radidx=-1;
             for (int i=0; i<nRadialBins; i++)
             {
-                if (disMatrix.at<float>(ptidx, cmp)<logspaces[i])
+                if (dis[cmp]<logspaces[i])
                 {
                     radidx=i;
                     break;
@@ -366,7 +499,7 @@ void SCD::extractSCD(cv::Mat &contour, cv::Mat &descriptors, const std::vector<i
             }
             for (int i=0; i<nAngularBins; i++)
             {
-                if (angleMatrix.at<float>(ptidx, cmp)<angspaces[i])
+                if (angle[cmp]<angspaces[i])
                 {
                     angidx=i;
                     break;
@@ -375,7 +508,7 @@ void SCD::extractSCD(cv::Mat &contour, cv::Mat &descriptors, const std::vector<i
             if (angidx!=-1 && radidx!=-1)
             {
                 int idx = angidx+radidx*nAngularBins;
-                descriptors.at<float>(ptidx, idx)++;
+                descriptor[idx]++;
             }
         }
     }
@@ -408,78 +541,97 @@ void SCD::angularSpaces(std::vector<double> &vecSpaces) const
     }
 }
 
-void SCD::buildNormalizedDistanceMatrix(cv::Mat &contour, cv::Mat &disMatrix, const std::vector<int> &queryInliers, const float _meanDistance)
+void SCD::buildDistanceMatrix(const cv::Mat &contour, cv::Mat &disMatrix) const
 {
-    cv::Mat contourMat = contour;
-    cv::Mat mask(disMatrix.rows, disMatrix.cols, CV_8U);
+    const int nPoints = contour.cols;
+    const cv::Point2f* points = contour.ptr<cv::Point2f>(0);
+    disMatrix.create(nPoints, nPoints, CV_32F);
 
-    for (int i=0; i<contourMat.cols; i++)
+    for (int i=0; i<nPoints; i++)
     {
-      for (int j=0; j<contourMat.cols; j++)
-      {
-          disMatrix.at<float>(i,j) = (float)norm( cv::Mat(contourMat.at<cv::Point2f>(0,i)-contourMat.at<cv::Point2f>(0,j)), cv::NORM_L2 );
-          if (_meanDistance<0)
-          {
-              if (queryInliers.size()>0)
-              {
-                  mask.at<char>(i,j)=char(queryInliers[j] && queryInliers[i]);
-              }
-              else
-              {
-                  mask.at<char>(i,j)=1;
-              }
-          }
-      }
+        float* dis = disMatrix.ptr<float>(i);
+        for (int j=0; j<nPoints; j++)
+        {
+            cv::Point2f dif = points[i] - points[j];
+            dis[j] = (float)std::sqrt((double)dif.x*dif.x + (double)dif.y*dif.y);
+        }
     }
+}
 
+void SCD::normalizeDistanceMatrix(const cv::Mat &disMatrix, cv::Mat &normalizedDisMatrix,
+                                  const std::vector<int> &queryInliers, const float _meanDistance)
+{
     if (_meanDistance<0)
     {
-      meanDistance=(float)mean(disMatrix, mask)[0];
+        cv::Mat mask(disMatrix.rows, disMatrix.cols, CV_8U);
+        for (int i=0; i<disMatrix.rows; i++)
+        {
+            for (int j=0; j<disMatrix.cols; j++)
+            {
+                if (queryInliers.size()>0)
+                {
+                    mask.at<char>(i,j)=char(queryInliers[j] && queryInliers[i]);
+                }
+                else
+                {
+                    mask.at<char>(i,j)=1;
+                }
+            }
+        }
+        meanDistance=(float)mean(disMatrix, mask)[0];
     }
     else
     {
-      meanDistance=_meanDistance;
+        meanDistance=_meanDistance;
     }
-    disMatrix/=meanDistance+FLT_EPSILON;
+    disMatrix.copyTo(normalizedDisMatrix);
+    normalizedDisMatrix/=meanDistance+FLT_EPSILON;
 }
 
-void SCD::buildAngleMatrix(cv::Mat &contour, cv::Mat &angleMatrix) const
+void SCD::buildAngleMatrix(const cv::Mat &contour, cv::Mat &angleMatrix) const
 {
-    cv::Mat contourMat = contour;
+    const int nPoints = contour.cols;
+    const cv::Point2f* points = contour.ptr<cv::Point2f>(0);
+    angleMatrix.create(nPoints, nPoints, CV_32F);
 
     // if descriptor is rotationInvariant compute massCenter //
     cv::Point2f massCenter(0,0);
     if (rotationInvariant)
     {
-        for (int i=0; i<contourMat.cols; i++)
+        for (int i=0; i<nPoints; i++)
         {
-            massCenter+=contourMat.at<cv::Point2f>(0,i);
+            massCenter+=points[i];
         }
-        massCenter.x=massCenter.x/(float)contourMat.cols;
-        massCenter.y=massCenter.y/(float)contourMat.cols;
+        massCenter.x=massCenter.x/(float)nPoints;
+        massCenter.y=massCenter.y/(float)nPoints;
     }
 
 
-    for (int i=0; i<contourMat.cols; i++)
+    for (int i=0; i<nPoints; i++)
     {
-        for (int j=0; j<contourMat.cols; j++)
+        float* angle = angleMatrix.ptr<float>(i);
+        float refAngle = 0;
+        if (rotationInvariant)
+        {
+            cv::Point2f refPt = points[i] - massCenter;
+            refAngle = atan2(refPt.y, refPt.x);
+        }
+        for (int j=0; j<nPoints; j++)
         {
             if (i==j)
             {
-                angleMatrix.at<float>(i,j)=0.0;
+                angle[j]=0.0;
             }
             else
             {
-                cv::Point2f dif = contourMat.at<cv::Point2f>(0,i) - contourMat.at<cv::Point2f>(0,j);
-                angleMatrix.at<float>(i,j) = std::atan2(dif.y, dif.x);
+                cv::Point2f dif = points[i] - points[j];
+                angle[j] = std::atan2(dif.y, dif.x);
 
                 if (rotationInvariant)
                 {
-                    cv::Point2f refPt = contourMat.at<cv::Point2f>(0,i) - massCenter;
-                    float refAngle = atan2(refPt.y, refPt.x);
-                    angleMatrix.at<float>(i,j) -= refAngle;
+                    angle[j] -= refAngle;
                 }
-                angleMatrix.at<float>(i,j) = float(fmod(double(angleMatrix.at<float>(i,j)+(double)FLT_EPSILON),2*CV_PI)+CV_PI);
+                angle[j] = float(fmod(double(angle[j]+(double)FLT_EPSILON),2*CV_PI)+CV_PI);
             }
         }
     }
@@ -487,7 +639,8 @@ void SCD::buildAngleMatrix(cv::Mat &contour, cv::Mat &angleMatrix) const
 
 //! SCDMatcher
 void SCDMatcher::matchDescriptors(cv::Mat &descriptors1, cv::Mat &descriptors2, std::vector<cv::DMatch> &matches,
-                                  cv::Ptr<cv::HistogramCostExtractor> &comparer, std::vector<int> &inliers1, std::vector<int> &inliers2)
+                                  const cv::Ptr<cv::HistogramCostExtractor> &comparer, std::vector<int> &inliers1,
+                                  std::vector<int> &inliers2, float tolerance)
 {
     matches.clear();
 
@@ -495,24 +648,28 @@ void SCDMatcher::matchDescriptors(cv::Mat &descriptors1, cv::Mat &descriptors2,
     cv::Mat costMat;
     buildCostMatrix(descriptors1, descriptors2, costMat, comparer);
 
-    // Solve the matching problem using the hungarian method //
-    hungarian(costMat, matches, inliers1, inliers2, descriptors1.rows, descriptors2.rows);
+    // Solve the matching problem using the hungarian method, or an auction if an approximate solution is enough //
+    std::vector<int> rowsol, colsol;
+    if (tolerance <= 0 || !auction(costMat, rowsol, colsol, tolerance))
+        hungarian(costMat, rowsol, colsol);
+    saveMatches(costMat, rowsol, colsol, matches, inliers1, inliers2, descriptors1.rows, descriptors2.rows);
 }
 
 void SCDMatcher::buildCostMatrix(const cv::Mat &descriptors1, const cv::Mat &descriptors2,
-                                 cv::Mat &costMatrix, cv::Ptr<cv::HistogramCostExtractor> &comparer) const
+                                 cv::Mat &costMatrix, const cv::Ptr<cv::HistogramCostExtractor> &comparer) const
 {
     CV_INSTRUMENT_REGION();
 
     comparer->buildCostMatrix(descriptors1, descriptors2, costMatrix);
 }
 
-void SCDMatcher::hungarian(cv::Mat &costMatrix, std::vector<cv::DMatch> &outMatches, std::vector<int> &inliers1,
-                           std::vector<int> &inliers2, int sizeScd1, int sizeScd2)
+void SCDMatcher::hungarian(const cv::Mat &costMatrix, std::vector<int> &rowsol, std::vector<int> &colsol) const
 {
     std::vector<int> free(costMatrix.rows, 0), collist(costMatrix.rows, 0);
-    std::vector<int> matches(costMatrix.rows, 0), colsol(costMatrix.rows), rowsol(costMatrix.rows);
+    std::vector<int> matches(costMatrix.rows, 0);
     std::vector<float> d(costMatrix.rows), pred(costMatrix.rows), v(costMatrix.rows);
+    colsol.resize(costMatrix.rows);
+    rowsol.resize(costMatrix.rows);
 
     const float LOWV = 1e-10f;
     bool unassignedfound;
@@ -740,7 +897,88 @@ void SCDMatcher::hungarian(cv::Mat &costMatrix, std::vector<cv::DMatch> &outMatc
             rowsol[i] = j1;
         }while (i != freerow);
     }
+}
+
+/* Auction algorithm with epsilon scaling (Bertsekas). Rows bid for the columns, each bid raising the price of
+ * the column by the difference between the best and the second best reduced costs of the row, plus epsilon.
+ * An assignment where every row gets its best column up to epsilon costs at most nrows*epsilon more than the
+ * optimal one, so the phases stop once epsilon reaches the tolerance of the mean cost.
+ * Epsilon is kept above the float resolution of the costs and the number of bids is capped, so that the caller
+ * can fall back to the exact solver when the prices stop moving.
+ */
+bool SCDMatcher::auction(const cv::Mat &costMatrix, std::vector<int> &rowsol, std::vector<int> &colsol, float tolerance) const
+{
+    const int n = costMatrix.rows;
+    std::vector<float> prices(n, 0.f);
+    std::vector<int> unassigned;
+    unassigned.reserve(n);
+    rowsol.resize(n);
+    colsol.resize(n);
+
+    double minCost, maxCost;
+    minMaxIdx(costMatrix, &minCost, &maxCost);
+    tolerance = std::max(tolerance, float(1e-6*(maxCost - minCost)));
+    float epsilon = std::max(float(maxCost - minCost)/4, tolerance);
+    if (epsilon <= 0)
+        return false;
+    // every bid costs O(n), keep the worst case in the range of the hungarian method
+    int64 bidsLeft = std::max((int64)n*n*4, (int64)1024);
+
+    for (;;)
+    {
+        // every phase starts from an empty assignment, keeping the prices of the previous one
+        std::fill(rowsol.begin(), rowsol.end(), -1);
+        std::fill(colsol.begin(), colsol.end(), -1);
+        for (int i = n-1; i >= 0; i--)
+            unassigned.push_back(i);
+
+        while (!unassigned.empty())
+        {
+            if (--bidsLeft < 0)
+                return false;
+            int i = unassigned.back();
+            unassigned.pop_back();
+
+            // best and second best columns for row i
+            const float* cost = costMatrix.ptr<float>(i);
+            float umin = std::numeric_limits<float>::max(), usubmin = std::numeric_limits<float>::max();
+            int j1 = 0;
+            for (int j = 0; j < n; j++)
+            {
+                float h = cost[j] + prices[j];
+                if (h < umin)
+                {
+                    usubmin = umin;
+                    umin = h;
+                    j1 = j;
+                }
+                else if (h < usubmin)
+                {
+                    usubmin = h;
+                }
+            }
+
+            prices[j1] += (n > 1 ? usubmin - umin : 0.f) + epsilon;
+            int i0 = colsol[j1];
+            if (i0 >= 0)
+            {
+                rowsol[i0] = -1;
+                unassigned.push_back(i0);
+            }
+            rowsol[i] = j1;
+            colsol[j1] = i;
+        }
+
+        if (epsilon <= tolerance)
+            return true;
+        epsilon = std::max(epsilon/5, tolerance);
+    }
+}
 
+void SCDMatcher::saveMatches(const cv::Mat &costMatrix, const std::vector<int> &rowsol, const std::vector<int> &colsol,
+                             std::vector<cv::DMatch> &outMatches, std::vector<int> &inliers1, std::vector<int> &inliers2,
+                             int sizeScd1, int sizeScd2)
+{
     // calculate symmetric shape context cost
     cv::Mat trueCostMatrix(costMatrix, cv::Rect(0,0,sizeScd1, sizeScd2));
     CV_Assert(!trueCostMatrix.empty());
@@ -765,7 +1003,7 @@ void SCDMatcher::hungarian(cv::Mat &costMatrix, std::vector<cv::DMatch> &outMatc
     minMatchCost = std::max(leftcost,rightcost);
 
     // Save in a DMatch vector
-    for (i=0;i<costMatrix.cols;i++)
+    for (int i=0;i<costMatrix.cols;i++)
     {
         cv::DMatch singleMatch(colsol[i],i,costMatrix.at<float>(colsol[i],i));//queryIdx,trainIdx,distance
         outMatches.push_back(singleMatch);
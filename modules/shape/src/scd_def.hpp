@@ -68,6 +68,16 @@ public:
                     const std::vector<int>& queryInliers=std::vector<int>(),
                     const float _meanDistance=-1);
 
+    // same as extractSCD, from the distance and angle matrices of the contour
+    void computeDescriptors(const cv::Mat& disMatrix, const cv::Mat& angleMatrix, cv::Mat& descriptors,
+                            const std::vector<int>& queryInliers=std::vector<int>(),
+                            const float _meanDistance=-1);
+
+    // distances between the points of the contour, not normalized
+    void buildDistanceMatrix(const cv::Mat& contour, cv::Mat& disMatrix) const;
+
+    void buildAngleMatrix(const cv::Mat& contour, cv::Mat& angleMatrix) const;
+
     int descriptorSize() {return nAngularBins*nRadialBins;}
     void setAngularBins(int angularBins) { nAngularBins=angularBins; }
     void setRadialBins(int radialBins) { nRadialBins=radialBins; }
@@ -93,18 +103,14 @@ protected:
     void logarithmicSpaces(std::vector<double>& vecSpaces) const;
     void angularSpaces(std::vector<double>& vecSpaces) const;
 
-    void buildNormalizedDistanceMatrix(cv::Mat& contour,
-                          cv::Mat& disMatrix, const std::vector<int> &queryInliers,
-                          const float _meanDistance=-1);
-
-    void buildAngleMatrix(cv::Mat& contour,
-                              cv::Mat& angleMatrix) const;
+    void normalizeDistanceMatrix(const cv::Mat& disMatrix, cv::Mat& normalizedDisMatrix,
+                                 const std::vector<int> &queryInliers, const float _meanDistance=-1);
 };
 
 /*
  * Matcher
  */
-class SCDMatcher
+class CV_EXPORTS SCDMatcher
 {
 public:
     // the full constructor
@@ -112,9 +118,9 @@ public:
     {
     }
 
-    // the matcher function using Hungarian method
-    void matchDescriptors(cv::Mat& descriptors1,  cv::Mat& descriptors2, std::vector<cv::DMatch>& matches, cv::Ptr<cv::HistogramCostExtractor>& comparer,
-                                      std::vector<int>& inliers1, std::vector<int> &inliers2);
+    // the matcher function using Hungarian method, or an auction algorithm if tolerance is positive
+    void matchDescriptors(cv::Mat& descriptors1,  cv::Mat& descriptors2, std::vector<cv::DMatch>& matches, const cv::Ptr<cv::HistogramCostExtractor>& comparer,
+                                      std::vector<int>& inliers1, std::vector<int> &inliers2, float tolerance=0);
 
     // matching cost
     float getMatchingCost() const {return minMatchCost;}
@@ -123,9 +129,15 @@ private:
     float minMatchCost;
 protected:
     void buildCostMatrix(const cv::Mat& descriptors1, const cv::Mat& descriptors2,
-                                     cv::Mat& costMatrix, cv::Ptr<cv::HistogramCostExtractor>& comparer) const;
-    void hungarian(cv::Mat& costMatrix, std::vector<cv::DMatch>& outMatches, std::vector<int> &inliers1,
-                   std::vector<int> &inliers2, int sizeScd1=0, int sizeScd2=0);
+                                     cv::Mat& costMatrix, const cv::Ptr<cv::HistogramCostExtractor>& comparer) const;
+    // exact assignment (Jonker-Volgenant)
+    void hungarian(const cv::Mat& costMatrix, std::vector<int>& rowsol, std::vector<int>& colsol) const;
+    // assignment whose mean cost is at most tolerance above the optimal one (auction with epsilon scaling),
+    // returns false if it did not converge within its bid budget
+    bool auction(const cv::Mat& costMatrix, std::vector<int>& rowsol, std::vector<int>& colsol, float tolerance) const;
+    void saveMatches(const cv::Mat& costMatrix, const std::vector<int>& rowsol, const std::vector<int>& colsol,
+                     std::vector<cv::DMatch>& outMatches, std::vector<int> &inliers1, std::vector<int> &inliers2,
+                     int sizeScd1, int sizeScd2);
 
 };
 
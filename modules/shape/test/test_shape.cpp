@@ -40,6 +40,7 @@
 //M*/
 
 #include "test_precomp.hpp"
+#include "../src/scd_def.hpp"
 
 namespace opencv_test { namespace {
 
@@ -321,4 +322,81 @@ TEST(computeDistance, regression_4976)
     EXPECT_NEAR(d2, 0.25804194808, 1e-3) << "ShapeContextDistanceExtractor";
 }
 
+TEST(computeDistances, matches_computeDistance)
+{
+    Mat a = imread(cvtest::findDataFile("shape/samples/1.png"), 0);
+    Mat b = imread(cvtest::findDataFile("shape/samples/2.png"), 0);
+
+    vector<vector<Point> > ca,cb;
+    findContours(a, ca, cv::RETR_CCOMP, cv::CHAIN_APPROX_TC89_KCOS);
+    findContours(b, cb, cv::RETR_CCOMP, cv::CHAIN_APPROX_TC89_KCOS);
+
+    vector<vector<Point> > contours1, contours2;
+    contours1.push_back(ca[0]);
+    contours1.push_back(cb[0]);
+    contours2.push_back(cb[0]);
+    contours2.push_back(ca[0]);
+    contours2.push_back(cb[0]);
+
+    Ptr<ShapeContextDistanceExtractor> sd = createShapeContextDistanceExtractor();
+    Mat distances;
+    sd->computeDistances(contours1, contours2, distances);
+
+    ASSERT_EQ(2, distances.rows);
+    ASSERT_EQ(3, distances.cols);
+    for (int i = 0; i < distances.rows; i++)
+        for (int j = 0; j < distances.cols; j++)
+            EXPECT_NEAR(sd->computeDistance(contours1[i], contours2[j]), distances.at<float>(i, j), 1e-5);
+    EXPECT_NEAR(distances.at<float>(0, 0), 0.25804194808, 1e-3);
+
+    sd->setAssignmentTolerance(1e-4f);
+    EXPECT_NEAR(sd->computeDistance(ca[0],cb[0]), 0.25804194808, 5e-3) << "approximate assignment";
+}
+
+// exposes the assignment solvers of the matcher
+struct SCDMatcherSolvers : public SCDMatcher
+{
+    using SCDMatcher::hungarian;
+    using SCDMatcher::auction;
+};
+
+static float meanAssignmentCost(const Mat& costMatrix, const vector<int>& colsol)
+{
+    double cost = 0;
+    for (int j = 0; j < costMatrix.cols; j++)
+        cost += costMatrix.at<float>(colsol[j], j);
+    return float(cost / costMatrix.cols);
+}
+
+TEST(SCDMatcher, auction_vs_hungarian)
+{
+    const int n = 200;
+    Mat costMatrix(n, n, CV_32F);
+    RNG rng(0);
+    rng.fill(costMatrix, RNG::UNIFORM, 0.f, 1.f);
+
+    SCDMatcherSolvers solvers;
+    vector<int> rowsolRef, colsolRef;
+    solvers.hungarian(costMatrix, rowsolRef, colsolRef);
+    const float optimalCost = meanAssignmentCost(costMatrix, colsolRef);
+
+    const float tolerances[] = { 1e-2f, 1e-3f };
+    for (size_t t = 0; t < sizeof(tolerances)/sizeof(tolerances[0]); t++)
+    {
+        vector<int> rowsol, colsol;
+        ASSERT_TRUE(solvers.auction(costMatrix, rowsol, colsol, tolerances[t])) << "tolerance " << tolerances[t];
+
+        // a complete one to one assignment
+        for (int j = 0; j < n; j++)
+        {
+            ASSERT_GE(colsol[j], 0);
+            ASSERT_EQ(j, rowsol[colsol[j]]);
+        }
+
+        const float cost = meanAssignmentCost(costMatrix, colsol);
+        EXPECT_GE(cost, optimalCost - 1e-6f) << "tolerance " << tolerances[t];
+        EXPECT_LE(cost, optimalCost + tolerances[t]) << "tolerance " << tolerances[t];
+    }
+}
+
 }} // namespace
@@ -185,7 +185,8 @@ namespace cv
 
         -   By default, the algorithm is single-pass, which means that you consider only 5 directions
         instead of 8. Set mode=StereoSGBM::MODE_HH in createStereoSGBM to run the full variant of the
-        algorithm but beware that it may consume a lot of memory.
+        algorithm but beware that it may consume a lot of memory. MODE_HH4 uses the 4 horizontal and
+        vertical directions only and aggregates them in parallel, with the same memory use as MODE_HH.
         -   The algorithm matches blocks, not individual pixels. Though, setting blockSize=1 reduces the
         blocks to single pixels.
         -   Mutual information cost function is not implemented. Instead, a simpler Birchfield-Tomasi
@@ -204,7 +205,8 @@ namespace cv
             enum
             {
                 MODE_SGBM = 0,
-                MODE_HH   = 1
+                MODE_HH   = 1,
+                MODE_HH4  = 3
             };
 
             virtual int getPreFilterCap() const = 0;
@@ -262,7 +264,8 @@ namespace cv
             Normally, 1 or 2 is good enough.
             @param mode Set it to StereoSGBM::MODE_HH to run the full-scale two-pass dynamic programming
             algorithm. It will consume O(W\*H\*numDisparities) bytes, which is large for 640x480 stereo and
-            huge for HD-size pictures. By default, it is set to false .
+            huge for HD-size pictures. Set it to StereoBinarySGBM::MODE_HH4 to run the 4-directions
+            variant in parallel, with the same memory requirements. By default, it is set to false .
 
             The first constructor initializes StereoSGBM with all the default parameters. So, you only have to
             set StereoSGBM::numDisparities at minimum. The second constructor enables you to set each parameter
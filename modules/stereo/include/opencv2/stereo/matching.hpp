@@ -185,6 +185,82 @@ namespace cv
                     }
                 }
             };
+            //!running sums along the rows of a band, used in costGathering
+            class partialSumsRows:public ParallelLoopBody
+            {
+            private:
+                short *c, *ham, *totals;
+                int maxDisp, width, height, bandRows;
+            public:
+                partialSumsRows(const Mat &hammingDistanceCost, Mat &cost, int maxDispa, int rowsPerBand, short *bandTotals)
+                {
+                    maxDisp = maxDispa;
+                    width = cost.cols / ( maxDisp + 1) - 1;
+                    height = cost.rows - 1;
+                    c = (short *)cost.data;
+                    ham = (short *)hammingDistanceCost.data;
+                    bandRows = rowsPerBand;
+                    totals = bandTotals;
+                }
+                void operator()(const cv::Range &r) const CV_OVERRIDE {
+                    for (int b = r.start; b < r.end; b++)
+                    {
+                        int i1 = b * bandRows + 1, i2 = std::min((b + 1) * bandRows, height);
+                        //the band starts from zero, the sums of the previous bands are added in the vertical pass
+                        std::vector<short> zero(maxDisp + 1, 0);
+                        const short *prev = &zero[0];
+                        for (int i = i1; i <= i2; i++)
+                        {
+                            int iw = i * width;
+                            int iwi = (i - 1) * width;
+                            for (int j = 1; j <= width; j++)
+                            {
+                                int iwj = (iw + j) * (maxDisp + 1);
+                                int iwijmu = (iwi + j - 1) * (maxDisp + 1);
+                                for (int d = 0; d <= maxDisp; d++)
+                                {
+                                    c[iwj + d] = ham[iwijmu + d] + prev[d];
+                                }
+                                prev = c + iwj;
+                            }
+                        }
+                        for (int d = 0; d <= maxDisp; d++)
+                            totals[b * (maxDisp + 1) + d] = prev[d];
+                    }
+                }
+            };
+            //!running sums along the columns, used in costGathering
+            class partialSumsCols:public ParallelLoopBody
+            {
+            private:
+                short *c, *offsets;
+                int maxDisp, width, height, bandRows;
+            public:
+                partialSumsCols(Mat &cost, int maxDispa, int rowsPerBand, short *bandOffsets)
+                {
+                    maxDisp = maxDispa;
+                    width = cost.cols / ( maxDisp + 1) - 1;
+                    height = cost.rows - 1;
+                    c = (short *)cost.data;
+                    bandRows = rowsPerBand;
+                    offsets = bandOffsets;
+                }
+                void operator()(const cv::Range &r) const CV_OVERRIDE {
+                    for (int i = 1; i <= height; i++)
+                    {
+                        const short *off = offsets + ((i - 1) / bandRows) * (maxDisp + 1);
+                        for (int j = r.start; j < r.end; j++)
+                        {
+                            int iwj = (i * width + j) * (maxDisp + 1);
+                            int iwjmu = ((i - 1)  * width + j) * (maxDisp + 1);
+                            for (int d = 0; d <= maxDisp; d++)
+                            {
+                                c[iwj + d] = c[iwj + d] + off[d] + c[iwjmu + d];
+                            }
+                        }
+                    }
+                }
+            };
             //!cost aggregation
             class agregateCost:public ParallelLoopBody
             {
@@ -428,35 +504,21 @@ namespace cv
                 int width = cost.cols / ( maxDisp + 1) - 1;
                 int height = cost.rows - 1;
                 short *c = (short *)cost.data;
-                short *ham = (short *)hammingDistanceCost.data;
                 memset(c, 0, sizeof(c[0]) * (width + 1) * (height + 1) * (maxDisp + 1));
-                for (int i = 1; i <= height; i++)
+                //the rows follow each other in the volume, so the horizontal pass is one running sum over
+                //all of them. It is computed by bands of rows, and each band is shifted by the sum of the
+                //previous ones during the vertical pass. The sums wrap around exactly as the serial ones.
+                const int bandRows = 16;
+                int bands = (height + bandRows - 1) / bandRows;
+                std::vector<short> offsets(std::max(bands, 1) * (maxDisp + 1), 0);
+                std::vector<short> totals(offsets.size(), 0);
+                parallel_for_(Range(0, bands), partialSumsRows(hammingDistanceCost, cost, maxDisp, bandRows, &totals[0]));
+                for (int b = 1; b < bands; b++)
                 {
-                    int iw = i * width;
-                    int iwi = (i - 1) * width;
-                    for (int j = 1; j <= width; j++)
-                    {
-                        int iwj = (iw + j) * (maxDisp + 1);
-                        int iwjmu = (iw + j - 1) * (maxDisp + 1);
-                        int iwijmu = (iwi + j - 1) * (maxDisp + 1);
-                        for (int d = 0; d <= maxDisp; d++)
-                        {
-                            c[iwj + d] = ham[iwijmu + d] + c[iwjmu + d];
-                        }
-                    }
-                }
-                for (int i = 1; i <= height; i++)
-                {
-                    for (int j = 1; j <= width; j++)
-                    {
-                        int iwj = (i * width + j) * (maxDisp + 1);
-                        int iwjmu = ((i - 1)  * width + j) * (maxDisp + 1);
-                        for (int d = 0; d <= maxDisp; d++)
-                        {
-                            c[iwj + d] += c[iwjmu + d];
-                        }
-                    }
+                    for (int d = 0; d <= maxDisp; d++)
+                        offsets[b * (maxDisp + 1) + d] = offsets[(b - 1) * (maxDisp + 1) + d] + totals[(b - 1) * (maxDisp + 1) + d];
                 }
+                parallel_for_(Range(1, width + 1), partialSumsCols(cost, maxDisp, bandRows, &offsets[0]));
             }
             //!The aggregation on the cost volume
             void blockAgregation(const Mat &partialSums, int windowSize, Mat &cost)
@@ -61,6 +61,9 @@ struct CV_EXPORTS PropagationParameters
     int gftMinSeperationDist;
     int gftMaxNumFeatures;
 
+    // Parallel propagation.
+    int tileSize;				// side of the propagation tiles, 0 for a single global queue
+
 };
 
 
@@ -82,6 +85,11 @@ struct CV_EXPORTS PropagationParameters
  * that are not previously computed. New matches are stored in the seed priority queue and used as seeds.
  * The propagation process ends when no additional matches can be retrieved.
  *
+ * When PropagationParameters::tileSize is positive the left image is split in square tiles, each
+ * one growing its own priority queue in parallel. Seeds whose neighborhood crosses a tile border
+ * are handed to the neighbouring tile, so the result depends on the tile size but not on the
+ * number of threads.
+ *
  *
  * @sa This code represents the work presented in @cite Stoyanov2010.
  * If this code is useful for your work please cite @cite Stoyanov2010.
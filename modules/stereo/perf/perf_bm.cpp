@@ -114,5 +114,55 @@ PERF_TEST_P( s_bm, bm_perf,
     SANITY_CHECK(out1);
 }
 
+typedef tuple<Size, int> s_sgbm_mode_t;
+typedef perf::TestBaseWithParam<s_sgbm_mode_t> s_sgbm_mode;
+
+PERF_TEST_P( s_sgbm_mode, sgbm_mode,
+            testing::Combine(
+            testing::Values( cv::Size(640, 480), cv::Size(1280, 720) ),
+            testing::Values( (int)StereoBinarySGBM::MODE_SGBM, (int)StereoBinarySGBM::MODE_HH4 )
+            )
+            )
+{
+    Size sz = get<0>(GetParam());
+    int mode = get<1>(GetParam());
+
+    Mat left(sz, CV_8U);
+    Mat right(sz, CV_8U);
+    Mat out1(sz, CV_16S);
+    Ptr<StereoBinarySGBM> sgbm = StereoBinarySGBM::create(0, 64, 5);
+    sgbm->setBinaryKernelType(CV_DENSE_CENSUS);
+    sgbm->setMode(mode);
+    declare.in(left, right, WARMUP_RNG)
+        .out(out1);
+    TEST_CYCLE()
+    {
+        sgbm->compute(left, right, out1);
+    }
+    SANITY_CHECK_NOTHING();
+}
+
+typedef perf::TestBaseWithParam<Size> s_bm_size;
+
+PERF_TEST_P( s_bm_size, bm_size, testing::Values( cv::Size(640, 480), cv::Size(1280, 720) ) )
+{
+    Size sz = GetParam();
+
+    Mat left(sz, CV_8U);
+    Mat right(sz, CV_8U);
+    Mat out1(sz, CV_8U);
+    Ptr<StereoBinaryBM> sbm = StereoBinaryBM::create(64, 9);
+    sbm->setAgregationWindowSize(11);
+    sbm->setSpekleRemovalTechnique(CV_SPECKLE_REMOVAL_AVG_ALGORITHM);
+    sbm->setUsePrefilter(false);
+    declare.in(left, right, WARMUP_RNG)
+        .out(out1);
+    TEST_CYCLE()
+    {
+        sbm->compute(left, right, out1);
+    }
+    SANITY_CHECK_NOTHING();
+}
+
 
 }} // namespace
@@ -0,0 +1,38 @@
+// This file is part of OpenCV project.
+// It is subject to the license terms in the LICENSE file found in the top-level directory
+// of this distribution and at http://opencv.org/license.html.
+#include "perf_precomp.hpp"
+
+namespace opencv_test { namespace {
+
+typedef perf::TestBaseWithParam<int> qds;
+
+// smooth random texture, seen by the right camera 12 pixels further to the left
+static void generateStereoPair(const Size &size, Mat &left, Mat &right)
+{
+    const int shift = 12;
+    Mat noise(size.height, size.width + shift, CV_8UC1);
+    RNG rng(1234);
+    rng.fill(noise, RNG::UNIFORM, 0, 256);
+    GaussianBlur(noise, noise, Size(5, 5), 1.5);
+    noise(Rect(0, 0, size.width, size.height)).copyTo(left);
+    noise(Rect(shift, 0, size.width, size.height)).copyTo(right);
+}
+
+PERF_TEST_P(qds, process, testing::Values(0, 64, 160))
+{
+    const int tileSize = GetParam();
+    const Size size(1280, 720);
+
+    Mat left, right;
+    generateStereoPair(size, left, right);
+
+    Ptr<QuasiDenseStereo> stereo = QuasiDenseStereo::create(size);
+    stereo->Param.tileSize = tileSize;
+
+    TEST_CYCLE() stereo->process(left, right);
+
+    SANITY_CHECK_NOTHING();
+}
+
+}} // namespace
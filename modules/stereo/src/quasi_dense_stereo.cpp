@@ -5,7 +5,9 @@
 #include "precomp.hpp"
 #include <opencv2/video/tracking.hpp>
 #include <opencv2/stereo/quasi_dense_stereo.hpp>
+#include "opencv2/core/hal/intrin.hpp"
 #include <queue>
+#include <unordered_set>
 
 
 namespace cv {
@@ -15,6 +17,16 @@ namespace stereo {
 
 typedef std::priority_queue<Match, std::vector<Match>, std::less<Match> > t_matchPriorityQueue;
 
+#if CV_SIMD128
+static inline v_int32x4 dotProductU8(const v_uint8x16 &a, const v_uint8x16 &b)
+{
+    v_uint16x8 a0, a1, b0, b1;
+    v_expand(a, a0, a1);
+    v_expand(b, b0, b1);
+    return v_dotprod(v_reinterpret_as_s16(a0), v_reinterpret_as_s16(b0)) +
+           v_dotprod(v_reinterpret_as_s16(a1), v_reinterpret_as_s16(b1));
+}
+#endif
 
 class QuasiDenseStereoImpl : public QuasiDenseStereo
 {
@@ -32,6 +44,11 @@ public:
         sum1 = cv::Mat_<int32_t>(integralSize);
         ssum0 = cv::Mat_<double>(integralSize);
         ssum1 = cv::Mat_<double>(integralSize);
+        // statistics of the correlation windows.
+        patchMean0 = cv::Mat_<float>(monoImgSize);
+        patchMean1 = cv::Mat_<float>(monoImgSize);
+        patchDev0 = cv::Mat_<float>(monoImgSize);
+        patchDev1 = cv::Mat_<float>(monoImgSize);
         // the disparity image.
         disparity = cv::Mat_<float>(monoImgSize);
         disparityImg = cv::Mat_<uchar>(monoImgSize);
@@ -53,6 +70,10 @@ public:
         sum1.release();
         ssum0.release();
         ssum1.release();
+        patchMean0.release();
+        patchMean1.release();
+        patchDev0.release();
+        patchDev1.release();
         // the disparity image.
         disparity.release();
         disparityImg.release();
@@ -77,6 +98,8 @@ public:
      * @param[out] featuresRight (vector of points) The location of the features in the right image.
      * @note featuresLeft and featuresRight must have the same length and corresponding features
      * must be indexed the same way in both vectors.
+     * @note The features and the pyramid of the left image are computed in parallel with the pyramid
+     * of the right image.
      */
     void sparseMatching(const cv::Mat &imgLeft ,const cv::Mat &imgRight,
                         std::vector< cv::Point2f > &featuresLeft,
@@ -87,13 +110,26 @@ public:
         featuresLeft.clear();
         featuresRight.clear();
 
-        cv::goodFeaturesToTrack(imgLeft, featuresLeft, Param.gftMaxNumFeatures,
-        Param.gftQualityThres, Param.gftMinSeperationDist);
-
         cv::Size templateSize(Param.lkTemplateSize,Param.lkTemplateSize);
+        std::vector< cv::Mat > pyramidLeft, pyramidRight;
+        cv::parallel_for_(cv::Range(0, 2), [&](const cv::Range& range)
+        {
+            for(int i = range.start; i < range.end; i++)
+            {
+                if(i == 0)
+                {
+                    cv::goodFeaturesToTrack(imgLeft, featuresLeft, Param.gftMaxNumFeatures,
+                    Param.gftQualityThres, Param.gftMinSeperationDist);
+                    cv::buildOpticalFlowPyramid(imgLeft, pyramidLeft, templateSize, Param.lkPyrLvl);
+                }
+                else
+                    cv::buildOpticalFlowPyramid(imgRight, pyramidRight, templateSize, Param.lkPyrLvl);
+            }
+        });
+
         cv::TermCriteria termination(cv::TermCriteria::MAX_ITER | cv::TermCriteria::EPS,
                                      Param.lkTermParam1, Param.lkTermParam2);
-        cv::calcOpticalFlowPyrLK(imgLeft, imgRight, featuresLeft, featuresRight,
+        cv::calcOpticalFlowPyrLK(pyramidLeft, pyramidRight, featuresLeft, featuresRight,
         featureStatus, error,
         templateSize, Param.lkPyrLvl, termination);
         //discard bad features.
@@ -131,6 +167,7 @@ public:
      * match is not registered in refMap, it means that is the best match for this point. The
      * algorithm registers this point in refMap and also push it to the Seed queue. If a candidate
      * match is already registered, it means that is not the best and the algorithm discards it.
+     * If Param.tileSize is positive the propagation is done by tiledPropagation instead.
      *
      * @note This method does not have input arguments, but uses the "leftFeatures" and
      * "rightFeatures" vectors.
@@ -152,12 +189,20 @@ public:
         // generate the intergal images for fast variable window correlation calculations
         cv::integral(grayLeft, sum0, ssum0);
         cv::integral(grayRight, sum1, ssum1);
+        // and the mean and deviation of the correlation window of every pixel.
+        buildPatchStatistics(sum0, ssum0, patchMean0, patchDev0);
+        buildPatchStatistics(sum1, ssum1, patchMean1, patchDev1);
 
         // Seed priority queue. The algorithm wants to pop the best seed available in order to densify
         //the sparse set.
         t_matchPriorityQueue seeds = extractSparseSeeds(featuresLeft, featuresRight,
         refMap, mtcMap);
 
+        if(Param.tileSize > 0)
+        {
+            tiledPropagation(seeds);
+            return;
+        }
 
         // Do the propagation part
         while(!seeds.empty())
@@ -172,53 +217,7 @@ public:
             if(!CheckBorder(m, Param.borderX, Param.borderY, width, height))
                 continue;
 
-            // For all neighbours of the seed in image 1
-            //the neighborghoud is defined with Param.N*2 dimentrion
-            for(int y=-Param.neighborhoodSize;y<=Param.neighborhoodSize;y++)
-            {
-                for(int x=-Param.neighborhoodSize;x<=Param.neighborhoodSize;x++)
-                {
-                    cv::Point2i p0 = cv::Point2i(m.p0.x+x,m.p0.y+y);
-
-                    // Check if its unique in ref
-                    if(refMap.at<cv::Point2i>(p0.y,p0.x) != NO_MATCH)
-                        continue;
-
-                    // Check the texture descriptor for a boundary
-                    if(textureDescLeft.at<int>(p0.y, p0.x) > Param.textrureThreshold)
-                        continue;
-
-                    // For all candidate matches.
-                    for(int wy=-Param.disparityGradient; wy<=Param.disparityGradient; wy++)
-                    {
-                        for(int wx=-Param.disparityGradient; wx<=Param.disparityGradient; wx++)
-                        {
-                            cv::Point p1 = cv::Point(m.p1.x+x+wx,m.p1.y+y+wy);
-
-                            // Check if its unique in ref
-                            if(mtcMap.at<cv::Point2i>(p1.y, p1.x) != NO_MATCH)
-                                continue;
-
-                            // Check the texture descriptor for a boundary
-                            if(textureDescRight.at<int>(p1.y, p1.x) > Param.textrureThreshold)
-                                continue;
-
-                            // Calculate ZNCC and store local match.
-                            float corr = iZNCC_c1(p0,p1,Param.corrWinSizeX,Param.corrWinSizeY);
-
-                            // push back if this is valid match
-                            if( corr > Param.correlationThreshold )
-                            {
-                                Match nm;
-                                nm.p0 = p0;
-                                nm.p1 = p1;
-                                nm.corr = corr;
-                                Local.push(nm);
-                            }
-                        }
-                    }
-                }
-            }
+            findCandidates(m, cv::Rect(0, 0, width, height), NULL, Local);
 
             // Get seeds from the local
             while( !Local.empty() )
@@ -243,6 +242,207 @@ public:
     }
 
 
+    /**
+     * @brief Find the candidate matches around a seed.
+     *
+     * Every point in the neighborhood of the left seed point is matched with the points around the
+     * corresponding right location, allowing for the disparity gradient. Pairs that are not
+     * registered yet, are textured enough and correlate above the threshold are pushed to Local.
+     * @param[in] m The seed.
+     * @param[in] roi Only left points inside this rectangle are considered.
+     * @param[in] claims Right points, as y*width+x, matched but not registered in mtcMap yet.
+     * May be NULL.
+     * @param[out] Local The candidate matches.
+     */
+    void findCandidates(const Match &m, const cv::Rect &roi, const std::unordered_set<int> *claims,
+                        t_matchPriorityQueue &Local)
+    {
+        // For all neighbours of the seed in image 1
+        //the neighborghoud is defined with Param.N*2 dimentrion
+        for(int y=-Param.neighborhoodSize;y<=Param.neighborhoodSize;y++)
+        {
+            for(int x=-Param.neighborhoodSize;x<=Param.neighborhoodSize;x++)
+            {
+                cv::Point2i p0 = cv::Point2i(m.p0.x+x,m.p0.y+y);
+
+                if(!roi.contains(p0))
+                    continue;
+
+                // Check if its unique in ref
+                if(refMap.at<cv::Point2i>(p0.y,p0.x) != NO_MATCH)
+                    continue;
+
+                // Check the texture descriptor for a boundary
+                if(textureDescLeft.at<int>(p0.y, p0.x) > Param.textrureThreshold)
+                    continue;
+
+                // For all candidate matches.
+                for(int wy=-Param.disparityGradient; wy<=Param.disparityGradient; wy++)
+                {
+                    for(int wx=-Param.disparityGradient; wx<=Param.disparityGradient; wx++)
+                    {
+                        cv::Point p1 = cv::Point(m.p1.x+x+wx,m.p1.y+y+wy);
+
+                        // Check if its unique in ref
+                        if(mtcMap.at<cv::Point2i>(p1.y, p1.x) != NO_MATCH)
+                            continue;
+                        if(claims && claims->count(p1.y*width + p1.x))
+                            continue;
+
+                        // Check the texture descriptor for a boundary
+                        if(textureDescRight.at<int>(p1.y, p1.x) > Param.textrureThreshold)
+                            continue;
+
+                        // Calculate ZNCC and store local match.
+                        float corr = iZNCC_c1(p0,p1,Param.corrWinSizeX,Param.corrWinSizeY);
+
+                        // push back if this is valid match
+                        if( corr > Param.correlationThreshold )
+                        {
+                            Match nm;
+                            nm.p0 = p0;
+                            nm.p1 = p1;
+                            nm.corr = corr;
+                            Local.push(nm);
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+
+    /**
+     * @brief Propagate the seeds in parallel, over square tiles of the left image.
+     *
+     * Each tile owns a priority queue and only registers matches whose left point lies inside it,
+     * so tiles grow in parallel without sharing any part of refMap. The propagation runs in rounds.
+     * During a round mtcMap is only read and each tile keeps its claimed right points aside. At the
+     * end of the round they are registered in tile order, and when two tiles claimed the same right
+     * point the first one keeps it. Seeds whose neighborhood reaches other tiles are handed to them
+     * for the next round. The propagation ends when a round hands no seed over.
+     * @param[in] seeds The sparse seeds, see extractSparseSeeds.
+     * @note The result depends on Param.tileSize but not on the number of threads.
+     */
+    void tiledPropagation(t_matchPriorityQueue &seeds)
+    {
+        const int tileSize = Param.tileSize;
+        const int tilesX = (width + tileSize - 1)/tileSize;
+        const int tilesY = (height + tileSize - 1)/tileSize;
+        const int numTiles = tilesX*tilesY;
+        const int N = Param.neighborhoodSize;
+
+        std::vector< t_matchPriorityQueue > queues(numTiles);
+        // matches found during a round and seeds handed to other tiles, per tile.
+        std::vector< std::vector<Match> > found(numTiles);
+        std::vector< std::vector< std::pair<int, Match> > > handOff(numTiles);
+
+        while(!seeds.empty())
+        {
+            const Match &m = seeds.top();
+            queues[(m.p0.y/tileSize)*tilesX + m.p0.x/tileSize].push(m);
+            seeds.pop();
+        }
+
+        for(;;)
+        {
+            cv::parallel_for_(cv::Range(0, numTiles), [&](const cv::Range& range)
+            {
+                for(int t = range.start; t < range.end; t++)
+                {
+                    const cv::Rect roi = cv::Rect((t%tilesX)*tileSize, (t/tilesX)*tileSize,
+                                                  tileSize, tileSize) & cv::Rect(0, 0, width, height);
+                    std::unordered_set<int> claims;
+                    t_matchPriorityQueue &tileSeeds = queues[t];
+
+                    while(!tileSeeds.empty())
+                    {
+                        t_matchPriorityQueue Local;
+
+                        Match m = tileSeeds.top();
+                        tileSeeds.pop();
+
+                        if(!CheckBorder(m, Param.borderX, Param.borderY, width, height))
+                            continue;
+
+                        // Seeds received from other tiles are not handed over again.
+                        if(roi.contains(m.p0))
+                        {
+                            const int x0 = std::max(m.p0.x-N, 0)/tileSize;
+                            const int x1 = std::min(m.p0.x+N, width-1)/tileSize;
+                            const int y0 = std::max(m.p0.y-N, 0)/tileSize;
+                            const int y1 = std::min(m.p0.y+N, height-1)/tileSize;
+                            for(int y = y0; y <= y1; y++)
+                            {
+                                for(int x = x0; x <= x1; x++)
+                                {
+                                    if(y*tilesX + x != t)
+                                        handOff[t].push_back(std::make_pair(y*tilesX + x, m));
+                                }
+                            }
+                        }
+
+                        findCandidates(m, roi, &claims, Local);
+
+                        while( !Local.empty() )
+                        {
+                            Match lm = Local.top();
+                            Local.pop();
+                            // Check if its unique in both ref and dst.
+                            if(refMap.at<cv::Point2i>(lm.p0.y, lm.p0.x) != NO_MATCH)
+                                continue;
+                            if(mtcMap.at<cv::Point2i>(lm.p1.y, lm.p1.x) != NO_MATCH)
+                                continue;
+                            const int p1Idx = lm.p1.y*width + lm.p1.x;
+                            if(claims.count(p1Idx))
+                                continue;
+
+                            refMap.at<cv::Point2i>(lm.p0.y, lm.p0.x) = lm.p1;
+                            claims.insert(p1Idx);
+                            found[t].push_back(lm);
+                            tileSeeds.push(lm);
+                        }
+                    }
+                }
+            });
+
+            for(int t = 0; t < numTiles; t++)
+            {
+                for(size_t i = 0; i < found[t].size(); i++)
+                {
+                    const Match &lm = found[t][i];
+                    cv::Point2i &mtc = mtcMap.at<cv::Point2i>(lm.p1.y, lm.p1.x);
+                    if(mtc == NO_MATCH)
+                    {
+                        mtc = lm.p0;
+                        dMatchesLen++;
+                    }
+                    else
+                        refMap.at<cv::Point2i>(lm.p0.y, lm.p0.x) = NO_MATCH;
+                }
+                found[t].clear();
+            }
+
+            bool handedOver = false;
+            for(int t = 0; t < numTiles; t++)
+            {
+                for(size_t i = 0; i < handOff[t].size(); i++)
+                {
+                    const Match &m = handOff[t][i].second;
+                    // the match may have lost its right point above.
+                    if(refMap.at<cv::Point2i>(m.p0.y, m.p0.x) != m.p1)
+                        continue;
+                    queues[handOff[t][i].first].push(m);
+                    handedOver = true;
+                }
+                handOff[t].clear();
+            }
+            if(!handedOver)
+                break;
+        }
+    }
+
+
     /**
      * @brief Compute the disparity map based on the Euclidean distance of corresponding points.
      * @param[in] matchMap A matrix of points, the same size as the left channel. Each cell of this
@@ -319,6 +519,8 @@ public:
      * @param [in] wy The distance from the center of the patch to the border in the y direction.
      * @return The value of the the zero-mean normalized cross correlation.
      * @note Default value for wx, wy is 1. in this case the patch is 3x3.
+     * @note Means and deviations of the Param.corrWinSizeX by Param.corrWinSizeY windows are read
+     * from the maps built by buildPatchStatistics.
      */
     float iZNCC_c1(const cv::Point2i p0, const cv::Point2i p1, const int wx=1, const int wy=1)
     {
@@ -326,28 +528,114 @@ public:
         float wa = (float)(2*wy+1)*(2*wx+1);
         float zncc=0.0;
 
+        if(wx == Param.corrWinSizeX && wy == Param.corrWinSizeY)
+        {
+            m0 = patchMean0.at<float>(p0.y, p0.x);
+            m1 = patchMean1.at<float>(p1.y, p1.x);
+            s0 = patchDev0.at<float>(p0.y, p0.x);
+            s1 = patchDev1.at<float>(p1.y, p1.x);
+        }
+        else
+        {
+            patchSumSum2(p0, sum0, ssum0, m0, s0, wx, wy);
+            patchSumSum2(p1, sum1, ssum1, m1, s1, wx, wy);
 
-        patchSumSum2(p0, sum0, ssum0, m0, s0, wx, wy);
-        patchSumSum2(p1, sum1, ssum1, m1, s1, wx, wy);
+            m0 /= wa;
+            m1 /= wa;
 
-        m0 /= wa;
-        m1 /= wa;
+            // standard deviations
+            s0 = sqrt(s0-wa*m0*m0);
+            s1 = sqrt(s1-wa*m1*m1);
+        }
 
-        // standard deviations
-        s0 = sqrt(s0-wa*m0*m0);
-        s1 = sqrt(s1-wa*m1*m1);
+        zncc = (float)patchDotProduct(p0, p1, wx, wy);
+        zncc = (zncc-wa*m0*m1)/(s0*s1);
+        return zncc;
+    }
 
 
-        for (int col=-wy; col<=wy; col++)
+    /**
+     * @brief Compute the sum of the products of corresponding pixels of a patch in the left image,
+     * centered in point p0, and a patch in the right image, centered in point p1.
+     * @param [in] p0 The central point of the patch in the left image.
+     * @param [in] p1 The central point of the patch in the right image.
+     * @param [in] wx The distance from the center of the patch to the border in the x direction.
+     * @param [in] wy The distance from the center of the patch to the border in the y direction.
+     * @return The sum of products, computed exactly in integers.
+     */
+    int patchDotProduct(const cv::Point2i p0, const cv::Point2i p1, const int wx, const int wy) const
+    {
+        const int patchWidth = 2*wx+1;
+        int dot = 0;
+#if CV_SIMD128
+        // the last partial vector of a row is read as a full one when it stays inside both images,
+        // and its extra lanes are masked out.
+        const int tail = patchWidth % 16;
+        const bool loadTail = tail > 0 && p0.x+wx-tail+16 < width && p1.x+wx-tail+16 < width;
+        uchar maskBuf[16];
+        for(int i = 0; i < 16; i++)
+            maskBuf[i] = i < tail ? 255 : 0;
+        const v_uint8x16 tailMask = v_load(maskBuf);
+        v_int32x4 vdot = v_setzero_s32();
+#endif
+        for(int row=-wy; row<=wy; row++)
         {
-            for (int row=-wx; row<=wx; row++)
+            const uchar* a = grayLeft.ptr<uchar>(p0.y+row) + p0.x - wx;
+            const uchar* b = grayRight.ptr<uchar>(p1.y+row) + p1.x - wx;
+            int col = 0;
+#if CV_SIMD128
+            for(; col <= patchWidth-16; col += 16)
+                vdot += dotProductU8(v_load(a+col), v_load(b+col));
+            if(loadTail)
             {
-                zncc += (float)grayLeft.at<uchar>(p0.y+row, p0.x+col) *
-                (float)grayRight.at<uchar>(p1.y+row, p1.x+col);
+                vdot += dotProductU8(v_load(a+col) & tailMask, v_load(b+col));
+                col = patchWidth;
             }
+#endif
+            for(; col < patchWidth; col++)
+                dot += a[col]*b[col];
         }
-        zncc = (zncc-wa*m0*m1)/(s0*s1);
-        return zncc;
+#if CV_SIMD128
+        dot += v_reduce_sum(vdot);
+#endif
+        return dot;
+    }
+
+
+    /**
+     * @brief Compute the mean and standard deviation of the Param.corrWinSizeX by
+     * Param.corrWinSizeY window centered in every pixel, from the integral images.
+     * @param[in] sum The integral image.
+     * @param[in] ssum The integral image of squared values.
+     * @param[out] mean The mean of the window of every pixel.
+     * @param[out] dev The standard deviation of the window of every pixel.
+     * @note Pixels whose window crosses the image border are set to zero.
+     * @sa patchSumSum2
+     */
+    void buildPatchStatistics(const cv::Mat &sum, const cv::Mat &ssum,
+                              cv::Mat_<float> &mean, cv::Mat_<float> &dev)
+    {
+        const int wx = Param.corrWinSizeX, wy = Param.corrWinSizeY;
+        const float wa = (float)(2*wy+1)*(2*wx+1);
+        mean = 0.f;
+        dev = 0.f;
+
+        cv::parallel_for_(cv::Range(wy, std::max(height-wy, wy)), [&](const cv::Range& range)
+        {
+            for(int row = range.start; row < range.end; row++)
+            {
+                float* meanRow = mean[row];
+                float* devRow = dev[row];
+                for(int col = wx; col < width-wx; col++)
+                {
+                    float m, s;
+                    patchSumSum2(cv::Point2i(col, row), sum, ssum, m, s, wx, wy);
+                    m /= wa;
+                    meanRow[col] = m;
+                    devRow[col] = sqrt(s-wa*m*m);
+                }
+            }
+        });
     }
 
 
@@ -461,32 +749,34 @@ public:
      */
     void buildTextureDescriptor(cv::Mat &img,cv::Mat &descriptor)
     {
-        float a, b, c, d;
-
-        uint8_t center, top, bottom, right, left;
-        //reset descriptors
-
         // traverse every pixel.
-        for(int row=1; row<height-1; row++)
+        cv::parallel_for_(cv::Range(1, std::max(height-1, 1)), [&](const cv::Range& range)
         {
-            for(int col=1; col<width-1; col++)
+            float a, b, c, d;
+
+            uint8_t center, top, bottom, right, left;
+
+            for(int row=range.start; row<range.end; row++)
             {
-                // the values of the current pixel.
-                center = img.at<uchar>(row,col);
-                top = img.at<uchar>(row-1,col);
-                bottom = img.at<uchar>(row+1,col);
-                left = img.at<uchar>(row,col-1);
-                right = img.at<uchar>(row,col+1);
-
-                a = (float)abs(center - top);
-                b = (float)abs(center - bottom);
-                c = (float)abs(center - left);
-                d = (float)abs(center - right);
-                //choose the biggest of them.
-                int val = (int) std::max(a, std::max(b, std::max(c, d)));
-                descriptor.at<int>(row, col) = val;
+                for(int col=1; col<width-1; col++)
+                {
+                    // the values of the current pixel.
+                    center = img.at<uchar>(row,col);
+                    top = img.at<uchar>(row-1,col);
+                    bottom = img.at<uchar>(row+1,col);
+                    left = img.at<uchar>(row,col-1);
+                    right = img.at<uchar>(row,col+1);
+
+                    a = (float)abs(center - top);
+                    b = (float)abs(center - bottom);
+                    c = (float)abs(center - left);
+                    d = (float)abs(center - right);
+                    //choose the biggest of them.
+                    int val = (int) std::max(a, std::max(b, std::max(c, d)));
+                    descriptor.at<int>(row, col) = val;
+                }
             }
-        }
+        });
     }
 
     //-------------------------------------------------------------------------
@@ -534,6 +824,8 @@ public:
             fs["gftQualityThres"] >> Param.gftQualityThres;
             fs["gftMinSeperationDist"] >> Param.gftMinSeperationDist;
             fs["gftMaxNumFeatures"] >> Param.gftMaxNumFeatures;
+
+            fs["tileSize"] >> Param.tileSize;
             fs.release();
             return 1;
         }
@@ -557,6 +849,8 @@ public:
         Param.gftQualityThres = (float)0.01;
         Param.gftMinSeperationDist = 10;
         Param.gftMaxNumFeatures = 500;
+
+        Param.tileSize = 0;
         // Return 0 if there was no filepath provides.
         // Return -1 if there was a problem opening the filepath provided.
         if(filepath.empty())
@@ -589,6 +883,8 @@ public:
             fs << "gftQualityThres" << Param.gftQualityThres;
             fs << "gftMinSeperationDist" << Param.gftMinSeperationDist;
             fs << "gftMaxNumFeatures" << Param.gftMaxNumFeatures;
+
+            fs << "tileSize" << Param.tileSize;
             fs.release();
         }
         return -1;
@@ -661,6 +957,11 @@ public:
     cv::Mat_<int32_t> sum1;
     cv::Mat_<double> ssum0;
     cv::Mat_<double> ssum1;
+    // Mean and standard deviation of the correlation window centered in each pixel.
+    cv::Mat_<float> patchMean0;
+    cv::Mat_<float> patchMean1;
+    cv::Mat_<float> patchDev0;
+    cv::Mat_<float> patchDev1;
     // Container to store the disparity un-normalized
     cv::Mat_<float> disparity;
     // Container to store the disparity image.
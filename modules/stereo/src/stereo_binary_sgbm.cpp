@@ -49,6 +49,7 @@ SGBM (Semi-global block matching)
 */
 
 #include "precomp.hpp"
+#include "opencv2/core/hal/intrin.hpp"
 #include <limits.h>
 
 namespace cv
@@ -110,6 +111,82 @@ namespace cv
             int subpixelInterpolationMethod;
         };
 
+        /*
+        sub-pixel refinement of the best disparity d of a pixel, from its summary costs Sp.
+        returns the disparity with DISP_SHIFT fractional bits.
+        */
+        static inline int interpolateDisparity(const CostType* Sp, int d, int D, int method)
+        {
+            const int DISP_SCALE = (1 << StereoMatcher::DISP_SHIFT);
+            if( 0 < d && d < D-1 )
+            {
+                if(method == CV_SIMETRICV_INTERPOLATION)
+                {
+                    double m2m1, m3m1, m3, m2, m1;
+                    m2 = Sp[d - 1];
+                    m3 = Sp[d + 1];
+                    m1 = Sp[d];
+                    m2m1 = m2 - m1;
+                    m3m1 = m3 - m1;
+                    if (!(m2m1 == 0 || m3m1 == 0))
+                    {
+                        double p;
+                        p = 0;
+                        if (m2 > m3)
+                        {
+                            p = (0.5 - 0.25 * ((m3m1 * m3m1) / (m2m1 * m2m1) + (m3m1 / m2m1)));
+                        }
+                        else
+                        {
+                            p = -1 * (0.5 - 0.25 * ((m2m1 * m2m1) / (m3m1 * m3m1) + (m2m1 / m3m1)));
+                        }
+                        if (p >= -0.5 && p <= 0.5)
+                            d = (int)(d * DISP_SCALE + p * DISP_SCALE );
+                    }
+                    else
+                    {
+                        d *= DISP_SCALE;
+                    }
+                }
+                else if(method == CV_QUADRATIC_INTERPOLATION)
+                {
+                    // do subpixel quadratic interpolation:
+                    //   fit parabola into (x1=d-1, y1=Sp[d-1]), (x2=d, y2=Sp[d]), (x3=d+1, y3=Sp[d+1])
+                    //   then find minimum of the parabola.
+                    int denom2 = std::max(Sp[d-1] + Sp[d+1] - 2*Sp[d], 1);
+                    d = d*DISP_SCALE + ((Sp[d-1] - Sp[d+1])*DISP_SCALE + denom2)/(denom2*2);
+                }
+            }
+            else
+                d *= DISP_SCALE;
+            return d;
+        }
+
+        /*
+        left-right check of a row of disp1, disp2ptr being the reverse disparity of the same row.
+        */
+        static inline void checkDisparityRow(DispType* disp1ptr, const DispType* disp2ptr, int minX1, int maxX1,
+            int width, int minD, int disp12MaxDiff, int INVALID_DISP_SCALED)
+        {
+            const int DISP_SHIFT = StereoMatcher::DISP_SHIFT;
+            const int DISP_SCALE = (1 << DISP_SHIFT);
+            for( int x = minX1; x < maxX1; x++ )
+            {
+                // we round the computed disparity both towards -inf and +inf and check
+                // if either of the corresponding disparities in disp2 is consistent.
+                // This is to give the computed disparity a chance to look valid if it is.
+                int d1 = disp1ptr[x];
+                if( d1 == INVALID_DISP_SCALED )
+                    continue;
+                int _d = d1 >> DISP_SHIFT;
+                int d_ = (d1 + DISP_SCALE-1) >> DISP_SHIFT;
+                int _x = x - _d, x_ = x - d_;
+                if( 0 <= _x && _x < width && disp2ptr[_x] >= minD && std::abs(disp2ptr[_x] - _d) > disp12MaxDiff &&
+                    0 <= x_ && x_ < width && disp2ptr[x_] >= minD && std::abs(disp2ptr[x_] - d_) > disp12MaxDiff )
+                    disp1ptr[x] = (DispType)INVALID_DISP_SCALED;
+            }
+        }
+
         /*
         computes disparity for "roi" in img1 w.r.t. img2 and write it to disp1buf.
         that is, disp1buf(x, y)=d means that img1(x+roi.x, y+roi.y) ~ img2(x+roi.x-d, y+roi.y).
@@ -553,64 +630,10 @@ namespace cv
                                 disp2cost[_x2] = (CostType)minS;
                                 disp2ptr[_x2] = (DispType)(d + minD);
                             }
-                            if( 0 < d && d < D-1 )
-                            {
-                                if(params.subpixelInterpolationMethod == CV_SIMETRICV_INTERPOLATION)
-                                {
-                                    double m2m1, m3m1, m3, m2, m1;
-                                    m2 = Sp[d - 1];
-                                    m3 = Sp[d + 1];
-                                    m1 = Sp[d];
-                                    m2m1 = m2 - m1;
-                                    m3m1 = m3 - m1;
-                                    if (!(m2m1 == 0 || m3m1 == 0))
-                                    {
-                                        double p;
-                                        p = 0;
-                                        if (m2 > m3)
-                                        {
-                                            p = (0.5 - 0.25 * ((m3m1 * m3m1) / (m2m1 * m2m1) + (m3m1 / m2m1)));
-                                        }
-                                        else
-                                        {
-                                            p = -1 * (0.5 - 0.25 * ((m2m1 * m2m1) / (m3m1 * m3m1) + (m2m1 / m3m1)));
-                                        }
-                                        if (p >= -0.5 && p <= 0.5)
-                                            d = (int)(d * DISP_SCALE + p * DISP_SCALE );
-                                    }
-                                    else
-                                    {
-                                        d *= DISP_SCALE;
-                                    }
-                                }
-                                else if(params.subpixelInterpolationMethod == CV_QUADRATIC_INTERPOLATION)
-                                {
-                                    // do subpixel quadratic interpolation:
-                                    //   fit parabola into (x1=d-1, y1=Sp[d-1]), (x2=d, y2=Sp[d]), (x3=d+1, y3=Sp[d+1])
-                                    //   then find minimum of the parabola.
-                                    int denom2 = std::max(Sp[d-1] + Sp[d+1] - 2*Sp[d], 1);
-                                    d = d*DISP_SCALE + ((Sp[d-1] - Sp[d+1])*DISP_SCALE + denom2)/(denom2*2);
-                                }
-                            }
-                            else
-                                d *= DISP_SCALE;
+                            d = interpolateDisparity(Sp, d, D, params.subpixelInterpolationMethod);
                             disp1ptr[x + minX1] = (DispType)(d + minD*DISP_SCALE);
                         }
-                        for( x = minX1; x < maxX1; x++ )
-                        {
-                            // we round the computed disparity both towards -inf and +inf and check
-                            // if either of the corresponding disparities in disp2 is consistent.
-                            // This is to give the computed disparity a chance to look valid if it is.
-                            int d1 = disp1ptr[x];
-                            if( d1 == INVALID_DISP_SCALED )
-                                continue;
-                            int _d = d1 >> DISP_SHIFT;
-                            int d_ = (d1 + DISP_SCALE-1) >> DISP_SHIFT;
-                            int _x = x - _d, x_ = x - d_;
-                            if( 0 <= _x && _x < width && disp2ptr[_x] >= minD && std::abs(disp2ptr[_x] - _d) > disp12MaxDiff &&
-                                0 <= x_ && x_ < width && disp2ptr[x_] >= minD && std::abs(disp2ptr[x_] - d_) > disp12MaxDiff )
-                                disp1ptr[x] = (DispType)INVALID_DISP_SCALED;
-                        }
+                        checkDisparityRow(disp1ptr, disp2ptr, minX1, maxX1, width, minD, disp12MaxDiff, INVALID_DISP_SCALED);
                     }
                     // now shift the cyclic buffers
                     std::swap( Lr[0], Lr[1] );
@@ -618,6 +641,248 @@ namespace cv
                 }
             }
         }
+        /*
+        one step of the dynamic programming along a path r (formula 13 in the paper):
+        L_r(p, d) = C(p, d) + min(L_r(p-r, d), L_r(p-r, d-1) + P1, L_r(p-r, d+1) + P1,
+                                  min_k L_r(p-r, k) + P2) - min_k L_r(p-r, k)
+        Lp is L_r(p-r, .), with MAX_COST at -1 and D, and delta = min_k L_r(p-r, k) + P2.
+        Cp already includes P2, see computeDisparityBinarySGBM.
+        L_r(p, .) is written to Lr and added to Sp (or stored in it), returns min_k L_r(p, k).
+        */
+        static inline int updatePathCost(const CostType* Cp, const CostType* Lp, CostType* Lr, CostType* Sp,
+            int D, int P1, int delta, bool accumulate)
+        {
+            int d = 0, minL = SHRT_MAX;
+#if CV_SIMD128
+            v_int16x8 _P1 = v_setall_s16((short)P1), _delta = v_setall_s16((short)delta);
+            v_int16x8 _minL = v_setall_s16(SHRT_MAX);
+            for( ; d <= D - 8; d += 8 )
+            {
+                v_int16x8 L = v_load(Lp + d);
+                L = v_min(L, v_load(Lp + d - 1) + _P1);
+                L = v_min(L, v_load(Lp + d + 1) + _P1);
+                L = v_min(L, _delta);
+                L = (L - _delta) + v_load(Cp + d);
+                v_store(Lr + d, L);
+                _minL = v_min(_minL, L);
+                v_store(Sp + d, accumulate ? v_load(Sp + d) + L : L);
+            }
+            minL = v_reduce_min(_minL);
+#endif
+            for( ; d < D; d++ )
+            {
+                int L = Cp[d] + std::min((int)Lp[d], std::min(Lp[d-1] + P1, std::min(Lp[d+1] + P1, delta))) - delta;
+                Lr[d] = saturate_cast<CostType>(L);
+                minL = std::min(minL, (int)Lr[d]);
+                Sp[d] = saturate_cast<CostType>((accumulate ? Sp[d] : 0) + Lr[d]);
+            }
+            return minL;
+        }
+
+        /*
+        4-directions variant of computeDisparityBinarySGBM (MODE_HH4), same inputs and outputs.
+        The cost volume and the summary costs are kept for the whole image, so that each step runs in
+        parallel: the block costs over the rows and then over the columns, the two horizontal paths
+        over the rows, the two vertical paths over bands of columns and the disparity selection over
+        the rows. The result does not depend on the number of threads.
+        */
+        static void computeDisparityBinarySGBM_HH4( const Mat& img1, Mat& disp1,
+            const StereoBinarySGBMParams& params, Mat& buffer, const Mat& hamDist )
+        {
+            const int ALIGN = 16;
+            const int DISP_SHIFT = StereoMatcher::DISP_SHIFT;
+            const int DISP_SCALE = (1 << DISP_SHIFT);
+            const CostType MAX_COST = SHRT_MAX;
+            int minD = params.minDisparity, maxD = minD + params.numDisparities;
+            int kernelSize = params.kernelSize > 0 ? params.kernelSize : 5;
+            int uniquenessRatio = params.uniquenessRatio >= 0 ? params.uniquenessRatio : 10;
+            int disp12MaxDiff = params.disp12MaxDiff > 0 ? params.disp12MaxDiff : 1;
+            int P1 = params.P1 > 0 ? params.P1 : 2, P2 = std::max(params.P2 > 0 ? params.P2 : 5, P1+1);
+            int width = disp1.cols, height = disp1.rows;
+            int minX1 = std::max(-maxD, 0), maxX1 = width + std::min(minD, 0);
+            int D = maxD - minD, width1 = maxX1 - minX1;
+            int INVALID_DISP = minD - 1, INVALID_DISP_SCALED = INVALID_DISP*DISP_SCALE;
+            int SW2 = kernelSize/2, SH2 = kernelSize/2;
+
+            if( minX1 >= maxX1 )
+            {
+                disp1 = Scalar::all(INVALID_DISP_SCALED);
+                return;
+            }
+            CV_Assert( D % 16 == 0 );
+
+            // hamDist holds numDisparities + 1 costs for every pixel of img1
+            const short* ham = (const short*)hamDist.data;
+            const int hamStep = params.numDisparities + 1, ww = img1.cols;
+            size_t costBufSize = (size_t)width1*D;
+            size_t totalBufSize = costBufSize*height*2*sizeof(CostType) + ALIGN;
+            if( buffer.empty() || !buffer.isContinuous() ||
+                buffer.cols*buffer.rows*buffer.elemSize() < totalBufSize )
+                buffer.create(1, (int)totalBufSize, CV_8U);
+            CostType* Cbuf = (CostType*)alignPtr(buffer.ptr(), ALIGN);
+            CostType* Sbuf = Cbuf + costBufSize*height;
+
+            // horizontal sums of the costs over the block, kept in S until C is built
+            parallel_for_(Range(0, height), [&](const Range& range)
+            {
+                AutoBuffer<int> _hsum(D);
+                int* hsum = _hsum.data();
+                for( int y = range.start; y < range.end; y++ )
+                {
+                    const short* hamRow = ham + (size_t)y*ww*hamStep;
+                    CostType* H = Sbuf + y*costBufSize;
+                    for( int d = 0; d < D; d++ )
+                        hsum[d] = 0;
+                    for( int x = -SW2; x <= SW2; x++ )
+                    {
+                        const short* h = hamRow + (std::min(std::max(x, 0), width1-1) + minX1)*hamStep;
+                        for( int d = 0; d < D; d++ )
+                            hsum[d] += h[d];
+                    }
+                    for( int x = 0; x < width1; x++ )
+                    {
+                        const short* hAdd = hamRow + (std::min(x + SW2 + 1, width1-1) + minX1)*hamStep;
+                        const short* hSub = hamRow + (std::max(x - SW2, 0) + minX1)*hamStep;
+                        for( int d = 0; d < D; d++ )
+                        {
+                            H[x*D + d] = saturate_cast<CostType>(hsum[d]);
+                            hsum[d] += hAdd[d] - hSub[d];
+                        }
+                    }
+                }
+            });
+
+            // C = P2 + vertical sums of the horizontal ones
+            parallel_for_(Range(0, width1), [&](const Range& range)
+            {
+                const int x0 = range.start*D, n = (range.end - range.start)*D;
+                AutoBuffer<int> _vsum(n);
+                int* vsum = _vsum.data();
+                for( int i = 0; i < n; i++ )
+                    vsum[i] = 0;
+                for( int k = -SH2; k <= SH2; k++ )
+                {
+                    const CostType* H = Sbuf + std::min(std::max(k, 0), height-1)*costBufSize + x0;
+                    for( int i = 0; i < n; i++ )
+                        vsum[i] += H[i];
+                }
+                for( int y = 0; y < height; y++ )
+                {
+                    CostType* C = Cbuf + y*costBufSize + x0;
+                    const CostType* hAdd = Sbuf + std::min(y + SH2 + 1, height-1)*costBufSize + x0;
+                    const CostType* hSub = Sbuf + std::max(y - SH2, 0)*costBufSize + x0;
+                    for( int i = 0; i < n; i++ )
+                    {
+                        C[i] = saturate_cast<CostType>(vsum[i] + P2);
+                        vsum[i] += hAdd[i] - hSub[i];
+                    }
+                }
+            });
+
+            // left to right and right to left paths, S = L_0 + L_1
+            parallel_for_(Range(0, height), [&](const Range& range)
+            {
+                // previous and current L_r, with the MAX_COST borders
+                AutoBuffer<CostType> _Lr((D + 2)*2);
+                CostType* Lr[2] = { _Lr.data() + 1, _Lr.data() + D + 3 };
+                Lr[0][-1] = Lr[0][D] = Lr[1][-1] = Lr[1][D] = MAX_COST;
+                for( int y = range.start; y < range.end; y++ )
+                {
+                    const CostType* C = Cbuf + y*costBufSize;
+                    CostType* S = Sbuf + y*costBufSize;
+                    for( int dir = 0; dir < 2; dir++ )
+                    {
+                        int x1 = dir == 0 ? 0 : width1-1, x2 = dir == 0 ? width1 : -1, dx = dir == 0 ? 1 : -1;
+                        int minL = 0;
+                        memset(Lr[0], 0, D*sizeof(CostType));
+                        for( int x = x1; x != x2; x += dx )
+                        {
+                            minL = updatePathCost(C + x*D, Lr[0], Lr[1], S + x*D, D, P1, minL + P2, dir == 1);
+                            std::swap(Lr[0], Lr[1]);
+                        }
+                    }
+                }
+            });
+
+            // top to bottom and bottom to top paths, S += L_2 + L_3
+            parallel_for_(Range(0, width1), [&](const Range& range)
+            {
+                const int n = range.end - range.start, D2 = D + 2;
+                AutoBuffer<CostType> _Lr(n*D2*2);
+                AutoBuffer<int> _minLr(n);
+                CostType* Lr[2] = { _Lr.data() + 1, _Lr.data() + n*D2 + 1 };
+                int* minLr = _minLr.data();
+                for( int dir = 0; dir < 2; dir++ )
+                {
+                    int y1 = dir == 0 ? 0 : height-1, y2 = dir == 0 ? height : -1, dy = dir == 0 ? 1 : -1;
+                    for( int i = 0; i < n; i++ )
+                    {
+                        CostType* L0 = Lr[0] + i*D2;
+                        CostType* L1 = Lr[1] + i*D2;
+                        memset(L0, 0, D*sizeof(CostType));
+                        L0[-1] = L0[D] = L1[-1] = L1[D] = MAX_COST;
+                        minLr[i] = 0;
+                    }
+                    for( int y = y1; y != y2; y += dy )
+                    {
+                        const CostType* C = Cbuf + y*costBufSize + range.start*D;
+                        CostType* S = Sbuf + y*costBufSize + range.start*D;
+                        for( int i = 0; i < n; i++ )
+                            minLr[i] = updatePathCost(C + i*D, Lr[0] + i*D2, Lr[1] + i*D2, S + i*D, D, P1, minLr[i] + P2, true);
+                        std::swap(Lr[0], Lr[1]);
+                    }
+                }
+            });
+
+            parallel_for_(Range(0, height), [&](const Range& range)
+            {
+                AutoBuffer<CostType> _disp2cost(width);
+                AutoBuffer<DispType> _disp2(width);
+                CostType* disp2cost = _disp2cost.data();
+                DispType* disp2ptr = _disp2.data();
+                for( int y = range.start; y < range.end; y++ )
+                {
+                    DispType* disp1ptr = disp1.ptr<DispType>(y);
+                    const CostType* S = Sbuf + y*costBufSize;
+                    for( int x = 0; x < width; x++ )
+                    {
+                        disp1ptr[x] = disp2ptr[x] = (DispType)INVALID_DISP_SCALED;
+                        disp2cost[x] = MAX_COST;
+                    }
+                    for( int x = width1 - 1; x >= 0; x-- )
+                    {
+                        const CostType* Sp = S + x*D;
+                        int minS = MAX_COST, bestDisp = -1, d;
+                        for( d = 0; d < D; d++ )
+                        {
+                            if( Sp[d] < minS )
+                            {
+                                minS = Sp[d];
+                                bestDisp = d;
+                            }
+                        }
+                        for( d = 0; d < D; d++ )
+                        {
+                            if( Sp[d]*(100 - uniquenessRatio) < minS*100 && std::abs(bestDisp - d) > 1 )
+                                break;
+                        }
+                        if( d < D )
+                            continue;
+                        d = bestDisp;
+                        int _x2 = x + minX1 - d - minD;
+                        if( disp2cost[_x2] > minS )
+                        {
+                            disp2cost[_x2] = (CostType)minS;
+                            disp2ptr[_x2] = (DispType)(d + minD);
+                        }
+                        d = interpolateDisparity(Sp, d, D, params.subpixelInterpolationMethod);
+                        disp1ptr[x + minX1] = (DispType)(d + minD*DISP_SCALE);
+                    }
+                    checkDisparityRow(disp1ptr, disp2ptr, minX1, maxX1, width, minD, disp12MaxDiff, INVALID_DISP_SCALED);
+                }
+            });
+        }
+
         class StereoBinarySGBMImpl CV_FINAL : public StereoBinarySGBM, public Matching
         {
         public:
@@ -686,7 +951,10 @@ namespace cv
 
                 hammingDistanceBlockMatching(censusImageLeft, censusImageRight, hamDist);
 
-                computeDisparityBinarySGBM( left, right, disp, params, buffer,hamDist);
+                if(params.mode == StereoBinarySGBM::MODE_HH4)
+                    computeDisparityBinarySGBM_HH4( left, disp, params, buffer, hamDist);
+                else
+                    computeDisparityBinarySGBM( left, right, disp, params, buffer,hamDist);
 
                 if(params.regionRemoval == CV_SPECKLE_REMOVAL_AVG_ALGORITHM)
                 {
@@ -41,7 +41,19 @@
 
 #include "test_precomp.hpp"
 
-namespace opencv_test { namespace {
+namespace opencv_test {
+
+void generateShiftedStereoPair(const Size &size, int shift, Mat &left, Mat &right)
+{
+    Mat noise(size.height, size.width + shift, CV_8UC1);
+    RNG rng(1234);
+    rng.fill(noise, RNG::UNIFORM, 0, 256);
+    GaussianBlur(noise, noise, Size(5, 5), 1.5);
+    noise(Rect(0, 0, size.width, size.height)).copyTo(left);
+    noise(Rect(shift, 0, size.width, size.height)).copyTo(right);
+}
+
+namespace {
 
 class CV_BlockMatchingTest : public cvtest::BaseTest
 {
@@ -232,5 +244,47 @@ void CV_SGBlockMatchingTest::run(int )
 TEST(block_matching_simple_test, accuracy) { CV_BlockMatchingTest test; test.safe_run(); }
 TEST(SG_block_matching_simple_test, accuracy) { CV_SGBlockMatchingTest test; test.safe_run(); }
 
+static Mat computeBinarySGBM(const Mat &left, const Mat &right, int numDisparities, int mode)
+{
+    Ptr<StereoBinarySGBM> sgbm = StereoBinarySGBM::create(0, numDisparities, 5);
+    sgbm->setBinaryKernelType(CV_DENSE_CENSUS);
+    sgbm->setMode(mode);
+    Mat disp;
+    sgbm->compute(left, right, disp);
+    return disp;
+}
+
+TEST(SG_block_matching_HH4, shifted_pair_accuracy)
+{
+    const int shift = 12, numDisparities = 32;
+    Mat left, right;
+    generateShiftedStereoPair(Size(320, 240), shift, left, right);
+
+    Mat dispHH4 = computeBinarySGBM(left, right, numDisparities, StereoBinarySGBM::MODE_HH4);
+    Mat dispHH = computeBinarySGBM(left, right, numDisparities, StereoBinarySGBM::MODE_HH);
+    ASSERT_EQ(CV_16S, dispHH4.type());
+    ASSERT_EQ(left.size(), dispHH4.size());
+
+    // skip the columns without a full disparity range and the kernel borders
+    const Rect roi(numDisparities + 8, 8, left.cols - numDisparities - 16, left.rows - 16);
+    const int tol = StereoBinarySGBM::DISP_SCALE;
+    int nearShift = 0, nearHH = 0;
+    for (int y = roi.y; y < roi.y + roi.height; y++)
+    {
+        const short *d4 = dispHH4.ptr<short>(y);
+        const short *d = dispHH.ptr<short>(y);
+        for (int x = roi.x; x < roi.x + roi.width; x++)
+        {
+            if (std::abs(d4[x] - shift * StereoBinarySGBM::DISP_SCALE) <= tol)
+                nearShift++;
+            if (std::abs(d4[x] - d[x]) <= tol)
+                nearHH++;
+        }
+    }
+    const double total = (double)roi.area();
+    EXPECT_GT(nearShift / total, 0.95);
+    EXPECT_GT(nearHH / total, 0.95);
+}
+
 
 }} // namespace
\ No newline at end of file
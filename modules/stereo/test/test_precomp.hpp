@@ -11,6 +11,9 @@
 
 namespace opencv_test {
 using namespace cv::stereo;
+
+// smooth random texture, seen by the right camera `shift` pixels further to the left
+void generateShiftedStereoPair(const Size &size, int shift, Mat &left, Mat &right);
 }
 
 #endif
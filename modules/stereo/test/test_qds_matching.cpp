@@ -0,0 +1,88 @@
+// This file is part of OpenCV project.
+// It is subject to the license terms in the LICENSE file found in the top-level directory
+// of this distribution and at http://opencv.org/license.html.
+#include "test_precomp.hpp"
+
+namespace opencv_test { namespace {
+
+static const int qdsShift = 12;
+
+static void runQuasiDenseStereo(const Mat &left, const Mat &right, int tileSize,
+                                std::vector<stereo::Match> &matches)
+{
+    Ptr<QuasiDenseStereo> stereo = QuasiDenseStereo::create(left.size());
+    stereo->Param.tileSize = tileSize;
+    stereo->process(left, right);
+    stereo->getDenseMatches(matches);
+}
+
+static double shiftedMatchesRatio(const std::vector<stereo::Match> &matches)
+{
+    int good = 0;
+    for (size_t i = 0; i < matches.size(); i++)
+    {
+        const Point d = matches[i].p0 - matches[i].p1;
+        if (std::abs(d.x - qdsShift) <= 1 && std::abs(d.y) <= 1)
+            good++;
+    }
+    return matches.empty() ? 0. : (double)good / matches.size();
+}
+
+TEST(QuasiDenseStereo_tiles, accuracy)
+{
+    const Size size(640, 480);
+    Mat left, right;
+    generateShiftedStereoPair(size, qdsShift, left, right);
+
+    std::vector<stereo::Match> global, tiled;
+    runQuasiDenseStereo(left, right, 0, global);
+    runQuasiDenseStereo(left, right, 64, tiled);
+
+    ASSERT_GT(global.size(), (size_t)size.area() / 2);
+    EXPECT_GT(tiled.size(), global.size() * 9 / 10);
+    EXPECT_GT(shiftedMatchesRatio(global), 0.95);
+    EXPECT_GT(shiftedMatchesRatio(tiled), 0.95);
+
+    // where both variants found a match, they should mostly agree
+    Mat_<Point2i> globalMap(size, Point2i(0, 0));
+    for (size_t i = 0; i < global.size(); i++)
+        globalMap(global[i].p0) = global[i].p1;
+    int common = 0, same = 0;
+    for (size_t i = 0; i < tiled.size(); i++)
+    {
+        const Point2i p1 = globalMap(tiled[i].p0);
+        if (p1 == Point2i(0, 0))
+            continue;
+        common++;
+        if (std::abs(p1.x - tiled[i].p1.x) <= 1 && std::abs(p1.y - tiled[i].p1.y) <= 1)
+            same++;
+    }
+    ASSERT_GT(common, 0);
+    EXPECT_GT((double)same / common, 0.95);
+}
+
+TEST(QuasiDenseStereo_tiles, thread_count_invariance)
+{
+    int nThreads = cv::getNumThreads();
+    if (nThreads == 1)
+        throw SkipTestException("Single thread environment");
+
+    Mat left, right;
+    generateShiftedStereoPair(Size(640, 480), qdsShift, left, right);
+
+    std::vector<stereo::Match> res, resRef;
+    cv::setNumThreads(nThreads);
+    runQuasiDenseStereo(left, right, 64, res);
+    cv::setNumThreads(1);
+    runQuasiDenseStereo(left, right, 64, resRef);
+    cv::setNumThreads(nThreads);
+
+    ASSERT_EQ(resRef.size(), res.size());
+    for (size_t i = 0; i < res.size(); i++)
+    {
+        ASSERT_EQ(resRef[i].p0, res[i].p0);
+        ASSERT_EQ(resRef[i].p1, res[i].p1);
+    }
+}
+
+}} // namespace
@@ -0,0 +1,54 @@
+// This file is part of OpenCV project.
+// It is subject to the license terms in the LICENSE file found in the top-level directory
+// of this distribution and at http://opencv.org/license.html.
+#include "perf_precomp.hpp"
+
+namespace opencv_test { namespace {
+
+typedef perf::TestBaseWithParam<Size> graycode;
+
+// the pattern as seen by a camera of the given size, shifted by shift pixels to the right
+static void acquirePattern(const vector<Mat>& pattern, const Size& camSize, int shift, vector<Mat>& acquired)
+{
+    Mat M = (Mat_<double>(2, 3) << 1, 0, shift, 0, 1, 0);
+    acquired.resize(pattern.size());
+    for (size_t i = 0; i < pattern.size(); i++)
+    {
+        Mat resized;
+        resize(pattern[i], resized, camSize, 0, 0, INTER_NEAREST);
+        warpAffine(resized, acquired[i], M, camSize, INTER_NEAREST, BORDER_REPLICATE);
+    }
+}
+
+PERF_TEST_P(graycode, decode, testing::Values(Size(1280, 720), Size(1920, 1080)))
+{
+    const Size camSize = GetParam();
+
+    Ptr<GrayCodePattern> graycode = GrayCodePattern::create(1024, 768);
+    vector<Mat> pattern;
+    graycode->generate(pattern);
+    Mat black, white;
+    graycode->getImagesForShadowMasks(black, white);
+    pattern.push_back(white);
+    pattern.push_back(black);
+
+    vector<vector<Mat> > acquired(2);
+    acquirePattern(pattern, camSize, 0, acquired[0]);
+    acquirePattern(pattern, camSize, 16, acquired[1]);
+
+    vector<Mat> whiteImages(2), blackImages(2);
+    for (int k = 0; k < 2; k++)
+    {
+        blackImages[k] = acquired[k].back();
+        acquired[k].pop_back();
+        whiteImages[k] = acquired[k].back();
+        acquired[k].pop_back();
+    }
+
+    Mat disparityMap;
+    TEST_CYCLE() graycode->decode(acquired, disparityMap, blackImages, whiteImages);
+
+    SANITY_CHECK_NOTHING();
+}
+
+}} // namespace
@@ -40,6 +40,7 @@
  //M*/
 
 #include "precomp.hpp"
+#include "opencv2/core/hal/intrin.hpp"
 
 namespace cv {
 namespace structured_light {
@@ -104,8 +105,53 @@ class CV_EXPORTS_W GrayCodePattern_Impl CV_FINAL : public GrayCodePattern
 
   // Converts a gray code sequence (~ binary number) to a decimal number
   int grayToDec( const std::vector<uchar>& gray ) const;
+
+  // Decodes the pattern images of a camera into projector pixel indices (x * height + y), -1 where decoding fails
+  void decodeProjIndices( const std::vector<Mat>& patternImages, const Mat& shadowMask, Mat& projIndices ) const;
 };
 
+// Decodes numBits consecutive gray code bit planes of row y, the first pattern image being firstImg,
+// into binary numbers. The planes are processed from the most significant one, each of them updating
+// the whole row: bit holds the running XOR of the gray code, dec the decoded number. Pixels whose
+// pattern and inverse intensities differ by less than threshold are flagged in err.
+static void grayCodeRowToDec( const std::vector<Mat>& patternImages, size_t firstImg, size_t numBits, int y,
+                              uchar threshold, ushort* dec, uchar* bit, uchar* err )
+{
+  const int width = patternImages[firstImg].cols;
+  memset( dec, 0, width * sizeof( dec[0] ) );
+  memset( bit, 0, width * sizeof( bit[0] ) );
+
+  for( size_t count = 0; count < numBits; count++ )
+  {
+    const uchar* pattern = patternImages[firstImg + count * 2].ptr<uchar>( y );
+    const uchar* inverse = patternImages[firstImg + count * 2 + 1].ptr<uchar>( y );
+    int x = 0;
+#if CV_SIMD128
+    const v_uint8x16 vthreshold = v_setall_u8( threshold ), one = v_setall_u8( 1 );
+    for( ; x <= width - 16; x += 16 )
+    {
+      v_uint8x16 val1 = v_load( pattern + x ), val2 = v_load( inverse + x );
+      v_uint8x16 b = v_load( bit + x ) ^ ( ( val1 > val2 ) & one );
+      v_store( bit + x, b );
+      v_store( err + x, v_load( err + x ) | ( v_absdiff( val1, val2 ) < vthreshold ) );
+
+      v_uint16x8 b0, b1;
+      v_expand( b, b0, b1 );
+      v_store( dec + x, ( v_load( dec + x ) << 1 ) | b0 );
+      v_store( dec + x + 8, ( v_load( dec + x + 8 ) << 1 ) | b1 );
+    }
+#endif
+    for( ; x < width; x++ )
+    {
+      int val1 = pattern[x], val2 = inverse[x];
+      bit[x] ^= ( uchar ) ( val1 > val2 );
+      if( std::abs( val1 - val2 ) < threshold )
+        err[x] = ( uchar ) 255;
+      dec[x] = ( ushort ) ( ( dec[x] << 1 ) | bit[x] );
+    }
+  }
+}
+
 /*
  *  GrayCodePattern
  */
@@ -216,6 +262,8 @@ bool GrayCodePattern_Impl::decode( const std::vector< std::vector<Mat> >& patter
 
   if( flags == DECODE_3D_UNDERWORLD )
   {
+    CV_Assert( acquired_pattern.size() >= 2 );
+
     // Computing shadows mask
     std::vector<Mat> shadowMasks;
     computeShadowMasks( blackImages, whitheImages, shadowMasks );
@@ -223,86 +271,63 @@ bool GrayCodePattern_Impl::decode( const std::vector< std::vector<Mat> >& patter
     int cam_width = acquired_pattern[0][0].cols;
     int cam_height = acquired_pattern[0][0].rows;
 
-    Point projPixel;
-
-    // Storage for the pixels of the two cams that correspond to the same pixel of the projector
-    std::vector<std::vector<std::vector<Point> > > camsPixels;
-    camsPixels.resize( acquired_pattern.size() );
+    Mat& disparityMap_ = *( Mat* ) disparityMap.getObj();
+    disparityMap_ = Mat( cam_height, cam_width, CV_64F, double( 0 ) );
 
-    // TODO: parallelize for (k and j)
-    for( size_t k = 0; k < acquired_pattern.size(); k++ )
+    // no pixel can be decoded
+    if( whiteThreshold > 255 )
+      return true;
+
+    // For every pixel of the two cams, the index of the corresponding projector pixel
+    Mat projIndices[2];
+    for( int k = 0; k < 2; k++ )
+      decodeProjIndices( acquired_pattern[k], shadowMasks[k], projIndices[k] );
+
+    // Number of pixels of each cam and sum of their x coordinates, for every projector pixel.
+    // The disparity only needs the mean x coordinate of the pixels sharing a projector pixel,
+    // so they are accumulated directly instead of being stored.
+    const int projSize = params.width * params.height;
+    std::vector<int> counts[2];
+    std::vector<int64> sumsX[2];
+    parallel_for_( Range( 0, 2 ), [&]( const Range& range )
     {
-      camsPixels[k].resize( params.height * params.width );
-      for( int i = 0; i < cam_width; i++ )
+      for( int k = range.start; k < range.end; k++ )
       {
-        for( int j = 0; j < cam_height; j++ )
+        counts[k].assign( projSize, 0 );
+        sumsX[k].assign( projSize, 0 );
+        for( int j = 0; j < projIndices[k].rows; j++ )
         {
-          //if the pixel is not shadowed, reconstruct
-          if( shadowMasks[k].at<uchar>( j, i ) )
+          const int* idx = projIndices[k].ptr<int>( j );
+          for( int i = 0; i < projIndices[k].cols; i++ )
           {
-            //for a (x,y) pixel of the camera returns the corresponding projector pixel by calculating the decimal number
-            bool error = getProjPixel( acquired_pattern[k], i, j, projPixel );
-
-            if( error )
+            if( idx[i] >= 0 )
             {
-              continue;
+              counts[k][idx[i]]++;
+              sumsX[k][idx[i]] += i;
             }
-
-            camsPixels[k][projPixel.x * params.height + projPixel.y].push_back( Point( i, j ) );
           }
         }
       }
-    }
-
-    std::vector<Point> cam1Pixs, cam2Pixs;
-
-    Mat& disparityMap_ = *( Mat* ) disparityMap.getObj();
-    disparityMap_ = Mat( cam_height, cam_width, CV_64F, double( 0 ) );
+    });
 
-    double number_of_pixels_cam1 = 0;
-    double number_of_pixels_cam2 = 0;
-
-    for( int i = 0; i < params.width; i++ )
+    parallel_for_( Range( 0, cam_height ), [&]( const Range& range )
     {
-      for( int j = 0; j < params.height; j++ )
+      for( int j = range.start; j < range.end; j++ )
       {
-        cam1Pixs = camsPixels[0][i * params.height + j];
-        cam2Pixs = camsPixels[1][i * params.height + j];
-
-        if( cam1Pixs.size() == 0 || cam2Pixs.size() == 0 )
-          continue;
-
-        Point p1;
-        Point p2;
-
-        double sump1x = 0;
-        double sump2x = 0;
-
-        number_of_pixels_cam1 += cam1Pixs.size();
-        number_of_pixels_cam2 += cam2Pixs.size();
-        for( int c1 = 0; c1 < (int) cam1Pixs.size(); c1++ )
-        {
-          p1 = cam1Pixs[c1];
-          sump1x += p1.x;
-        }
-        for( int c2 = 0; c2 < (int) cam2Pixs.size(); c2++ )
+        const int* idx = projIndices[0].ptr<int>( j );
+        double* disparity = disparityMap_.ptr<double>( j );
+        for( int i = 0; i < cam_width; i++ )
         {
-          p2 = cam2Pixs[c2];
-          sump2x += p2.x;
-        }
+          int p = idx[i];
+          if( p < 0 || counts[1][p] == 0 )
+            continue;
 
-        sump2x /= cam2Pixs.size();
-        sump1x /= cam1Pixs.size();
-        for( int c1 = 0; c1 < (int) cam1Pixs.size(); c1++ )
-        {
-          p1 = cam1Pixs[c1];
-          disparityMap_.at<double>( p1.y, p1.x ) = ( double ) (sump2x - sump1x);
+          double sump1x = ( double ) sumsX[0][p] / counts[0][p];
+          double sump2x = ( double ) sumsX[1][p] / counts[1][p];
+          disparity[i] = sump2x - sump1x;
         }
-
-        sump2x = 0;
-        sump1x = 0;
       }
-    }
+    });
 
     return true;
   }  // end if flags
@@ -318,6 +343,47 @@ void GrayCodePattern_Impl::computeNumberOfPatternImages()
   numOfPatternImages = 2 * numOfColImgs + 2 * numOfRowImgs;
 }
 
+// Decodes the pattern images of a camera into projector pixel indices, row by row
+void GrayCodePattern_Impl::decodeProjIndices( const std::vector<Mat>& patternImages, const Mat& shadowMask,
+                                              Mat& projIndices ) const
+{
+  CV_Assert( patternImages.size() >= numOfPatternImages );
+
+  const int cam_width = patternImages[0].cols;
+  const int cam_height = patternImages[0].rows;
+  const uchar threshold = ( uchar ) whiteThreshold;
+
+  projIndices.create( cam_height, cam_width, CV_32S );
+
+  parallel_for_( Range( 0, cam_height ), [&]( const Range& range )
+  {
+    AutoBuffer<ushort> decBuf( cam_width * 2 );
+    AutoBuffer<uchar> bitBuf( cam_width * 2 );
+    ushort* xDec = decBuf.data();
+    ushort* yDec = xDec + cam_width;
+    uchar* bit = bitBuf.data();
+    uchar* err = bit + cam_width;
+
+    for( int j = range.start; j < range.end; j++ )
+    {
+      memset( err, 0, cam_width );
+      grayCodeRowToDec( patternImages, 0, numOfColImgs, j, threshold, xDec, bit, err );
+      grayCodeRowToDec( patternImages, 2 * numOfColImgs, numOfRowImgs, j, threshold, yDec, bit, err );
+
+      const uchar* mask = shadowMask.ptr<uchar>( j );
+      int* idx = projIndices.ptr<int>( j );
+      for( int i = 0; i < cam_width; i++ )
+      {
+        //if the pixel is not shadowed and its code is valid, store the corresponding projector pixel
+        if( mask[i] && !err[i] && xDec[i] < params.width && yDec[i] < params.height )
+          idx[i] = xDec[i] * params.height + yDec[i];
+        else
+          idx[i] = -1;
+      }
+    }
+  });
+}
+
 // Returns the number of pattern images to project / decode
 size_t GrayCodePattern_Impl::getNumberOfPatternImages() const
 {
@@ -337,28 +403,31 @@ void GrayCodePattern_Impl::computeShadowMasks( InputArrayOfArrays blackImages, I
   int cam_width = whiteImages_[0].cols;
   int cam_height = whiteImages_[0].rows;
 
-  // TODO: parallelize for
-  for( int k = 0; k < (int) shadowMasks_.size(); k++ )
+  // a difference of at most 255 never exceeds larger thresholds
+  const uchar threshold = ( uchar ) std::min( blackThreshold, ( size_t ) 255 );
+
+  for( size_t k = 0; k < shadowMasks_.size(); k++ )
+    shadowMasks_[k].create( cam_height, cam_width, CV_8U );
+
+  parallel_for_( Range( 0, (int) shadowMasks_.size() * cam_height ), [&]( const Range& range )
   {
-    shadowMasks_[k] = Mat( cam_height, cam_width, CV_8U );
-    for( int i = 0; i < cam_width; i++ )
+    for( int r = range.start; r < range.end; r++ )
     {
-      for( int j = 0; j < cam_height; j++ )
-      {
-        double white = whiteImages_[k].at<uchar>( Point( i, j ) );
-        double black = blackImages_[k].at<uchar>( Point( i, j ) );
-
-        if( abs(white - black) > blackThreshold )
-        {
-          shadowMasks_[k].at<uchar>( Point( i, j ) ) = ( uchar ) 1;
-        }
-        else
-        {
-          shadowMasks_[k].at<uchar>( Point( i, j ) ) = ( uchar ) 0;
-        }
-      }
+      const int k = r / cam_height, j = r % cam_height;
+      const uchar* white = whiteImages_[k].ptr<uchar>( j );
+      const uchar* black = blackImages_[k].ptr<uchar>( j );
+      uchar* mask = shadowMasks_[k].ptr<uchar>( j );
+
+      int i = 0;
+#if CV_SIMD128
+      const v_uint8x16 vthreshold = v_setall_u8( threshold ), one = v_setall_u8( 1 );
+      for( ; i <= cam_width - 16; i += 16 )
+        v_store( mask + i, ( v_absdiff( v_load( white + i ), v_load( black + i ) ) > vthreshold ) & one );
+#endif
+      for( ; i < cam_width; i++ )
+        mask[i] = ( uchar ) ( std::abs( white[i] - black[i] ) > threshold ? 1 : 0 );
     }
-  }
+  });
 }
 
 // Generates the images needed for shadowMasks computation
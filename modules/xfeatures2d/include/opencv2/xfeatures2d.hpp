@@ -262,6 +262,27 @@ public:
      */
     virtual bool GetUnnormalizedDescriptor( double y, double x, int orientation, float* descriptor , double *H ) const = 0;
 
+    /** @brief Computes the smoothed gradient layers of an image.
+     *
+     * The layers are kept until the next image is processed, so that descriptors at many positions
+     * of a same image can be queried with GetDescriptors() or GetDescriptor() without processing the image again.
+     * @param image image to extract descriptors
+     */
+    virtual void setImage( InputArray image ) = 0;
+
+    /** @brief Computes the descriptors of keypoints of the image given to the last setImage() or compute() call.
+     * @param keypoints keypoints of interest within image
+     * @param descriptors resulted descriptors array, of descriptorType()
+     */
+    virtual void GetDescriptors( const std::vector<KeyPoint>& keypoints, OutputArray descriptors ) const = 0;
+
+    /** @brief Sets the type of the computed descriptors.
+     * @param type CV_32F (default) or CV_8U. CV_8U descriptors are the normalized float ones scaled by 255
+     * (by 255/0.154 with NRM_SIFT); they take 4 times less memory. CV_8U is rejected with NRM_NONE, whose
+     * values are not bounded.
+     */
+    virtual void setDescriptorType( int type ) = 0;
+
 };
 
 /** @brief Class implementing the MSD (*Maximal Self-Dissimilarity*) keypoint detector, described in @cite Tombari14.
@@ -852,6 +873,66 @@ public:
 
 };
 
+/**
+* @brief Collection of signatures searched with Signature Quadratic Form Distance.
+*       The centroids of all signatures are stored contiguously, one array per dimension,
+*       and the similarity of each signature with itself is computed once when it is added,
+*       so that queries only compute the similarities with the query signature.
+*       The signatures of the collection are processed in parallel.
+* @cite BeecksUS10
+*/
+class CV_EXPORTS_W PCTSignaturesSQFDDatabase : public Algorithm
+{
+public:
+
+    /**
+    * @brief Creates an empty collection using selected distance function,
+    *       similarity function and similarity function parameter.
+    * @param distanceFunction Distance function selector. Default: L2
+    *       Available: L0_25, L0_5, L1, L2, L2SQUARED, L5, L_INFINITY
+    * @param similarityFunction Similarity function selector. Default: HEURISTIC
+    *       Available: MINUS, GAUSSIAN, HEURISTIC
+    * @param similarityParameter Parameter of the similarity function.
+    */
+    CV_WRAP static Ptr<PCTSignaturesSQFDDatabase> create(
+        const int distanceFunction = 3,
+        const int similarityFunction = 2,
+        const float similarityParameter = 1.0f);
+
+    /**
+    * @brief Adds signatures to the collection. Signatures are identified by the order they were added in.
+    * @param signatures Vector of signatures computed by PCTSignatures.
+    */
+    CV_WRAP virtual void add(const std::vector<Mat>& signatures) = 0;
+
+    /** @brief Returns the number of signatures in the collection. */
+    CV_WRAP virtual int getSignatureCount() const = 0;
+
+    /**
+    * @brief Computes Signature Quadratic Form Distance between the query signature
+    *       and each signature of the collection.
+    * @param querySignature The signature to measure distance of the collection signatures from.
+    * @param distances Output vector of measured distances, in the order the signatures were added.
+    */
+    CV_WRAP virtual void computeQuadraticFormDistances(
+        const Mat& querySignature,
+        std::vector<float>& distances) const = 0;
+
+    /**
+    * @brief Finds the signatures of the collection closest to the query signature.
+    * @param querySignature The signature to search for.
+    * @param k Number of signatures to find.
+    * @param indices Output vector of the indices of the closest signatures, closest first.
+    * @param distances Output vector of their distances to the query signature.
+    */
+    CV_WRAP virtual void search(
+        const Mat& querySignature,
+        int k,
+        CV_OUT std::vector<int>& indices,
+        CV_OUT std::vector<float>& distances) const = 0;
+
+};
+
 /**
 * @brief Elliptic region around an interest point.
 */
@@ -30,4 +30,49 @@ PERF_TEST_P(daisy, extract, testing::Values(DAISY_IMAGES))
     SANITY_CHECK_NOTHING();
 }
 
+CV_ENUM(DaisyDescriptorType, CV_32F, CV_8U)
+
+typedef perf::TestBaseWithParam<tuple<std::string, DaisyDescriptorType> > daisy_type;
+
+PERF_TEST_P(daisy_type, extract_dense, testing::Combine(testing::Values(DAISY_IMAGES), DaisyDescriptorType::all()))
+{
+    string filename = getDataPath(get<0>(GetParam()));
+    Mat frame = imread(filename, IMREAD_GRAYSCALE);
+    ASSERT_FALSE(frame.empty()) << "Unable to load source image " << filename;
+
+    declare.in(frame).time(90);
+
+    Ptr<DAISY> descriptor = DAISY::create();
+    descriptor->setDescriptorType(get<1>(GetParam()));
+
+    Mat descriptors;
+    TEST_CYCLE() descriptor->compute(frame, descriptors);
+
+    SANITY_CHECK_NOTHING();
+}
+
+PERF_TEST_P(daisy_type, extract_cached, testing::Combine(testing::Values(DAISY_IMAGES), DaisyDescriptorType::all()))
+{
+    string filename = getDataPath(get<0>(GetParam()));
+    Mat frame = imread(filename, IMREAD_GRAYSCALE);
+    ASSERT_FALSE(frame.empty()) << "Unable to load source image " << filename;
+
+    // dense grid of queries, as issued by a matcher sweeping the image
+    vector<KeyPoint> points;
+    for (int y = 0; y < frame.rows; y += 4)
+        for (int x = 0; x < frame.cols; x += 4)
+            points.push_back(KeyPoint((float)x, (float)y, 1.f));
+
+    declare.in(frame);
+
+    Ptr<DAISY> descriptor = DAISY::create();
+    descriptor->setDescriptorType(get<1>(GetParam()));
+    descriptor->setImage(frame);
+
+    Mat descriptors;
+    TEST_CYCLE() descriptor->GetDescriptors(points, descriptors);
+
+    SANITY_CHECK_NOTHING();
+}
+
 }} // namespace
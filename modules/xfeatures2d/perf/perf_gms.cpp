@@ -0,0 +1,61 @@
+// This file is part of OpenCV project.
+// It is subject to the license terms in the LICENSE file found in the top-level directory
+// of this distribution and at http://opencv.org/license.html.
+#include "perf_precomp.hpp"
+
+namespace opencv_test { namespace {
+
+typedef tuple<int, bool, bool> GMSParams;
+typedef perf::TestBaseWithParam<GMSParams> gms;
+
+// putative matches between two 640x480 views related by a rotation and a scale change,
+// 70% of them are outliers
+static void generateMatches(int numberMatches, vector<KeyPoint>& keypoints1, vector<KeyPoint>& keypoints2,
+                            vector<DMatch>& matches)
+{
+    RNG rng(1234);
+    const Size size(640, 480);
+    const float angle = (float)(CV_PI / 6), scale = 0.8f;
+    const float c = scale * std::cos(angle), s = scale * std::sin(angle);
+
+    keypoints1.clear();
+    keypoints2.clear();
+    matches.clear();
+    for (int i = 0; i < numberMatches; i++)
+    {
+        Point2f p1(rng.uniform(0.f, (float)size.width), rng.uniform(0.f, (float)size.height));
+        Point2f p2;
+        if (rng.uniform(0.f, 1.f) < 0.3f)
+        {
+            Point2f d = p1 - Point2f(size.width / 2.f, size.height / 2.f);
+            p2 = Point2f(c * d.x - s * d.y, s * d.x + c * d.y) + Point2f(size.width / 2.f, size.height / 2.f);
+            p2 += Point2f(rng.uniform(-2.f, 2.f), rng.uniform(-2.f, 2.f));
+            p2.x = std::min(std::max(p2.x, 0.f), size.width - 1.f);
+            p2.y = std::min(std::max(p2.y, 0.f), size.height - 1.f);
+        }
+        else
+            p2 = Point2f(rng.uniform(0.f, (float)size.width), rng.uniform(0.f, (float)size.height));
+
+        keypoints1.push_back(KeyPoint(p1, 1.f));
+        keypoints2.push_back(KeyPoint(p2, 1.f));
+        matches.push_back(DMatch(i, i, 0.f));
+    }
+}
+
+PERF_TEST_P(gms, match, testing::Combine(testing::Values(10000, 100000), testing::Bool(), testing::Bool()))
+{
+    const int numberMatches = get<0>(GetParam());
+    const bool withRotation = get<1>(GetParam());
+    const bool withScale = get<2>(GetParam());
+
+    vector<KeyPoint> keypoints1, keypoints2;
+    vector<DMatch> matches, matchesGMS;
+    generateMatches(numberMatches, keypoints1, keypoints2, matches);
+
+    TEST_CYCLE() matchGMS(Size(640, 480), Size(640, 480), keypoints1, keypoints2, matches, matchesGMS,
+                          withRotation, withScale);
+
+    SANITY_CHECK_NOTHING();
+}
+
+}} // namespace
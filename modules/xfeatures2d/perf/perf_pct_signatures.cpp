@@ -0,0 +1,47 @@
+// This file is part of OpenCV project.
+// It is subject to the license terms in the LICENSE file found in the top-level directory
+// of this distribution and at http://opencv.org/license.html.
+#include "perf_precomp.hpp"
+
+namespace opencv_test { namespace {
+
+static std::vector<Mat> randomSignatures(int count)
+{
+    RNG rng(0);
+    std::vector<Mat> signatures;
+    for (int i = 0; i < count; i++)
+    {
+        Mat signature(rng.uniform(20, 60), 8, CV_32F);
+        rng.fill(signature, RNG::UNIFORM, 0.f, 1.f);
+        signatures.push_back(signature);
+    }
+    return signatures;
+}
+
+typedef perf::TestBaseWithParam<int> pct_sqfd;
+
+PERF_TEST_P(pct_sqfd, computeQuadraticFormDistances, testing::Values(1000, 10000))
+{
+    std::vector<Mat> signatures = randomSignatures(GetParam());
+    Ptr<PCTSignaturesSQFD> sqfd = PCTSignaturesSQFD::create();
+
+    std::vector<float> distances;
+    TEST_CYCLE() sqfd->computeQuadraticFormDistances(signatures[0], signatures, distances);
+
+    SANITY_CHECK_NOTHING();
+}
+
+PERF_TEST_P(pct_sqfd, database_search, testing::Values(1000, 10000))
+{
+    std::vector<Mat> signatures = randomSignatures(GetParam());
+    Ptr<PCTSignaturesSQFDDatabase> database = PCTSignaturesSQFDDatabase::create();
+    database->add(signatures);
+
+    std::vector<int> indices;
+    std::vector<float> distances;
+    TEST_CYCLE() database->search(signatures[0], 10, indices, distances);
+
+    SANITY_CHECK_NOTHING();
+}
+
+}} // namespace
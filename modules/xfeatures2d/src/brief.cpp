@@ -73,7 +73,7 @@ public:
     virtual void compute(InputArray image, std::vector<KeyPoint>& keypoints, OutputArray descriptors) CV_OVERRIDE;
 
 protected:
-    typedef void(*PixelTestFn)(InputArray, const std::vector<KeyPoint>&, OutputArray, bool use_orientation );
+    typedef void(*PixelTestFn)(const Mat& sum, const std::vector<KeyPoint>&, Mat& descriptors, bool use_orientation, const Range& range );
 
     int bytes_;
     bool use_orientation_;
@@ -107,13 +107,12 @@ inline int smoothedSum(const Mat& sum, const KeyPoint& pt, int y, int x, bool us
            + sum.at<int>(img_y - HALF_KERNEL, img_x - HALF_KERNEL);
 }
 
-static void pixelTests16(InputArray _sum, const std::vector<KeyPoint>& keypoints, OutputArray _descriptors, bool use_orientation )
+static void pixelTests16(const Mat& sum, const std::vector<KeyPoint>& keypoints, Mat& descriptors, bool use_orientation, const Range& range)
 {
     Matx21f R;
-    Mat sum = _sum.getMat(), descriptors = _descriptors.getMat();
-    for (size_t i = 0; i < keypoints.size(); ++i)
+    for (int i = range.start; i < range.end; ++i)
     {
-        uchar* desc = descriptors.ptr(static_cast<int>(i));
+        uchar* desc = descriptors.ptr(i);
         const KeyPoint& pt = keypoints[i];
         if ( use_orientation )
         {
@@ -127,13 +126,12 @@ static void pixelTests16(InputArray _sum, const std::vector<KeyPoint>& keypoints
     }
 }
 
-static void pixelTests32(InputArray _sum, const std::vector<KeyPoint>& keypoints, OutputArray _descriptors, bool use_orientation)
+static void pixelTests32(const Mat& sum, const std::vector<KeyPoint>& keypoints, Mat& descriptors, bool use_orientation, const Range& range)
 {
     Matx21f R;
-    Mat sum = _sum.getMat(), descriptors = _descriptors.getMat();
-    for (size_t i = 0; i < keypoints.size(); ++i)
+    for (int i = range.start; i < range.end; ++i)
     {
-        uchar* desc = descriptors.ptr(static_cast<int>(i));
+        uchar* desc = descriptors.ptr(i);
         const KeyPoint& pt = keypoints[i];
         if ( use_orientation )
         {
@@ -147,13 +145,12 @@ static void pixelTests32(InputArray _sum, const std::vector<KeyPoint>& keypoints
     }
 }
 
-static void pixelTests64(InputArray _sum, const std::vector<KeyPoint>& keypoints, OutputArray _descriptors, bool use_orientation)
+static void pixelTests64(const Mat& sum, const std::vector<KeyPoint>& keypoints, Mat& descriptors, bool use_orientation, const Range& range)
 {
     Matx21f R;
-    Mat sum = _sum.getMat(), descriptors = _descriptors.getMat();
-    for (size_t i = 0; i < keypoints.size(); ++i)
+    for (int i = range.start; i < range.end; ++i)
     {
-        uchar* desc = descriptors.ptr(static_cast<int>(i));
+        uchar* desc = descriptors.ptr(i);
         const KeyPoint& pt = keypoints[i];
         if ( use_orientation )
         {
@@ -250,7 +247,13 @@ void BriefDescriptorExtractorImpl::compute(InputArray image,
 
     descriptors.create((int)keypoints.size(), bytes_, CV_8U);
     descriptors.setTo(Scalar::all(0));
-    test_fn_(sum, keypoints, descriptors, use_orientation_);
+    Mat desc = descriptors.getMat();
+
+    // keypoints are independent, each range fills its own descriptor rows
+    parallel_for_(Range(0, (int)keypoints.size()), [&](const Range& range)
+    {
+        test_fn_(sum, keypoints, desc, use_orientation_, range);
+    });
 }
 
 }
@@ -110,7 +110,7 @@ public:
     };
 
     /** returns the descriptor type */
-    virtual int descriptorType() const CV_OVERRIDE { return CV_32F; }
+    virtual int descriptorType() const CV_OVERRIDE { return m_descriptor_type; }
 
     /** returns the default norm type */
     virtual int defaultNorm() const CV_OVERRIDE { return NORM_L2; }
@@ -169,6 +169,22 @@ public:
      */
     virtual bool GetUnnormalizedDescriptor( double y, double x, int orientation, float* descriptor, double* H ) const CV_OVERRIDE;
 
+    /**
+     * @param image image to extract descriptors
+     */
+    virtual void setImage( InputArray image ) CV_OVERRIDE;
+
+    /**
+     * @param keypoints of interest within image
+     * @param descriptors resulted descriptors array
+     */
+    virtual void GetDescriptors( const std::vector<KeyPoint>& keypoints, OutputArray descriptors ) const CV_OVERRIDE;
+
+    /**
+     * @param type CV_32F or CV_8U
+     */
+    virtual void setDescriptorType( int type ) CV_OVERRIDE;
+
 protected:
 
     /*
@@ -194,6 +210,9 @@ protected:
     // the size of the descriptor vector
     int m_descriptor_size;
 
+    // type of the output descriptors, CV_32F or CV_8U
+    int m_descriptor_type;
+
     // the number of grid locations
     int m_grid_point_number;
 
@@ -245,6 +264,9 @@ protected:
     // Holds the oriented coordinates (y,x) of the grid points of the region.
     Mat m_oriented_grid_points;
 
+    // single precision copy of m_oriented_grid_points for the float sampling path
+    Mat m_oriented_grid_points_f;
+
     // holds the gaussian sigmas for radius quantizations for an incremental
     // application
     Mat m_cube_sigmas;
@@ -317,8 +339,11 @@ private:
     // histograms are going to be computed according to the given parameters.
     inline void compute_oriented_grid_points();
 
-    // applies one of the normalizations (partial,full,sift) to the desciptors.
-    inline void normalize_descriptors( Mat* m_dense_descriptors );
+    // computes the unnormalized descriptor at (y,x) in single precision; the descriptor must be zeroed
+    inline void get_unnormalized_descriptor_f( float y, float x, int orientation, float* descriptor ) const;
+
+    // normalizes (if asked) a descriptor and stores it as m_descriptor_type
+    inline void store_descriptor( float* descriptor, uchar* dst, bool normalize ) const;
 
     inline void update_selected_cubes();
 
@@ -347,6 +372,7 @@ inline void DAISY_Impl::release_auxiliary()
     m_cube_sigmas.release();
     m_grid_points.release();
     m_oriented_grid_points.release();
+    m_oriented_grid_points_f.release();
 }
 
 static int filter_size( double sigma, double factor )
@@ -361,7 +387,7 @@ static int filter_size( double sigma, double factor )
 }
 
 // transform a point via the homography
-static void pt_H( double* H, double x, double y, double &u, double &v )
+static void pt_H( const double* H, double x, double y, double &u, double &v )
 {
     double kxp = H[0]*x + H[1]*y + H[2];
     double kyp = H[3]*x + H[4]*y + H[5];
@@ -572,6 +598,22 @@ static void normalize_descriptor( float* desc, const DAISY::NormalizationType nr
         CV_Error( Error::StsInternal, "No such normalization" );
 }
 
+// upper bound of the normalized descriptor values, 0 if they are not bounded
+static float normalized_descriptor_bound( const DAISY::NormalizationType nrm_type )
+{
+    switch( nrm_type )
+    {
+      case DAISY::NRM_PARTIAL:
+      case DAISY::NRM_FULL:
+        return 1.f;
+      case DAISY::NRM_SIFT:
+        // every normalize_sift_way iteration ends with the clipping
+        return 0.154f;
+      default:
+        return 0.f;
+    }
+}
+
 static void ni_get_histogram( float* histogram, const int y, const int x, const int shift, const Mat* hcube )
 {
 
@@ -658,6 +700,64 @@ static void i_get_histogram( float* histogram, const double y, const double x, c
     else                     ti_get_histogram( histogram, y, x,  shift  , hcube );
 }
 
+// single precision versions of bi_get_histogram, ti_get_histogram and i_get_histogram
+static void bi_get_histogram_f( float* histogram, const float y, const float x, const int shift, const Mat& hcube )
+{
+    int mnx = int( x );
+    int mny = int( y );
+    int _hist_th_q_no = hcube.size[2];
+    if( mnx >= hcube.size[1]-2  || mny >= hcube.size[0]-2 )
+    {
+      memset(histogram, 0, sizeof(float)*_hist_th_q_no);
+      return;
+    }
+
+    // A C --> pixel positions
+    // B D
+    const float* A = hcube.ptr<float>( mny, mnx );
+    const float* B = A + hcube.step[0]/sizeof(float);
+    const float* C = A + _hist_th_q_no;
+    const float* D = B + _hist_th_q_no;
+
+    float alpha = mnx+1-x;
+    float beta  = mny+1-y;
+
+    float w0 = alpha * beta;
+    float w1 = beta - w0;             // (1-alpha)*beta;
+    float w2 = alpha - w0;            // (1-beta)*alpha;
+    float w3 = 1 + w0 - alpha - beta; // (1-beta)*(1-alpha);
+
+    for( int h=0; h<_hist_th_q_no; h++ )
+    {
+      int hi = h+shift;
+      if( hi >= _hist_th_q_no ) hi -= _hist_th_q_no;
+      histogram[h] = w0 * A[hi] + w1 * C[hi] + w2 * B[hi] + w3 * D[hi];
+    }
+}
+
+static void ti_get_histogram_f( float* histogram, const float y, const float x, const float shift, const Mat& hcube )
+{
+    int ishift = int( shift );
+    float layer_alpha  = shift - ishift;
+
+    float thist[MAX_CUBE_NO];
+    bi_get_histogram_f( thist, y, x, ishift, hcube );
+
+    int _hist_th_q_no = hcube.size[2];
+    for( int h=0; h<_hist_th_q_no-1; h++ )
+      histogram[h] = (1-layer_alpha)*thist[h]+layer_alpha*thist[h+1];
+    histogram[_hist_th_q_no-1] = (1-layer_alpha)*thist[_hist_th_q_no-1]+layer_alpha*thist[0];
+}
+
+static void i_get_histogram_f( float* histogram, const float y, const float x, const float shift, const Mat& hcube )
+{
+    int ishift = (int)shift;
+    float fshift = shift-ishift;
+    if     ( fshift < 0.01f ) bi_get_histogram_f( histogram, y, x, ishift  , hcube );
+    else if( fshift > 0.99f ) bi_get_histogram_f( histogram, y, x, ishift+1, hcube );
+    else                      ti_get_histogram_f( histogram, y, x,  shift  , hcube );
+}
+
 static void ni_get_descriptor( const double y, const double x, const int orientation, float* descriptor, const std::vector<Mat>* layers,
                                const Mat* _oriented_grid_points, const double* _orientation_shift_table, const int _th_q_no )
 {
@@ -746,7 +846,7 @@ static void i_get_descriptor( const double y, const double x, const int orientat
     }
 }
 
-static bool ni_get_descriptor_h( const double y, const double x, const int orientation, double* H, float* descriptor, const std::vector<Mat>* layers,
+static bool ni_get_descriptor_h( const double y, const double x, const int orientation, const double* H, float* descriptor, const std::vector<Mat>* layers,
                                  const Mat& _cube_sigmas, const Mat* _grid_points, const double* _orientation_shift_table, const int _th_q_no )
 {
     CV_Assert( orientation >= 0 && orientation < 360 );
@@ -813,7 +913,7 @@ static bool ni_get_descriptor_h( const double y, const double x, const int orien
     return true;
 }
 
-static bool i_get_descriptor_h( const double y, const double x, const int orientation, double* H, float* descriptor, const std::vector<Mat>* layers,
+static bool i_get_descriptor_h( const double y, const double x, const int orientation, const double* H, float* descriptor, const std::vector<Mat>* layers,
                                 const Mat _cube_sigmas, const Mat* _grid_points, const double* _orientation_shift_table, const int _th_q_no )
 {
     CV_Assert( orientation >= 0 && orientation < 360 );
@@ -895,7 +995,7 @@ static void get_descriptor( const double y, const double x, const int orientatio
     normalize_descriptor( descriptor, m_nrm_type, m_grid_point_number, m_hist_th_q_no, m_descriptor_size );
 }
 
-static bool get_unnormalized_descriptor_h( const double y, const double x, const int orientation, float* descriptor, double* H,
+static bool get_unnormalized_descriptor_h( const double y, const double x, const int orientation, float* descriptor, const double* H,
             const std::vector<Mat>* m_smoothed_gradient_layers, const Mat& m_cube_sigmas,
             const Mat* m_grid_points, const double* m_orientation_shift_table, const int m_th_q_no, const bool m_enable_interpolation )
 
@@ -908,7 +1008,7 @@ static bool get_unnormalized_descriptor_h( const double y, const double x, const
                                   m_grid_points, m_orientation_shift_table, m_th_q_no );
 }
 
-static bool get_descriptor_h( const double y, const double x, const int orientation, float* descriptor, double* H,
+static bool get_descriptor_h( const double y, const double x, const int orientation, float* descriptor, const double* H,
             const std::vector<Mat>* m_smoothed_gradient_layers, const Mat& m_cube_sigmas,
             const Mat* m_grid_points, const double* m_orientation_shift_table, const int m_th_q_no,
             const int m_hist_th_q_no, const int m_grid_point_number, const int m_descriptor_size,
@@ -957,6 +1057,108 @@ bool DAISY_Impl::GetUnnormalizedDescriptor( double y, double x, int orientation,
                                  m_enable_interpolation );
 }
 
+inline void DAISY_Impl::get_unnormalized_descriptor_f( float y, float x, int orientation, float* descriptor ) const
+{
+    if( !m_enable_interpolation )
+    {
+      ni_get_descriptor( y, x, orientation, descriptor, &m_smoothed_gradient_layers,
+                         &m_oriented_grid_points, m_orientation_shift_table, m_th_q_no );
+      return;
+    }
+
+    // same sampling as i_get_descriptor, without double precision nor generic Mat accessors
+    const Mat& first = m_smoothed_gradient_layers[0];
+    CV_Assert( y >= 0 && y < first.size[0] );
+    CV_Assert( x >= 0 && x < first.size[1] );
+    CV_Assert( orientation >= 0 && orientation < 360 );
+
+    const float width = (float)(first.size[1]-1), height = (float)(first.size[0]-1);
+    const float shift = (float)m_orientation_shift_table[orientation];
+
+    i_get_histogram_f( descriptor, y, x, shift, m_smoothed_gradient_layers[g_selected_cubes[0]] );
+
+    const float* grid = m_oriented_grid_points_f.ptr<float>( orientation );
+
+    // petals of the flower
+    for( int r=0; r<m_rad_q_no; r++ )
+    {
+      int rdt = r*m_th_q_no+1;
+      for( int region=rdt; region<rdt+m_th_q_no; region++ )
+      {
+         float yy = y + grid[2*region    ];
+         float xx = x + grid[2*region + 1];
+
+         // same test as Point2f::inside( Rect(0, 0, width, height) )
+         if( !( xx >= 0 && xx < width && yy >= 0 && yy < height ) )
+           continue;
+
+         i_get_histogram_f( descriptor + region*m_hist_th_q_no, yy, xx, shift, m_smoothed_gradient_layers[r] );
+      }
+    }
+}
+
+inline void DAISY_Impl::store_descriptor( float* descriptor, uchar* dst, bool normalize ) const
+{
+    if( normalize )
+      normalize_descriptor( descriptor, m_nrm_type, m_grid_point_number, m_hist_th_q_no, m_descriptor_size );
+
+    if( m_descriptor_type == CV_32F )
+    {
+      memcpy( dst, descriptor, sizeof(float)*m_descriptor_size );
+      return;
+    }
+
+    const float scale = 255.f / normalized_descriptor_bound( m_nrm_type );
+    for( int i=0; i<m_descriptor_size; i++ )
+      dst[i] = saturate_cast<uchar>( descriptor[i] * scale );
+}
+
+void DAISY_Impl::GetDescriptors( const std::vector<KeyPoint>& keypoints, OutputArray _descriptors ) const
+{
+    CV_Assert( !m_smoothed_gradient_layers.empty() );
+
+    // get homography
+    Mat H = m_h_matrix;
+
+    // convert to double if case
+    if ( H.depth() != CV_64F )
+        H.convertTo( H, CV_64F );
+
+    // allocate array
+    _descriptors.create( (int) keypoints.size(), m_descriptor_size, m_descriptor_type );
+    Mat descriptors = _descriptors.getMat();
+
+    // keypoints are independent
+    parallel_for_( Range(0, (int) keypoints.size()), [&]( const Range& range )
+    {
+      std::vector<float> buffer( m_descriptor_size );
+      float* descriptor = &buffer[0];
+      for( int k = range.start; k < range.end; k++ )
+      {
+        std::fill( buffer.begin(), buffer.end(), 0.f );
+        int orientation = m_use_orientation ? (int) keypoints[k].angle : 0;
+        bool valid = true;
+        if( H.empty() )
+          get_unnormalized_descriptor_f( keypoints[k].pt.y, keypoints[k].pt.x, orientation, descriptor );
+        else
+          valid = get_unnormalized_descriptor_h( keypoints[k].pt.y, keypoints[k].pt.x, orientation, descriptor,
+                                                 H.ptr<double>(), &m_smoothed_gradient_layers, m_cube_sigmas,
+                                                 &m_grid_points, m_orientation_shift_table, m_th_q_no,
+                                                 m_enable_interpolation );
+        // out of image descriptors are left unnormalized as GetDescriptor does
+        store_descriptor( descriptor, descriptors.ptr( k ), valid );
+      }
+    } );
+}
+
+void DAISY_Impl::setDescriptorType( int type )
+{
+    CV_Assert( type == CV_32F || type == CV_8U );
+    if( type == CV_8U && normalized_descriptor_bound( m_nrm_type ) == 0.f )
+        CV_Error( Error::StsBadArg, "CV_8U DAISY descriptors need NRM_PARTIAL, NRM_FULL or NRM_SIFT normalization" );
+    m_descriptor_type = type;
+}
+
 inline void DAISY_Impl::compute_grid_points()
 {
     double r_step = m_rad / (double)m_rad_q_no;
@@ -984,110 +1186,38 @@ inline void DAISY_Impl::compute_grid_points()
     compute_oriented_grid_points();
 }
 
-struct ComputeDescriptorsInvoker : ParallelLoopBody
-{
-    ComputeDescriptorsInvoker( Mat* _descriptors, Mat* _image, Rect* _roi,
-                               std::vector<Mat>* _layers, Mat* _orientation_map,
-                               Mat* _oriented_grid_points, double* _orientation_shift_table,
-                               int _th_q_no, bool _enable_interpolation )
-    {
-      x_off = _roi->x;
-      x_end = _roi->x + _roi->width;
-      image = _image;
-      layers = _layers;
-      th_q_no = _th_q_no;
-      descriptors = _descriptors;
-      orientation_map = _orientation_map;
-      enable_interpolation = _enable_interpolation;
-      oriented_grid_points = _oriented_grid_points;
-      orientation_shift_table = _orientation_shift_table;
-    }
-
-    void operator ()(const cv::Range& range) const CV_OVERRIDE
-    {
-      int index, orientation;
-      for (int y = range.start; y < range.end; ++y)
-      {
-        for( int x = x_off; x < x_end; x++ )
-        {
-          index = y*image->cols + x;
-          orientation = 0;
-          if( !orientation_map->empty() )
-              orientation = (int) orientation_map->at<ushort>( y, x );
-          if( !( orientation >= 0 && orientation < g_grid_orientation_resolution ) )
-              orientation = 0;
-          get_unnormalized_descriptor( y, x, orientation, descriptors->ptr<float>( index ),
-                                       layers, oriented_grid_points, orientation_shift_table,
-                                       th_q_no, enable_interpolation );
-        }
-      }
-    }
-
-    int th_q_no;
-    int x_off, x_end;
-    std::vector<Mat>* layers;
-    Mat *descriptors;
-    Mat *orientation_map;
-    bool enable_interpolation;
-    double* orientation_shift_table;
-    Mat *image, *oriented_grid_points;
-};
-
 // Computes the descriptor by sampling convoluted orientation maps.
 inline void DAISY_Impl::compute_descriptors( Mat* m_dense_descriptors )
 {
     int y_off = m_roi.y;
     int y_end = m_roi.y + m_roi.height;
+    int x_off = m_roi.x;
+    int x_end = m_roi.x + m_roi.width;
 
     if( m_scale_invariant    ) compute_scales();
     if( m_rotation_invariant ) compute_orientations();
 
-    m_dense_descriptors->setTo( Scalar(0) );
-
-    parallel_for_( Range(y_off, y_end),
-        ComputeDescriptorsInvoker( m_dense_descriptors, &m_image, &m_roi, &m_smoothed_gradient_layers,
-                                   &m_orientation_map, &m_oriented_grid_points, m_orientation_shift_table,
-                                   m_th_q_no, m_enable_interpolation )
-    );
-
-}
-
-struct NormalizeDescriptorsInvoker : ParallelLoopBody
-{
-    NormalizeDescriptorsInvoker( Mat* _descriptors, DAISY::NormalizationType _nrm_type, int _grid_point_number,
-                                 int _hist_th_q_no, int _descriptor_size )
-    {
-      descriptors = _descriptors;
-      nrm_type = _nrm_type;
-      grid_point_number = _grid_point_number;
-      hist_th_q_no = _hist_th_q_no;
-      descriptor_size = _descriptor_size;
-    }
-
-    void operator ()(const cv::Range& range) const CV_OVERRIDE
+    // sample, normalize and store each descriptor in one pass
+    parallel_for_( Range(y_off, y_end), [&]( const Range& range )
     {
-      for (int d = range.start; d < range.end; ++d)
+      std::vector<float> buffer( m_descriptor_size );
+      float* descriptor = &buffer[0];
+      for( int y = range.start; y < range.end; ++y )
       {
-        normalize_descriptor( descriptors->ptr<float>(d), nrm_type,
-                              grid_point_number, hist_th_q_no, descriptor_size );
+        for( int x = x_off; x < x_end; x++ )
+        {
+          int index = (y - y_off)*m_roi.width + (x - x_off);
+          int orientation = 0;
+          if( !m_orientation_map.empty() )
+              orientation = (int) m_orientation_map.at<ushort>( y, x );
+          if( !( orientation >= 0 && orientation < g_grid_orientation_resolution ) )
+              orientation = 0;
+          std::fill( buffer.begin(), buffer.end(), 0.f );
+          get_unnormalized_descriptor_f( (float)y, (float)x, orientation, descriptor );
+          store_descriptor( descriptor, m_dense_descriptors->ptr( index ), true );
+        }
       }
-    }
-
-    Mat *descriptors;
-    DAISY::NormalizationType nrm_type;
-    int grid_point_number;
-    int hist_th_q_no;
-    int descriptor_size;
-};
-
-inline void DAISY_Impl::normalize_descriptors( Mat* m_dense_descriptors )
-{
-    CV_Assert( !m_dense_descriptors->empty() );
-    int number_of_descriptors =  m_roi.width * m_roi.height;
-
-    parallel_for_( Range(0, number_of_descriptors),
-        NormalizeDescriptorsInvoker( m_dense_descriptors, m_nrm_type, m_grid_point_number, m_hist_th_q_no, m_descriptor_size )
-    );
+    } );
 }
 
 inline void DAISY_Impl::initialize()
@@ -1237,6 +1367,7 @@ inline void DAISY_Impl::compute_oriented_grid_points()
          point_list.at<double>(2*k  ) = -x*zin + y*kos; // y
       }
     }
+    m_oriented_grid_points.convertTo( m_oriented_grid_points_f, CV_32F );
 }
 
 struct MaxDoGInvoker : ParallelLoopBody
@@ -1480,59 +1611,29 @@ inline void DAISY_Impl::set_image( InputArray _image )
 // -------------------------------------------------
 /* DAISY interface implementation */
 
-// keypoint scope
-void DAISY_Impl::compute( InputArray _image, std::vector<KeyPoint>& keypoints, OutputArray _descriptors )
+void DAISY_Impl::setImage( InputArray _image )
 {
-    // do nothing if no image
-    if( _image.getMat().empty() )
-      return;
-
     set_image( _image );
 
     // whole image
     m_roi = Rect( 0, 0, m_image.cols, m_image.rows );
 
-    // get homography
-    Mat H = m_h_matrix;
-
-    // convert to double if case
-    if ( H.depth() != CV_64F )
-        H.convertTo( H, CV_64F );
-
     set_parameters();
-
     initialize_single_descriptor_mode();
+}
 
-    // allocate array
-    _descriptors.create( (int) keypoints.size(), m_descriptor_size, CV_32F );
+// keypoint scope
+void DAISY_Impl::compute( InputArray _image, std::vector<KeyPoint>& keypoints, OutputArray _descriptors )
+{
+    // do nothing if no image
+    if( _image.getMat().empty() )
+      return;
 
-    // prepare descriptors
-    Mat descriptors = _descriptors.getMat();
-    descriptors.setTo( Scalar(0) );
+    setImage( _image );
 
     // iterate over keypoints
     // and fill computed descriptors
-    if ( H.empty() )
-      for (int k = 0; k < (int) keypoints.size(); k++)
-      {
-          get_descriptor( keypoints[k].pt.y, keypoints[k].pt.x,
-                          m_use_orientation ? (int) keypoints[k].angle : 0,
-                          &descriptors.at<float>( k, 0 ), &m_smoothed_gradient_layers,
-                          &m_oriented_grid_points, m_orientation_shift_table, m_th_q_no,
-                          m_hist_th_q_no, m_grid_point_number, m_descriptor_size, m_enable_interpolation,
-                          m_nrm_type );
-      }
-    else
-      for (int k = 0; k < (int) keypoints.size(); k++)
-      {
-        get_descriptor_h( keypoints[k].pt.y, keypoints[k].pt.x,
-                          m_use_orientation ? (int) keypoints[k].angle : 0,
-                          &descriptors.at<float>( k, 0 ), &H.at<double>( 0 ), &m_smoothed_gradient_layers,
-                          m_cube_sigmas, &m_grid_points, m_orientation_shift_table, m_th_q_no,
-                          m_hist_th_q_no, m_grid_point_number, m_descriptor_size, m_enable_interpolation,
-                          m_nrm_type );
-      }
-
+    GetDescriptors( keypoints, _descriptors );
 }
 
 // full scope with roi
@@ -1552,13 +1653,12 @@ void DAISY_Impl::compute( InputArray _image, Rect roi, OutputArray _descriptors
     set_parameters();
     initialize_single_descriptor_mode();
 
-    _descriptors.create( m_roi.width*m_roi.height, m_descriptor_size, CV_32F );
+    _descriptors.create( m_roi.width*m_roi.height, m_descriptor_size, m_descriptor_type );
 
     Mat descriptors = _descriptors.getMat();
 
     // compute full desc
     compute_descriptors( &descriptors );
-    normalize_descriptors( &descriptors );
 }
 
 // full scope
@@ -1579,13 +1679,12 @@ void DAISY_Impl::compute( InputArray _image, OutputArray _descriptors )
     set_parameters();
     initialize_single_descriptor_mode();
 
-    _descriptors.create( m_roi.width*m_roi.height, m_descriptor_size, CV_32F );
+    _descriptors.create( m_roi.width*m_roi.height, m_descriptor_size, m_descriptor_type );
 
     Mat descriptors = _descriptors.getMat();
 
     // compute full desc
     compute_descriptors( &descriptors );
-    normalize_descriptors( &descriptors );
 }
 
 // constructor
@@ -1596,6 +1695,7 @@ DAISY_Impl::DAISY_Impl( float _radius, int _q_radius, int _q_theta, int _q_hist,
 {
 
     m_descriptor_size = 0;
+    m_descriptor_type = CV_32F;
     m_grid_point_number = 0;
 
     m_scale_invariant = false;
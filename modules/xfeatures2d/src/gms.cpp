@@ -65,6 +65,93 @@ const int mRotationPatterns[8][9] = {
 // 5 level scales
 const double mScaleRatios[5] = { 1.0, 1.0 / 2, 1.0 / std::sqrt(2.0), std::sqrt(2.0), 2.0 };
 
+// Number of matches falling in each pair of left and right grid cells.
+// Only the non empty cell pairs are stored: the entries of left cell i are
+// [mOffsets[i], mOffsets[i+1]), sorted by right cell index.
+class CellPairHistogram
+{
+public:
+    void build(const vector<int> &leftIdx, const vector<int> &rightIdx, const int gridNumberLeft);
+
+    // number of matches from left cell l to right cell r
+    int count(const int l, const int r) const
+    {
+        const int *begin = &mRightCells[0] + mOffsets[l], *end = &mRightCells[0] + mOffsets[l + 1];
+        const int *it = std::lower_bound(begin, end, r);
+        return it != end && *it == r ? mCounts[it - &mRightCells[0]] : 0;
+    }
+
+    // right cell with most matches from left cell l, the smallest one in case of ties
+    int bestRightCell(const int l) const
+    {
+        int best = -1, max_number = 0;
+        for (int k = mOffsets[l]; k < mOffsets[l + 1]; k++)
+        {
+            if (mCounts[k] > max_number)
+            {
+                best = mRightCells[k];
+                max_number = mCounts[k];
+            }
+        }
+        return best;
+    }
+
+    // number of matches in left cell l
+    int pointsInCell(const int l) const { return mPointsPerCellLeft[l]; }
+
+private:
+    vector<int> mOffsets;
+    vector<int> mRightCells;
+    vector<int> mCounts;
+    vector<int> mPointsPerCellLeft;
+};
+
+void CellPairHistogram::build(const vector<int> &leftIdx, const vector<int> &rightIdx, const int gridNumberLeft)
+{
+    const size_t numberMatches = leftIdx.size();
+
+    // bucket the right cells of the matches by left cell
+    mPointsPerCellLeft.assign(gridNumberLeft, 0);
+    for (size_t i = 0; i < numberMatches; i++)
+    {
+        if (leftIdx[i] >= 0 && rightIdx[i] >= 0)
+            mPointsPerCellLeft[leftIdx[i]]++;
+    }
+
+    vector<int> bucketStart(gridNumberLeft + 1, 0);
+    for (int l = 0; l < gridNumberLeft; l++)
+        bucketStart[l + 1] = bucketStart[l] + mPointsPerCellLeft[l];
+
+    vector<int> buckets(std::max(bucketStart[gridNumberLeft], 1));
+    vector<int> bucketEnd(bucketStart.begin(), bucketStart.end() - 1);
+    for (size_t i = 0; i < numberMatches; i++)
+    {
+        if (leftIdx[i] >= 0 && rightIdx[i] >= 0)
+            buckets[bucketEnd[leftIdx[i]]++] = rightIdx[i];
+    }
+
+    // run-length encode each sorted bucket
+    mOffsets.assign(gridNumberLeft + 1, 0);
+    mRightCells.resize(buckets.size());
+    mCounts.resize(buckets.size());
+    int n = 0;
+    for (int l = 0; l < gridNumberLeft; l++)
+    {
+        int *begin = &buckets[0] + bucketStart[l], *end = &buckets[0] + bucketStart[l + 1];
+        std::sort(begin, end);
+        for (const int *it = begin; it != end; )
+        {
+            const int *run = it;
+            while (it != end && *it == *run)
+                ++it;
+            mRightCells[n] = *run;
+            mCounts[n] = (int)(it - run);
+            n++;
+        }
+        mOffsets[l + 1] = n;
+    }
+}
+
 class GMSMatcher
 {
 public:
@@ -105,45 +192,40 @@ private:
     size_t mNumberMatches;
 
     // Grid Size
-    Size mGridSizeLeft, mGridSizeRight;
+    Size mGridSizeLeft;
     int mGridNumberLeft;
-    int mGridNumberRight;
 
-    // x      : left grid idx
-    // y      : right grid idx
-    // value  : how many matches from idx_left to idx_right
-    Mat mMotionStatistics;
+    // Right grid of each tested scale
+    Size mGridSizeRight[5];
+    int mGridNumberRight[5];
 
-    //
-    vector<int> mNumberPointsInPerCellLeft;
+    // Left grid index of every match, for each of the 4 shifted grids
+    vector<int> mLeftIdx[4];
 
-    // Inldex  : grid_idx_left
-    // Value   : grid_idx_right
-    vector<int> mCellPairs;
+    // Right grid index of every match, for each tested scale
+    vector<int> mRightIdx[5];
 
-    // Every Matches has a cell-pair
-    // first  : grid_idx_left
-    // second : grid_idx_right
-    vector<pair<int, int> > mvMatchPairs;
-
-    // Inlier Mask for output
-    vector<bool> mvbInlierMask;
+    // Cell pair histograms, for each tested scale and left grid
+    CellPairHistogram mMotionStatistics[5][4];
 
     //
     Mat mGridNeighborLeft;
-    Mat mGridNeighborRight;
+    Mat mGridNeighborRight[5];
 
     double mThresholdFactor;
 
 
-    // Assign Matches to Cell Pairs
-    void assignMatchPairs(const int GridType);
+    // Assign Matches to Cells of the left grids
+    void assignMatchesLeft();
+
+    // Assign Matches to Cells of the right grid of a scale
+    void assignMatchesRight(const int scale);
 
     void convertMatches(const vector<DMatch> &vDMatches, vector<pair<int, int> > &vMatches);
 
-    int getGridIndexLeft(const Point2f &pt, const int type);
+    int getGridIndexLeft(const Point2f &pt, const int type) const;
 
-    int getGridIndexRight(const Point2f &pt);
+    int getGridIndexRight(const Point2f &pt, const int scale) const;
 
     vector<int> getNB9(const int idx, const Size& GridSize);
 
@@ -151,41 +233,34 @@ private:
 
     void normalizePoints(const vector<KeyPoint> &kp, const Size &size, vector<Point2f> &npts);
 
-    // Run
-    int run(const int rotationType);
+    // Run, fills the inlier mask and returns the number of inliers
+    int run(const int scale, const int rotationType, vector<int> &cellPairs, vector<uchar> &inlierMask) const;
 
     void setScale(const int scale);
 
     // Verify Cell Pairs
-    void verifyCellPairs(const int rotationType);
+    void verifyCellPairs(const int scale, const int gridType, const int rotationType, vector<int> &cellPairs) const;
 };
 
-void GMSMatcher::assignMatchPairs(const int gridType)
+void GMSMatcher::assignMatchesLeft()
 {
-    for (size_t i = 0; i < mNumberMatches; i++)
+    for (int gridType = 1; gridType <= 4; gridType++)
     {
-        Point2f &lp = mvP1[mvMatches[i].first];
-        Point2f &rp = mvP2[mvMatches[i].second];
-
-        int lgidx = mvMatchPairs[i].first = getGridIndexLeft(lp, gridType);
-        int rgidx = -1;
-
-        if (gridType == 1)
-        {
-            rgidx = mvMatchPairs[i].second = getGridIndexRight(rp);
-        }
-        else
-        {
-            rgidx = mvMatchPairs[i].second;
-        }
-
-        if (lgidx < 0 || rgidx < 0) continue;
-
-        mMotionStatistics.at<int>(lgidx, rgidx)++;
-        mNumberPointsInPerCellLeft[lgidx]++;
+        vector<int> &leftIdx = mLeftIdx[gridType - 1];
+        leftIdx.resize(mNumberMatches);
+        for (size_t i = 0; i < mNumberMatches; i++)
+            leftIdx[i] = getGridIndexLeft(mvP1[mvMatches[i].first], gridType);
     }
 }
 
+void GMSMatcher::assignMatchesRight(const int scale)
+{
+    vector<int> &rightIdx = mRightIdx[scale];
+    rightIdx.resize(mNumberMatches);
+    for (size_t i = 0; i < mNumberMatches; i++)
+        rightIdx[i] = getGridIndexRight(mvP2[mvMatches[i].second], scale);
+}
+
 // Convert OpenCV DMatch to Match (pair<int, int>)
 void GMSMatcher::convertMatches(const vector<DMatch> &vDMatches, vector<pair<int, int> > &vMatches)
 {
@@ -194,7 +269,7 @@ void GMSMatcher::convertMatches(const vector<DMatch> &vDMatches, vector<pair<int
         vMatches[i] = pair<int, int>(vDMatches[i].queryIdx, vDMatches[i].trainIdx);
 }
 
-int GMSMatcher::getGridIndexLeft(const Point2f &pt, const int type)
+int GMSMatcher::getGridIndexLeft(const Point2f &pt, const int type) const
 {
     int x = 0, y = 0;
 
@@ -225,76 +300,73 @@ int GMSMatcher::getGridIndexLeft(const Point2f &pt, const int type)
     return x + y * mGridSizeLeft.width;
 }
 
-int GMSMatcher::getGridIndexRight(const Point2f &pt)
+int GMSMatcher::getGridIndexRight(const Point2f &pt, const int scale) const
 {
-    int x = cvFloor(pt.x * mGridSizeRight.width);
-    int y = cvFloor(pt.y * mGridSizeRight.height);
+    const Size &gridSize = mGridSizeRight[scale];
+    int x = cvFloor(pt.x * gridSize.width);
+    int y = cvFloor(pt.y * gridSize.height);
 
-    return x + y * mGridSizeRight.width;
+    if (x < 0 || y < 0 || x >= gridSize.width || y >= gridSize.height)
+        return -1;
+
+    return x + y * gridSize.width;
 }
 
 int GMSMatcher::getInlierMask(vector<bool> &vbInliers, const bool withRotation, const bool withScale)
 {
-    int max_inlier = 0;
+    const int numberScales = withScale ? 5 : 1;
+    const int numberRotations = withRotation ? 8 : 1;
+
+    // the cell assignments and the histograms only depend on the scale and the left grid
+    assignMatchesLeft();
+    for (int scale = 0; scale < numberScales; scale++)
+        setScale(scale);
 
-    if (!withScale && !withRotation)
+    parallel_for_(Range(0, numberScales), [&](const Range& range)
     {
-        setScale(0);
-        max_inlier = run(1);
-        vbInliers = mvbInlierMask;
-        return max_inlier;
-    }
+        for (int scale = range.start; scale < range.end; scale++)
+            assignMatchesRight(scale);
+    });
 
-    if (withRotation && withScale)
+    parallel_for_(Range(0, numberScales * 4), [&](const Range& range)
     {
-        for (int scale = 0; scale < 5; scale++)
+        for (int k = range.start; k < range.end; k++)
         {
-            setScale(scale);
-            for (int rotationType = 1; rotationType <= 8; rotationType++)
-            {
-                int num_inlier = run(rotationType);
-
-                if (num_inlier > max_inlier)
-                {
-                    vbInliers = mvbInlierMask;
-                    max_inlier = num_inlier;
-                }
-            }
+            const int scale = k / 4, gridType = k % 4 + 1;
+            mMotionStatistics[scale][gridType - 1].build(mLeftIdx[gridType - 1], mRightIdx[scale], mGridNumberLeft);
         }
-        return max_inlier;
-    }
+    });
 
-    if (withRotation && !withScale)
+    // evaluate every (scale, rotation) hypothesis
+    const int numberHypotheses = numberScales * numberRotations;
+    vector<int> numberInliers(numberHypotheses, 0);
+    parallel_for_(Range(0, numberHypotheses), [&](const Range& range)
     {
-        setScale(0);
-        for (int rotationType = 1; rotationType <= 8; rotationType++)
+        vector<int> cellPairs;
+        vector<uchar> inlierMask;
+        for (int k = range.start; k < range.end; k++)
+            numberInliers[k] = run(k / numberRotations, k % numberRotations + 1, cellPairs, inlierMask);
+    });
+
+    // first hypothesis with most inliers, as in a sequential scan
+    int best = -1, max_inlier = 0;
+    for (int k = 0; k < numberHypotheses; k++)
+    {
+        if (numberInliers[k] > max_inlier)
         {
-            int num_inlier = run(rotationType);
-
-            if (num_inlier > max_inlier)
-            {
-                vbInliers = mvbInlierMask;
-                max_inlier = num_inlier;
-            }
+            best = k;
+            max_inlier = numberInliers[k];
         }
-        return max_inlier;
     }
 
-    if (!withRotation && withScale)
+    vbInliers.assign(mNumberMatches, false);
+    if (best >= 0)
     {
-        for (int scale = 0; scale < 5; scale++)
-        {
-            setScale(scale);
-            int num_inlier = run(1);
-
-            if (num_inlier > max_inlier)
-            {
-                vbInliers = mvbInlierMask;
-                max_inlier = num_inlier;
-            }
-
-        }
-        return max_inlier;
+        vector<int> cellPairs;
+        vector<uchar> inlierMask;
+        run(best / numberRotations, best % numberRotations + 1, cellPairs, inlierMask);
+        for (size_t i = 0; i < mNumberMatches; i++)
+            vbInliers[i] = inlierMask[i] != 0;
     }
 
     return max_inlier;
@@ -349,74 +421,55 @@ void GMSMatcher::normalizePoints(const vector<KeyPoint> &kp, const Size &size, v
     }
 }
 
-int GMSMatcher::run(const int rotationType)
+int GMSMatcher::run(const int scale, const int rotationType, vector<int> &cellPairs, vector<uchar> &inlierMask) const
 {
-    mvbInlierMask.assign(mNumberMatches, false);
-
-    // Initialize Motion Statisctics
-    mMotionStatistics = Mat::zeros(mGridNumberLeft, mGridNumberRight, CV_32SC1);
-    mvMatchPairs.assign(mNumberMatches, pair<int, int>(0, 0));
+    inlierMask.assign(mNumberMatches, 0);
 
     for (int gridType = 1; gridType <= 4; gridType++)
     {
-        // initialize
-        mMotionStatistics.setTo(0);
-        mCellPairs.assign(mGridNumberLeft, -1);
-        mNumberPointsInPerCellLeft.assign(mGridNumberLeft, 0);
-
-        assignMatchPairs(gridType);
-        verifyCellPairs(rotationType);
+        verifyCellPairs(scale, gridType, rotationType, cellPairs);
 
         // Mark inliers
+        const vector<int> &leftIdx = mLeftIdx[gridType - 1];
+        const vector<int> &rightIdx = mRightIdx[scale];
         for (size_t i = 0; i < mNumberMatches; i++)
         {
-            if (mCellPairs[mvMatchPairs[i].first] == mvMatchPairs[i].second)
-                mvbInlierMask[i] = true;
+            if (leftIdx[i] >= 0 && cellPairs[leftIdx[i]] == rightIdx[i])
+                inlierMask[i] = 1;
         }
     }
 
-    return (int) count(mvbInlierMask.begin(), mvbInlierMask.end(), true); //number of inliers
+    return (int) count(inlierMask.begin(), inlierMask.end(), (uchar)1); //number of inliers
 }
 
 void GMSMatcher::setScale(const int scale)
 {
     // Set Scale
-    mGridSizeRight.width = cvRound(mGridSizeLeft.width  * mScaleRatios[scale]);
-    mGridSizeRight.height = cvRound(mGridSizeLeft.height * mScaleRatios[scale]);
-    mGridNumberRight = mGridSizeRight.width * mGridSizeRight.height;
+    mGridSizeRight[scale].width = cvRound(mGridSizeLeft.width  * mScaleRatios[scale]);
+    mGridSizeRight[scale].height = cvRound(mGridSizeLeft.height * mScaleRatios[scale]);
+    mGridNumberRight[scale] = mGridSizeRight[scale].width * mGridSizeRight[scale].height;
 
     // Initialize the neighbor of right grid
-    mGridNeighborRight = Mat::zeros(mGridNumberRight, 9, CV_32SC1);
-    initalizeNeighbors(mGridNeighborRight, mGridSizeRight);
+    mGridNeighborRight[scale] = Mat::zeros(mGridNumberRight[scale], 9, CV_32SC1);
+    initalizeNeighbors(mGridNeighborRight[scale], mGridSizeRight[scale]);
 }
 
-void GMSMatcher::verifyCellPairs(const int rotationType)
+void GMSMatcher::verifyCellPairs(const int scale, const int gridType, const int rotationType, vector<int> &cellPairs) const
 {
     const int *CurrentRP = mRotationPatterns[rotationType - 1];
+    const CellPairHistogram &motionStatistics = mMotionStatistics[scale][gridType - 1];
+
+    cellPairs.assign(mGridNumberLeft, -1);
 
     for (int i = 0; i < mGridNumberLeft; i++)
     {
-        if (sum(mMotionStatistics.row(i))[0] == 0)
-        {
-            mCellPairs[i] = -1;
+        if (motionStatistics.pointsInCell(i) == 0)
             continue;
-        }
-
-        int max_number = 0;
-        for (int j = 0; j < mGridNumberRight; j++)
-        {
-            int *value = mMotionStatistics.ptr<int>(i);
-            if (value[j] > max_number)
-            {
-                mCellPairs[i] = j;
-                max_number = value[j];
-            }
-        }
 
-        int idx_grid_rt = mCellPairs[i];
+        int idx_grid_rt = cellPairs[i] = motionStatistics.bestRightCell(i);
 
         const int *NB9_lt = mGridNeighborLeft.ptr<int>(i);
-        const int *NB9_rt = mGridNeighborRight.ptr<int>(idx_grid_rt);
+        const int *NB9_rt = mGridNeighborRight[scale].ptr<int>(idx_grid_rt);
 
         int score = 0;
         double thresh = 0;
@@ -429,15 +482,15 @@ void GMSMatcher::verifyCellPairs(const int rotationType)
             if (ll == -1 || rr == -1)
                 continue;
 
-            score += mMotionStatistics.at<int>(ll, rr);
-            thresh += mNumberPointsInPerCellLeft[ll];
+            score += motionStatistics.count(ll, rr);
+            thresh += motionStatistics.pointsInCell(ll);
             numpair++;
         }
 
         thresh = mThresholdFactor * std::sqrt(thresh / numpair);
 
         if (score < thresh)
-            mCellPairs[i] = -2;
+            cellPairs[i] = -2;
     }
 }
 
@@ -75,7 +75,7 @@ namespace cv
             virtual void compute(InputArray image, std::vector<KeyPoint>& keypoints, OutputArray descriptors) CV_OVERRIDE;
 
         protected:
-            typedef void(*PixelTestFn)(const Mat& input_image, const std::vector<KeyPoint>& keypoints, OutputArray, const std::vector<int> &points, bool rotationInvariance, int half_ssd_size);
+            typedef void(*PixelTestFn)(const Mat& input_image, const std::vector<KeyPoint>& keypoints, Mat& descriptors, const std::vector<int> &points, bool rotationInvariance, int half_ssd_size, const Range& range);
             void setSamplingPoints();
             int bytes_;
             PixelTestFn test_fn_;
@@ -94,10 +94,9 @@ namespace cv
         void CalcuateSums(int count, const std::vector<int> &points, bool rotationInvariance, const Mat &grayImage, const KeyPoint &pt, int &suma, int &sumc, float cos_theta, float sin_theta, int half_ssd_size);
 
 
-        static void pixelTests1(const Mat& grayImage, const std::vector<KeyPoint>& keypoints, OutputArray _descriptors, const std::vector<int> &points, bool rotationInvariance, int half_ssd_size)
+        static void pixelTests1(const Mat& grayImage, const std::vector<KeyPoint>& keypoints, Mat& descriptors, const std::vector<int> &points, bool rotationInvariance, int half_ssd_size, const Range& range)
         {
-            Mat descriptors = _descriptors.getMat();
-            for (int i = 0; i < (int)keypoints.size(); ++i)
+            for (int i = range.start; i < range.end; ++i)
             {
                 uchar* desc = descriptors.ptr(i);
                 const KeyPoint& pt = keypoints[i];
@@ -125,10 +124,9 @@ namespace cv
         }
 
 
-        static void pixelTests2(const Mat& grayImage, const std::vector<KeyPoint>& keypoints, OutputArray _descriptors, const std::vector<int> &points, bool rotationInvariance, int half_ssd_size)
+        static void pixelTests2(const Mat& grayImage, const std::vector<KeyPoint>& keypoints, Mat& descriptors, const std::vector<int> &points, bool rotationInvariance, int half_ssd_size, const Range& range)
         {
-            Mat descriptors = _descriptors.getMat();
-            for (int i = 0; i < (int)keypoints.size(); ++i)
+            for (int i = range.start; i < range.end; ++i)
             {
                 uchar* desc = descriptors.ptr(i);
                 const KeyPoint& pt = keypoints[i];
@@ -156,10 +154,9 @@ namespace cv
         }
 
 
-        static void pixelTests4(const Mat& grayImage, const std::vector<KeyPoint>& keypoints, OutputArray _descriptors, const std::vector<int> &points, bool rotationInvariance, int half_ssd_size)
+        static void pixelTests4(const Mat& grayImage, const std::vector<KeyPoint>& keypoints, Mat& descriptors, const std::vector<int> &points, bool rotationInvariance, int half_ssd_size, const Range& range)
         {
-            Mat descriptors = _descriptors.getMat();
-            for (int i = 0; i < (int)keypoints.size(); ++i)
+            for (int i = range.start; i < range.end; ++i)
             {
                 uchar* desc = descriptors.ptr(i);
                 const KeyPoint& pt = keypoints[i];
@@ -188,10 +185,9 @@ namespace cv
 
 
 
-        static void pixelTests8(const Mat& grayImage, const std::vector<KeyPoint>& keypoints, OutputArray _descriptors, const std::vector<int> &points, bool rotationInvariance, int half_ssd_size)
+        static void pixelTests8(const Mat& grayImage, const std::vector<KeyPoint>& keypoints, Mat& descriptors, const std::vector<int> &points, bool rotationInvariance, int half_ssd_size, const Range& range)
         {
-            Mat descriptors = _descriptors.getMat();
-            for (int i = 0; i < (int)keypoints.size(); ++i)
+            for (int i = range.start; i < range.end; ++i)
             {
                 uchar* desc = descriptors.ptr(i);
                 const KeyPoint& pt = keypoints[i];
@@ -219,10 +215,9 @@ namespace cv
         }
 
 
-        static void pixelTests16(const Mat& grayImage, const std::vector<KeyPoint>& keypoints, OutputArray _descriptors, const std::vector<int> &points, bool rotationInvariance, int half_ssd_size)
+        static void pixelTests16(const Mat& grayImage, const std::vector<KeyPoint>& keypoints, Mat& descriptors, const std::vector<int> &points, bool rotationInvariance, int half_ssd_size, const Range& range)
         {
-            Mat descriptors = _descriptors.getMat();
-            for (int i = 0; i < (int)keypoints.size(); ++i)
+            for (int i = range.start; i < range.end; ++i)
             {
                 uchar* desc = descriptors.ptr(i);
                 const KeyPoint& pt = keypoints[i];
@@ -250,10 +245,9 @@ namespace cv
         }
 
 
-        static void pixelTests32(const Mat& grayImage, const std::vector<KeyPoint>& keypoints, OutputArray _descriptors, const std::vector<int> &points, bool rotationInvariance, int half_ssd_size)
+        static void pixelTests32(const Mat& grayImage, const std::vector<KeyPoint>& keypoints, Mat& descriptors, const std::vector<int> &points, bool rotationInvariance, int half_ssd_size, const Range& range)
         {
-            Mat descriptors = _descriptors.getMat();
-            for (int i = 0; i < (int)keypoints.size(); ++i)
+            for (int i = range.start; i < range.end; ++i)
             {
                 uchar* desc = descriptors.ptr(i);
                 const KeyPoint& pt = keypoints[i];
@@ -280,10 +274,9 @@ namespace cv
         }
 
 
-        static void pixelTests64(const Mat& grayImage, const std::vector<KeyPoint>& keypoints, OutputArray _descriptors, const std::vector<int> &points, bool rotationInvariance, int half_ssd_size)
+        static void pixelTests64(const Mat& grayImage, const std::vector<KeyPoint>& keypoints, Mat& descriptors, const std::vector<int> &points, bool rotationInvariance, int half_ssd_size, const Range& range)
         {
-            Mat descriptors = _descriptors.getMat();
-            for (int i = 0; i < (int)keypoints.size(); ++i)
+            for (int i = range.start; i < range.end; ++i)
             {
                 uchar* desc = descriptors.ptr(i);
                 const KeyPoint& pt = keypoints[i];
@@ -390,13 +383,14 @@ namespace cv
                 const uchar * Mi_b = grayImage.ptr<uchar>(by2 + iy);
                 const uchar * Mi_c = grayImage.ptr<uchar>(cy2 + iy);
 
+                // differences of 8-bit values, their squares are exact in int
                 for (int ix = -K; ix <= K; ix++)
                 {
-                    double difa = Mi_a[ax2 + ix] - Mi_b[bx2 + ix];
-                    suma += (int)((difa)*(difa));
+                    int difa = Mi_a[ax2 + ix] - Mi_b[bx2 + ix];
+                    suma += difa*difa;
 
-                    double difc = Mi_c[cx2 + ix] - Mi_b[bx2 + ix];
-                    sumc += (int)((difc)*(difc));
+                    int difc = Mi_c[cx2 + ix] - Mi_b[bx2 + ix];
+                    sumc += difc*difc;
                 }
             }
 
@@ -544,7 +538,11 @@ namespace cv
             //Mat descriptors = _descriptors.getMat();
 
 
-            test_fn_(grayImage, keypoints, descriptors, sampling_points_, rotationInvariance_, half_ssd_size_);
+            // keypoints are independent, each range fills its own descriptor rows
+            parallel_for_(Range(0, (int)keypoints.size()), [&](const Range& range)
+            {
+                test_fn_(grayImage, keypoints, descriptors, sampling_points_, rotationInvariance_, half_ssd_size_, range);
+            });
         }
 
 
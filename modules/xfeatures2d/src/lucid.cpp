@@ -47,6 +47,7 @@ the use of this software, even if advised of the possibility of such damage.
 */
 
 #include "precomp.hpp"
+#include <algorithm>
 
 namespace cv {
     namespace xfeatures2d {
@@ -110,38 +111,46 @@ namespace cv {
                 src_input = _src.getMat();
             }
 
+            if (!_desc.needed())
+                return;
+
             Mat_<Vec3b> src;
 
             blur(src_input, src, cv::Size(b_kernel, b_kernel));
 
-            int x, y, j, d, p, m = (l_kernel*2+1)*(l_kernel*2+1)*3, width = src.cols, height = src.rows, r, c;
+            const int m = (l_kernel*2+1)*(l_kernel*2+1)*3, width = src.cols, height = src.rows;
 
-            Mat_<uchar> desc(static_cast<int>(keypoints.size()), m);
+            _desc.create(static_cast<int>(keypoints.size()), m, CV_8U);
+            Mat_<uchar> desc = _desc.getMat();
 
-            for (std::size_t i = 0; i < keypoints.size(); ++i) {
-                x = static_cast<int>(keypoints[i].pt.x)-l_kernel, y = static_cast<int>(keypoints[i].pt.y)-l_kernel, d = x+2*l_kernel, p = y+2*l_kernel, j = x, r = static_cast<int>(i), c = 0;
+            // keypoints are independent, each range gathers and sorts its own descriptor rows
+            parallel_for_(Range(0, static_cast<int>(keypoints.size())), [&](const Range& range) {
+                for (int i = range.start; i < range.end; ++i) {
+                    int x = static_cast<int>(keypoints[i].pt.x)-l_kernel, y = static_cast<int>(keypoints[i].pt.y)-l_kernel, d = x+2*l_kernel, p = y+2*l_kernel, j = x, c = 0;
+                    uchar *row = desc[i];
 
-                while (x <= d) {
-                    Vec3b &pix = src((y < 0 ? height+y : y >= height ? y-height : y), (x < 0 ? width+x : x >= width ? x-width : x));
+                    while (x <= d) {
+                        const Vec3b &pix = src((y < 0 ? height+y : y >= height ? y-height : y), (x < 0 ? width+x : x >= width ? x-width : x));
 
-                    desc(r, c++) = pix[0];
-                    desc(r, c++) = pix[1];
-                    desc(r, c++) = pix[2];
+                        row[c++] = pix[0];
+                        row[c++] = pix[1];
+                        row[c++] = pix[2];
 
-                    ++x;
-                    if (x > d) {
-                        if (y < p) {
-                            ++y;
-                            x = j;
+                        ++x;
+                        if (x > d) {
+                            if (y < p) {
+                                ++y;
+                                x = j;
+                            }
+                            else
+                                break;
                         }
-                        else
-                            break;
                     }
-                }
-            }
 
-            if (_desc.needed())
-                sort(desc, _desc, SORT_EVERY_ROW | SORT_ASCENDING);
+                    // same as sort(SORT_EVERY_ROW | SORT_ASCENDING), row by row
+                    std::sort(row, row + m);
+                }
+            });
         }
     }
 } // END NAMESPACE CV
@@ -57,6 +57,7 @@ References:
     ACM, 2010.
 */
 #include "precomp.hpp"
+#include "opencv2/core/hal/intrin.hpp"
 
 #include "pct_signatures/constants.hpp"
 #include "pct_signatures/similarity.hpp"
@@ -138,7 +139,7 @@ namespace cv
 
                     for (int i = range.start; i < range.end; i++)
                     {
-                        if (mImageSignatures[i].empty())
+                        if ((*mImageSignatures)[i].empty())
                         {
                             CV_Error_(Error::StsBadArg, ("Signature ID: %d is empty!", i));
                         }
@@ -209,6 +210,387 @@ namespace cv
 
 
 
+
+            /**
+            * @brief Database of signatures stored dimension by dimension: the centroids of all signatures
+            *       are stored in one array per dimension, so that the centroids of a signature can be
+            *       processed several at a time.
+            */
+            class PCTSignaturesSQFDDatabase_Impl : public PCTSignaturesSQFDDatabase
+            {
+            public:
+                PCTSignaturesSQFDDatabase_Impl(
+                    const int distanceFunction,
+                    const int similarityFunction,
+                    const float similarityParameter)
+                    : mDistanceFunction(distanceFunction),
+                    mSimilarityFunction(similarityFunction),
+                    mSimilarityParameter(similarityParameter),
+                    mOffsets(1, 0)
+                {
+                    if (distanceFunction < PCTSignatures::L0_25 || distanceFunction > PCTSignatures::L_INFINITY)
+                    {
+                        CV_Error(Error::StsBadArg, "Distance function not implemented!");
+                    }
+                    if (similarityFunction < PCTSignatures::MINUS || similarityFunction > PCTSignatures::HEURISTIC)
+                    {
+                        CV_Error(Error::StsNotImplemented, "Similarity function not implemented!");
+                    }
+                }
+
+                void add(const std::vector<Mat>& signatures) CV_OVERRIDE;
+
+                int getSignatureCount() const CV_OVERRIDE
+                {
+                    return (int)mSelfTerms.size();
+                }
+
+                void clear() CV_OVERRIDE
+                {
+                    for (int d = 0; d < SIGNATURE_DIMENSION; d++)
+                    {
+                        mCentroids[d].clear();
+                    }
+                    mOffsets.assign(1, 0);
+                    mSelfTerms.clear();
+                }
+
+                bool empty() const CV_OVERRIDE
+                {
+                    return mSelfTerms.empty();
+                }
+
+                void computeQuadraticFormDistances(
+                    const Mat& querySignature,
+                    std::vector<float>& distances) const CV_OVERRIDE;
+
+                void search(
+                    const Mat& querySignature,
+                    int k,
+                    std::vector<int>& indices,
+                    std::vector<float>& distances) const CV_OVERRIDE;
+
+            private:
+                int mDistanceFunction;
+                int mSimilarityFunction;
+                float mSimilarityParameter;
+
+                /** @brief Values of each dimension (weight first) of the centroids of all signatures. */
+                std::vector<float> mCentroids[SIGNATURE_DIMENSION];
+                /** @brief Centroids of signature i are in range [mOffsets[i], mOffsets[i + 1]). */
+                std::vector<int> mOffsets;
+                /** @brief Sum of weighted similarities of each signature with itself. */
+                std::vector<float> mSelfTerms;
+
+                void getCentroids(const float* centroids[SIGNATURE_DIMENSION]) const
+                {
+                    for (int d = 0; d < SIGNATURE_DIMENSION; d++)
+                    {
+                        centroids[d] = mCentroids[d].empty() ? 0 : &mCentroids[d][0];
+                    }
+                }
+
+                /** @brief Sum of weighted similarities of a signature with itself. */
+                float computeSelfTerm(const Mat& signature) const
+                {
+                    // same layout as the database
+                    Mat transposed = signature.t();
+                    const float* centroids[SIGNATURE_DIMENSION];
+                    for (int d = 0; d < SIGNATURE_DIMENSION; d++)
+                    {
+                        centroids[d] = transposed.ptr<float>(d);
+                    }
+                    return computePartialSQFD(signature, centroids, 0, signature.rows);
+                }
+
+                /**
+                * @brief Sum of weighted similarities of the centroids of a signature (one centroid in each row)
+                *       with the centroids [begin, end) of the given dimension arrays.
+                */
+                float computePartialSQFD(
+                    const Mat& signature,
+                    const float* const* centroids,
+                    int begin,
+                    int end) const;
+
+                float computeSimilarity(float distance) const
+                {
+                    switch (mSimilarityFunction)
+                    {
+                    case PCTSignatures::MINUS:
+                        return -distance;
+                    case PCTSignatures::GAUSSIAN:
+                        return exp(-mSimilarityParameter * distance * distance);
+                    default:
+                        return 1 / (mSimilarityParameter + distance);
+                    }
+                }
+
+                /** @brief Same as computeDistance(), between a centroid and the centroid j of the dimension arrays. */
+                float computeDistance(const float* centroid, const float* const* centroids, int j) const
+                {
+                    float result = 0;
+                    for (int d = 1; d < SIGNATURE_DIMENSION; d++)
+                    {
+                        float difference = centroid[d] - centroids[d][j];
+                        switch (mDistanceFunction)
+                        {
+                        case PCTSignatures::L0_25:
+                            result += std::sqrt(std::sqrt(std::abs(difference)));
+                            break;
+                        case PCTSignatures::L0_5:
+                            result += std::sqrt(std::abs(difference));
+                            break;
+                        case PCTSignatures::L1:
+                            result += std::abs(difference);
+                            break;
+                        case PCTSignatures::L2:
+                        case PCTSignatures::L2SQUARED:
+                            result += difference * difference;
+                            break;
+                        case PCTSignatures::L5:
+                            result += std::abs(difference) * difference * difference * difference * difference;
+                            break;
+                        default:
+                            result = std::max(result, difference);
+                        }
+                    }
+                    switch (mDistanceFunction)
+                    {
+                    case PCTSignatures::L0_25:
+                        result *= result;
+                        return result * result;
+                    case PCTSignatures::L0_5:
+                        return result * result;
+                    case PCTSignatures::L2:
+                        return std::sqrt(result);
+                    case PCTSignatures::L5:
+                        return std::pow(result, (float)0.2);
+                    default:
+                        return result;
+                    }
+                }
+
+#if CV_SIMD128
+                /** @brief Vectorized computeDistance(), with the centroids j to j + 3. */
+                v_float32x4 computeDistance(const v_float32x4* centroid, const float* const* centroids, int j) const
+                {
+                    v_float32x4 result = v_setzero_f32();
+                    for (int d = 1; d < SIGNATURE_DIMENSION; d++)
+                    {
+                        v_float32x4 difference = centroid[d] - v_load(centroids[d] + j);
+                        switch (mDistanceFunction)
+                        {
+                        case PCTSignatures::L0_25:
+                            result += v_sqrt(v_sqrt(v_abs(difference)));
+                            break;
+                        case PCTSignatures::L0_5:
+                            result += v_sqrt(v_abs(difference));
+                            break;
+                        case PCTSignatures::L1:
+                            result += v_abs(difference);
+                            break;
+                        case PCTSignatures::L_INFINITY:
+                            result = v_max(result, difference);
+                            break;
+                        default:
+                            result = v_fma(difference, difference, result);
+                        }
+                    }
+                    switch (mDistanceFunction)
+                    {
+                    case PCTSignatures::L0_25:
+                        result *= result;
+                        return result * result;
+                    case PCTSignatures::L0_5:
+                        return result * result;
+                    case PCTSignatures::L2:
+                        return v_sqrt(result);
+                    default:
+                        return result;
+                    }
+                }
+#endif
+            };
+
+
+            void PCTSignaturesSQFDDatabase_Impl::add(const std::vector<Mat>& signatures)
+            {
+                for (size_t i = 0; i < signatures.size(); i++)
+                {
+                    const Mat& signature = signatures[i];
+                    if (signature.empty() || signature.rows <= 0)
+                    {
+                        CV_Error_(Error::StsBadArg, ("Signature ID: %d is empty!", (int)i));
+                    }
+                    if (signature.cols != SIGNATURE_DIMENSION || signature.type() != CV_32F)
+                    {
+                        CV_Error_(Error::StsBadArg, ("Signature dimension must be %d!", SIGNATURE_DIMENSION));
+                    }
+                }
+
+                for (size_t i = 0; i < signatures.size(); i++)
+                {
+                    const Mat& signature = signatures[i];
+                    for (int r = 0; r < signature.rows; r++)
+                    {
+                        const float* centroid = signature.ptr<float>(r);
+                        for (int d = 0; d < SIGNATURE_DIMENSION; d++)
+                        {
+                            mCentroids[d].push_back(centroid[d]);
+                        }
+                    }
+                    mOffsets.push_back(mOffsets.back() + signature.rows);
+                }
+
+                // the self-similarity terms do not depend on the queries, compute them once
+                const float* centroids[SIGNATURE_DIMENSION];
+                getCentroids(centroids);
+                size_t first = mSelfTerms.size();
+                mSelfTerms.resize(first + signatures.size());
+                parallel_for_(Range(0, (int)signatures.size()), [&](const Range& range)
+                {
+                    for (int i = range.start; i < range.end; i++)
+                    {
+                        mSelfTerms[first + i] = computePartialSQFD(
+                            signatures[i], centroids, mOffsets[first + i], mOffsets[first + i + 1]);
+                    }
+                });
+            }
+
+
+            float PCTSignaturesSQFDDatabase_Impl::computePartialSQFD(
+                const Mat& signature,
+                const float* const* centroids,
+                int begin,
+                int end) const
+            {
+                const float* weights = centroids[WEIGHT_IDX];
+                float result = 0;
+                for (int i = 0; i < signature.rows; i++)
+                {
+                    const float* centroid = signature.ptr<float>(i);
+                    float partial = 0;
+                    int j = begin;
+#if CV_SIMD128
+                    v_float32x4 centroidVec[SIGNATURE_DIMENSION];
+                    for (int d = 0; d < SIGNATURE_DIMENSION; d++)
+                    {
+                        centroidVec[d] = v_setall_f32(centroid[d]);
+                    }
+                    // pow has no vector counterpart
+                    if (mDistanceFunction != PCTSignatures::L5)
+                    {
+                        const v_float32x4 parameter = v_setall_f32(mSimilarityParameter);
+                        v_float32x4 sum = v_setzero_f32();
+                        for (; j <= end - 4; j += 4)
+                        {
+                            v_float32x4 distance = computeDistance(centroidVec, centroids, j);
+                            v_float32x4 similarity;
+                            if (mSimilarityFunction == PCTSignatures::MINUS)
+                            {
+                                similarity = v_setzero_f32() - distance;
+                            }
+                            else if (mSimilarityFunction == PCTSignatures::HEURISTIC)
+                            {
+                                similarity = v_setall_f32(1.f) / (parameter + distance);
+                            }
+                            else
+                            {
+                                float buf[4];
+                                v_store(buf, distance);
+                                for (int k = 0; k < 4; k++)
+                                {
+                                    buf[k] = computeSimilarity(buf[k]);
+                                }
+                                similarity = v_load(buf);
+                            }
+                            sum = v_fma(v_load(weights + j), similarity, sum);
+                        }
+                        partial = v_reduce_sum(sum);
+                    }
+#endif
+                    for (; j < end; j++)
+                    {
+                        partial += weights[j] * computeSimilarity(computeDistance(centroid, centroids, j));
+                    }
+                    result += centroid[WEIGHT_IDX] * partial;
+                }
+                return result;
+            }
+
+
+            void PCTSignaturesSQFDDatabase_Impl::computeQuadraticFormDistances(
+                const Mat& querySignature,
+                std::vector<float>& distances) const
+            {
+                if (querySignature.empty())
+                {
+                    CV_Error(Error::StsBadArg, "Source signature is empty!");
+                }
+                if (querySignature.cols != SIGNATURE_DIMENSION || querySignature.type() != CV_32F)
+                {
+                    CV_Error_(Error::StsBadArg, ("Signature dimension must be %d!", SIGNATURE_DIMENSION));
+                }
+
+                const int count = getSignatureCount();
+                distances.resize(count);
+                if (count == 0)
+                {
+                    return;
+                }
+
+                const float querySelfTerm = computeSelfTerm(querySignature);
+                const float* centroids[SIGNATURE_DIMENSION];
+                getCentroids(centroids);
+
+                // shards of signatures, the similarities with the query are the only terms left to compute
+                parallel_for_(Range(0, count), [&](const Range& range)
+                {
+                    for (int i = range.start; i < range.end; i++)
+                    {
+                        float crossTerm = computePartialSQFD(querySignature, centroids, mOffsets[i], mOffsets[i + 1]);
+                        float result = querySelfTerm + mSelfTerms[i] - crossTerm * 2;
+                        // rounding errors can make the distance of identical signatures slightly negative
+                        distances[i] = sqrt(std::max(result, 0.f));
+                    }
+                });
+            }
+
+
+            void PCTSignaturesSQFDDatabase_Impl::search(
+                const Mat& querySignature,
+                int k,
+                std::vector<int>& indices,
+                std::vector<float>& distances) const
+            {
+                CV_Assert(k > 0);
+
+                std::vector<float> allDistances;
+                computeQuadraticFormDistances(querySignature, allDistances);
+
+                k = std::min(k, (int)allDistances.size());
+                indices.resize(allDistances.size());
+                for (size_t i = 0; i < indices.size(); i++)
+                {
+                    indices[i] = (int)i;
+                }
+                // ties are broken by the order in which the signatures were added
+                auto closer = [&allDistances](int a, int b)
+                {
+                    return allDistances[a] < allDistances[b] || (allDistances[a] == allDistances[b] && a < b);
+                };
+                std::nth_element(indices.begin(), indices.begin() + k, indices.end(), closer);
+                std::sort(indices.begin(), indices.begin() + k, closer);
+                indices.resize(k);
+
+                distances.resize(k);
+                for (int i = 0; i < k; i++)
+                {
+                    distances[i] = allDistances[indices[i]];
+                }
+            }
+
         }// end of namespace pct_signatures
 
 
@@ -220,5 +602,13 @@ namespace cv
             return makePtr<pct_signatures::PCTSignaturesSQFD_Impl>(distanceFunction, similarityFunction, similarityParameter);
         }
 
+        Ptr<PCTSignaturesSQFDDatabase> PCTSignaturesSQFDDatabase::create(
+            const int distanceFunction,
+            const int similarityFunction,
+            const float similarityParameter)
+        {
+            return makePtr<pct_signatures::PCTSignaturesSQFDDatabase_Impl>(distanceFunction, similarityFunction, similarityParameter);
+        }
+
     }
 }
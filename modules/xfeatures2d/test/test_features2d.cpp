@@ -141,6 +141,44 @@ TEST( Features2d_DescriptorExtractor_DAISY, regression )
     test.safe_run();
 }
 
+TEST( Features2d_DescriptorExtractor_DAISY, cached_image )
+{
+    Mat img = imread(string(cvtest::TS::ptr()->get_data_path()) + "shared/graffiti.png", IMREAD_GRAYSCALE);
+    ASSERT_FALSE(img.empty());
+
+    vector<KeyPoint> keypoints;
+    for (int y = 20; y < img.rows - 20; y += 37)
+        for (int x = 20; x < img.cols - 20; x += 41)
+            keypoints.push_back(KeyPoint((float)x + 0.3f, (float)y + 0.6f, 1.f));
+
+    Ptr<DAISY> daisy = DAISY::create(15, 3, 8, 8, DAISY::NRM_PARTIAL);
+    Mat expected;
+    daisy->compute(img, keypoints, expected);
+    ASSERT_EQ((int)keypoints.size(), expected.rows);
+
+    // repeated queries on the image set once give the same descriptors
+    daisy->setImage(img);
+    Mat first, second;
+    daisy->GetDescriptors(vector<KeyPoint>(keypoints.begin(), keypoints.begin() + keypoints.size()/2), first);
+    daisy->GetDescriptors(vector<KeyPoint>(keypoints.begin() + keypoints.size()/2, keypoints.end()), second);
+    Mat cached;
+    vconcat(first, second, cached);
+    EXPECT_EQ(0, cvtest::norm(expected, cached, NORM_INF));
+
+    // quantized output stays within rounding of the scaled float descriptors
+    daisy->setDescriptorType(CV_8U);
+    EXPECT_EQ(CV_8U, daisy->descriptorType());
+    Mat quantized;
+    daisy->GetDescriptors(keypoints, quantized);
+    ASSERT_EQ(CV_8U, quantized.type());
+    Mat scaled;
+    expected.convertTo(scaled, CV_8U, 255.);
+    EXPECT_LE(cvtest::norm(scaled, quantized, NORM_INF), 1.);
+
+    // unnormalized descriptors have no range to quantize
+    EXPECT_THROW(DAISY::create()->setDescriptorType(CV_8U), cv::Exception);
+}
+
 TEST( Features2d_DescriptorExtractor_FREAK, regression )
 {
     CV_DescriptorExtractorTest<Hamming> test("descriptor-freak", (CV_DescriptorExtractorTest<Hamming>::DistanceType)12.f,
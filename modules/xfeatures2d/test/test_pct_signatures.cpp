@@ -0,0 +1,85 @@
+// This file is part of OpenCV project.
+// It is subject to the license terms in the LICENSE file found in the top-level directory
+// of this distribution and at http://opencv.org/license.html.
+
+#include "test_precomp.hpp"
+
+namespace opencv_test { namespace {
+
+static std::vector<Mat> randomSignatures(RNG& rng, int count)
+{
+    std::vector<Mat> signatures;
+    for (int i = 0; i < count; i++)
+    {
+        Mat signature(rng.uniform(1, 20), 8, CV_32F);
+        rng.fill(signature, RNG::UNIFORM, 0.f, 1.f);
+        signatures.push_back(signature);
+    }
+    return signatures;
+}
+
+typedef testing::TestWithParam< tuple<int, int> > PCTSignaturesSQFDDatabaseTest;
+
+TEST_P(PCTSignaturesSQFDDatabaseTest, accuracy)
+{
+    const int distanceFunction = get<0>(GetParam());
+    const int similarityFunction = get<1>(GetParam());
+
+    RNG rng(0);
+    std::vector<Mat> signatures = randomSignatures(rng, 100);
+    std::vector<Mat> queries = randomSignatures(rng, 3);
+    queries.push_back(signatures[42]);
+
+    Ptr<PCTSignaturesSQFD> sqfd = PCTSignaturesSQFD::create(distanceFunction, similarityFunction, 0.5f);
+    Ptr<PCTSignaturesSQFDDatabase> database =
+        PCTSignaturesSQFDDatabase::create(distanceFunction, similarityFunction, 0.5f);
+    database->add(std::vector<Mat>(signatures.begin(), signatures.begin() + 60));
+    database->add(std::vector<Mat>(signatures.begin() + 60, signatures.end()));
+    ASSERT_EQ(100, database->getSignatureCount());
+
+    for (size_t q = 0; q < queries.size(); q++)
+    {
+        std::vector<float> expected, distances;
+        sqfd->computeQuadraticFormDistances(queries[q], signatures, expected);
+        database->computeQuadraticFormDistances(queries[q], distances);
+        ASSERT_EQ(expected.size(), distances.size());
+        for (size_t i = 0; i < distances.size(); i++)
+        {
+            // the collection reports 0 instead of NaN for negative squared distances
+            if (cvIsNaN(expected[i]))
+                EXPECT_LE(distances[i], 1e-2f) << "signature " << i;
+            else
+                EXPECT_NEAR(expected[i], distances[i], 1e-2f * std::max(1.f, expected[i])) << "signature " << i;
+        }
+
+        std::vector<int> indices;
+        std::vector<float> topDistances;
+        database->search(queries[q], 5, indices, topDistances);
+        ASSERT_EQ(5u, indices.size());
+        ASSERT_EQ(5u, topDistances.size());
+        for (int i = 0; i < 5; i++)
+        {
+            EXPECT_EQ(distances[indices[i]], topDistances[i]);
+            if (i > 0)
+                EXPECT_LE(topDistances[i - 1], topDistances[i]);
+        }
+        EXPECT_LE(std::count_if(distances.begin(), distances.end(),
+                                [&](float d) { return d < topDistances[4]; }), 4);
+    }
+
+    // MINUS similarity does not give a metric, other signatures can be at distance 0
+    if (similarityFunction != PCTSignatures::MINUS)
+    {
+        std::vector<int> indices;
+        std::vector<float> topDistances;
+        database->search(signatures[42], 1, indices, topDistances);
+        ASSERT_EQ(1u, indices.size());
+        EXPECT_EQ(42, indices[0]);
+    }
+}
+
+INSTANTIATE_TEST_CASE_P(/**/, PCTSignaturesSQFDDatabaseTest, testing::Combine(
+    testing::Values((int)PCTSignatures::L1, (int)PCTSignatures::L2, (int)PCTSignatures::L5, (int)PCTSignatures::L_INFINITY),
+    testing::Values((int)PCTSignatures::MINUS, (int)PCTSignatures::GAUSSIAN, (int)PCTSignatures::HEURISTIC)));
+
+}} // namespace
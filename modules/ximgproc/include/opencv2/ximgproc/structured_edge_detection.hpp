@@ -127,12 +127,21 @@ public:
     @param isParallel enables/disables parallel computing.
      */
     CV_WRAP virtual void edgesNms(cv::InputArray edge_image, cv::InputArray orientation_image, cv::OutputArray _dst, int r = 2, int s = 0, float m = 1, bool isParallel = true) const = 0;
+
+    /** @brief Stores the model in a compact binary format.
+
+    The binary file holds the forest as flat arrays in native byte order, it loads much faster than
+    the .yml.gz model. createStructuredEdgeDetection recognizes both formats.
+    @param filename name of the binary model file.
+     */
+    CV_WRAP virtual void saveModel(const String &filename) const = 0;
 };
 
 /*!
 * The only constructor
 *
-* \param model : name of the file where the model is stored
+* \param model : name of the file where the model is stored, either in the
+*                FileStorage format or in the binary format written by saveModel
 * \param howToGetFeatures : optional object inheriting from RFFeatureGetter.
 *                           You need it only if you would like to train your
 *                           own forest, pass NULL otherwise
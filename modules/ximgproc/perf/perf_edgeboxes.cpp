@@ -0,0 +1,37 @@
+// This file is part of OpenCV project.
+// It is subject to the license terms in the LICENSE file found in the top-level directory
+// of this distribution and at http://opencv.org/license.html.
+#include "perf_precomp.hpp"
+
+namespace opencv_test { namespace {
+
+typedef tuple<std::string, int> EdgeBoxesParams;
+typedef perf::TestBaseWithParam<EdgeBoxesParams> EdgeBoxesPerfTest;
+
+PERF_TEST_P(EdgeBoxesPerfTest, getBoundingBoxes,
+            testing::Combine(testing::Values("sources/01.png", "sources/02.png"), testing::Values(30, 1000)))
+{
+    const std::string name = get<0>(GetParam());
+    const int maxBoxes = get<1>(GetParam());
+
+    Ptr<StructuredEdgeDetection> sed = createStructuredEdgeDetection(getDataPath("cv/ximgproc/model.yml.gz"));
+
+    Mat src = imread(getDataPath("cv/ximgproc/" + name), IMREAD_COLOR);
+    ASSERT_FALSE(src.empty());
+    src.convertTo(src, CV_32F, 1/255.0);
+
+    Mat edges, orientation, edgesNms;
+    sed->detectEdges(src, edges);
+    sed->computeOrientation(edges, orientation);
+    sed->edgesNms(edges, orientation, edgesNms, 2, 0, 1, true);
+
+    Ptr<EdgeBoxes> edgeBoxes = createEdgeBoxes();
+    edgeBoxes->setMaxBoxes(maxBoxes);
+
+    std::vector<Rect> boxes;
+    TEST_CYCLE() edgeBoxes->getBoundingBoxes(edgesNms, orientation, boxes);
+
+    SANITY_CHECK_NOTHING();
+}
+
+}} // namespace
@@ -0,0 +1,32 @@
+// This file is part of OpenCV project.
+// It is subject to the license terms in the LICENSE file found in the top-level directory
+// of this distribution and at http://opencv.org/license.html.
+#include "perf_precomp.hpp"
+
+namespace opencv_test { namespace {
+
+using namespace cv::ximgproc::segmentation;
+
+typedef TestBaseWithParam<Size> GraphSegmentationTest;
+
+PERF_TEST_P(GraphSegmentationTest, processImage, Values(sz720p, sz1080p, Size(4000, 3000)))
+{
+    Size sz = GetParam();
+
+    // piecewise smooth image: upscaled random colors with some noise on top
+    RNG rng(1234);
+    Mat small(sz.height / 32, sz.width / 32, CV_8UC3), noise(sz, CV_8UC3), src;
+    rng.fill(small, RNG::UNIFORM, 0, 256);
+    resize(small, src, sz, 0, 0, INTER_LINEAR);
+    rng.fill(noise, RNG::UNIFORM, 0, 16);
+    src += noise;
+
+    Ptr<GraphSegmentation> gs = createGraphSegmentation();
+    Mat dst;
+
+    TEST_CYCLE() gs->processImage(src, dst);
+
+    SANITY_CHECK_NOTHING();
+}
+
+}} // namespace
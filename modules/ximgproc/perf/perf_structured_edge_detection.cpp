@@ -0,0 +1,24 @@
+// This file is part of OpenCV project.
+// It is subject to the license terms in the LICENSE file found in the top-level directory
+// of this distribution and at http://opencv.org/license.html.
+#include "perf_precomp.hpp"
+
+namespace opencv_test { namespace {
+
+typedef perf::TestBaseWithParam<std::string> StructuredEdgeDetectionPerfTest;
+
+PERF_TEST_P(StructuredEdgeDetectionPerfTest, detectEdges, testing::Values("sources/01.png", "sources/02.png"))
+{
+    Ptr<StructuredEdgeDetection> sed = createStructuredEdgeDetection(getDataPath("cv/ximgproc/model.yml.gz"));
+
+    Mat src = imread(getDataPath("cv/ximgproc/" + GetParam()), IMREAD_COLOR);
+    ASSERT_FALSE(src.empty());
+    src.convertTo(src, CV_32F, 1/255.0);
+
+    Mat dst;
+    TEST_CYCLE() sed->detectEdges(src, dst);
+
+    SANITY_CHECK_NOTHING();
+}
+
+}} // namespace
@@ -44,5 +44,29 @@ PERF_TEST_P(WeightedMedianFilterTest, perf,
     SANITY_CHECK_NOTHING();
 }
 
+typedef TestBaseWithParam<int> WeightedMedianFilterThreadsTest;
+
+PERF_TEST_P(WeightedMedianFilterThreadsTest, perf, Values(1, 2, 4, 8, 16))
+{
+    int numThreads = GetParam();
+
+    Mat joint(sz720p, CV_8UC3);
+    Mat src(sz720p, CV_8UC3);
+    Mat dst(sz720p, src.type());
+
+    declare.in(joint, src, WARMUP_RNG).out(dst);
+
+    int prevNumThreads = getNumThreads();
+    setNumThreads(numThreads);
+
+    TEST_CYCLE_N(1)
+    {
+        weightedMedianFilter(joint, src, dst, 10, 25.0, WMF_EXP);
+    }
+
+    setNumThreads(prevNumThreads);
+
+    SANITY_CHECK_NOTHING();
+}
 
 }} // namespace
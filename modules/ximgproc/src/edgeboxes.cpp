@@ -161,19 +161,25 @@ private:
     vector<float> _scaleNorm;
     float _sxStep, _ayStep, _xyStepRatio;
 
-    // data structures for efficiency (see scoreBox)
-    Mat _sWts;
-    Mat _sDone, _sMap, _sIds;
-    int _sId;
+    // data structures for efficiency (see scoreBox), one per thread
+    struct ScoreScratch
+    {
+        explicit ScoreScratch(int n) : sWts(n, 0), sDone(n, -1), sMap(n, 0), sIds(n, 0), sId(0) {}
+
+        vector<float> sWts;
+        vector<int> sDone, sMap, sIds;
+        int sId;
+    };
 
     // helper routines
     static bool boxesCompare(const Box &a, const Box &b) { return a.score < b.score; }
     void clusterEdges(Mat &edgeMap, Mat &orientationMap);
     void prepDataStructs(Mat &edgeMap);
     void scoreAllBoxes(Boxes &boxes);
-    void scoreBox(Box &box);
-    void refineBox(Box &box);
-    float boxesOverlap(Box &a, Box &b);
+    bool boundBox(Box &box, float &v, float &norm) const;
+    void scoreBox(Box &box, ScoreScratch &scratch) const;
+    void refineBox(Box &box, ScoreScratch &scratch) const;
+    float boxesOverlap(const Box &a, const Box &b) const;
     void boxesNms(Boxes &boxes, float thr, float eta, int maxBoxes);
 };
 
@@ -523,64 +529,56 @@ void EdgeBoxesImpl::prepDataStructs(Mat &edgeMap)
       }
     }
 
-    // create remaining data structures
-    int s = 0;
-    int s1;
-
-    _hIdxs.resize(h);
+    // create remaining data structures, every row and column is independent
+    _hIdxs.assign(h, vector<int>());
     _hIdxImg = Mat::zeros(w, h, DataType<int>::type);
-    for (y = 0; y < h; y++)
+    parallel_for_(Range(0, h), [&](const Range& range)
     {
-        s = 0;
-        _hIdxs[y].push_back(s);
-        for (x = 0; x < w; x++)
+        for (int yy = range.start; yy < range.end; yy++)
         {
-            s1 = _segIds.at<int>(x, y);
-            if (s1 != s)
+            int s = 0;
+            _hIdxs[yy].push_back(s);
+            for (int xx = 0; xx < w; xx++)
             {
-                s = s1;
-                _hIdxs[y].push_back(s);
+                int s1 = _segIds.at<int>(xx, yy);
+                if (s1 != s)
+                {
+                    s = s1;
+                    _hIdxs[yy].push_back(s);
+                }
+                _hIdxImg.at<int>(xx, yy) = (int)_hIdxs[yy].size() - 1;
             }
-            _hIdxImg.at<int>(x, y) = (int)_hIdxs[y].size() - 1;
         }
-    }
+    });
 
-    _vIdxs.resize(w);
+    _vIdxs.assign(w, vector<int>());
     _vIdxImg = Mat::zeros(w, h, DataType<int>::type);
-    for (x = 0; x < w; x++)
+    parallel_for_(Range(0, w), [&](const Range& range)
     {
-        s = 0;
-        _vIdxs[x].push_back(s);
-        for (y = 0; y < h; y++)
+        for (int xx = range.start; xx < range.end; xx++)
         {
-            s1 = _segIds.at<int>(x, y);
-            if (s1 != s)
+            int s = 0;
+            const int *s_ptr = _segIds.ptr<int>(xx);
+            int *v_ptr = _vIdxImg.ptr<int>(xx);
+            _vIdxs[xx].push_back(s);
+            for (int yy = 0; yy < h; yy++)
             {
-                s = s1;
-                _vIdxs[x].push_back(s);
+                int s1 = s_ptr[yy];
+                if (s1 != s)
+                {
+                    s = s1;
+                    _vIdxs[xx].push_back(s);
+                }
+                v_ptr[yy] = (int)_vIdxs[xx].size() - 1;
             }
-            _vIdxImg.at<int>(x, y) = (int)_vIdxs[x].size() - 1;
         }
-    }
-
-    // initialize scoreBox() data structures
-    int n = _segCnt + 1;
-    _sWts = Mat::zeros(n, 1, DataType<float>::type);
-    _sDone = Mat(n, 1, DataType<int>::type,Scalar(-1));
-    _sMap = Mat::zeros(n, 1, DataType<int>::type);
-    _sIds = Mat::zeros(n, 1, DataType<int>::type);
-    _sId = 0;
+    });
 }
 
 
-void EdgeBoxesImpl::scoreBox(Box &box)
+bool EdgeBoxesImpl::boundBox(Box &box, float &v, float &norm) const
 {
-    int i, j, k, q, bh, bw, y0, x0, y1, x1, y0m, y1m, x0m, x1m;
-    float *sWts = (float *)_sWts.data;
-    int *sDone = (int *)_sDone.data;
-    int *sMap = (int *)_sMap.data;
-    int *sIds = (int *)_sIds.data;
-    int sId = _sId++;
+    int bh, bw, y0, x0, y1, x1, y0m, y1m, x0m, x1m;
 
     // add edge count inside box
     y1 = clamp(box.y + box.h, 0, h - 1);
@@ -591,8 +589,8 @@ void EdgeBoxesImpl::scoreBox(Box &box)
     bh /= 2;
     bw = box.w = x1 - box.x;
     bw /= 2;
-    float v = _segIImg.at<float>(x0, y0) + _segIImg.at<float>(x1 + 1, y1 + 1)
-              - _segIImg.at<float>(x1 + 1, y0) - _segIImg.at<float>(x0, y1 + 1);
+    v = _segIImg.at<float>(x0, y0) + _segIImg.at<float>(x1 + 1, y1 + 1)
+        - _segIImg.at<float>(x1 + 1, y0) - _segIImg.at<float>(x0, y1 + 1);
 
     // subtract middle quarter of edges
     y0m = y0 + bh / 2;
@@ -603,13 +601,32 @@ void EdgeBoxesImpl::scoreBox(Box &box)
          - _magIImg.at<float>(x1m + 1, y0m) - _magIImg.at<float>(x0m, y1m + 1);
 
     // short circuit computation if impossible to score highly
-    float norm = _scaleNorm[bw + bh];
+    norm = _scaleNorm[bw + bh];
     box.score = v * norm;
-    if (box.score < _minScore)
+    return box.score >= _minScore;
+}
+
+
+void EdgeBoxesImpl::scoreBox(Box &box, ScoreScratch &scratch) const
+{
+    int i, j, k, q, y0, x0, y1, x1;
+    float v, norm;
+    float *sWts = &scratch.sWts[0];
+    int *sDone = &scratch.sDone[0];
+    int *sMap = &scratch.sMap[0];
+    int *sIds = &scratch.sIds[0];
+    int sId = scratch.sId++;
+
+    // the integral images bound the score from above
+    if (!boundBox(box, v, norm))
     {
         box.score = 0;
         return;
     }
+    y0 = box.y;
+    y1 = box.y + box.h;
+    x0 = box.x;
+    x1 = box.x + box.w;
 
     // find interesecting segments along four boundaries
     int cs, ce, rs, re, n = 0;
@@ -709,7 +726,7 @@ void EdgeBoxesImpl::scoreBox(Box &box)
 }
 
 
-void EdgeBoxesImpl::refineBox(Box &box)
+void EdgeBoxesImpl::refineBox(Box &box, ScoreScratch &scratch) const
 {
     int yStep = (int)(box.h * _xyStepRatio);
     int xStep = (int)(box.w * _xyStepRatio);
@@ -726,53 +743,53 @@ void EdgeBoxesImpl::refineBox(Box &box)
         B = box;
         B.y = box.y - yStep;
         B.h = B.h + yStep;
-        scoreBox(B);
+        scoreBox(B, scratch);
 
         if (B.score <= box.score)
         {
             B = box;
             B.y = box.y + yStep;
             B.h = B.h - yStep;
-            scoreBox(B);
+            scoreBox(B, scratch);
         }
         if (B.score > box.score) box = B;
         // search over y end
         B = box;
         B.h = B.h + yStep;
-        scoreBox(B);
+        scoreBox(B, scratch);
 
         if (B.score <= box.score)
         {
             B = box;
             B.h = B.h - yStep;
-            scoreBox(B);
+            scoreBox(B, scratch);
         }
         if (B.score > box.score) box = B;
         // search over x start
         B = box;
         B.x = box.x - xStep;
         B.w = B.w + xStep;
-        scoreBox(B);
+        scoreBox(B, scratch);
 
         if (B.score <= box.score)
         {
             B = box;
             B.x = box.x + xStep;
             B.w = B.w - xStep;
-            scoreBox(B);
+            scoreBox(B, scratch);
         }
 
         if (B.score > box.score) box = B;
         // search over x end
         B = box;
         B.w = B.w + xStep;
-        scoreBox(B);
+        scoreBox(B, scratch);
 
         if (B.score <= box.score)
         {
             B = box;
             B.w = B.w - xStep;
-            scoreBox(B);
+            scoreBox(B, scratch);
         }
         if (B.score > box.score) box = B;
     }
@@ -781,18 +798,22 @@ void EdgeBoxesImpl::refineBox(Box &box)
 void EdgeBoxesImpl::scoreAllBoxes(Boxes &boxes)
 {
     // get list of all boxes roughly distributed in grid
-    boxes.resize(0);
     int ayRad, sxNum;
     float minSize = sqrt(_minBoxArea);
     ayRad = (int)(log(_maxAspectRatio) / log(_ayStep * _ayStep));
     sxNum = (int)(ceil(log(max(w, h) / minSize) / log(_sxStep)));
 
-    for (int s = 0; s < sxNum; s++)
+    // boxes of every scale and aspect ratio, the ones that cannot score
+    // highly according to the integral images are dropped right away
+    const int nShapes = sxNum * (2 * ayRad + 1);
+    vector<Boxes> shapeBoxes(max(nShapes, 0));
+    parallel_for_(Range(0, max(nShapes, 0)), [&](const Range& range)
     {
-        int a, y, x, bh, bw, ky, kx = -1;
-        float ay, sx;
-        for (a = 0; a < 2 * ayRad + 1; a++)
+        for (int shape = range.start; shape < range.end; shape++)
         {
+            int s = shape / (2 * ayRad + 1), a = shape % (2 * ayRad + 1);
+            int y, x, bh, bw, ky, kx;
+            float ay, sx, v, norm;
             ay = pow(_ayStep, float(a - ayRad));
             sx = minSize * pow(_sxStep, float(s));
             bh = (int)(sx / ay);
@@ -808,27 +829,42 @@ void EdgeBoxesImpl::scoreAllBoxes(Boxes &boxes)
                     b.x = x;
                     b.h = bh;
                     b.w = bw;
-                    boxes.push_back(b);
+                    if (boundBox(b, v, norm))
+                        shapeBoxes[shape].push_back(b);
                 }
             }
         }
-    }
+    });
+
+    boxes.resize(0);
+    for (size_t shape = 0; shape < shapeBoxes.size(); shape++)
+        boxes.insert(boxes.end(), shapeBoxes[shape].begin(), shapeBoxes[shape].end());
 
     // score all boxes, refine top candidates
-    int i, k = 0, m = (int)boxes.size();
-    for (i = 0; i < m; i++)
+    int m = (int)boxes.size();
+    parallel_for_(Range(0, m), [&](const Range& range)
+    {
+        ScoreScratch scratch(_segCnt + 1);
+        for (int i = range.start; i < range.end; i++)
+        {
+            scoreBox(boxes[i], scratch);
+            if (!boxes[i].score) continue;
+            refineBox(boxes[i], scratch);
+        }
+    }, max(1, getNumThreads() * 4));
+
+    // refinement never lowers a score
+    int k = 0;
+    for (int i = 0; i < m; i++)
     {
-        scoreBox(boxes[i]);
-        if (!boxes[i].score) continue;
-        k++;
-        refineBox(boxes[i]);
+        if (boxes[i].score) k++;
     }
     sort(boxes.rbegin(), boxes.rend(), boxesCompare);
     boxes.resize(k);
 }
 
 
-float EdgeBoxesImpl::boxesOverlap(Box &a, Box &b)
+float EdgeBoxesImpl::boxesOverlap(const Box &a, const Box &b) const
 {
     float areai, areaj, areaij;
     int y0, y1, x0, x1, y1i, x1i, y1j, x1j;
@@ -851,6 +887,19 @@ float EdgeBoxesImpl::boxesOverlap(Box &a, Box &b)
 }
 
 
+// uniform grid over the kept boxes of one area bin, every box is registered
+// in all the cells it covers
+struct BoxGrid
+{
+    BoxGrid() : cell(0) {}
+
+    static int64 key(int cx, int cy) { return ((int64)cy << 32) | (unsigned)cx; }
+
+    int cell;
+    std::map<int64, vector<int> > cells;
+};
+
+
 void EdgeBoxesImpl::boxesNms(Boxes &boxes, float thr, float eta, int maxBoxes)
 {
     sort(boxes.rbegin(), boxes.rend(), boxesCompare);
@@ -860,32 +909,66 @@ void EdgeBoxesImpl::boxesNms(Boxes &boxes, float thr, float eta, int maxBoxes)
     const float step = 1 / thr;
     const float lstep = log(step);
 
-    vector<Boxes> kept;
-    kept.resize(nBin + 1);
+    // boxes of a bin have similar areas, so only the kept boxes sharing a grid
+    // cell with the current one can overlap it
+    vector<vector<int> > kept(nBin + 1);
+    vector<BoxGrid> grids(nBin + 1);
+    Boxes keptBoxes;
+    vector<int> visited;
     int n = (int) boxes.size();
     int i = 0;
-    int j, k, b;
+    int j, k, b, cx, cy;
     int m = 0;
     int d = 1;
 
     while (i < n && m < maxBoxes)
     {
-        b = boxes[i].w * boxes[i].h;
+        const Box &box = boxes[i];
+        b = box.w * box.h;
 
         bool keep = 1;
         b = clamp((int)(ceil(log(float(b)) / lstep)), d, nBin - d);
-        for (j = b - d; j <= b + d; j++)
+        for (j = b - d; j <= b + d && keep; j++)
         {
-            for (k = 0; k < (int)kept[j].size(); k++)
+            const BoxGrid &grid = grids[j];
+            if (grid.cell == 0 || box.w <= 0 || box.h <= 0) continue;
+            int cx0 = box.x / grid.cell, cx1 = (box.x + box.w - 1) / grid.cell;
+            int cy0 = box.y / grid.cell, cy1 = (box.y + box.h - 1) / grid.cell;
+            for (cy = cy0; cy <= cy1 && keep; cy++)
             {
-                if (keep)
-                    keep = boxesOverlap(boxes[i], kept[j][k]) <= thr;
+                for (cx = cx0; cx <= cx1 && keep; cx++)
+                {
+                    std::map<int64, vector<int> >::const_iterator it = grid.cells.find(BoxGrid::key(cx, cy));
+                    if (it == grid.cells.end()) continue;
+                    const vector<int> &ids = it->second;
+                    for (k = 0; k < (int)ids.size() && keep; k++)
+                    {
+                        if (visited[ids[k]] == i) continue;
+                        visited[ids[k]] = i;
+                        keep = boxesOverlap(box, keptBoxes[ids[k]]) <= thr;
+                    }
+                }
             }
         }
 
         if (keep)
         {
-            kept[b].push_back(boxes[i]);
+            int id = (int)keptBoxes.size();
+            keptBoxes.push_back(box);
+            visited.push_back(-1);
+            kept[b].push_back(id);
+
+            BoxGrid &grid = grids[b];
+            if (grid.cell == 0)
+                grid.cell = max(1, (int)ceil(sqrt((float)box.w * box.h)));
+            if (box.w > 0 && box.h > 0)
+            {
+                for (cy = box.y / grid.cell; cy <= (box.y + box.h - 1) / grid.cell; cy++)
+                {
+                    for (cx = box.x / grid.cell; cx <= (box.x + box.w - 1) / grid.cell; cx++)
+                        grid.cells[BoxGrid::key(cx, cy)].push_back(id);
+                }
+            }
             m++;
         }
 
@@ -903,7 +986,7 @@ void EdgeBoxesImpl::boxesNms(Boxes &boxes, float thr, float eta, int maxBoxes)
     {
         for (k = 0; k < (int)kept[j].size(); k++)
         {
-            boxes[i++] = kept[j][k];
+            boxes[i++] = keptBoxes[kept[j][k]];
         }
     }
     sort(boxes.rbegin(), boxes.rend(), boxesCompare);
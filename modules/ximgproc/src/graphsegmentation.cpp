@@ -49,37 +49,28 @@ namespace cv {
 
             // Helpers
 
-            // Represent an edge between two pixels
-            class Edge {
-                public:
-                    int from;
-                    int to;
-                    float weight;
-
-                    bool operator <(const Edge& e) const {
-                        return weight < e.weight;
-                    }
-            };
-
-            // A point in the sets of points
-            class PointSetElement {
-                public:
-                    int p;
-                    int size;
+            // Edges are identified by the pixel they start from: edge 2 * p links the pixel p to its
+            // right neighbour and edge 2 * p + 1 links it to the pixel under it
+            static inline int edgeFrom(int edge) {
+                return edge >> 1;
+            }
 
-                    PointSetElement() { }
+            static inline int edgeTo(int edge, int cols) {
+                return (edge & 1) ? (edge >> 1) + cols : (edge >> 1) + 1;
+            }
 
-                    PointSetElement(int p_) {
-                        p = p_;
-                        size = 1;
-                    }
-            };
+            // Bucket of a non-negative weight: the bit patterns of non-negative floats are ordered
+            // like their values, the 16 high bits give a bucket per 1/128 of octave
+            static inline int weightBucket(float weight) {
+                Cv32suf v;
+                v.f = weight;
+                return (int)(v.u >> 16);
+            }
 
             // An object to manage set of points, who can be fusionned
             class PointSet {
                 public:
                     PointSet(int nb_elements_);
-                    ~PointSet();
 
                     int nb_elements;
 
@@ -90,10 +81,11 @@ namespace cv {
                     void joinPoints(int p_a, int p_b);
 
                     // Return the set size of a set (based on the main point)
-                    int size(unsigned int p) { return mapping[p].size; }
+                    int size(int p) const { return sizes[p]; }
 
                 private:
-                    PointSetElement* mapping;
+                    std::vector<int> parents;
+                    std::vector<int> sizes;
 
             };
 
@@ -144,17 +136,20 @@ namespace cv {
                     // Pre-filter the image
                     void filter(const Mat &img, Mat &img_filtered);
 
-                    // Build the graph between each pixels
-                    void buildGraph(Edge **edges, int &nb_edges, const Mat &img_filtered);
+                    // Build the graph between each pixels, weights[e] is the weight of the edge e
+                    void buildGraph(std::vector<float> &weights, const Mat &img_filtered);
+
+                    // Sort the edges inside the image by weight
+                    void sortEdges(std::vector<int> &edges, const std::vector<float> &weights, const Mat &img_filtered);
 
                     // Segment the graph
-                    void segmentGraph(Edge * edges, const int &nb_edges, const Mat & img_filtered, PointSet **es);
+                    void segmentGraph(const std::vector<int> &edges, std::vector<float> &weights, const Mat &img_filtered, PointSet &es);
 
                     // Remove areas too small
-                    void filterSmallAreas(Edge *edges, const int &nb_edges, PointSet *es);
+                    void filterSmallAreas(const std::vector<int> &edges, const std::vector<float> &weights, const Mat &img_filtered, PointSet &es);
 
                     // Map the segemented graph to a Mat with uniques, sequentials ids
-                    void finalMapping(PointSet *es, Mat &output);
+                    void finalMapping(PointSet &es, Mat &output);
             };
 
             void GraphSegmentationImpl::filter(const Mat &img, Mat &img_filtered) {
@@ -168,96 +163,162 @@ namespace cv {
                 GaussianBlur(img_converted, img_filtered, Size(0, 0), sigma, sigma);
             }
 
-            void GraphSegmentationImpl::buildGraph(Edge **edges, int &nb_edges, const Mat &img_filtered) {
+            void GraphSegmentationImpl::buildGraph(std::vector<float> &weights, const Mat &img_filtered) {
 
-                *edges = new Edge[img_filtered.rows * img_filtered.cols * 4];
+                const int rows = img_filtered.rows;
+                const int cols = img_filtered.cols;
+                const int nb_channels = img_filtered.channels();
 
-                nb_edges = 0;
+                weights.resize((size_t)rows * cols * 2);
 
-                int nb_channels = img_filtered.channels();
+                // Edges leaving the image are never used, their weight is left to 0
+                parallel_for_(Range(0, rows), [&](const Range &range) {
+                    for (int i = range.start; i < range.end; i++) {
+                        const float* p = img_filtered.ptr<float>(i);
+                        const float* p_down = i + 1 < rows ? img_filtered.ptr<float>(i + 1) : NULL;
+                        float* w = &weights[(size_t)i * cols * 2];
 
-                for (int i = 0; i < (int)img_filtered.rows; i++) {
-                    const float* p = img_filtered.ptr<float>(i);
+                        for (int j = 0; j < cols; j++) {
 
-                    for (int j = 0; j < (int)img_filtered.cols; j++) {
+                            float right = 0, down = 0;
 
-                        //Take the right, left, top and down pixel
-                        for (int delta = -1; delta <= 1; delta += 2) {
-                            for (int delta_j = 0, delta_i = 1; delta_j <= 1; delta_j++ || delta_i--) {
+                            for (int channel = 0; channel < nb_channels; channel++) {
+                                float value = p[j * nb_channels + channel];
 
-                                int i2 = i + delta * delta_i;
-                                int j2 = j + delta * delta_j;
+                                if (j + 1 < cols) {
+                                    float diff = value - p[(j + 1) * nb_channels + channel];
+                                    right += diff * diff;
+                                }
 
-                                if (i2 >= 0 && i2 < img_filtered.rows && j2 >= 0 && j2 < img_filtered.cols) {
-                                    const float* p2 = img_filtered.ptr<float>(i2);
+                                if (p_down) {
+                                    float diff = value - p_down[j * nb_channels + channel];
+                                    down += diff * diff;
+                                }
+                            }
 
-                                    float tmp_total = 0;
+                            w[2 * j] = std::sqrt(right);
+                            w[2 * j + 1] = std::sqrt(down);
+                        }
+                    }
+                });
+            }
 
-                                    for ( int channel = 0; channel < nb_channels; channel++) {
-                                        tmp_total += pow(p[j * nb_channels + channel] - p2[j2 * nb_channels + channel], 2);
-                                    }
+            void GraphSegmentationImpl::sortEdges(std::vector<int> &edges, const std::vector<float> &weights, const Mat &img_filtered) {
 
-                                    float diff = 0;
-                                    diff = sqrt(tmp_total);
+                const int rows = img_filtered.rows;
+                const int cols = img_filtered.cols;
+                const int band_height = 64;
+                const int nb_bands = (rows + band_height - 1) / band_height;
 
-                                    (*edges)[nb_edges].weight = diff;
-                                    (*edges)[nb_edges].from = i * img_filtered.cols +  j;
-                                    (*edges)[nb_edges].to = i2 * img_filtered.cols + j2;
+                double max_weight = 0;
+                minMaxLoc(Mat(1, (int)weights.size(), CV_32F, (void*)&weights[0]), NULL, &max_weight);
+                const int nb_buckets = weightBucket((float)max_weight) + 1;
+
+                // Counting sort on the weight buckets: the edges of each band of rows are first counted
+                // per bucket, which gives the position of the first edge of every (band, bucket) pair,
+                // then stored at these positions
+                std::vector<int> positions((size_t)nb_bands * nb_buckets, 0);
+
+                auto processBands = [&](const Range &range, bool store) {
+                    for (int b = range.start; b < range.end; b++) {
+                        int* band_positions = &positions[(size_t)b * nb_buckets];
+                        int row_end = std::min(rows, (b + 1) * band_height);
+
+                        for (int i = b * band_height; i < row_end; i++) {
+                            for (int j = 0; j < cols; j++) {
+                                int edge = 2 * (i * cols + j);
+
+                                if (j + 1 < cols) {
+                                    int bucket = std::min(weightBucket(weights[edge]), nb_buckets - 1);
+                                    if (store)
+                                        edges[band_positions[bucket]] = edge;
+                                    band_positions[bucket]++;
+                                }
 
-                                    nb_edges++;
+                                if (i + 1 < rows) {
+                                    int bucket = std::min(weightBucket(weights[edge + 1]), nb_buckets - 1);
+                                    if (store)
+                                        edges[band_positions[bucket]] = edge + 1;
+                                    band_positions[bucket]++;
                                 }
                             }
                         }
                     }
+                };
+
+                parallel_for_(Range(0, nb_bands), [&](const Range &range) { processBands(range, false); });
+
+                std::vector<int> bucket_starts(nb_buckets + 1);
+                int nb_edges = 0;
+
+                for (int bucket = 0; bucket < nb_buckets; bucket++) {
+                    bucket_starts[bucket] = nb_edges;
+
+                    for (int b = 0; b < nb_bands; b++) {
+                        int count = positions[(size_t)b * nb_buckets + bucket];
+                        positions[(size_t)b * nb_buckets + bucket] = nb_edges;
+                        nb_edges += count;
+                    }
                 }
-            }
+                bucket_starts[nb_buckets] = nb_edges;
 
-            void GraphSegmentationImpl::segmentGraph(Edge *edges, const int &nb_edges, const Mat &img_filtered, PointSet **es) {
+                edges.resize(nb_edges);
 
-                int total_points = ( int)(img_filtered.rows * img_filtered.cols);
+                parallel_for_(Range(0, nb_bands), [&](const Range &range) { processBands(range, true); });
 
-                // Sort edges
-                std::sort(edges, edges + nb_edges);
+                // Finish the sort inside each bucket, edges of the same weight stay in creation order
+                parallel_for_(Range(0, nb_buckets), [&](const Range &range) {
+                    for (int bucket = range.start; bucket < range.end; bucket++) {
+                        std::sort(edges.begin() + bucket_starts[bucket], edges.begin() + bucket_starts[bucket + 1],
+                                  [&](int e1, int e2) {
+                                      return weights[e1] < weights[e2] || (weights[e1] == weights[e2] && e1 < e2);
+                                  });
+                    }
+                });
+            }
 
-                // Create a set with all point (by default mapped to themselfs)
-                *es = new PointSet(img_filtered.cols * img_filtered.rows);
+            void GraphSegmentationImpl::segmentGraph(const std::vector<int> &edges, std::vector<float> &weights, const Mat &img_filtered, PointSet &es) {
 
-                // Thresholds
-                float* thresholds = new float[total_points];
+                const int total_points = img_filtered.rows * img_filtered.cols;
+                const int cols = img_filtered.cols;
+                const int nb_edges = (int)edges.size();
 
-                for (int i = 0; i < total_points; i++)
-                    thresholds[i] = k;
+                // Thresholds
+                std::vector<float> thresholds(total_points, k);
 
-                for ( int i = 0; i < nb_edges; i++) {
+                for (int i = 0; i < nb_edges; i++) {
 
-                    int p_a = (*es)->getBasePoint(edges[i].from);
-                    int p_b = (*es)->getBasePoint(edges[i].to);
+                    int p_a = es.getBasePoint(edgeFrom(edges[i]));
+                    int p_b = es.getBasePoint(edgeTo(edges[i], cols));
 
                     if (p_a != p_b) {
-                        if (edges[i].weight <= thresholds[p_a] && edges[i].weight <= thresholds[p_b]) {
-                            (*es)->joinPoints(p_a, p_b);
-                            p_a = (*es)->getBasePoint(p_a);
-                            thresholds[p_a] = edges[i].weight + k / (*es)->size(p_a);
+                        float weight = weights[edges[i]];
+
+                        if (weight <= thresholds[p_a] && weight <= thresholds[p_b]) {
+                            es.joinPoints(p_a, p_b);
+                            p_a = es.getBasePoint(p_a);
+                            thresholds[p_a] = weight + k / es.size(p_a);
 
-                            edges[i].weight = 0;
+                            weights[edges[i]] = 0;
                         }
                     }
                 }
-
-                delete [] thresholds;
             }
 
-            void GraphSegmentationImpl::filterSmallAreas(Edge *edges, const int &nb_edges, PointSet *es) {
+            void GraphSegmentationImpl::filterSmallAreas(const std::vector<int> &edges, const std::vector<float> &weights, const Mat &img_filtered, PointSet &es) {
 
-                for ( int i = 0; i < nb_edges; i++) {
+                const int cols = img_filtered.cols;
+                const int nb_edges = (int)edges.size();
 
-                    if (edges[i].weight > 0) {
+                for (int i = 0; i < nb_edges; i++) {
 
-                        int p_a = es->getBasePoint(edges[i].from);
-                        int p_b = es->getBasePoint(edges[i].to);
+                    if (weights[edges[i]] > 0) {
 
-                        if (p_a != p_b && (es->size(p_a) < min_size || es->size(p_b) < min_size)) {
-                            es->joinPoints(p_a, p_b);
+                        int p_a = es.getBasePoint(edgeFrom(edges[i]));
+                        int p_b = es.getBasePoint(edgeTo(edges[i], cols));
+
+                        if (p_a != p_b && (es.size(p_a) < min_size || es.size(p_b) < min_size)) {
+                            es.joinPoints(p_a, p_b);
 
                         }
                     }
@@ -265,15 +326,12 @@ namespace cv {
 
             }
 
-            void GraphSegmentationImpl::finalMapping(PointSet *es, Mat &output) {
+            void GraphSegmentationImpl::finalMapping(PointSet &es, Mat &output) {
 
                 int maximum_size = ( int)(output.rows * output.cols);
 
                 int last_id = 0;
-                int * mapped_id = new int[maximum_size];
-
-                for ( int i = 0; i < maximum_size; i++)
-                    mapped_id[i] = -1;
+                std::vector<int> mapped_id(maximum_size, -1);
 
                 int rows = output.rows;
                 int cols = output.cols;
@@ -289,7 +347,7 @@ namespace cv {
 
                     for (int j = 0; j < cols; j++) {
 
-                        int point = es->getBasePoint(i * cols + j);
+                        int point = es.getBasePoint(i * cols + j);
 
                         if (mapped_id[point] == -1) {
                             mapped_id[point] = last_id;
@@ -299,8 +357,6 @@ namespace cv {
                         p[j] = mapped_id[point];
                     }
                 }
-
-                delete [] mapped_id;
             }
 
             void GraphSegmentationImpl::processImage(InputArray src, OutputArray dst) {
@@ -311,30 +367,30 @@ namespace cv {
                 Mat output = dst.getMat();
                 output.setTo(0);
 
+                if (img.empty())
+                    return;
+
                 // Filter graph
                 Mat img_filtered;
                 filter(img, img_filtered);
 
                 // Build graph
-                Edge *edges;
-                int nb_edges;
+                std::vector<float> weights;
+                std::vector<int> edges;
 
-                buildGraph(&edges, nb_edges, img_filtered);
+                buildGraph(weights, img_filtered);
+                sortEdges(edges, weights, img_filtered);
 
                 // Segment graph
-                PointSet *es;
+                PointSet es(img_filtered.cols * img_filtered.rows);
 
-                segmentGraph(edges, nb_edges, img_filtered, &es);
+                segmentGraph(edges, weights, img_filtered, es);
 
                 // Remove small areas
-                filterSmallAreas(edges, nb_edges, es);
+                filterSmallAreas(edges, weights, img_filtered, es);
 
                 // Map to final output
                 finalMapping(es, output);
-
-                delete [] edges;
-                delete es;
-
             }
 
             Ptr<GraphSegmentation> createGraphSegmentation(double sigma, float k, int min_size) {
@@ -348,42 +404,33 @@ namespace cv {
                 return graphseg;
             }
 
-            PointSet::PointSet(int nb_elements_) {
+            PointSet::PointSet(int nb_elements_) : parents(nb_elements_), sizes(nb_elements_, 1) {
                 nb_elements = nb_elements_;
 
-                mapping = new PointSetElement[nb_elements];
-
                 for ( int i = 0; i < nb_elements; i++) {
-                    mapping[i] = PointSetElement(i);
+                    parents[i] = i;
                 }
             }
 
-            PointSet::~PointSet() {
-                delete [] mapping;
-            }
-
             int PointSet::getBasePoint( int p) {
 
-                 int base_p = p;
-
-                while (base_p != mapping[base_p].p) {
-                    base_p = mapping[base_p].p;
+                // Path halving: every visited point is linked to its grandparent
+                while (parents[p] != p) {
+                    parents[p] = parents[parents[p]];
+                    p = parents[p];
                 }
 
-                // Save mapping for faster acces later
-                mapping[p].p = base_p;
-
-                return base_p;
+                return p;
             }
 
             void PointSet::joinPoints(int p_a, int p_b) {
 
                 // Always target smaller set, to avoid redirection in getBasePoint
-                if (mapping[p_a].size < mapping[p_b].size)
+                if (sizes[p_a] < sizes[p_b])
                     swap(p_a, p_b);
 
-                mapping[p_b].p = p_a;
-                mapping[p_a].size += mapping[p_b].size;
+                parents[p_b] = p_a;
+                sizes[p_a] += sizes[p_b];
 
                 nb_elements--;
             }
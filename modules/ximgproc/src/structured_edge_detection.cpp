@@ -42,6 +42,7 @@
 #include <iterator>
 #include <iostream>
 #include <cmath>
+#include <fstream>
 
 #include "precomp.hpp"
 
@@ -145,26 +146,29 @@ static cv::Mat rgb2luv(const cv::Mat &src)
 
     const int nchannels = 3;
 
-    for (int i = 0; i < src.rows; ++i)
+    cv::parallel_for_(cv::Range(0, src.rows), [&](const cv::Range& range)
     {
-        const float *pSrc = src.ptr<float>(i);
-        float *pDst = dst.ptr<float>(i);
-
-        for (int j = 0; j < src.cols*nchannels; j += nchannels)
+        for (int i = range.start; i < range.end; ++i)
         {
-            const float rgb[] = {pSrc[j + 0], pSrc[j + 1], pSrc[j + 2]};
+            const float *pSrc = src.ptr<float>(i);
+            float *pDst = dst.ptr<float>(i);
+
+            for (int j = 0; j < src.cols*nchannels; j += nchannels)
+            {
+                const float rgb[] = {pSrc[j + 0], pSrc[j + 1], pSrc[j + 2]};
 
-            const float xyz[] = {mX[0]*rgb[0] + mX[1]*rgb[1] + mX[2]*rgb[2],
-                                 mY[0]*rgb[0] + mY[1]*rgb[1] + mY[2]*rgb[2],
-                                 mZ[0]*rgb[0] + mZ[1]*rgb[1] + mZ[2]*rgb[2]};
-            const float nz = 1.0f / float(xyz[0] + 15*xyz[1] + 3*xyz[2] + 1e-35);
+                const float xyz[] = {mX[0]*rgb[0] + mX[1]*rgb[1] + mX[2]*rgb[2],
+                                     mY[0]*rgb[0] + mY[1]*rgb[1] + mY[2]*rgb[2],
+                                     mZ[0]*rgb[0] + mZ[1]*rgb[1] + mZ[2]*rgb[2]};
+                const float nz = 1.0f / float(xyz[0] + 15*xyz[1] + 3*xyz[2] + 1e-35);
 
-            const float l = pDst[j] = lTable[cvFloor(1024*xyz[1])];
+                const float l = pDst[j] = lTable[cvFloor(1024*xyz[1])];
 
-            pDst[j + 1] = l * (13*4*xyz[0]*nz - 13*un) - minu;;
-            pDst[j + 2] = l * (13*9*xyz[1]*nz - 13*vn) - minv;
+                pDst[j + 1] = l * (13*4*xyz[0]*nz - 13*un) - minu;;
+                pDst[j + 2] = l * (13*9*xyz[1]*nz - 13*vn) - minv;
+            }
         }
-    }
+    });
 
     return dst;
 }
@@ -201,58 +205,65 @@ static void gradientHist(const cv::Mat &src, cv::Mat &magnitude, cv::Mat &histog
 
     int nchannels = src.channels();
 
-    for (int i = 0; i < src.rows; ++i)
+    cv::parallel_for_(cv::Range(0, src.rows), [&](const cv::Range& range)
     {
-        const float *pDx = Dx.ptr<float>(i);
-        const float *pDy = Dy.ptr<float>(i);
+        for (int i = range.start; i < range.end; ++i)
+        {
+            const float *pDx = Dx.ptr<float>(i);
+            const float *pDy = Dy.ptr<float>(i);
 
-        float *pMagnitude = magnitude.ptr<float>(i);
-        float *pPhase = phase.ptr<float>(i);
+            float *pMagnitude = magnitude.ptr<float>(i);
+            float *pPhase = phase.ptr<float>(i);
 
-        for (int j = 0; j < src.cols*nchannels; j += nchannels)
-        {
-            float fMagn = float(-1e-5), fdx = 0, fdy = 0;
-            for (int k = 0; k < nchannels; ++k)
+            for (int j = 0; j < src.cols*nchannels; j += nchannels)
             {
-                float cMagn = CV_SQR( pDx[j + k] ) + CV_SQR( pDy[j + k] );
-                if (cMagn > fMagn)
+                float fMagn = float(-1e-5), fdx = 0, fdy = 0;
+                for (int k = 0; k < nchannels; ++k)
                 {
-                    fMagn = cMagn;
-                    fdx = pDx[j + k];
-                    fdy = pDy[j + k];
+                    float cMagn = CV_SQR( pDx[j + k] ) + CV_SQR( pDy[j + k] );
+                    if (cMagn > fMagn)
+                    {
+                        fMagn = cMagn;
+                        fdx = pDx[j + k];
+                        fdy = pDy[j + k];
+                    }
                 }
-            }
 
-            pMagnitude[j/nchannels] = sqrtf(fMagn);
+                pMagnitude[j/nchannels] = sqrtf(fMagn);
 
-            float angle = cv::fastAtan2(fdy, fdx) / 180.0f - 1.0f * (fdy < 0);
-            if (std::fabs(fdx) + std::fabs(fdy) < 1e-5)
-                angle = 0.5f;
-            pPhase[j/nchannels] = angle;
+                float angle = cv::fastAtan2(fdy, fdx) / 180.0f - 1.0f * (fdy < 0);
+                if (std::fabs(fdx) + std::fabs(fdy) < 1e-5)
+                    angle = 0.5f;
+                pPhase[j/nchannels] = angle;
+            }
         }
-    }
+    });
 
     magnitude /= imsmooth( magnitude, gnrmRad )
         + 0.01*cv::Mat::ones( magnitude.size(), magnitude.type() );
 
-    for (int i = 0; i < phase.rows; ++i)
+    // every histogram row accumulates its own pSize source rows, in the same order
+    cv::parallel_for_(cv::Range(0, histogram.rows), [&](const cv::Range& range)
     {
-        const float *pPhase = phase.ptr<float>(i);
-        const float *pMagn  = magnitude.ptr<float>(i);
+        for (int i = range.start*pSize; i < std::min(range.end*pSize, phase.rows); ++i)
+        {
+            const float *pPhase = phase.ptr<float>(i);
+            const float *pMagn  = magnitude.ptr<float>(i);
 
-        float *pHist = histogram.ptr<float>(i/pSize);
+            float *pHist = histogram.ptr<float>(i/pSize);
 
-        for (int j = 0; j < phase.cols; ++j)
-        {
-            int angle = cvRound(pPhase[j]*nBins);
-            if(angle >= nBins)
+            for (int j = 0; j < phase.cols; ++j)
             {
-              angle = 0;
+                int angle = cvRound(pPhase[j]*nBins);
+                if(angle >= nBins)
+                {
+                  angle = 0;
+                }
+                const int index = (j/pSize)*nBins + angle;
+                pHist[index] += pMagn[j] / CV_SQR(pSize);
             }
-            const int index = (j/pSize)*nBins + angle;
-            pHist[index] += pMagn[j] / CV_SQR(pSize);
         }
-    }
+    });
 }
 
 /*!
@@ -428,92 +439,13 @@ public:
                           ? _howToGetFeatures
                           : createRFFeatureGetter().staticCast<const RFFeatureGetter>() )
     {
-        cv::FileStorage modelFile(filename, FileStorage::READ);
-        CV_Assert( modelFile.isOpened() );
-
-        __rf.options.stride
-            = modelFile["options"]["stride"];
-        __rf.options.shrinkNumber
-            = modelFile["options"]["shrinkNumber"];
-        __rf.options.patchSize
-            = modelFile["options"]["patchSize"];
-        __rf.options.patchInnerSize
-            = modelFile["options"]["patchInnerSize"];
-
-        __rf.options.numberOfGradientOrientations
-            = modelFile["options"]["numberOfGradientOrientations"];
-        __rf.options.gradientSmoothingRadius
-            = modelFile["options"]["gradientSmoothingRadius"];
-        __rf.options.regFeatureSmoothingRadius
-            = modelFile["options"]["regFeatureSmoothingRadius"];
-        __rf.options.ssFeatureSmoothingRadius
-            = modelFile["options"]["ssFeatureSmoothingRadius"];
-        __rf.options.gradientNormalizationRadius
-            = modelFile["options"]["gradientNormalizationRadius"];
-
-        __rf.options.selfsimilarityGridSize
-            = modelFile["options"]["selfsimilarityGridSize"];
-
-        __rf.options.numberOfTrees
-            = modelFile["options"]["numberOfTrees"];
-        __rf.options.numberOfTreesToEvaluate
-            = modelFile["options"]["numberOfTreesToEvaluate"];
+        if (isBinaryModel(filename))
+            readBinaryModel(filename);
+        else
+            readModel(filename);
 
         __rf.options.numberOfOutputChannels =
             2*(__rf.options.numberOfGradientOrientations + 1) + 3;
-        //--------------------------------------------
-
-        cv::FileNode childs = modelFile["childs"];
-        cv::FileNode featureIds = modelFile["featureIds"];
-
-        std::vector <int> currentTree;
-
-        for(cv::FileNodeIterator it = childs.begin();
-            it != childs.end(); ++it)
-        {
-            (*it) >> currentTree;
-            std::copy(currentTree.begin(), currentTree.end(),
-                std::back_inserter(__rf.childs));
-        }
-
-        for(cv::FileNodeIterator it = featureIds.begin();
-            it != featureIds.end(); ++it)
-        {
-            (*it) >> currentTree;
-            std::copy(currentTree.begin(), currentTree.end(),
-                std::back_inserter(__rf.featureIds));
-        }
-
-        cv::FileNode thresholds = modelFile["thresholds"];
-        std::vector <float> fcurrentTree;
-
-        for(cv::FileNodeIterator it = thresholds.begin();
-            it != thresholds.end(); ++it)
-        {
-            (*it) >> fcurrentTree;
-            std::copy(fcurrentTree.begin(), fcurrentTree.end(),
-                std::back_inserter(__rf.thresholds));
-        }
-
-        cv::FileNode edgeBoundaries = modelFile["edgeBoundaries"];
-        cv::FileNode edgeBins = modelFile["edgeBins"];
-
-        for(cv::FileNodeIterator it = edgeBoundaries.begin();
-            it != edgeBoundaries.end(); ++it)
-        {
-            (*it) >> currentTree;
-            std::copy(currentTree.begin(), currentTree.end(),
-                std::back_inserter(__rf.edgeBoundaries));
-        }
-
-        for(cv::FileNodeIterator it = edgeBins.begin();
-            it != edgeBins.end(); ++it)
-        {
-            (*it) >> currentTree;
-            std::copy(currentTree.begin(), currentTree.end(),
-                std::back_inserter(__rf.edgeBins));
-        }
-
         __rf.numberOfTreeNodes = int( __rf.childs.size() ) / __rf.options.numberOfTrees;
     }
 
@@ -643,8 +575,263 @@ public:
       dst.copyTo(_dst);
     }
 
+    /*!
+     * The function stores the model in the binary format
+     *
+     * \param filename : name of the file where the model is stored
+     */
+    void saveModel(const cv::String &filename) const CV_OVERRIDE
+    {
+        std::ofstream modelFile(filename.c_str(), std::ios::binary);
+        CV_Assert( modelFile.is_open() );
+
+        BinaryModelHeader header;
+        memset(&header, 0, sizeof(header));
+        memcpy(header.magic, binaryModelMagic, sizeof(binaryModelMagic));
+        header.byteOrder = binaryModelByteOrder;
+        getOptions(header.options);
+        header.sizes[0] = (int64)__rf.featureIds.size();
+        header.sizes[1] = (int64)__rf.thresholds.size();
+        header.sizes[2] = (int64)__rf.childs.size();
+        header.sizes[3] = (int64)__rf.edgeBoundaries.size();
+        header.sizes[4] = (int64)__rf.edgeBins.size();
+
+        modelFile.write((const char *)&header, sizeof(header));
+
+        const char *sections[] = { (const char *)dataOrNull(__rf.featureIds), (const char *)dataOrNull(__rf.thresholds),
+                                   (const char *)dataOrNull(__rf.childs), (const char *)dataOrNull(__rf.edgeBoundaries),
+                                   (const char *)dataOrNull(__rf.edgeBins) };
+        int64 offset = sizeof(header);
+        for (int k = 0; k < 5; ++k)
+        {
+            // every section starts on a 64 bytes boundary
+            const int64 aligned = alignSize((size_t)offset, 64);
+            for (; offset < aligned; ++offset)
+                modelFile.put(0);
+            modelFile.write(sections[k], header.sizes[k]*4);
+            offset += header.sizes[k]*4;
+        }
+        CV_Assert( modelFile.good() );
+    }
+
 
 protected:
+    /*!
+     * Layout of the binary model files: this header is followed by the featureIds,
+     * thresholds, childs, edgeBoundaries and edgeBins arrays (32-bit, native byte order),
+     * each one starting on a 64 bytes boundary, so that the file can be read
+     * with a single read per array or memory mapped as is.
+     * The last magic character is the format version, byteOrder tells the
+     * byte order of the machine that wrote the file.
+     */
+    struct BinaryModelHeader
+    {
+        char magic[8];
+        int byteOrder;
+        int options[12];
+        int reserved;
+        int64 sizes[5];
+    };
+
+    static const char binaryModelMagic[8];
+    static const int binaryModelByteOrder = 0x01020304;
+
+    template <typename T> static const T *dataOrNull(const std::vector<T> &v)
+    {
+        return v.empty() ? NULL : &v[0];
+    }
+
+    void getOptions(int *options) const
+    {
+        options[0] = __rf.options.stride;
+        options[1] = __rf.options.shrinkNumber;
+        options[2] = __rf.options.patchSize;
+        options[3] = __rf.options.patchInnerSize;
+        options[4] = __rf.options.numberOfGradientOrientations;
+        options[5] = __rf.options.gradientSmoothingRadius;
+        options[6] = __rf.options.regFeatureSmoothingRadius;
+        options[7] = __rf.options.ssFeatureSmoothingRadius;
+        options[8] = __rf.options.gradientNormalizationRadius;
+        options[9] = __rf.options.selfsimilarityGridSize;
+        options[10] = __rf.options.numberOfTrees;
+        options[11] = __rf.options.numberOfTreesToEvaluate;
+    }
+
+    void setOptions(const int *options)
+    {
+        __rf.options.stride = options[0];
+        __rf.options.shrinkNumber = options[1];
+        __rf.options.patchSize = options[2];
+        __rf.options.patchInnerSize = options[3];
+        __rf.options.numberOfGradientOrientations = options[4];
+        __rf.options.gradientSmoothingRadius = options[5];
+        __rf.options.regFeatureSmoothingRadius = options[6];
+        __rf.options.ssFeatureSmoothingRadius = options[7];
+        __rf.options.gradientNormalizationRadius = options[8];
+        __rf.options.selfsimilarityGridSize = options[9];
+        __rf.options.numberOfTrees = options[10];
+        __rf.options.numberOfTreesToEvaluate = options[11];
+    }
+
+    static bool isBinaryModel(const cv::String &filename)
+    {
+        std::ifstream modelFile(filename.c_str(), std::ios::binary);
+        // the version is left out, so that readBinaryModel can report it
+        char magic[sizeof(binaryModelMagic)];
+        return modelFile.read(magic, sizeof(magic))
+            && memcmp(magic, binaryModelMagic, sizeof(magic) - 1) == 0;
+    }
+
+    /*!
+     * The function loads the model stored by saveModel
+     *
+     * \param filename : name of the file where the model is stored
+     */
+    void readBinaryModel(const cv::String &filename)
+    {
+        std::ifstream modelFile(filename.c_str(), std::ios::binary | std::ios::ate);
+        CV_Assert( modelFile.is_open() );
+        const int64 fileSize = (int64)modelFile.tellg();
+        modelFile.seekg(0);
+
+        BinaryModelHeader header;
+        if ( fileSize < (int64)sizeof(header) || !modelFile.read((char *)&header, sizeof(header)) )
+            CV_Error(Error::StsParseError, "Truncated header in the binary model " + filename);
+        if ( memcmp(header.magic, binaryModelMagic, sizeof(binaryModelMagic)) != 0 )
+            CV_Error(Error::StsParseError, "Unknown magic or version in the binary model " + filename);
+        if ( header.byteOrder != binaryModelByteOrder )
+            CV_Error(Error::StsParseError, "The binary model " + filename + " was written with another byte order");
+        if ( header.options[10] <= 0 )
+            CV_Error(Error::StsParseError, "Invalid number of trees in the binary model " + filename);
+        if ( header.sizes[0] != header.sizes[2] || header.sizes[1] != header.sizes[2] )
+            CV_Error(Error::StsParseError, "Inconsistent node arrays in the binary model " + filename);
+
+        // every array has to fit in the file before anything is allocated
+        int64 offset = sizeof(header);
+        for (int k = 0; k < 5; ++k)
+        {
+            offset = alignSize((size_t)offset, 64);
+            if ( header.sizes[k] < 0 || offset > fileSize || header.sizes[k] > (fileSize - offset)/4 )
+                CV_Error_(Error::StsParseError, ("Array %d is out of the bounds of the binary model %s", k, filename.c_str()));
+            offset += header.sizes[k]*4;
+        }
+        setOptions(header.options);
+
+        void *sections[5];
+        __rf.featureIds.resize((size_t)header.sizes[0]);
+        __rf.thresholds.resize((size_t)header.sizes[1]);
+        __rf.childs.resize((size_t)header.sizes[2]);
+        __rf.edgeBoundaries.resize((size_t)header.sizes[3]);
+        __rf.edgeBins.resize((size_t)header.sizes[4]);
+        sections[0] = (void *)dataOrNull(__rf.featureIds);
+        sections[1] = (void *)dataOrNull(__rf.thresholds);
+        sections[2] = (void *)dataOrNull(__rf.childs);
+        sections[3] = (void *)dataOrNull(__rf.edgeBoundaries);
+        sections[4] = (void *)dataOrNull(__rf.edgeBins);
+
+        offset = sizeof(header);
+        for (int k = 0; k < 5; ++k)
+        {
+            offset = alignSize((size_t)offset, 64);
+            modelFile.seekg(offset);
+            if ( !modelFile.read((char *)sections[k], header.sizes[k]*4) )
+                CV_Error_(Error::StsParseError, ("Cannot read array %d of the binary model %s", k, filename.c_str()));
+            offset += header.sizes[k]*4;
+        }
+    }
+
+    /*!
+     * The function loads the model stored in the FileStorage format
+     *
+     * \param filename : name of the file where the model is stored
+     */
+    void readModel(const cv::String &filename)
+    {
+        cv::FileStorage modelFile(filename, FileStorage::READ);
+        CV_Assert( modelFile.isOpened() );
+
+        __rf.options.stride
+            = modelFile["options"]["stride"];
+        __rf.options.shrinkNumber
+            = modelFile["options"]["shrinkNumber"];
+        __rf.options.patchSize
+            = modelFile["options"]["patchSize"];
+        __rf.options.patchInnerSize
+            = modelFile["options"]["patchInnerSize"];
+
+        __rf.options.numberOfGradientOrientations
+            = modelFile["options"]["numberOfGradientOrientations"];
+        __rf.options.gradientSmoothingRadius
+            = modelFile["options"]["gradientSmoothingRadius"];
+        __rf.options.regFeatureSmoothingRadius
+            = modelFile["options"]["regFeatureSmoothingRadius"];
+        __rf.options.ssFeatureSmoothingRadius
+            = modelFile["options"]["ssFeatureSmoothingRadius"];
+        __rf.options.gradientNormalizationRadius
+            = modelFile["options"]["gradientNormalizationRadius"];
+
+        __rf.options.selfsimilarityGridSize
+            = modelFile["options"]["selfsimilarityGridSize"];
+
+        __rf.options.numberOfTrees
+            = modelFile["options"]["numberOfTrees"];
+        __rf.options.numberOfTreesToEvaluate
+            = modelFile["options"]["numberOfTreesToEvaluate"];
+
+        //--------------------------------------------
+
+        cv::FileNode childs = modelFile["childs"];
+        cv::FileNode featureIds = modelFile["featureIds"];
+
+        std::vector <int> currentTree;
+
+        for(cv::FileNodeIterator it = childs.begin();
+            it != childs.end(); ++it)
+        {
+            (*it) >> currentTree;
+            std::copy(currentTree.begin(), currentTree.end(),
+                std::back_inserter(__rf.childs));
+        }
+
+        for(cv::FileNodeIterator it = featureIds.begin();
+            it != featureIds.end(); ++it)
+        {
+            (*it) >> currentTree;
+            std::copy(currentTree.begin(), currentTree.end(),
+                std::back_inserter(__rf.featureIds));
+        }
+
+        cv::FileNode thresholds = modelFile["thresholds"];
+        std::vector <float> fcurrentTree;
+
+        for(cv::FileNodeIterator it = thresholds.begin();
+            it != thresholds.end(); ++it)
+        {
+            (*it) >> fcurrentTree;
+            std::copy(fcurrentTree.begin(), fcurrentTree.end(),
+                std::back_inserter(__rf.thresholds));
+        }
+
+        cv::FileNode edgeBoundaries = modelFile["edgeBoundaries"];
+        cv::FileNode edgeBins = modelFile["edgeBins"];
+
+        for(cv::FileNodeIterator it = edgeBoundaries.begin();
+            it != edgeBoundaries.end(); ++it)
+        {
+            (*it) >> currentTree;
+            std::copy(currentTree.begin(), currentTree.end(),
+                std::back_inserter(__rf.edgeBoundaries));
+        }
+
+        for(cv::FileNodeIterator it = edgeBins.begin();
+            it != edgeBins.end(); ++it)
+        {
+            (*it) >> currentTree;
+            std::copy(currentTree.begin(), currentTree.end(),
+                std::back_inserter(__rf.edgeBins));
+        }
+    }
+
     /*!
      * Private method used by process method. The function
      * predict edges in n-channel feature image and store them to dst.
@@ -730,6 +917,14 @@ protected:
             }
             // lookup tables for mapping linear index to offset pairs
 
+        // the trees are stored as flat arrays of nodes, one array per node field
+        const int *childs = &__rf.childs[0];
+        const int *featureIds = &__rf.featureIds[0];
+        const float *thresholds = &__rf.thresholds[0];
+        const int *pOffsetI = &offsetI[0];
+        const int *pOffsetX = offsetX.empty() ? NULL : &offsetX[0];
+        const int *pOffsetY = offsetY.empty() ? NULL : &offsetY[0];
+
         #ifdef CV_CXX11
         parallel_for_(cv::Range(0, height), [&](const cv::Range& range)
         #else
@@ -749,30 +944,22 @@ protected:
                     int currentNode = baseNode;
                     // select root node of the tree to evaluate
 
-                    int offset = (j*stride/shrink)*nchannels;
-                    while ( __rf.childs[currentNode] != 0 )
+                    const float *regPatch = regFeaturesPtr + (j*stride/shrink)*nchannels;
+                    const float *ssPatch = ssFeaturesPtr + (j*stride/shrink)*nchannels;
+                    int child;
+                    while ( (child = childs[currentNode]) != 0 )
                     {
-                        int currentId = __rf.featureIds[currentNode];
+                        int currentId = featureIds[currentNode];
                         float currentFeature;
 
                         if (currentId >= nFeatures)
-                        {
-                            int xIndex = offsetX[currentId - nFeatures];
-                            float A = ssFeaturesPtr[offset + xIndex];
-
-                            int yIndex = offsetY[currentId - nFeatures];
-                            float B = ssFeaturesPtr[offset + yIndex];
-
-                            currentFeature = A - B;
-                        }
+                            currentFeature = ssPatch[pOffsetX[currentId - nFeatures]]
+                                           - ssPatch[pOffsetY[currentId - nFeatures]];
                         else
-                            currentFeature = regFeaturesPtr[offset + offsetI[currentId]];
+                            currentFeature = regPatch[pOffsetI[currentId]];
 
                         // compare feature to threshold and move left or right accordingly
-                        if (currentFeature < __rf.thresholds[currentNode])
-                            currentNode = baseNode + __rf.childs[currentNode] - 1;
-                        else
-                            currentNode = baseNode + __rf.childs[currentNode];
+                        currentNode = baseNode + child - (currentFeature < thresholds[currentNode]);
                     }
 
                     indexPtr[j*nTreesEval + k] = currentNode;
@@ -882,6 +1069,8 @@ protected:
     } __rf;
 };
 
+const char StructuredEdgeDetectionImpl::binaryModelMagic[8] = { 'C', 'V', 'S', 'E', 'D', 'R', 'F', '1' };
+
 Ptr<StructuredEdgeDetection> createStructuredEdgeDetection(const String &model,
     Ptr<const RFFeatureGetter> howToGetFeatures)
 {
@@ -165,50 +165,21 @@ void from32STo32F(Mat &img, Mat &outImg, float *mapping)
 
 
 /***************************************************************
- * Function: float2D
- * Description: allocate a 2D float array with dimension "dim1 x dim2"
+ * Struct: WMFWorkspace
+ * Description: working memory of filterCore for one strip of columns: the joint-histogram,
+ *                the BCB and the links of their necklace tables.
  ***************************************************************/
-float** float2D(int dim1, int dim2)
+struct WMFWorkspace
 {
-    float **ret = new float*[dim1];
-    ret[0] = new float[dim1*dim2];
-    for(int i=1;i<dim1;i++)ret[i] = ret[i-1]+dim2;
+    vector<int> H, Hf, Hb;
+    vector<int> BCB, BCBf, BCBb;
 
-    return ret;
-}
-
-/***************************************************************
- * Function: float2D_release
- * Description: deallocate the 2D array created by float2D()
- ***************************************************************/
-void float2D_release(float **p)
-{
-    delete []p[0];
-    delete []p;
-}
-
-/***************************************************************
- * Function: int2D
- * Description: allocate a 2D integer array with dimension "dim1 x dim2"
- ***************************************************************/
-int** int2D(int dim1, int dim2)
-{
-    int **ret = new int*[dim1];
-    ret[0] = new int[dim1*dim2];
-    for(int i=1;i<dim1;i++)ret[i] = ret[i-1]+dim2;
-
-    return ret;
-}
-
-/***************************************************************
- * Function: int2D_release
- * Description: deallocate the 2D array created by int2D()
- ***************************************************************/
-void int2D_release(int **p)
-{
-    delete []p[0];
-    delete []p;
-}
+    WMFWorkspace(int nI, int nF) :
+        H((size_t)nI * nF), Hf((size_t)nI * nF), Hb((size_t)nI * nF),
+        BCB(nF), BCBf(nF), BCBb(nF)
+    {
+    }
+};
 
 /***************************************************************
  * Function: updateBCB
@@ -216,7 +187,7 @@ void int2D_release(int **p)
  ***************************************************************/
 inline void updateBCB(int &num,int *f,int *b,int i,int v)
 {
-    static int p1,p2;
+    int p1,p2;
 
     if(i)
     {
@@ -246,7 +217,7 @@ inline void updateBCB(int &num,int *f,int *b,int i,int v)
  *                If F is 3-channel, perform k-means clustering
  *                If F is 1-channel, only perform type-casting
  ***************************************************************/
-void featureIndexing(Mat &F, float **&wMap, int &nF, float sigmaI, int weightType){
+void featureIndexing(Mat &F, Mat &wMap, int &nF, float sigmaI, int weightType){
     // Configuration and Declaration
     Mat FNew;
     int cols = F.cols, rows = F.rows;
@@ -262,7 +233,7 @@ void featureIndexing(Mat &F, float **&wMap, int &nF, float sigmaI, int weightTyp
         F.convertTo(FNew, CV_32S);
 
         // Compute weight map (weight between each pair of feature index)
-        wMap = float2D(nF,nF);
+        wMap.create(nF,nF,CV_32F);
         float nSigmaI = sigmaI;
         float divider = (1.0f/(2*nSigmaI*nSigmaI));
 
@@ -284,7 +255,7 @@ void featureIndexing(Mat &F, float **&wMap, int &nF, float sigmaI, int weightTyp
                     default: val = exp(-(diff*diff)*divider);
                 }
 
-                wMap[i][j] = wMap[j][i] = val;
+                wMap.at<float>(i,j) = wMap.at<float>(j,i) = val;
             }
         }
     }
@@ -294,9 +265,9 @@ void featureIndexing(Mat &F, float **&wMap, int &nF, float sigmaI, int weightTyp
     {
         const int shift = 2; // 256(8-bit)->64(6-bit)
         const int LOW_NUM = 256>>shift;
-        static int hash[LOW_NUM][LOW_NUM][LOW_NUM]={{{0}}};
-
-        memset(hash,0,sizeof(hash));
+        // not static: several images can be indexed at the same time
+        vector<int> hashBuffer(LOW_NUM*LOW_NUM*LOW_NUM, 0);
+        int (*hash)[LOW_NUM][LOW_NUM] = (int (*)[LOW_NUM][LOW_NUM])&hashBuffer[0];
 
         // throw pixels into a 2D histogram
         int candCnt = 0;
@@ -362,7 +333,7 @@ void featureIndexing(Mat &F, float **&wMap, int &nF, float sigmaI, int weightTyp
         }
 
         // Compute weight map (weight between each pair of feature index)
-        wMap = float2D(nF,nF);
+        wMap.create(nF,nF,CV_32F);
         float nSigmaI = sigmaI/256.0f*LOW_NUM;
         float divider = (1.0f/(2*nSigmaI*nSigmaI));
 
@@ -399,7 +370,7 @@ void featureIndexing(Mat &F, float **&wMap, int &nF, float sigmaI, int weightTyp
                     default: val = exp(-(diff0*diff0+diff1*diff1+diff2*diff2)*divider);
                 }
 
-                wMap[i][j] = wMap[j][i] = val;
+                wMap.at<float>(i,j) = wMap.at<float>(j,i) = val;
             }
         }
 
@@ -409,7 +380,7 @@ void featureIndexing(Mat &F, float **&wMap, int &nF, float sigmaI, int weightTyp
     F = FNew;
 }
 
-Mat filterCore(Mat &I, Mat &F, float **wMap, int r=20, int nF=256, int nI=256, Mat mask=Mat())
+Mat filterCore(Mat &I, Mat &F, const Mat &wMap, int r=20, int nF=256, int nI=256, Mat mask=Mat())
 {
     // Check validation
     assert(I.depth() == CV_32S && I.channels()==1);//input image: 32SC1
@@ -426,149 +397,155 @@ Mat filterCore(Mat &I, Mat &F, float **wMap, int r=20, int nF=256, int nI=256, M
         mask = Scalar(1);
     }
 
-    // Allocate memory for joint-histogram and BCB
-    int **H = int2D(nI,nF);
-    int *BCB = new int[nF];
+    // Columns are filtered independently, each thread scans a strip of columns
+    // with its own joint-histogram and BCB, allocated once per strip
+    parallel_for_(Range(0, cols), [&](const Range& range)
+    {
+        WMFWorkspace workspace(nI, nF);
 
-    // Allocate links for necklace table
-    int **Hf = int2D(nI,nF);//forward link
-    int **Hb = int2D(nI,nF);//backward link
-    int *BCBf = new int[nF];//forward link
-    int *BCBb = new int[nF];//backward link
+        // Joint-histogram and BCB, the row "i" of the joint-histogram starts at H + i*nF
+        int *H = &workspace.H[0];
+        int *BCB = &workspace.BCB[0];
 
-    // Column Scanning
-    for(int x=0;x<cols;x++)
-    {
-        // Reset histogram and BCB for each column
-        memset(BCB, 0, sizeof(int)*nF);
-        memset(H[0], 0, sizeof(int)*nF*nI);
-        for(int i=0;i<nI;i++)Hf[i][0]=Hb[i][0]=0;
-        BCBf[0]=BCBb[0]=0;
-
-        // Reset cut-point
-        int medianVal = -1;
-
-        // Precompute "x" range and checks boundary
-        int downX = max(0,x-r);
-        int upX = min(cols-1,x+r);
-
-        // Initialize joint-histogram and BCB for the first window
-        int upY = min(rows-1,r);
-        for(int i=0;i<=upY;i++)
-        {
-            int *IPtr = I.ptr<int>(i);
-            int *FPtr = F.ptr<int>(i);
-            uchar *maskPtr = mask.ptr<uchar>(i);
+        // Links for necklace table
+        int *Hf = &workspace.Hf[0];//forward link
+        int *Hb = &workspace.Hb[0];//backward link
+        int *BCBf = &workspace.BCBf[0];//forward link
+        int *BCBb = &workspace.BCBb[0];//backward link
 
-            for(int j=downX;j<=upX;j++)
+        // Column Scanning
+        for(int x=range.start;x<range.end;x++)
+        {
+            // Reset histogram and BCB for each column
+            memset(BCB, 0, sizeof(int)*nF);
+            memset(H, 0, sizeof(int)*nF*nI);
+            for(int i=0;i<nI;i++)Hf[i*nF]=Hb[i*nF]=0;
+            BCBf[0]=BCBb[0]=0;
+
+            // Reset cut-point
+            int medianVal = -1;
+
+            // Precompute "x" range and checks boundary
+            int downX = max(0,x-r);
+            int upX = min(cols-1,x+r);
+
+            // Initialize joint-histogram and BCB for the first window
+            int upY = min(rows-1,r);
+            for(int i=0;i<=upY;i++)
             {
-                if(!maskPtr[j])continue;
+                int *IPtr = I.ptr<int>(i);
+                int *FPtr = F.ptr<int>(i);
+                uchar *maskPtr = mask.ptr<uchar>(i);
 
-                int fval = IPtr[j];
-                int *curHist = H[fval];
-                int gval = FPtr[j];
-
-                // Maintain necklace table of joint-histogram
-                if(!curHist[gval] && gval)
+                for(int j=downX;j<=upX;j++)
                 {
-                    int *curHf = Hf[fval];
-                    int *curHb = Hb[fval];
-
-                    int p1=0,p2=curHf[0];
-                    curHf[p1]=gval;
-                    curHf[gval]=p2;
-                    curHb[p2]=gval;
-                    curHb[gval]=p1;
-                }
+                    if(!maskPtr[j])continue;
 
-                curHist[gval]++;
-                // Maintain necklace table of BCB
-                updateBCB(BCB[gval],BCBf,BCBb,gval,-1);
-            }
-        }
+                    int fval = IPtr[j];
+                    int *curHist = H + fval*nF;
+                    int gval = FPtr[j];
 
-        for(int y=0;y<rows;y++)
-        {
-            // Find weighted median with help of BCB and joint-histogram
-            float balanceWeight = 0;
-            int curIndex = F.ptr<int>(y,x)[0];
-            float *fPtr = wMap[curIndex];
-            int &curMedianVal = medianVal;
+                    // Maintain necklace table of joint-histogram
+                    if(!curHist[gval] && gval)
+                    {
+                        int *curHf = Hf + fval*nF;
+                        int *curHb = Hb + fval*nF;
+
+                        int p1=0,p2=curHf[0];
+                        curHf[p1]=gval;
+                        curHf[gval]=p2;
+                        curHb[p2]=gval;
+                        curHb[gval]=p1;
+                    }
 
-            // Compute current balance
-            {
-                int i=0;
-                do
-                {
-                    balanceWeight += BCB[i]*fPtr[i];
-                    i=BCBf[i];
-                }while(i);
+                    curHist[gval]++;
+                    // Maintain necklace table of BCB
+                    updateBCB(BCB[gval],BCBf,BCBb,gval,-1);
+                }
             }
 
-            // Move cut-point to the left
-            if(balanceWeight >= 0)
+            for(int y=0;y<rows;y++)
             {
-                for(;balanceWeight >= 0 && curMedianVal > 0; curMedianVal--)
-                {
-                    float curWeight = 0;
-                    int *nextHist = H[curMedianVal];
-                    int *nextHf = Hf[curMedianVal];
+                // Find weighted median with help of BCB and joint-histogram
+                float balanceWeight = 0;
+                int curIndex = F.ptr<int>(y,x)[0];
+                const float *fPtr = wMap.ptr<float>(curIndex);
+                int &curMedianVal = medianVal;
 
-                    // Compute weight change by shift cut-point
+                // Compute current balance
+                {
                     int i=0;
                     do
                     {
-                        curWeight += (nextHist[i]<<1)*fPtr[i];
+                        balanceWeight += BCB[i]*fPtr[i];
+                        i=BCBf[i];
+                    }while(i);
+                }
 
-                        // Update BCB and maintain the necklace table of BCB
-                        updateBCB(BCB[i],BCBf,BCBb,i,-(nextHist[i]<<1));
+                // Move cut-point to the left
+                if(balanceWeight >= 0)
+                {
+                    for(;balanceWeight >= 0 && curMedianVal > 0; curMedianVal--)
+                    {
+                        float curWeight = 0;
+                        int *nextHist = H + curMedianVal*nF;
+                        int *nextHf = Hf + curMedianVal*nF;
 
-                        i=nextHf[i];
-                    }while(i);
+                        // Compute weight change by shift cut-point
+                        int i=0;
+                        do
+                        {
+                            curWeight += (nextHist[i]<<1)*fPtr[i];
+
+                            // Update BCB and maintain the necklace table of BCB
+                            updateBCB(BCB[i],BCBf,BCBb,i,-(nextHist[i]<<1));
 
-                    balanceWeight -= curWeight;
+                            i=nextHf[i];
+                        }while(i);
+
+                        balanceWeight -= curWeight;
+                    }
                 }
-            }
-            // Move cut-point to the right
-            else if(balanceWeight < 0)
-            {
-                for(;balanceWeight < 0 && curMedianVal != nI-1; curMedianVal++)
+                // Move cut-point to the right
+                else if(balanceWeight < 0)
                 {
-                    float curWeight = 0;
-                    int *nextHist = H[curMedianVal+1];
-                    int *nextHf = Hf[curMedianVal+1];
-
-                    // Compute weight change by shift cut-point
-                    int i=0;
-                    do
+                    for(;balanceWeight < 0 && curMedianVal != nI-1; curMedianVal++)
                     {
-                        curWeight += (nextHist[i]<<1)*fPtr[i];
+                        float curWeight = 0;
+                        int *nextHist = H + (curMedianVal+1)*nF;
+                        int *nextHf = Hf + (curMedianVal+1)*nF;
 
-                        // Update BCB and maintain the necklace table of BCB
-                        updateBCB(BCB[i],BCBf,BCBb,i,nextHist[i]<<1);
+                        // Compute weight change by shift cut-point
+                        int i=0;
+                        do
+                        {
+                            curWeight += (nextHist[i]<<1)*fPtr[i];
 
-                        i=nextHf[i];
-                    }while(i);
-                    balanceWeight += curWeight;
+                            // Update BCB and maintain the necklace table of BCB
+                            updateBCB(BCB[i],BCBf,BCBb,i,nextHist[i]<<1);
+
+                            i=nextHf[i];
+                        }while(i);
+                        balanceWeight += curWeight;
+                    }
                 }
-            }
 
-            // Weighted median is found and written to the output image
-            if(curMedianVal != -1)
-            {
-                if(balanceWeight < 0)
-                    outImg.ptr<int>(y,x)[0] = curMedianVal+1;
-                else
-                    outImg.ptr<int>(y,x)[0] = curMedianVal;
-            }
+                // Weighted median is found and written to the output image
+                if(curMedianVal != -1)
+                {
+                    if(balanceWeight < 0)
+                        outImg.ptr<int>(y,x)[0] = curMedianVal+1;
+                    else
+                        outImg.ptr<int>(y,x)[0] = curMedianVal;
+                }
 
-            // Update joint-histogram and BCB when local window is shifted.
-            int fval,gval,*curHist;
+                // Update joint-histogram and BCB when local window is shifted.
+                int fval,gval,*curHist;
 
-            // Add entering pixels into joint-histogram and BCB
-            int rownum = y + r + 1;
-            if(rownum < rows)
-            {
+                // Add entering pixels into joint-histogram and BCB
+                int rownum = y + r + 1;
+                if(rownum < rows)
+                {
                     int *inputImgPtr = I.ptr<int>(rownum);
                     int *guideImgPtr = F.ptr<int>(rownum);
                     uchar *maskPtr = mask.ptr<uchar>(rownum);
@@ -578,14 +555,14 @@ Mat filterCore(Mat &I, Mat &F, float **wMap, int r=20, int nF=256, int nI=256, M
                         if(!maskPtr[j])continue;
 
                         fval = inputImgPtr[j];
-                        curHist = H[fval];
+                        curHist = H + fval*nF;
                         gval = guideImgPtr[j];
 
                         // Maintain necklace table of joint-histogram
                         if(!curHist[gval] && gval)
                         {
-                            int *curHf = Hf[fval];
-                            int *curHb = Hb[fval];
+                            int *curHf = Hf + fval*nF;
+                            int *curHb = Hb + fval*nF;
 
                             int p1=0,p2=curHf[0];
                             curHf[gval]=p2;
@@ -600,7 +577,6 @@ Mat filterCore(Mat &I, Mat &F, float **wMap, int r=20, int nF=256, int nI=256, M
                     }
                 }
 
-
                 // Delete leaving pixels into joint-histogram and BCB
                 rownum = y - r;
                 if(rownum >= 0)
@@ -614,7 +590,7 @@ Mat filterCore(Mat &I, Mat &F, float **wMap, int r=20, int nF=256, int nI=256, M
                         if(!maskPtr[j])continue;
 
                         fval = inputImgPtr[j];
-                        curHist = H[fval];
+                        curHist = H + fval*nF;
                         gval = guideImgPtr[j];
 
                         curHist[gval]--;
@@ -622,8 +598,8 @@ Mat filterCore(Mat &I, Mat &F, float **wMap, int r=20, int nF=256, int nI=256, M
                         // Maintain necklace table of joint-histogram
                         if(!curHist[gval] && gval)
                         {
-                            int *curHf = Hf[fval];
-                            int *curHb = Hb[fval];
+                            int *curHf = Hf + fval*nF;
+                            int *curHb = Hb + fval*nF;
 
                             int p1=curHb[gval],p2=curHf[gval];
                             curHf[p1]=p2;
@@ -634,18 +610,9 @@ Mat filterCore(Mat &I, Mat &F, float **wMap, int r=20, int nF=256, int nI=256, M
                         updateBCB(BCB[gval],BCBf,BCBb,gval,-((fval <= medianVal)<<1)+1);
                     }
                 }
+            }
         }
-    }
-
-    // Deallocate the memory
-    {
-        delete []BCB;
-        delete []BCBf;
-        delete []BCBb;
-        int2D_release(H);
-        int2D_release(Hf);
-        int2D_release(Hb);
-    }
+    }, getNumThreads());
 
     // end of the function
     return outImg;
@@ -710,8 +677,8 @@ void weightedMedianFilter(InputArray joint, InputArray src, OutputArray dst, int
     //If "F" is 1-channel image, featureIndexing only does a type-casting on "F".
     //The output "F" is CV_32S type, containing indexes of feature values.
     //"wMap" is a 2D array that defines the distance between each pair of feature indexes.
-    // wMap[i][j] is the weight between feature index "i" and "j".
-    float **wMap = NULL;
+    // wMap(i,j) is the weight between feature index "i" and "j".
+    Mat wMap;
     featureIndexing(F, wMap, nF, float(sigma), weightType);
 
     //Filtering - Joint-Histogram Framework
@@ -719,7 +686,6 @@ void weightedMedianFilter(InputArray joint, InputArray src, OutputArray dst, int
     {
         Is[i] = filterCore(Is[i], F, wMap, r, nF, nI, mask.getMat());
     }
-    float2D_release(wMap);
 
     //Postprocess F
     //Convert input image back to the original type.
@@ -0,0 +1,89 @@
+// This file is part of OpenCV project.
+// It is subject to the license terms in the LICENSE file found in the top-level directory
+// of this distribution and at http://opencv.org/license.html.
+
+#include "test_precomp.hpp"
+
+namespace opencv_test { namespace {
+
+using namespace cv::ximgproc::segmentation;
+
+static const int blockSize = 40;
+
+// grid of constant colour blocks, no two neighbours share a colour
+static Mat createBlocksImage(int blocksX, int blocksY)
+{
+    Mat img(blocksY * blockSize, blocksX * blockSize, CV_8UC3);
+    for (int by = 0; by < blocksY; by++)
+    {
+        for (int bx = 0; bx < blocksX; bx++)
+        {
+            int id = by * blocksX + bx;
+            Scalar color(40 + 50 * (id % 4), 40 + 70 * ((id / 4) % 3), 30 + 17 * id);
+            img(Rect(bx * blockSize, by * blockSize, blockSize, blockSize)).setTo(color);
+        }
+    }
+    return img;
+}
+
+TEST(ximgproc_GraphSegmentation, constant_blocks)
+{
+    const int blocksX = 4, blocksY = 3;
+    Mat img = createBlocksImage(blocksX, blocksY);
+
+    // no pre-filtering, so every block is a segment of its own
+    Ptr<GraphSegmentation> gs = createGraphSegmentation(0.001, 300, 100);
+    Mat labels;
+    gs->processImage(img, labels);
+    ASSERT_EQ(CV_32SC1, labels.type());
+    ASSERT_EQ(img.size(), labels.size());
+
+    double minVal, maxVal;
+    minMaxLoc(labels, &minVal, &maxVal);
+    EXPECT_EQ(0, minVal);
+    EXPECT_EQ(blocksX * blocksY - 1, maxVal);
+
+    std::vector<int> blockLabels;
+    for (int by = 0; by < blocksY; by++)
+    {
+        for (int bx = 0; bx < blocksX; bx++)
+        {
+            Mat block = labels(Rect(bx * blockSize, by * blockSize, blockSize, blockSize));
+            int label = block.at<int>(0, 0);
+            EXPECT_EQ(0, countNonZero(block != label)) << "block " << bx << "x" << by;
+            blockLabels.push_back(label);
+        }
+    }
+    std::sort(blockLabels.begin(), blockLabels.end());
+    EXPECT_EQ(blockLabels.end(), std::unique(blockLabels.begin(), blockLabels.end()));
+}
+
+TEST(ximgproc_GraphSegmentation, small_regions_are_merged)
+{
+    // 6x6 patch (36 pixels) of another colour inside a single block
+    Mat img = createBlocksImage(1, 1);
+    img(Rect(17, 17, 6, 6)).setTo(Scalar(250, 250, 250));
+
+    double minVal, maxVal;
+    Mat labels;
+    Ptr<GraphSegmentation> gs = createGraphSegmentation(0.001, 300, 20);
+    gs->processImage(img, labels);
+    minMaxLoc(labels, &minVal, &maxVal);
+    EXPECT_EQ(1, maxVal);
+    EXPECT_EQ(36, countNonZero(labels == labels.at<int>(20, 20)));
+
+    gs->setMinSize(100);
+    gs->processImage(img, labels);
+    minMaxLoc(labels, &minVal, &maxVal);
+    EXPECT_EQ(0, maxVal);
+}
+
+TEST(ximgproc_GraphSegmentation, empty_input)
+{
+    Ptr<GraphSegmentation> gs = createGraphSegmentation();
+    Mat labels;
+    gs->processImage(Mat(), labels);
+    EXPECT_TRUE(labels.empty());
+}
+
+}} // namespace
@@ -39,4 +39,51 @@ TEST(ximpgroc_StructuredEdgeDetection, regression)
     }
 }
 
+TEST(ximpgroc_StructuredEdgeDetection, binary_model)
+{
+    cv::String dir = cvtest::TS::ptr()->get_data_path() + "cv/ximgproc/";
+    cv::Ptr<cv::ximgproc::StructuredEdgeDetection> pDollar =
+        cv::ximgproc::createStructuredEdgeDetection(dir + "model.yml.gz");
+
+    cv::String binaryName = cv::tempfile(".bin");
+    pDollar->saveModel(binaryName);
+    cv::Ptr<cv::ximgproc::StructuredEdgeDetection> pBinary =
+        cv::ximgproc::createStructuredEdgeDetection(binaryName);
+
+    cv::Mat src = cv::imread(dir + "sources/01.png", 1);
+    ASSERT_FALSE(src.empty());
+    src.convertTo(src, CV_32F, 1/255.0);
+
+    cv::Mat expected, result;
+    pDollar->detectEdges(src, expected);
+    pBinary->detectEdges(src, result);
+    EXPECT_EQ(0, cvtest::norm(expected, result, cv::NORM_INF));
+
+    remove(binaryName.c_str());
+}
+
+TEST(ximpgroc_StructuredEdgeDetection, truncated_binary_model)
+{
+    cv::String dir = cvtest::TS::ptr()->get_data_path() + "cv/ximgproc/";
+    cv::Ptr<cv::ximgproc::StructuredEdgeDetection> pDollar =
+        cv::ximgproc::createStructuredEdgeDetection(dir + "model.yml.gz");
+
+    cv::String binaryName = cv::tempfile(".bin");
+    pDollar->saveModel(binaryName);
+
+    std::vector<char> data;
+    {
+        std::ifstream in(binaryName.c_str(), std::ios::binary);
+        data.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+    ASSERT_GT(data.size(), (size_t)4096);
+    {
+        std::ofstream out(binaryName.c_str(), std::ios::binary | std::ios::trunc);
+        out.write(&data[0], data.size() - 4096);
+    }
+    EXPECT_THROW(cv::ximgproc::createStructuredEdgeDetection(binaryName), cv::Exception);
+
+    remove(binaryName.c_str());
+}
+
 }} // namespace
@@ -0,0 +1,62 @@
+// This file is part of OpenCV project.
+// It is subject to the license terms in the LICENSE file found in the top-level directory
+// of this distribution and at http://opencv.org/license.html.
+#include "perf_precomp.hpp"
+
+namespace opencv_test { namespace {
+
+// Random cascade in the format written by WBDetector::write(). The features are
+// picked among the first LBP features of the 24x24 window, and the rejection
+// thresholds let most windows leave the cascade after a few stages.
+static Ptr<WBDetector> createRandomDetector(int weak_count)
+{
+    RNG rng(0);
+    FileStorage fs(".yml", FileStorage::WRITE | FileStorage::MEMORY);
+    fs << "waldboost" << "{";
+    fs << "waldboost_params" << "{" << "weak_count" << weak_count << "}";
+    fs << "thresholds" << "[";
+    for (int i = 0; i < weak_count; ++i)
+        fs << rng.uniform(0.f, 255.f);
+    fs << "]";
+    fs << "alphas" << "[";
+    for (int i = 0; i < weak_count; ++i)
+        fs << rng.uniform(0.2f, 1.f);
+    fs << "]";
+    fs << "polarities" << "[";
+    for (int i = 0; i < weak_count; ++i)
+        fs << (rng.uniform(0, 2) ? +1 : -1);
+    fs << "]";
+    fs << "cascade_thresholds" << "[";
+    for (int i = 0; i < weak_count; ++i)
+        fs << -0.5f;
+    fs << "]";
+    fs << "feature_indices" << "[";
+    for (int i = 0; i < weak_count; ++i)
+        fs << rng.uniform(0, 1000);
+    fs << "]";
+    fs << "}";
+
+    FileStorage model(fs.releaseAndGetString(), FileStorage::READ | FileStorage::MEMORY);
+    Ptr<WBDetector> detector = WBDetector::create();
+    detector->read(model.getFirstTopLevelNode());
+    return detector;
+}
+
+typedef TestBaseWithParam<Size> WBDetectorPerf;
+
+PERF_TEST_P(WBDetectorPerf, detect, testing::Values(szVGA, sz720p))
+{
+    const Size sz = GetParam();
+    Mat img(sz, CV_8UC1);
+    declare.in(img, WARMUP_RNG);
+
+    Ptr<WBDetector> detector = createRandomDetector(256);
+    std::vector<Rect> bboxes;
+    std::vector<double> confidences;
+
+    TEST_CYCLE() detector->detect(img, bboxes, confidences);
+
+    SANITY_CHECK_NOTHING();
+}
+
+}} // namespace
@@ -128,6 +128,10 @@ public:
     virtual void setWindow(const cv::Point& p) = 0;
     virtual void writeFeatures( cv::FileStorage &fs, const cv::Mat& featureMap ) const = 0;
     virtual float operator()(int featureIdx) = 0;
+    // Prepares the given features for evaluation on integral images with the given row step (in elements)
+    virtual void setSumStep(int step, const std::vector<int> &feature_ind) = 0;
+    // Evaluates one feature on count windows whose top-left corners are at sum + offsets[k]
+    virtual void calcBatch(int featureIdx, const int *sum, const int *offsets, int count, float *vals) const = 0;
     static cv::Ptr<CvFeatureEvaluator> create();
 
     int getNumFeatures() const { return numFeatures; }
@@ -74,6 +74,23 @@ void CvLBPEvaluator::setImage(const Mat &img, uchar clsLabel, int idx,
     }
 }
 
+void CvLBPEvaluator::setSumStep(int step, const std::vector<int> &feature_ind)
+{
+    offset_ = step;
+    for (size_t i = 0; i < feature_ind.size(); ++i) {
+        features[feature_ind[i]].calcPoints(offset_);
+    }
+}
+
+void CvLBPEvaluator::calcBatch(int featureIdx, const int *_sum, const int *offsets,
+    int count, float *vals) const
+{
+    const Feature& feature = features[featureIdx];
+    for (int k = 0; k < count; ++k) {
+        vals[k] = (float)feature.calc(_sum + offsets[k]);
+    }
+}
+
 void CvLBPEvaluator::writeFeatures( FileStorage &fs, const Mat& featureMap ) const
 {
     _writeFeatures( features, fs, featureMap );
@@ -118,35 +118,100 @@ std::vector<int> WaldBoost::get_feature_indices()
     return feature_indices_;
 }
 
-void WaldBoost::detect(Ptr<CvFeatureEvaluator> eval,
+namespace {
+
+// Consecutive window rows of one pyramid level, scored by a single worker
+struct DetectionBand
+{
+    int level;
+    int row_start;
+    int row_end;
+    std::vector<Rect> bboxes;
+    std::vector<float> confidences;
+};
+
+}
+
+void WaldBoost::detect_windows(Ptr<CvFeatureEvaluator> eval,
             const Mat& img, const std::vector<float>& scales,
-            std::vector<Rect>& bboxes, Mat1f& confidences)
+            std::vector<Rect>& bboxes, std::vector<float>& confidences) const
 {
     bboxes.clear();
-    confidences.release();
+    confidences.clear();
+
+    const int win_size = 24;
+    const int step = 4;
+    const int band_rows = 8;
+    const int n_levels = (int)scales.size();
+    if (n_levels == 0)
+        return;
+
+    // Levels are scanned one after the other, so only the integral image of the
+    // current level is alive. Its row step is given to the evaluator before the
+    // window rows of the level are scored in parallel, bands of rows at a time
+    std::vector<DetectionBand> bands;
+    Mat resized_img, level_sum;
+    for (int i = 0; i < n_levels; ++i) {
+        resize(img, resized_img, Size(), scales[i], scales[i], INTER_LINEAR_EXACT);
+        integral(resized_img, level_sum, CV_32S);
+        const int sum_step = (int)level_sum.step1();
+        eval->setSumStep(sum_step, feature_indices_);
+
+        const float scale = scales[i];
+        const int width = resized_img.cols, height = resized_img.rows;
+        const int n_win_rows = height > win_size ? (height - win_size - 1) / step + 1 : 0;
+        const int n_win_cols = width > win_size ? (width - win_size - 1) / step + 1 : 0;
+        const size_t first_band = bands.size();
+        for (int r = 0; r < n_win_rows; r += band_rows) {
+            DetectionBand band;
+            band.level = i;
+            band.row_start = r;
+            band.row_end = std::min(r + band_rows, n_win_rows);
+            bands.push_back(band);
+        }
 
-    Mat resized_img;
-    int step = 4;
-    float h;
-    for (size_t i = 0; i < scales.size(); ++i) {
-        float scale = scales[i];
-        resize(img, resized_img, Size(), scale, scale, INTER_LINEAR_EXACT);
-        eval->setImage(resized_img, 0, 0, feature_indices_);
-        int n_rows = (int)(24 / scale);
-        int n_cols = (int)(24 / scale);
-        for (int r = 0; r + 24 < resized_img.rows; r += step) {
-            for (int c = 0; c + 24 < resized_img.cols; c += step) {
-                //eval->setImage(resized_img(Rect(c, r, 24, 24)), 0, 0);
-                eval->setWindow(Point(c, r));
-                if (predict(eval, &h) == +1) {
-                    int row = (int)(r / scale);
-                    int col = (int)(c / scale);
-                    bboxes.push_back(Rect(col, row, n_cols, n_rows));
-                    confidences.push_back(h);
+        parallel_for_(Range((int)first_band, (int)bands.size()), [&](const Range& range)
+        {
+            AutoBuffer<int> offsets(n_win_cols + 1), labels(n_win_cols + 1);
+            AutoBuffer<float> h(n_win_cols + 1);
+            const int* sum_ptr = level_sum.ptr<int>();
+            int n_rows = (int)(24 / scale);
+            int n_cols = (int)(24 / scale);
+            for (int b = range.start; b < range.end; ++b) {
+                DetectionBand& band = bands[b];
+                for (int wr = band.row_start; wr < band.row_end; ++wr) {
+                    const int r = wr * step;
+                    for (int k = 0; k < n_win_cols; ++k)
+                        offsets[k] = r * sum_step + k * step;
+                    predict_batch(eval, sum_ptr, offsets.data(), n_win_cols, labels.data(), h.data());
+                    for (int k = 0; k < n_win_cols; ++k) {
+                        if (labels[k] == +1) {
+                            int row = (int)(r / scale);
+                            int col = (int)(k * step / scale);
+                            band.bboxes.push_back(Rect(col, row, n_cols, n_rows));
+                            band.confidences.push_back(h[k]);
+                        }
+                    }
                 }
             }
-        }
+        });
+    }
+
+    for (size_t b = 0; b < bands.size(); ++b) {
+        bboxes.insert(bboxes.end(), bands[b].bboxes.begin(), bands[b].bboxes.end());
+        confidences.insert(confidences.end(), bands[b].confidences.begin(), bands[b].confidences.end());
     }
+}
+
+void WaldBoost::detect(Ptr<CvFeatureEvaluator> eval,
+            const Mat& img, const std::vector<float>& scales,
+            std::vector<Rect>& bboxes, Mat1f& confidences)
+{
+    std::vector<float> conf;
+    detect_windows(eval, img, scales, bboxes, conf);
+    confidences.release();
+    if (!conf.empty())
+        confidences = Mat1f(conf, true);
     groupRectangles(bboxes, 3, 0.7);
 }
 
@@ -154,30 +219,9 @@ void WaldBoost::detect(Ptr<CvFeatureEvaluator> eval,
             const Mat& img, const std::vector<float>& scales,
             std::vector<Rect>& bboxes, std::vector<double>& confidences)
 {
-    bboxes.clear();
-    confidences.clear();
-
-    Mat resized_img;
-    int step = 4;
-    float h;
-    for (size_t i = 0; i < scales.size(); ++i) {
-        float scale = scales[i];
-        resize(img, resized_img, Size(), scale, scale, INTER_LINEAR_EXACT);
-        eval->setImage(resized_img, 0, 0, feature_indices_);
-        int n_rows = (int)(24 / scale);
-        int n_cols = (int)(24 / scale);
-        for (int r = 0; r + 24 < resized_img.rows; r += step) {
-            for (int c = 0; c + 24 < resized_img.cols; c += step) {
-                eval->setWindow(Point(c, r));
-                if (predict(eval, &h) == +1) {
-                    int row = (int)(r / scale);
-                    int col = (int)(c / scale);
-                    bboxes.push_back(Rect(col, row, n_cols, n_rows));
-                    confidences.push_back(h);
-                }
-            }
-        }
-    }
+    std::vector<float> conf;
+    detect_windows(eval, img, scales, bboxes, conf);
+    confidences.assign(conf.begin(), conf.end());
     std::vector<int> levels(bboxes.size(), 0);
     groupRectangles(bboxes, levels, confidences, 3, 0.7);
 }
@@ -363,6 +407,53 @@ int WaldBoost::predict(Ptr<CvFeatureEvaluator> eval, float *h) const
     return res > cascade_thresholds_[count - 1] ? +1 : -1;
 }
 
+void WaldBoost::predict_batch(const Ptr<CvFeatureEvaluator>& eval,
+            const int *sum, const int *offsets, int count,
+            int *labels, float *h) const
+{
+    CV_Assert(weak_count_ > 0);
+    assert(feature_indices_.size() == size_t(weak_count_));
+    assert(cascade_thresholds_.size() == size_t(weak_count_));
+
+    // Windows rejected by a stage are compacted out of the working set, so
+    // every stage only evaluates its feature on the surviving windows
+    AutoBuffer<int> alive_buf(count), alive_offsets_buf(count);
+    AutoBuffer<float> res_buf(count), vals_buf(count);
+    int *alive = alive_buf.data();
+    int *alive_offsets = alive_offsets_buf.data();
+    float *res = res_buf.data();
+    float *vals = vals_buf.data();
+
+    for (int k = 0; k < count; ++k) {
+        alive[k] = k;
+        alive_offsets[k] = offsets[k];
+        res[k] = 0;
+        labels[k] = -1;
+    }
+
+    int n_alive = count;
+    for (int i = 0; i < weak_count_ && n_alive > 0; ++i) {
+        eval->calcBatch(feature_indices_[i], sum, alive_offsets, n_alive, vals);
+        int n = 0;
+        for (int k = 0; k < n_alive; ++k) {
+            int label = polarities_[i] * (vals[k] - thresholds_[i]) > 0 ? +1: -1;
+            float r = res[k] + alphas_[i] * label;
+            if (r < cascade_thresholds_[i])
+                continue;
+            alive[n] = alive[k];
+            alive_offsets[n] = alive_offsets[k];
+            res[n] = r;
+            ++n;
+        }
+        n_alive = n;
+    }
+
+    for (int k = 0; k < n_alive; ++k) {
+        h[alive[k]] = res[k];
+        labels[alive[k]] = res[k] > cascade_thresholds_[weak_count_ - 1] ? +1 : -1;
+    }
+}
+
 void WaldBoost::write(FileStorage &fs) const
 {
     fs << "{";
@@ -70,6 +70,9 @@ public:
 
     void fit(Mat& data_pos, Mat& data_neg);
     int predict(Ptr<CvFeatureEvaluator> eval, float *h) const;
+    void predict_batch(const Ptr<CvFeatureEvaluator>& eval,
+                       const int *sum, const int *offsets, int count,
+                       int *labels, float *h) const;
     void save(const std::string& filename);
     void load(const std::string& filename);
 
@@ -80,6 +83,12 @@ public:
     ~WaldBoost();
 
 private:
+    void detect_windows(Ptr<CvFeatureEvaluator> eval,
+                        const Mat& img,
+                        const std::vector<float>& scales,
+                        std::vector<Rect>& bboxes,
+                        std::vector<float>& confidences) const;
+
     int weak_count_;
     std::vector<float> thresholds_;
     std::vector<float> alphas_;